@@ -53,6 +53,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/param.h>
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -71,6 +72,7 @@
 #include "backend_handle.h"
 #include "backend_get.h"
 #include "backend_client.h"
+#include "backend_worker.h"
 
 /*! Find client by session-id 
  *
@@ -1629,6 +1631,106 @@ from_client_hello(clixon_handle       h,
     return retval;
 }
 
+/*! Send reply or part of reply to client, adding message-id of request unless already present
+ *
+ * A client with several outstanding requests on one socket correlates replies by message-id.
+ * The message-id is sent as a separate segment, the reply is not copied.
+ * A streamed reply is sent in several parts, where the message-id is only given with the
+ * first part and the last part has eom set.
+ * @param[in]  s      Socket to communicate with client
+ * @param[in]  descr  Description of peer for logging
+ * @param[in]  str    Reply message on the form <rpc-reply ...>..., null-terminated
+ * @param[in]  len    Length of reply message
+ * @param[in]  msgid  Message-id of request, or NULL
+ * @param[in]  eom    If set, this is the last part of the reply
+ * @retval     0      OK
+ * @retval    -1      Error, check errno
+ * @see clicon_rpc_pipe_send
+ */
+static int
+send_msg_reply_id(int         s,
+                  const char *descr,
+                  char       *str,
+                  size_t      len,
+                  char       *msgid,
+                  int         eom)
+{
+    int          retval = -1;
+    cbuf        *cb = NULL;
+    char        *p = NULL;
+    char         c;
+    int          found;
+    struct iovec iov[3];
+
+    /* Insert before end of start tag */
+    if (msgid != NULL &&
+        strncmp(str, "<rpc-reply", strlen("<rpc-reply")) == 0 &&
+        (p = strchr(str, '>')) != NULL){
+        if (*(p-1) == '/')
+            p--;
+        c = *p;
+        *p = '\0';
+        found = strstr(str, " message-id=") != NULL;
+        *p = c;
+        if (found)
+            p = NULL;
+    }
+    if (p == NULL){
+        iov[0].iov_base = str;
+        iov[0].iov_len = len;
+        retval = clixon_msg_send11_chunk(s, descr, iov, 1, eom);
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, " message-id=\"");
+    if (xml_chardata_cbuf_append(cb, 1, msgid) < 0)
+        goto done;
+    cprintf(cb, "\"");
+    iov[0].iov_base = str;
+    iov[0].iov_len = p - str;
+    iov[1].iov_base = cbuf_get(cb);
+    iov[1].iov_len = cbuf_len(cb);
+    iov[2].iov_base = p;
+    iov[2].iov_len = len - (p - str);
+    retval = clixon_msg_send11_chunk(s, descr, iov, 3, eom);
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/* Streamed reply to client, see CLICON_REPLY_STREAM_SIZE */
+struct reply_stream{
+    int         rs_s;     /* Socket to communicate with client */
+    const char *rs_descr; /* Description of peer for logging */
+    char       *rs_msgid; /* Message-id of request, cleared when first part is sent */
+};
+
+/*! Send part of streamed reply to client
+ *
+ * @param[in]  arg  Reply stream struct
+ * @param[in]  buf  Part of reply
+ * @param[in]  len  Length of part
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_writer_new
+ */
+static int
+reply_stream_flush(void  *arg,
+                   char  *buf,
+                   size_t len)
+{
+    struct reply_stream *rs = (struct reply_stream *)arg;
+    char                *msgid;
+
+    msgid = rs->rs_msgid;
+    rs->rs_msgid = NULL;
+    return send_msg_reply_id(rs->rs_s, rs->rs_descr, buf, len, msgid, 0);
+}
+
 /*! An internal clixon NETCONF message has arrived from a local client. Receive and dispatch.
  *
  * @param[in]   h    Clixon handle
@@ -1663,6 +1765,12 @@ from_client_msg(clixon_handle        h,
     char                *namespace = NULL;
     int                  nr = 0;
     cbuf                *cbce = NULL;
+    cxobj               *xa;
+    char                *msgid = NULL;
+    clixon_writer       *w = NULL;
+    struct reply_stream  rs;
+    int                  streamsz;
+    int                  streamed;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     yspec = clicon_dbspec_yang(h);
@@ -1675,7 +1783,10 @@ from_client_msg(clixon_handle        h,
     }
     /* Decode msg from client -> xml top (ct) and session id 
      * Bind is a part of the decode function
+     * The request is a temporary tree, allocate it from an arena
      */
+    if ((xt = xml_new_arena(XML_TOP_SYMBOL, CX_ELMNT)) == NULL)
+        goto done;
     if ((ret = clixon_xml_parse_string(msg, YB_RPC, yspec, &xt, &xret)) < 0){
         if (netconf_malformed_message(cbret, "XML parse error") < 0)
             goto done;
@@ -1704,6 +1815,10 @@ from_client_msg(clixon_handle        h,
     }
     rpcname = xml_name(x);
     rpcprefix = xml_prefix(x);
+    /* Unprefixed message-id is echoed in reply for clients with several outstanding requests */
+    if ((xa = xml_find_type(x, NULL, "message-id", CX_ATTR)) != NULL &&
+        xml_prefix(xa) == NULL)
+        msgid = xml_value(xa);
 #ifdef NOTACTIVE /* May need to re-activate */
     /* Sanity check:
      * op_id from internal message can be out-of-sync from client's sessions-id for the following reasons:
@@ -1839,18 +1954,41 @@ from_client_msg(clixon_handle        h,
                 goto reply;
             }
         }
+        /* Read-only RPCs may be handled by a worker process */
+        if ((ret = backend_worker_fork(h, ce, xe)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        /* Large get replies are sent in parts while serialized
+         * Not if replies are validated, which requires the whole reply, see rpc_reply_check */
+        if ((streamsz = clicon_option_int(h, "CLICON_REPLY_STREAM_SIZE")) > 0 &&
+            !clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML") &&
+            strcmp(module, "ietf-netconf") == 0 &&
+            (strcmp(rpc, "get") == 0 || strcmp(rpc, "get-config") == 0)){
+            if (cbce == NULL && ce_client_descr(ce, &cbce) < 0)
+                goto done;
+            rs.rs_s = ce->ce_s;
+            rs.rs_descr = cbuf_get(cbce);
+            rs.rs_msgid = msgid;
+            if ((w = clixon_writer_new(cbret, streamsz, reply_stream_flush, &rs)) == NULL)
+                goto done;
+        }
         clixon_err_reset();
         if ((ret = rpc_callback_call(h, xe, ce, &nr, cbret)) < 0){
-            if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
-                goto done;
             clixon_log(h, LOG_NOTICE, "%s Error in rpc_callback_call:%s", __FUNCTION__, xml_name(xe));
             ce->ce_out_rpc_errors++;
             netconf_monitoring_counter_inc(h, "out-rpc-errors");
+            if (w != NULL && clixon_writer_flushed(w) > 0)
+                goto terminate;
+            if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+                goto done;
             goto reply; /* Dont quit here on user callbacks */
         }
         if (ret == 0){
             ce->ce_out_rpc_errors++;
             netconf_monitoring_counter_inc(h, "out-rpc-errors");
+            if (w != NULL && clixon_writer_flushed(w) > 0)
+                goto terminate;
             goto reply;
         }
         if (nr == 0){ /* not handled by callback */
@@ -1868,16 +2006,20 @@ from_client_msg(clixon_handle        h,
         }
     } /* while */
  reply:
-    if (cbuf_len(cbret) == 0)
+    /* If parts of the reply have been sent, send the rest, which may be empty.
+     * An error after the first part cannot be reported as a new rpc-error */
+    streamed = w != NULL && clixon_writer_flushed(w) > 0;
+    if (!streamed && cbuf_len(cbret) == 0)
         if (netconf_operation_failed(cbret, "application",
                                      clixon_err_category()?clixon_err_reason():"unknown")< 0)
             goto done;
     // XXX    clixon_debug(CLIXON_DBG_MSG, "Reply:%s", cbuf_get(cbret));
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
-    if (ce_client_descr(ce, &cbce) < 0)
+    if (cbce == NULL && ce_client_descr(ce, &cbce) < 0)
         goto done;
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+    if (send_msg_reply_id(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret),
+                          streamed?NULL:msgid, 1) < 0){
         switch (errno){
         case EPIPE:
             /* man (2) write: 
@@ -1894,7 +2036,19 @@ from_client_msg(clixon_handle        h,
             goto done;
         }
     }
-    // ok:
+  ok:
+    retval = 0;
+    goto done;
+  terminate:
+    /* Parts of the reply have been sent, the error cannot be sent as an rpc-error and
+     * the client would wait for the end of the reply. Close the session instead.
+     * A worker process exits and the main process then reads EOF on the socket */
+    clixon_log(h, LOG_WARNING, "%s: Error after partial reply of %s, closing session %u",
+               __FUNCTION__, rpc, ce->ce_id);
+    shutdown(ce->ce_s, SHUT_RDWR);
+    backend_worker_exit(0);
+    backend_client_rm(h, ce);
+    netconf_monitoring_counter_inc(h, "dropped-sessions");
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
@@ -1907,6 +2061,8 @@ from_client_msg(clixon_handle        h,
         xml_free(xret);
     if (xt)
         xml_free(xt);
+    if (w)
+        clixon_writer_free(w);
     if (cbce)
         cbuf_free(cbce);
     if (cbret)
@@ -1916,17 +2072,88 @@ from_client_msg(clixon_handle        h,
         clixon_log(h, LOG_NOTICE, "%s: Internal error: No clixon_err call on RPC error (message: %s)",
                    __FUNCTION__, rpc?rpc:"");
     //    clixon_debug(CLIXON_DBG_BACKEND, "retval:%d", retval);
+    backend_worker_exit(retval); /* Does not return in a worker process */
     return retval;// -1 here terminates backend
 }
 
+/*! Check if client entry is still in client list, ie not removed while handling a message
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  ce  Client entry
+ * @retval     1   Client exists
+ * @retval     0   Client has been removed
+ */
+static int
+ce_exists(clixon_handle        h,
+          struct client_entry *ce)
+{
+    struct client_entry *c;
+
+    for (c = backend_client_list(h); c; c = c->ce_next)
+        if (c == ce)
+            return 1;
+    return 0;
+}
+
+/*! Read from client and handle all complete messages
+ *
+ * Stops if the client is removed, or if a message is handed over to a worker process.
+ * @param[in]   h    Clixon handle
+ * @param[in]   ce   Client entry
+ * @param[in]   s    Socket to read from, or -1 to only handle messages already received
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+from_client_input(clixon_handle        h,
+                  struct client_entry *ce,
+                  int                  s)
+{
+    int   retval = -1;
+    int   eof = 0;
+    cbuf *cbce = NULL;
+    cbuf *cb = NULL;
+
+    if (ce->ce_rcvbuf == NULL &&
+        (ce->ce_rcvbuf = clixon_msg_rcvbuf_new()) == NULL)
+        goto done;
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+    if (clixon_msg_rcv11_buf(s, cbuf_get(cbce), ce->ce_rcvbuf, &cb, &eof) < 0)
+        goto done;
+    while (!eof && cb != NULL){
+        if (from_client_msg(h, ce, cbuf_get(cb)) < 0)
+            goto done;
+        if (!ce_exists(h, ce)) /* eg stream removal */
+            goto ok;
+        if (ce->ce_worker) /* Resumed when worker exits */
+            goto ok;
+        if (clixon_msg_rcv11_buf(-1, cbuf_get(cbce), ce->ce_rcvbuf, &cb, &eof) < 0)
+            goto done;
+    }
+    if (eof){
+        backend_client_rm(h, ce);
+        netconf_monitoring_counter_inc(h, "dropped-sessions");
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+
 /*! Internal clixon message has arrived from a client. Receive and dispatch.
  *
  * Internal clixon is NETCONF 1.1 chunked encoding
+ * A client may have several outstanding messages (pipelining). All complete messages
+ * read are handled in order, any remaining input is kept in the client receive buffer.
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
  * @retval      0    OK
  * @retval     -1    Error Terminates backend and is never called). Instead errors are
  *                   propagated back to client.
+ * @see clicon_rpc_pipe_send  Client side of pipelining
  */
 int
 from_client(int   s,
@@ -1935,35 +2162,54 @@ from_client(int   s,
     int                  retval = -1;
     struct client_entry *ce = (struct client_entry *)arg;
     clixon_handle        h = ce->ce_handle;
-    int                  eof = 0;
-    cbuf                *cbce = NULL;
-    cbuf                *cb = NULL;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     if (s != ce->ce_s){
         clixon_err(OE_NETCONF, EINVAL, "Internal error: s != ce->ce_s");
         goto done;
     }
-    if (ce_client_descr(ce, &cbce) < 0)
-        goto done;
-    if (clixon_msg_rcv11(s, cbuf_get(cbce), 0, &cb, &eof) < 0) /* XXX why not descr here? */
-        goto done;
-    if (eof){
-        backend_client_rm(h, ce);
-        netconf_monitoring_counter_inc(h, "dropped-sessions");
-    }
-    else if (from_client_msg(h, ce, cbuf_get(cb)) < 0)
+    if (from_client_input(h, ce, s) < 0)
         goto done;
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
-    if (cb)
-        cbuf_free(cb);
-    if (cbce)
-        cbuf_free(cbce);
     return retval; /* -1 here terminates backend */
 }
 
+/*! Worker process of client has exited, resume reading from client
+ *
+ * Register client socket again and handle messages received while the worker was running
+ * @param[in]   h       Clixon handle
+ * @param[in]   ce      Client entry, may have been removed
+ * @param[in]   pid     Process id of exited worker
+ * @param[in]   errors  Number of rpc-error replies sent by worker
+ * @retval      0       OK
+ * @retval     -1       Error
+ * @see backend_worker_fork
+ */
+int
+from_client_resume(clixon_handle        h,
+                   struct client_entry *ce,
+                   pid_t                pid,
+                   uint32_t             errors)
+{
+    int retval = -1;
+
+    if (!ce_exists(h, ce) || ce->ce_worker != pid)
+        goto ok;
+    ce->ce_worker = 0;
+    ce->ce_out_rpc_errors += errors;
+    if (clixon_event_reg_fd_prio(ce->ce_s, from_client, (void*)ce, "local netconf client socket",
+                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+        goto done;
+    if (from_client_input(h, ce, -1) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Init backend rpc: Set up standard netconf rpc callbacks
  *
  * @param[in]  h     Clixon handle
@@ -84,6 +84,7 @@
  * @param[in]   h       Clixon handle
  * @param[in]   yspec   Yang spec
  * @param[in]   td      Transaction data
+ * @param[in]   incr    Only validate changes, td_src is valid and both trees are marked
  * @param[out]  xret    Error XML tree. Free with xml_free after use
  * @retval      1       Validation OK       
  * @retval      0       Validation failed (with cbret set)
@@ -93,6 +94,7 @@ static int
 generic_validate(clixon_handle       h,
                  yang_stmt          *yspec,
                  transaction_data_t *td,
+                 int                 incr,
                  cxobj             **xret)
 {
     int        retval = -1;
@@ -101,8 +103,12 @@ generic_validate(clixon_handle       h,
     int        ret;
     cbuf      *cb = NULL;
 
-    /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0)
+    /* All entries, or only entries affected by changes */
+    if (incr)
+        ret = xml_yang_validate_diff_top(h, yspec, td->td_src, td->td_target, xret);
+    else
+        ret = xml_yang_validate_all_top(h, td->td_target, xret);
+    if (ret < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -310,7 +316,7 @@ startup_common(clixon_handle       h,
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
     clixon_debug(CLIXON_DBG_BACKEND, "Validating startup %s", db);
-    if ((ret = generic_validate(h, yspec, td, &xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xret)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
@@ -498,7 +504,12 @@ validate_common(clixon_handle       h,
     if (xmldb_cache_get(h, db) != NULL){
         if (xmldb_populate(h, db) < 0)
             goto done;
-        if (xmldb_write_cache2file(h, db) < 0)
+        /* With journal, file and journal are already in sync with cache unless volatile.
+         * Journal is not used with multi datastores */
+        if ((!clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") ||
+             clicon_option_bool(h, "CLICON_XMLDB_MULTI") ||
+             xmldb_volatile_get(h, db)) &&
+            xmldb_write_cache2file(h, db) < 0)
             goto done;
     }
     /* This is the state we are going to */
@@ -558,7 +569,9 @@ validate_common(clixon_handle       h,
 
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td,
+                                clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL"),
+                                xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -1027,7 +1040,7 @@ from_client_restart_one(clixon_handle    h,
         goto fail;
     /* Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, &xerr)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xerr)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
@@ -82,8 +82,7 @@ struct confirmed_commit {
     enum confirmed_commit_state cc_state;
     char       *cc_persist_id;       /* a value given by a client in the confirmed-commit */
     uint32_t    cc_session_id;       /* the session_id of the client that gave no <persist> value */
-    int        (*cc_fn)(int, void*); /* function pointer for rollback event (rollback_fn()) */
-    void        *cc_arg;             /* clixon_handle that will be passed to rollback_fn() */
+    void        *cc_timer;           /* reference to rollback event timer (rollback_fn()), or NULL */
 };
 
 int
@@ -116,6 +115,7 @@ confirmed_commit_free(clixon_handle h)
 
     clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
     if (cc != NULL){
+        clixon_event_unreg_timeout_ref(cc->cc_timer);
         if (cc->cc_persist_id != NULL)
             free (cc->cc_persist_id);
         free(cc);
@@ -196,32 +196,6 @@ confirmed_commit_session_id_set(clixon_handle h,
     return 0;
 }
 
-static int
-confirmed_commit_fn_arg_get(clixon_handle h,
-                            int        (**fn)(int, void*),
-                            void        **arg)
-{
-    struct confirmed_commit *cc = NULL;
-
-    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
-    *fn = cc->cc_fn;
-    *arg = cc->cc_arg;
-    return 0;
-}
-
-static int
-confirmed_commit_fn_arg_set(clixon_handle h,
-                            int        (*fn)(int, void*),
-                            void        *arg)
-{
-    struct confirmed_commit *cc = NULL;
-
-    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
-    cc->cc_fn = fn;
-    cc->cc_arg = arg;
-    return 0;
-}
-
 /*! Return if confirmed tag found
  *
  * @param[in]  xe  Commit rpc xml
@@ -302,12 +276,11 @@ xe_timeout(cxobj *xe)
 int
 cancel_rollback_event(clixon_handle h)
 {
-    int   retval;
-    int (*fn)(int, void*) = NULL;
-    void *arg = NULL;
+    int                      retval;
+    struct confirmed_commit *cc = NULL;
 
-    confirmed_commit_fn_arg_get(h, &fn, &arg);
-    if ((retval = clixon_event_unreg_timeout(fn, arg)) == 0) {
+    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
+    if ((retval = clixon_event_unreg_timeout_ref(cc->cc_timer)) == 0) {
         clixon_log(h, LOG_INFO, "a scheduled rollback event has been cancelled");
     } else {
         clixon_log(h, LOG_WARNING, "the specified scheduled rollback event was not found");
@@ -347,7 +320,8 @@ static int
 schedule_rollback_event(clixon_handle h,
                         uint32_t      timeout)
 {
-    int retval = -1;
+    int                      retval = -1;
+    struct confirmed_commit *cc = NULL;
 
     // register a new scheduled event
     struct timeval t, t1;
@@ -363,9 +337,9 @@ schedule_rollback_event(clixon_handle h,
      * - persistent, and the client provided the persist-id in the new confirmed-commit
      */
 
-    /* remember the function pointer and args so the confirming-commit can cancel the rollback */
-    confirmed_commit_fn_arg_set(h, rollback_fn, h);
-    if (clixon_event_reg_timeout(t, rollback_fn, h, "rollback after timeout") < 0) {
+    /* remember the timer so the confirming-commit can cancel the rollback */
+    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
+    if (clixon_event_reg_timeout_ref(t, rollback_fn, h, "rollback after timeout", &cc->cc_timer) < 0) {
         /* error is logged in called function */
         goto done;
     };
@@ -433,6 +433,81 @@ get_nacm_and_reply(clixon_handle        h,
     return retval;
 }
 
+/*! Get configuration and reply without copying the datastore cache
+ *
+ * Only if no NACM read filtering is made, since that modifies the tree
+ * @param[in]  h        Clixon handle
+ * @param[in]  db       Database name
+ * @param[in]  xpath    XPath point to object to get
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
+ * @param[in]  wdef     With-defaults parameter
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see get_nacm_and_reply
+ */
+static int
+get_config_view_reply(clixon_handle     h,
+                      char             *db,
+                      char             *xpath,
+                      cvec             *nsc,
+                      int32_t           depth,
+                      withdefaults_type wdef,
+                      cbuf             *cbret)
+{
+    int     retval = -1;
+    cxobj  *xt = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen = 0;
+    cxobj  *xerr = NULL;
+    cbuf   *cbmsg = NULL;
+    int     ret;
+
+    if ((ret = xmldb_get_view(h, db, nsc, xpath?xpath:"/", &xt, &xvec, &xlen, &xerr)) < 0) {
+        if ((cbmsg = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbmsg, "Get %s datastore: %s", db, clixon_err_reason());
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
+    if (depth == 0)
+        ;
+    else if (xlen == 0)
+        cprintf(cbret, "<%s/>", NETCONF_OUTPUT_DATA);
+    else{
+        cprintf(cbret, "<%s>", NETCONF_OUTPUT_DATA);
+        /* Top level is data, printed here */
+        if (clixon_xml2cbuf_marked(cbret, xt, 0, 0, NULL, depth, 1, wdef) < 0){
+            xmldb_view_release(h, db, xvec, xlen);
+            goto done;
+        }
+        cprintf(cbret, "</%s>", NETCONF_OUTPUT_DATA);
+    }
+    cprintf(cbret, "</rpc-reply>");
+    if (xmldb_view_release(h, db, xvec, xlen) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xvec)
+        free(xvec);
+    if (xerr)
+        xml_free(xerr);
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    return retval;
+}
+
 /*! Help function for parsing restconf query parameter and setting netconf attribute
  *
  * Parse and set a uint32 numeric value,
@@ -1009,6 +1084,14 @@ get_common(clixon_handle        h,
             goto ok;
         }
     }
+    /* Config only without NACM: print directly from datastore cache */
+    if (content == CONTENT_CONFIG &&
+        clicon_nacm_cache(h) == NULL &&
+        !clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+        if (get_config_view_reply(h, db, xpath, nsc, depth, wdef, cbret) < 0)
+            goto done;
+        goto ok;
+    }
     /* Read configuration */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
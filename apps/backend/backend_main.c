@@ -128,6 +128,7 @@ backend_terminate(clixon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_pagination_free(h);
     
     if (pidfile)
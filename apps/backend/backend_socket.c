@@ -294,9 +294,17 @@ backend_accept_client(int   fd,
      * Register callback for actual data socket
      */
     if (clixon_event_reg_fd_prio(s, from_client, (void*)ce, "local netconf client socket",
-                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
-        goto done;
+                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0){
+        /* Drop this client, eg fd exceeds FD_SETSIZE, but continue with others */
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+        s = -1;
+        if (backend_client_rm(h, ce) < 0)
+            goto done;
+        goto ok;
+    }
     s = -1;
+ ok:
     retval = 0;
  done:
     if (s != -1)
@@ -0,0 +1,370 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ */
+
+/*
+ * Worker processes for read-only backend RPCs
+ *
+ * The backend handles all client messages in a single event loop. A slow get over a large
+ * datastore or state data therefore blocks commits and all other clients.
+ * If CLICON_BACKEND_READ_WORKERS is set, get, get-config and get-schema are instead handled by
+ * a forked worker process. The worker runs the regular RPC callback on a copy-on-write
+ * snapshot of the backend, including the datastore caches, sends the reply directly on the
+ * client socket and exits.
+ * A get that includes state data is not handled by a worker, since state data callbacks may
+ * use plugin sockets and other state shared with the main process.
+ * The worker drops the event registrations and sockets of other clients inherited from the
+ * main process. Counters updated by the worker are sent to the main process on the worker
+ * pipe before it exits.
+ * Meanwhile the main process continues with other clients, edits and commits are made in the
+ * main process only.
+ * The client socket is not read by the main process while its worker is running, which keeps
+ * replies in request order.
+ * Workers are not used with CLICON_XMLDB_MULTI, since sub-files loaded by a worker would be
+ * loaded again by the main process, and sub-files evicted by the main process could not be
+ * loaded by the worker from a datastore being rewritten.
+ * libclixon is not thread-safe, which is why processes and not threads are used.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_client.h"
+#include "backend_handle.h"
+#include "backend_client.h"
+#include "backend_worker.h"
+
+/* Running worker process
+ */
+struct backend_worker{
+    clixon_handle        bw_h;   /* Clixon handle */
+    pid_t                bw_pid; /* Process id of worker */
+    int                  bw_fd;  /* Read end of pipe, EOF when worker exits */
+    struct client_entry *bw_ce;  /* Client entry the worker replies to */
+    uint32_t             bw_errors; /* out-rpc-errors counted by worker, read from pipe */
+    size_t               bw_len; /* Bytes of bw_errors read */
+};
+
+/* Number of running worker processes */
+static int _worker_nr = 0;
+
+/* Set in worker process */
+static int _worker_child = 0;
+
+/* Write end of pipe in worker process */
+static int _worker_fd = -1;
+
+/* Client entry and its out-rpc-errors counter at fork, in worker process */
+static struct client_entry *_worker_ce = NULL;
+static uint32_t             _worker_errors = 0;
+
+/*! Check if RPC is read-only and may be handled by a worker
+ *
+ * @param[in]  xe   RPC request element, eg <get-config>
+ * @retval     1    Read-only
+ * @retval     0    Not read-only
+ * @retval    -1    Error
+ */
+static int
+worker_rpc_readonly(cxobj *xe)
+{
+    char *name;
+    char *ns = NULL;
+    char *content;
+
+    name = xml_name(xe);
+    if (xml2ns(xe, xml_prefix(xe), &ns) < 0)
+        return -1;
+    if (ns == NULL)
+        return 0;
+    if (strcmp(ns, NETCONF_BASE_NAMESPACE) == 0){
+        if (strcmp(name, "get-config") == 0)
+            return 1;
+        /* State data callbacks are called in the main process */
+        if (strcmp(name, "get") == 0)
+            return (content = xml_find_value(xe, "content")) != NULL &&
+                netconf_content_str2int(content) == CONTENT_CONFIG;
+        return 0;
+    }
+    if (strcmp(ns, NETCONF_MONITORING_NAMESPACE) == 0)
+        return strcmp(name, "get-schema") == 0;
+    return 0;
+}
+
+/*! Reap exited worker process without blocking the event loop
+ *
+ * The worker closes its pipe end just before it exits, so it may not yet have exited
+ * when the pipe reaches EOF. In that case, retry later from a timer.
+ * @param[in]  s    Not used
+ * @param[in]  arg  Process id of worker
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+backend_worker_reap(int   s,
+                    void *arg)
+{
+    pid_t          pid = (pid_t)(intptr_t)arg;
+    pid_t          wpid;
+    int            status = 0;
+    struct timeval t;
+    struct timeval t1 = {0, 10000}; /* 10ms */
+
+    while ((wpid = waitpid(pid, &status, WNOHANG)) < 0 && errno == EINTR)
+        ;
+    if (wpid < 0 && errno != ECHILD){
+        clixon_err(OE_UNIX, errno, "waitpid");
+        return -1;
+    }
+    if (wpid == 0){ /* Still running */
+        gettimeofday(&t, NULL);
+        timeradd(&t, &t1, &t);
+        if (clixon_event_reg_timeout(t, backend_worker_reap, arg, "worker reap") < 0)
+            return -1;
+        return 0;
+    }
+    if (wpid == pid && WIFEXITED(status) && WEXITSTATUS(status) != 0)
+        clixon_log(NULL, LOG_WARNING, "%s: worker %d exited with status %d",
+                   __FUNCTION__, pid, WEXITSTATUS(status));
+    return 0;
+}
+
+/*! Worker process has exited, resume reading from client
+ *
+ * Called when the worker writes its counters to the pipe and when the write end of the pipe
+ * held by the worker is closed
+ * @param[in]  fd   Read end of worker pipe
+ * @param[in]  arg  Worker struct
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+backend_worker_done(int   fd,
+                    void *arg)
+{
+    int                    retval = -1;
+    struct backend_worker *bw = (struct backend_worker *)arg;
+    char                   buf[64];
+    ssize_t                n;
+    uint32_t               i;
+
+    while ((n = read(fd, buf, sizeof(buf))) < 0 && errno == EINTR)
+        ;
+    if (n > 0){ /* Counters, see backend_worker_exit */
+        if (bw->bw_len + n <= sizeof(bw->bw_errors))
+            memcpy((char*)&bw->bw_errors + bw->bw_len, buf, n);
+        bw->bw_len += n;
+        return 0;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    clixon_event_unreg_fd(fd, backend_worker_done);
+    close(fd);
+    if (bw->bw_len != sizeof(bw->bw_errors))
+        bw->bw_errors = 0;
+    for (i=0; i<bw->bw_errors; i++)
+        netconf_monitoring_counter_inc(bw->bw_h, "out-rpc-errors");
+    /* Do not block in waitpid, reap from timer if worker has not yet exited */
+    if (backend_worker_reap(0, (void*)(intptr_t)bw->bw_pid) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_BACKEND, "worker %d done", bw->bw_pid);
+    _worker_nr--;
+    if (from_client_resume(bw->bw_h, bw->bw_ce, bw->bw_pid, bw->bw_errors) < 0)
+        goto done;
+    retval = 0;
+ done:
+    free(bw);
+    return retval;
+}
+
+/*! Drop state inherited from the main process in a new worker process
+ *
+ * Event registrations are freed and the epoll fd is closed without modifying the epoll set
+ * shared with the main process. Sockets of other clients are closed.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry the worker replies to
+ */
+static void
+backend_worker_detach(clixon_handle        h,
+                      struct client_entry *ce)
+{
+    struct client_entry *c;
+
+    clixon_event_exit();
+    for (c = backend_client_list(h); c; c = c->ce_next)
+        if (c != ce && c->ce_s){
+            close(c->ce_s);
+            c->ce_s = 0;
+        }
+}
+
+/*! Handle read-only RPC in a forked worker process
+ *
+ * If the RPC is read-only and there is a free worker slot, fork a worker process.
+ * No workers are forked with CLICON_XMLDB_MULTI.
+ * The parent stops reading from the client socket until the worker exits.
+ * The worker (child) continues to handle the RPC and send the reply, and should then call
+ * backend_worker_exit.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @param[in]  xe   RPC request element, eg <get-config>
+ * @retval     1    Continue handling the RPC in this process (no worker, or in worker)
+ * @retval     0    Handled by worker, parent should not reply
+ * @retval    -1    Error
+ * @see backend_worker_exit
+ */
+int
+backend_worker_fork(clixon_handle        h,
+                    struct client_entry *ce,
+                    cxobj               *xe)
+{
+    int                    retval = -1;
+    struct backend_worker *bw = NULL;
+    int                    fds[2] = {-1, -1};
+    pid_t                  pid;
+    int                    ret;
+
+    if (_worker_child ||
+        _worker_nr >= clicon_option_int(h, "CLICON_BACKEND_READ_WORKERS") ||
+        clicon_option_bool(h, "CLICON_XMLDB_MULTI"))
+        goto cont;
+    if ((ret = worker_rpc_readonly(xe)) < 0)
+        goto done;
+    if (ret == 0)
+        goto cont;
+    if ((bw = malloc(sizeof(*bw))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(bw, 0, sizeof(*bw));
+    if (pipe(fds) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    bw->bw_h = h;
+    bw->bw_fd = fds[0];
+    bw->bw_ce = ce;
+    /* Register before fork, if it fails, eg fd exceeds FD_SETSIZE, handle RPC in this process */
+    if (clixon_event_reg_fd(bw->bw_fd, backend_worker_done, bw, "backend read worker") < 0){
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+        goto cont;
+    }
+    if ((pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        clixon_event_unreg_fd(bw->bw_fd, backend_worker_done);
+        goto done;
+    }
+    if (pid == 0){ /* child: worker */
+        _worker_child = 1;
+        _worker_fd = fds[1]; /* Write end is kept open until worker exits */
+        _worker_ce = ce;
+        _worker_errors = ce->ce_out_rpc_errors;
+        close(fds[0]);
+        fds[0] = -1;
+        fds[1] = -1;
+        free(bw);
+        bw = NULL;
+        backend_worker_detach(h, ce); /* Also drops the registration above */
+        goto cont;
+    }
+    /* parent */
+    close(fds[1]);
+    fds[1] = -1;
+    bw->bw_pid = pid;
+    fds[0] = -1;
+    clixon_event_unreg_fd(ce->ce_s, from_client);
+    ce->ce_worker = pid;
+    _worker_nr++;
+    bw = NULL;
+    clixon_debug(CLIXON_DBG_BACKEND, "worker %d: %s ce_id:%u", pid, xml_name(xe), ce->ce_id);
+    retval = 0;
+ done:
+    if (fds[0] != -1)
+        close(fds[0]);
+    if (fds[1] != -1)
+        close(fds[1]);
+    if (bw)
+        free(bw);
+    return retval;
+ cont:
+    retval = 1;
+    goto done;
+}
+
+/*! Exit if this is a worker process, otherwise no-op
+ *
+ * The out-rpc-errors counted by the worker are written to the pipe, and added to the client
+ * and netconf-monitoring counters by the main process in backend_worker_done
+ * @param[in]  retval  Result of handling the RPC, non-zero exit status if < 0
+ * @retval     0       Not a worker process
+ * @note does not return in a worker process
+ */
+int
+backend_worker_exit(int retval)
+{
+    uint32_t errors;
+
+    if (!_worker_child)
+        return 0;
+    errors = _worker_ce->ce_out_rpc_errors - _worker_errors;
+    if (errors && write(_worker_fd, &errors, sizeof(errors)) < 0)
+        retval = -1;
+    _exit(retval < 0 ? 1 : 0); /* Skip atexit handlers, eg pidfile/socket removal */
+}
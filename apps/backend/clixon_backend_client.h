@@ -73,6 +73,8 @@ struct client_entry{
     uint32_t              ce_in_bad_rpcs;    /* Not correct <rpc> messages */
     uint32_t              ce_out_rpc_errors; /*  <rpc-error> messages*/
     uint32_t              ce_out_notifications; /* Outgoing notifications */
+    clixon_msg_rcvbuf    *ce_rcvbuf;  /* Input following last message (pipelined clients) */
+    pid_t                 ce_worker;  /* Read worker process handling request, or 0 */
 };
 typedef struct client_entry client_entry;
 
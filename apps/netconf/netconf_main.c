@@ -91,6 +91,31 @@ static int ignore_packet_errors = 1;
 /* Hello request received */
 static int _netconf_hello_nr = 0;
 
+/* Streamed reply on stdout, see CLICON_REPLY_STREAM_SIZE */
+struct netconf_stream{
+    int                  ns_s;       /* Output socket */
+    netconf_framing_type ns_framing; /* EOM or chunked */
+};
+
+/*! Flush part of streamed reply to output
+ *
+ * @param[in]  arg  Stream struct
+ * @param[in]  buf  Part of reply
+ * @param[in]  len  Length of part
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_writer_new
+ */
+static int
+netconf_stream_flush(void  *arg,
+                     char  *buf,
+                     size_t len)
+{
+    struct netconf_stream *ns = (struct netconf_stream *)arg;
+
+    return netconf_output_part(ns->ns_s, ns->ns_framing, buf, len, 0);
+}
+
 /*! Copy attributes from incoming request to reply. Skip already present (dont overwrite)
  *
  * RFC 6241:
@@ -222,6 +247,9 @@ netconf_rpc_message(clixon_handle h,
     cbuf                *cbret = NULL;
     cxobj               *xc;
     netconf_framing_type framing;
+    clixon_writer       *w = NULL;
+    struct netconf_stream ns;
+    int                  streamsz;
 
     framing = clicon_data_int_get(h, NETCONF_FRAMING_TYPE);
     if (_netconf_hello_nr == 0 &&
@@ -293,16 +321,31 @@ netconf_rpc_message(clixon_handle h,
             clixon_err(OE_XML, errno, "cbuf_new");
             goto done;
         }
+        /* Large replies are written in parts while serialized */
+        if ((streamsz = clicon_option_int(h, "CLICON_REPLY_STREAM_SIZE")) > 0){
+            ns.ns_s = 1;
+            ns.ns_framing = framing;
+            if ((w = clixon_writer_new(cbret, streamsz, netconf_stream_flush, &ns)) == NULL)
+                goto done;
+        }
         if (clixon_xml2cbuf(cbret, xml_child_i(xret,0), 0, 0, NULL, -1, 0) < 0)
             goto done;
-        if (netconf_output_encap(framing, cbret) < 0)
-            goto done;
-        if (netconf_output(1, cbret, "rpc-reply") < 0)
-            goto done;
+        if (w != NULL){
+            if (netconf_output_part(1, framing, cbuf_get(cbret), cbuf_len(cbret), 1) < 0)
+                goto done;
+        }
+        else {
+            if (netconf_output_encap(framing, cbret) < 0)
+                goto done;
+            if (netconf_output(1, cbret, "rpc-reply") < 0)
+                goto done;
+        }
     }
  ok:
     retval = 0;
  done:
+    if (w)
+        clixon_writer_free(w);
     if (cbret)
         cbuf_free(cbret);
     if (xret)
@@ -589,6 +632,7 @@ netconf_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clixon_handle_exit(h);
     clixon_err_exit();
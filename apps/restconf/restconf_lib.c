@@ -442,6 +442,7 @@ restconf_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_err_exit();
     clixon_debug(CLIXON_DBG_RESTCONF, "pid:%u done", getpid());
     restconf_handle_exit(h);
@@ -80,6 +80,7 @@
 
 /* Forward */
 static int restconf_idle_cb(int fd, void *arg);
+static int restconf_idle_timer_unreg(restconf_conn *rc);
 
 /*! Create restconf stream
  *
@@ -221,6 +222,8 @@ restconf_conn_free(restconf_conn *rc)
         clixon_err(OE_RESTCONF, EINVAL, "rc is NULL");
         goto done;
     }
+    /* Timer refers to rc */
+    restconf_idle_timer_unreg(rc);
 #ifdef HAVE_LIBNGHTTP2
     if (rc->rc_ngsession)
         nghttp2_session_del(rc->rc_ngsession);
@@ -1045,7 +1048,7 @@ restconf_connection(int   s,
 static int
 restconf_idle_timer_unreg(restconf_conn *rc)
 {
-    return clixon_event_unreg_timeout(restconf_idle_cb, rc);
+    return clixon_event_unreg_timeout_ref(rc->rc_idle_timer);
 }
 
 /*! Close Restconf native connection socket and unregister callback
@@ -1439,8 +1442,13 @@ restconf_ssl_accept_client(clixon_handle    h,
         break;
     } /* switch proto */
     gettimeofday(&rc->rc_t, NULL); /* activity timer */
-    if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
-        goto done;
+    if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0){
+        /* Close this connection, eg fd exceeds FD_SETSIZE, but continue with others */
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        restconf_close_ssl_socket(rc, __FUNCTION__, 0);
+        clixon_err_reset();
+        goto closed;
+    }
     if (rcp)
         *rcp = rc;
     retval = 1; /* OK, up */
@@ -1456,7 +1464,7 @@ restconf_ssl_accept_client(clixon_handle    h,
 
 static int
 restconf_idle_timer_set(struct timeval t,
-                        void          *arg,
+                        restconf_conn *rc,
                         char          *descr)
 {
     int   retval = -1;
@@ -1467,10 +1475,11 @@ restconf_idle_timer_set(struct timeval t,
         goto done;
     }
     cprintf(cb, "restconf idle timer %s", descr);
-    if (clixon_event_reg_timeout(t,
-                                 restconf_idle_cb,
-                                 arg,
-                                 cbuf_get(cb)) < 0)
+    if (clixon_event_reg_timeout_ref(t,
+                                     restconf_idle_cb,
+                                     rc,
+                                     cbuf_get(cb),
+                                     &rc->rc_idle_timer) < 0)
         goto done;
     retval = 0;
  done:
@@ -64,6 +64,35 @@
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Add hash indexes of large YANG lists and leaf-lists, keyed on list key values
+ *
+ * A hash index is built for a list when a keyed search is made among at least
+ * XML_HASH_INDEX_MIN children, and is then kept up-to-date when children are added or
+ * removed. Searches that would otherwise be binary searches are then made in constant time.
+ */
+#define XML_HASH_INDEX
+
+/*! Minimum number of children of an XML node for a hash index to be built
+ */
+#define XML_HASH_INDEX_MIN 64
+
+/*! Max memory in bytes of XML arenas pinned by nodes moved out of the tree of the arena
+ *
+ * The memory of an arena is kept until all its nodes are freed, also when the top node
+ * of the arena is freed. While more memory than this is pinned, xml_new_arena allocates
+ * nodes from the heap instead.
+ */
+#define XML_ARENA_PINNED_MAX (16*1024*1024)
+
+/*! Number of parsed XPath expressions kept in a cache of most recently used expressions
+ *
+ * XPaths evaluated repeatedly, eg once per list entry, are then parsed once.
+ * XPaths of YANG must, when and leafref path statements are kept with the statement instead,
+ * see yang_xpath_tree_get.
+ * If not set, XPaths are parsed on every evaluation.
+ */
+#define XPATH_CACHE_SIZE 256
+
 /*! Let state data be ordered-by system
  *
  * RFC 7950 is cryptic about this
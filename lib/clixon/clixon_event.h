@@ -54,7 +54,10 @@ int clixon_event_reg_fd_prio(int fd, int (*fn)(int, void*), void *arg, char *str
 int clixon_event_unreg_fd(int s, int (*fn)(int, void*));
 int clixon_event_reg_timeout(struct timeval t,  int (*fn)(int, void*),
                              void *arg, char *str);
+int clixon_event_reg_timeout_ref(struct timeval t,  int (*fn)(int, void*),
+                                 void *arg, char *str, void **ref);
 int clixon_event_unreg_timeout(int (*fn)(int, void*), void *arg);
+int clixon_event_unreg_timeout_ref(void *ref);
 int clixon_event_poll(int fd);
 int clixon_event_loop(clixon_handle h);
 int clixon_event_exit(void);
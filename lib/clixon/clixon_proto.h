@@ -40,9 +40,17 @@
 #ifndef _CLIXON_PROTO_H_
 #define _CLIXON_PROTO_H_
 
+/*
+ * Constants
+ */
+/* Max number of segments of a message, see clixon_msg_send11_iov */
+#define CLIXON_MSG_IOV_MAX 8
+
 /*
  * Types
  */
+struct iovec;
+
 
 /*! Protocol message header (histoorical)
  * Current use is a shim layer for sending packets
@@ -53,6 +61,11 @@ struct clicon_msg {
     char        op_body[0]; /* rest of message, actual data */
 };
 
+/*! Receive buffer of a connection with several outstanding messages, opaque
+ * @see clixon_msg_rcv11_buf
+ */
+typedef struct clixon_msg_rcvbuf clixon_msg_rcvbuf;
+
 /*
  * Prototypes
  */
@@ -73,8 +86,15 @@ int clixon_msg_send10(int s, const char *descr, cbuf *cb);
 int clixon_rpc10(int sock, const char *descr, cbuf *msgin, cbuf *msgret, int *eof);
 
 /* NETCONF 1.1 */
+int clixon_msg_send11_chunk(int s, const char *descr, const struct iovec *iov, int iovcnt, int eom);
+int clixon_msg_send11_iov(int s, const char *descr, const struct iovec *iov, int iovcnt);
+int clixon_msg_send11(int s, const char *descr, cbuf *cb);
 int clixon_msg_rcv11(int s, const char *descr, int intr, cbuf **cb, int *eof);
+clixon_msg_rcvbuf *clixon_msg_rcvbuf_new(void);
+int clixon_msg_rcvbuf_free(clixon_msg_rcvbuf *rb);
+int clixon_msg_rcv11_buf(int s, const char *descr, clixon_msg_rcvbuf *rb, cbuf **cb, int *eof);
 int clicon_rpc(int sock, const char *descr, struct clicon_msg *msg, char **xret, int *eof);
+int clicon_rpc_buf(int sock, const char *descr, struct clicon_msg *msg, clixon_msg_rcvbuf *rb, cbuf **cbret, int *eof);
 int send_msg_reply(int s, const char *descr, char *data, uint32_t datalen);
 int send_msg_notify_xml(clixon_handle h, int s, const char *descr, cxobj *xev);
 
@@ -42,6 +42,28 @@
 #ifndef _CLIXON_PROTO_CLIENT_H_
 #define _CLIXON_PROTO_CLIENT_H_
 
+/*
+ * Types
+ */
+/*! Pipelined backend connection, opaque
+ * @see clicon_rpc_pipe_new
+ */
+typedef struct clicon_rpc_pipe clicon_rpc_pipe;
+
+/*! Completion callback of pipelined request
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xret  Reply as XML tree, freed by caller
+ * @param[in]  arg   Argument given in clicon_rpc_pipe_send
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+typedef int (clicon_rpc_pipe_cb)(clixon_handle h, cxobj *xret, void *arg);
+
+/*
+ * Prototypes
+ */
+
 int clicon_rpc_connect(clixon_handle h, int *sock0);
 int clicon_rpc_msg(clixon_handle h, struct clicon_msg *msg, cxobj **xret0);
 int clicon_rpc_msg_persistent(clixon_handle h, struct clicon_msg *msg, cxobj **xret0, int *sock0);
@@ -71,5 +93,12 @@ int clicon_rpc_debug(clixon_handle h, int level);
 int clicon_rpc_restconf_debug(clixon_handle h, int level);
 int clicon_hello_req(clixon_handle h, char *transport, char *source_host, uint32_t *id);
 int clicon_rpc_restart_plugin(clixon_handle h, char *plugin);
+clicon_rpc_pipe *clicon_rpc_pipe_new(clixon_handle h, int depth);
+int clicon_rpc_pipe_free(clicon_rpc_pipe *cp);
+int clicon_rpc_pipe_fd(clicon_rpc_pipe *cp);
+int clicon_rpc_pipe_outstanding(clicon_rpc_pipe *cp);
+int clicon_rpc_pipe_input(int s, void *arg);
+int clicon_rpc_pipe_send(clicon_rpc_pipe *cp, const char *body, clicon_rpc_pipe_cb *fn, void *arg);
+int clicon_rpc_pipe_drain(clicon_rpc_pipe *cp);
 
 #endif  /* _CLIXON_PROTO_CLIENT_H_ */
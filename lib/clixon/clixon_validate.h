@@ -49,6 +49,7 @@ int xml_yang_validate_add(clixon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_list_key_only(cxobj *xt, cxobj **xret);
 int xml_yang_validate_all(clixon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_all_top(clixon_handle h, cxobj *xt, cxobj **xret);
+int xml_yang_validate_diff_top(clixon_handle h, yang_stmt *yspec, cxobj *xsrc, cxobj *xt, cxobj **xret);
 int rpc_reply_check(clixon_handle h, char *rpcname, cbuf *cbret);
 
 #endif  /* _CLIXON_VALIDATE_H_ */
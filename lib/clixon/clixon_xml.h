@@ -190,6 +190,7 @@ enum format_enum{
     FORMAT_TEXT,
     FORMAT_CLI,
     FORMAT_NETCONF,
+    FORMAT_BINARY,
     FORMAT_DEFAULT
 };
 
@@ -208,6 +209,10 @@ enum format_enum{
 #define XML_FLAG_BODYKEY  0x100 /* Text parsing key to be translated from body to key */
 #define XML_FLAG_ANYDATA  0x200 /* Treat as anydata, eg mount-points before bound */
 #define XML_FLAG_CACHE_DIRTY 0x400 /* This part of XML tree is not synced to disk */
+#define XML_FLAG_MULTI    0x800 /* Multi-file split node loaded from its sub-file */
+#define XML_FLAG_LRU     0x1000 /* Node has LRU list head or link, see xml_lru_touch */
+#define XML_FLAG_VIEW    0x2000 /* Node matched by datastore view, see xmldb_get_view */
+#define XML_FLAG_VIEW_PATH 0x4000 /* Ancestor of node matched by datastore view */
 
 /*
  * Prototypes
@@ -255,6 +260,8 @@ int       xml_childvec_set(cxobj *x, int len);
 cxobj   **xml_childvec_get(cxobj *x);
 int       clixon_child_xvec_append(cxobj *x, clixon_xvec *xv);
 cxobj    *xml_new(char *name, cxobj *xn_parent, enum cxobj_type type);
+cxobj    *xml_new_arena(char *name, enum cxobj_type type);
+int       xml_arena_stats(uint64_t *nr, size_t *pinned);
 cxobj    *xml_new_body(char *name, cxobj *parent, char *val);
 yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
@@ -292,6 +299,11 @@ int       cxvec_prepend(cxobj *x, cxobj ***vec, int *len);
 int       xml_apply(cxobj *xn, enum cxobj_type type, xml_applyfn_t fn, void *arg);
 int       xml_apply0(cxobj *xn, enum cxobj_type type, xml_applyfn_t fn, void *arg);
 int       xml_apply_ancestor(cxobj *xn, xml_applyfn_t fn, void *arg);
+int       xml_lru_touch(cxobj *xt, cxobj *x);
+int       xml_lru_rm(cxobj *x);
+int       xml_lru_len(cxobj *xt);
+cxobj    *xml_lru_last(cxobj *xt);
+cxobj    *xml_lru_prev(cxobj *x);
 int       xml_isancestor(cxobj *x, cxobj *xp);
 cxobj    *xml_root(cxobj *xn);
 int       xml_operation(char *opstr, enum operation_type *op);
@@ -300,11 +312,15 @@ int       xml_attr_insert2val(char *instr, enum insert_type *ins);
 cxobj    *xml_add_attr(cxobj *xn, char *name, char *value, char *prefix, char *ns);
 #ifdef XML_EXPLICIT_INDEX
 int       xml_search_index_p(cxobj *x);
+cxobj    *xml_search_index_leaf(cxobj *xe, char *indexvar);
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
+#endif
+#ifdef XML_HASH_INDEX
+int       xml_hash_index_search(cxobj *xp, yang_stmt *y, cxobj *x1, clixon_xvec *xvec);
 #endif
 
 #endif /* _CLIXON_XML_H */
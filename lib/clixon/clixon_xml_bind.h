@@ -48,6 +48,9 @@ int xml_bind_netconf_message_id_optional(int val);
 int xml_bind_yang_rpc(clixon_handle h, cxobj *xrpc, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang_rpc_reply(clixon_handle h, cxobj *xrpc, char *name, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang0(clixon_handle h, cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_parent(clixon_handle h, cxobj *xt, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_node(clixon_handle h, cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj *xsibling, cxobj **xerr);
+int xml_bind_yang_node_done(cxobj *xt);
 int xml_bind_yang(clixon_handle h, cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_special(cxobj *xd, yang_stmt *yspec, char *schema_nodeid);
 
@@ -43,6 +43,7 @@
 /*
  * Prototypes
  */
+int   xml2output_wdef(cxobj *x, withdefaults_type wdef, int *tag);
 int   clixon_xml2file1(FILE *f, cxobj *xn, int level, int pretty, char *prefix,
                        clicon_output_cb *fn, int skiptop, int autocliext, withdefaults_type wdef,
                        int multi);
@@ -54,6 +55,8 @@ int   xml_print(FILE *f, cxobj *xn);
 int   xml_dump(FILE  *f, cxobj *x);
 int   clixon_xml2cbuf1(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix,
                        int32_t depth, int skiptop, withdefaults_type wdef);
+int   clixon_xml2cbuf_marked(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix,
+                             int32_t depth, int skiptop, withdefaults_type wdef);
 int   clixon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix, int32_t depth, 
 int skiptop);
 int   xmltree2cbuf(cbuf *cb, cxobj *x, int level);
@@ -41,6 +41,8 @@
 /*
  * Prototypes
  */
+int xml_cv_cache(cxobj *x, cg_var **cvp);
+int xml_cv_cache_bind(cxobj *x);
 int xml_cmp(cxobj *x1, cxobj *x2, int same, int skip1, char *expl);
 int xml_sort(cxobj *x);
 int xml_sort_by(cxobj *x, char *indexvar);
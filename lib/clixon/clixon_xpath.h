@@ -135,6 +135,10 @@ xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
+int   xpath_vec_ctx_tree(cxobj *xcur, cvec *nsc, xpath_tree *xptree, int localonly, xp_ctx **xrp);
+int   xpath_vec_tree(cxobj *xcur, cvec *nsc, xpath_tree *xptree, cxobj ***vec, size_t *veclen);
+int   xpath_vec_bool_tree(cxobj *xcur, cvec *nsc, xpath_tree *xptree);
+void  xpath_cache_exit(void);
 
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
 int    xpath_vec_flag(cxobj *xcur, cvec *nsc, const char *xpformat, uint16_t flags,
@@ -38,10 +38,29 @@
 #ifndef _CLIXON_XPATH_OPTIMIZE_H
 #define _CLIXON_XPATH_OPTIMIZE_H
 
+/*
+ * Types
+ */
+/* Optimization plans of xpath steps, see xpath_list_optimize_stats */
+enum xpath_plan{
+    XPATH_PLAN_KEY,        /* List entry found using all keys */
+    XPATH_PLAN_KEY_PREFIX, /* Range of list entries found using leading keys */
+    XPATH_PLAN_INDEX,      /* List entries found using explicit search index */
+    XPATH_PLAN_DESCENDANT, /* Descendant search skipping subtrees using YANG */
+    XPATH_PLAN_NR
+};
+
+struct xpath_descendant; /* Descendant search cache, opaque */
 
-int  xpath_list_optimize_stats(int *hits);
+/*
+ * Prototypes
+ */
+int  xpath_list_optimize_stats(int *hits, int *plans);
 int  xpath_list_optimize_set(int enable);
 void xpath_optimize_exit(void);
 int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
+int  xpath_optimize_descendant(xpath_tree *nodetest, struct xpath_descendant **xdp);
+int  xpath_optimize_descendant_prune(struct xpath_descendant *xd, cxobj *x);
+void xpath_optimize_descendant_free(struct xpath_descendant *xd);
 
 #endif /* _CLIXON_XPATH_OPTIMIZE_H */
@@ -100,6 +100,11 @@
                                       * may be different from orig, therefore do not use link to
                                       * original. May also be due to deviations of derived trees
                                       */
+#define YANG_FLAG_DEPS       0x4000 /* (Dynamic) Constraints of this node may be affected by
+                                      * changes, see yang_deps_mark
+                                      */
+#define YANG_FLAG_DEPS_PATH  0x8000 /* (Dynamic) Ancestor of node marked with YANG_FLAG_DEPS
+                                      */
 /*! Names of top-level data YANGs
  */
 #define YANG_DATA_TOP   "data"    /* "dbspec" */
@@ -206,6 +211,7 @@ enum yang_class{
 typedef enum yang_class yang_class;
 
 struct xml;
+struct xpath_tree;
 
 /* This is the external handle type exposed in the API.
  * The internal struct is defined in clixon_yang_internal.h */
@@ -276,6 +282,8 @@ uint32_t   yang_linenum_get(yang_stmt *ys);
 int        yang_linenum_set(yang_stmt *ys, uint32_t linenum);
 void      *yang_typecache_get(yang_stmt *ys);
 int        yang_typecache_set(yang_stmt *ys, void *ycache);
+int        yang_xpath_tree_get(yang_stmt *ys, struct xpath_tree **xptree);
+int        yang_xpath_tree_set(yang_stmt *ys, struct xpath_tree *xptree);
 yang_stmt* yang_mymodule_get(yang_stmt *ys);
 int        yang_mymodule_set(yang_stmt *ys, yang_stmt *ym);
 
@@ -343,6 +351,11 @@ int        yang_single_child_type(yang_stmt *ys, enum rfc_6020 subkeyw);
 void      *yang_action_cb_get(yang_stmt *ys);
 int        yang_action_cb_add(yang_stmt *ys, void *rc);
 int        ys_populate_feature(clixon_handle h, yang_stmt *ys);
+#ifdef XML_EXPLICIT_INDEX
+int        yang_list_index_add(yang_stmt *ys);
+int        yang_search_index_path(yang_stmt *ys, void *arg);
+yang_stmt *yang_search_index_leaf(yang_stmt *ylist, char *path);
+#endif
 int        yang_init(clixon_handle h);
 int        yang_exit(clixon_handle h);
 
@@ -84,6 +84,8 @@
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
+#include "clixon_datastore_multi.h"
 
 /*! Get xml database element including id, xml cache, empty on startup and dirty bit
  *
@@ -320,19 +322,17 @@ xmldb_copy(clixon_handle h,
         xml_free(x2);
         x2 = NULL;
     }
-    else  if (x2 == NULL){ /* create x2 and copy from x1 */
+    else { /* create x2 and copy from x1 */
+        if (x2 != NULL)
+            xml_free(x2);
         if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
             goto done;
         xml_flag_set(x2, XML_FLAG_TOP);
         if (xml_copy(x1, x2) < 0) 
             goto done;
-    }
-    else{ /* copy x1 to x2 */
-        xml_free(x2);
-        if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
-            goto done;
-        xml_flag_set(x2, XML_FLAG_TOP);
-        if (xml_copy(x1, x2) < 0) 
+        /* Loaded sub-files, see CLICON_XMLDB_MULTI */
+        if (clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+            xmldb_multi_relink(x2, x2) < 0)
             goto done;
     }
     /* always set cache although not strictly necessary in case 1
@@ -359,7 +359,23 @@ xmldb_copy(clixon_handle h,
         goto done;
     if (xmldb_db2file(h, to, &tofile) < 0)
         goto done;
-    if (clicon_file_copy(fromfile, tofile) < 0)
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+        /* Snapshots are replaced, never rewritten, so they can be shared */
+        if (xmldb_file_link(fromfile, tofile) < 0)
+            goto done;
+    }
+    else if (xmldb_file_replace(h)){
+        if (xmldb_file_copy(fromfile, tofile) < 0)
+            goto done;
+    }
+    else{
+        if (xmldb_file_unshare(tofile) < 0)
+            goto done;
+        if (clicon_file_copy(fromfile, tofile) < 0)
+            goto done;
+    }
+    if (xmldb_journal_copy(h, from, to) < 0)
         goto done;
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")) {
         if (xmldb_db2subdir(h, from, &fromdir) < 0)
@@ -592,8 +608,12 @@ xmldb_delete(clixon_handle h,
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
     if (xmldb_clear(h, db) < 0)
         goto done;
+    if (xmldb_journal_remove(h, db) < 0)
+        goto done;
     if (xmldb_db2file(h, db, &filename) < 0)
         goto done;
+    if (xmldb_file_unshare(filename) < 0)
+        goto done;
     if (lstat(filename, &st) == 0)
         if (truncate(filename, 0) < 0){
             clixon_err(OE_DB, errno, "truncate %s", filename);
@@ -919,6 +939,8 @@ xmldb_rename(clixon_handle h,
     char  *old;
     char  *fname = NULL;
     cbuf  *cb = NULL;
+    cbuf  *cbj = NULL;
+    char  *jfile = NULL;
 
     if ((xmldb_db2file(h, db, &old)) < 0)
         goto done;
@@ -936,8 +958,29 @@ xmldb_rename(clixon_handle h,
         clixon_err(OE_UNIX, errno, "rename: %s", strerror(errno));
         goto done;
     };
+    /* Move journal along with file, if any */
+    if ((cbj = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbj, "%s%s", old, XMLDB_JOURNAL_SUFFIX);
+    jfile = strdup(cbuf_get(cbj));
+    cbuf_reset(cbj);
+    cprintf(cbj, "%s%s", fname, XMLDB_JOURNAL_SUFFIX);
+    if (jfile == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (rename(jfile, cbuf_get(cbj)) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "rename(%s)", jfile);
+        goto done;
+    }
     retval = 0;
  done:
+    if (jfile)
+        free(jfile);
+    if (cbj)
+        cbuf_free(cbj);
     if (cb)
         cbuf_free(cb);
     if (old)
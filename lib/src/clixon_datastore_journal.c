@@ -0,0 +1,815 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Datastore edit journal, see CLICON_XMLDB_JOURNAL
+ *
+ * Instead of rewriting the whole datastore file on every edit, xmldb_put appends the
+ * edit to a journal file next to the datastore file, eg candidate_db.journal.
+ * The datastore file is then a snapshot, and the journal is replayed on top of it when
+ * the datastore is read. When the journal grows larger than the snapshot, the cache
+ * is written to a new snapshot and the journal is removed (compaction).
+ *
+ * Journal file format:
+ *   clixon-journal <inode>\n
+ *   <len>\n<edit operation="<op>" xmlns...><config>...</config></edit>\n
+ *   ...
+ * where <inode> identifies the snapshot the journal applies to. A snapshot is never
+ * rewritten in place in journal mode, it is replaced by rename. If the inode does not
+ * match, the journal is stale, eg the process was interrupted after a snapshot was
+ * written but before the journal was removed.
+ * <len> is the length of the edit entry. A truncated last entry, eg from an
+ * interrupted write, is ignored.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <dirent.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_string.h"
+#include "clixon_file.h"
+#include "clixon_options.h"
+#include "clixon_xml_sort.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_io.h"
+#include "clixon_xml_bind.h"
+#include "clixon_datastore.h"
+#include "clixon_datastore_write.h"
+#include "clixon_datastore_journal.h"
+
+/* First token of journal header line */
+#define XMLDB_JOURNAL_MAGIC "clixon-journal"
+
+/* Journal is not compacted until it is at least this size, to avoid rewriting small datastores
+ * on every edit */
+#define XMLDB_JOURNAL_MIN 65536
+
+/*! Translate from symbolic database name to journal filename
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Journal filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ */
+static int
+xmldb_journal_file(clixon_handle h,
+                   const char   *db,
+                   char        **filename)
+{
+    int   retval = -1;
+    char *dbfile = NULL;
+    cbuf *cb = NULL;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s%s", dbfile, XMLDB_JOURNAL_SUFFIX);
+    if ((*filename = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Serialize an edit as a journal entry
+ *
+ * Must be called before the edit is applied, since text_modify removes operation
+ * attributes from the modification tree.
+ * Namespace declarations in the context of x1 are added to the entry, so that it can be
+ * parsed standalone.
+ * @param[in]  op    Default operation
+ * @param[in]  x1    Modification tree, top-level is <config>, or NULL
+ * @param[out] cbp   Journal entry. Free with cbuf_free
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_journal_append
+ */
+int
+xmldb_journal_entry(enum operation_type op,
+                    cxobj              *x1,
+                    cbuf              **cbp)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cvec   *nsc = NULL;
+    cg_var *cv = NULL;
+    char   *prefix;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<edit operation=\"%s\"", xml_operation2str(op));
+    if (x1 != NULL){
+        if (xml_nsctx_node(x1, &nsc) < 0)
+            goto done;
+        while ((cv = cvec_each(nsc, cv)) != NULL){
+            if ((prefix = cv_name_get(cv)) == NULL)
+                cprintf(cb, " xmlns=\"");
+            else
+                cprintf(cb, " xmlns:%s=\"", prefix);
+            if (xml_chardata_cbuf_append(cb, 1, cv_string_get(cv)) < 0)
+                goto done;
+            cprintf(cb, "\"");
+        }
+    }
+    cprintf(cb, ">");
+    if (x1 != NULL &&
+        clixon_xml2cbuf(cb, x1, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    cprintf(cb, "</edit>");
+    *cbp = cb;
+    cb = NULL;
+    retval = 0;
+ done:
+    if (nsc)
+        cvec_free(nsc);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Append an edit entry to the journal of a datastore and sync it to disk
+ *
+ * Creates the journal with a header identifying the current snapshot if it does not exist
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name, eg "candidate", "running"
+ * @param[in]  cbe  Journal entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_journal_entry
+ */
+int
+xmldb_journal_append(clixon_handle h,
+                     const char   *db,
+                     cbuf         *cbe)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    char       *jfile = NULL;
+    cbuf       *cb = NULL;
+    int         fd = -1;
+    struct stat st = {0,};
+    char       *buf;
+    size_t      len;
+    ssize_t     n;
+    off_t       size;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (xmldb_journal_file(h, db, &jfile) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((fd = open(jfile, O_WRONLY|O_APPEND|O_CREAT, S_IRUSR|S_IWUSR)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", jfile);
+        goto done;
+    }
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", jfile);
+        goto done;
+    }
+    size = st.st_size;
+    if (size == 0){
+        if (stat(dbfile, &st) < 0){
+            clixon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+            goto done;
+        }
+        cprintf(cb, "%s %" PRIuMAX "\n", XMLDB_JOURNAL_MAGIC, (uintmax_t)st.st_ino);
+    }
+    cprintf(cb, "%zu\n%s\n", cbuf_len(cbe), cbuf_get(cbe));
+    buf = cbuf_get(cb);
+    len = cbuf_len(cb);
+    while (len > 0){
+        if ((n = write(fd, buf, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "write(%s)", jfile);
+            /* Remove partial entry, if any */
+            if (ftruncate(fd, size) < 0)
+                clixon_log(h, LOG_WARNING, "ftruncate(%s): %s", jfile, strerror(errno));
+            goto done;
+        }
+        buf += n;
+        len -= n;
+    }
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", jfile);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (cb)
+        cbuf_free(cb);
+    if (jfile)
+        free(jfile);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Check if journal is due for compaction
+ *
+ * The journal is compacted when it is larger than the snapshot and XMLDB_JOURNAL_MIN.
+ * This keeps the cost of rewriting the snapshot proportional to the size of the edits
+ * since the last one.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name, eg "candidate", "running"
+ * @retval     1    Journal is larger than snapshot, compact
+ * @retval     0    No compaction needed
+ * @retval    -1    Error
+ */
+int
+xmldb_journal_full(clixon_handle h,
+                   const char   *db)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    char       *jfile = NULL;
+    struct stat st = {0,};
+    off_t       jsize;
+
+    if (xmldb_journal_file(h, db, &jfile) < 0)
+        goto done;
+    if (stat(jfile, &st) < 0){
+        retval = 0;
+        goto done;
+    }
+    if ((jsize = st.st_size) < XMLDB_JOURNAL_MIN){
+        retval = 0;
+        goto done;
+    }
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (stat(dbfile, &st) < 0)
+        st.st_size = 0;
+    retval = jsize > st.st_size;
+ done:
+    if (jfile)
+        free(jfile);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Replay one journal entry on top of a datastore tree
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  str    Journal entry
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  xt     Datastore XML tree, top-level is <config>
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      YANG binding of entry failed, xerr set
+ * @retval    -1      Error
+ */
+static int
+xmldb_journal_replay1(clixon_handle h,
+                      char         *str,
+                      yang_stmt    *yspec,
+                      cxobj        *xt,
+                      cxobj       **xerr)
+{
+    int                 retval = -1;
+    cxobj              *xj = NULL;
+    cxobj              *xe;
+    cxobj              *xc;
+    char               *opstr;
+    enum operation_type op = OP_MERGE;
+    cbuf               *cbret = NULL;
+    int                 ret;
+
+    if (clixon_xml_parse_string(str, YB_NONE, yspec, &xj, NULL) < 0)
+        goto done;
+    if ((xe = xml_find_type(xj, NULL, "edit", CX_ELMNT)) == NULL){
+        clixon_err(OE_DB, 0, "Journal entry without edit element");
+        goto done;
+    }
+    if ((opstr = xml_find_value(xe, "operation")) != NULL &&
+        xml_operation(opstr, &op) < 0)
+        goto done;
+    if ((xc = xml_find_type(xe, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) != NULL){
+        if ((ret = xml_bind_yang(h, xc, YB_MODULE, yspec, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (xml_sort_recurse(xc) < 0)
+            goto done;
+    }
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = xmldb_put_tree(h, xt, xc, yspec, op, NULL, NULL, 1, cbret)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_DB, 0, "Journal replay failed: %s", cbuf_get(cbret));
+        goto done;
+    }
+    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                  (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_CACHE_DIRTY)) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    if (xj)
+        xml_free(xj);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Replay journal of a datastore on top of a tree read from its snapshot
+ *
+ * The tree is bound to YANG if it is not already. A stale journal is removed. A truncated
+ * last entry, eg from a crash during append, is ignored and cut from the journal so that
+ * later entries are appended after the last complete entry.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  xt     XML tree read from snapshot, top-level is <config>
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK, journal replayed or no journal
+ * @retval     0      YANG binding failed, xerr set
+ * @retval    -1      Error
+ * @note The journal is replayed also if CLICON_XMLDB_JOURNAL is not set
+ */
+int
+xmldb_journal_replay(clixon_handle h,
+                     const char   *db,
+                     yang_stmt    *yspec,
+                     cxobj        *xt,
+                     cxobj       **xerr)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    char       *jfile = NULL;
+    FILE       *f = NULL;
+    char       *line = NULL;
+    size_t      linesz = 0;
+    char       *buf = NULL;
+    size_t      len;
+    uintmax_t   ino;
+    struct stat st = {0,};
+    cxobj      *x;
+    int         nr = 0;
+    off_t       off;   /* End of last complete entry */
+    int         truncated = 0;
+    int         ret;
+
+    if (xmldb_journal_file(h, db, &jfile) < 0)
+        goto done;
+    if ((f = fopen(jfile, "r")) == NULL){
+        if (errno == ENOENT)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "fopen(%s)", jfile);
+        goto done;
+    }
+    if (getline(&line, &linesz, f) < 0)
+        goto ok; /* empty */
+    if (line[strlen(line)-1] != '\n'){ /* truncated header, no entries */
+        clixon_log(h, LOG_WARNING, "%s: truncated journal removed", jfile);
+        if (unlink(jfile) < 0){
+            clixon_err(OE_UNIX, errno, "unlink(%s)", jfile);
+            goto done;
+        }
+        goto ok;
+    }
+    if (sscanf(line, XMLDB_JOURNAL_MAGIC " %ju", &ino) != 1){
+        clixon_err(OE_DB, 0, "%s: bad journal header", jfile);
+        goto done;
+    }
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (stat(dbfile, &st) < 0){
+        clixon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+        goto done;
+    }
+    if (st.st_ino != ino){
+        clixon_log(h, LOG_WARNING, "%s: stale journal, removed", jfile);
+        if (unlink(jfile) < 0){
+            clixon_err(OE_UNIX, errno, "unlink(%s)", jfile);
+            goto done;
+        }
+        goto ok;
+    }
+    if ((x = xml_child_i_type(xt, 0, CX_ELMNT)) != NULL && xml_spec(x) == NULL){
+        if ((ret = xml_bind_yang(h, xt, YB_MODULE, yspec, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (xml_sort_recurse(xt) < 0)
+            goto done;
+    }
+    off = ftello(f);
+    while (getline(&line, &linesz, f) > 0){
+        if (line[strlen(line)-1] != '\n'){
+            truncated++;
+            break;
+        }
+        if (sscanf(line, "%zu", &len) != 1){
+            clixon_err(OE_DB, 0, "%s: bad journal entry length", jfile);
+            goto done;
+        }
+        if ((buf = malloc(len + 1)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        /* An entry is complete only with its terminating newline */
+        if (fread(buf, 1, len, f) != len || fgetc(f) != '\n'){
+            truncated++;
+            break;
+        }
+        buf[len] = '\0';
+        if ((ret = xmldb_journal_replay1(h, buf, yspec, xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        free(buf);
+        buf = NULL;
+        nr++;
+        off = ftello(f);
+    }
+    if (truncated){
+        clixon_log(h, LOG_WARNING, "%s: truncated journal entry removed", jfile);
+        if (truncate(jfile, off) < 0){
+            clixon_err(OE_UNIX, errno, "truncate(%s)", jfile);
+            goto done;
+        }
+    }
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s: %d journal entries replayed", db, nr);
+ ok:
+    retval = 1;
+ done:
+    if (buf)
+        free(buf);
+    if (line)
+        free(line);
+    if (f)
+        fclose(f);
+    if (jfile)
+        free(jfile);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Remove journal of a datastore, if any
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name, eg "candidate", "running"
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_journal_remove(clixon_handle h,
+                     const char   *db)
+{
+    int   retval = -1;
+    char *jfile = NULL;
+
+    if (xmldb_journal_file(h, db, &jfile) < 0)
+        goto done;
+    if (unlink(jfile) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", jfile);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
+/*! Copy journal from one datastore to another
+ *
+ * The target datastore file must already be a copy or link of the source file.
+ * The journal header is rewritten to refer to the target file.
+ * If source has no journal, the journal of the target is removed
+ * @param[in]  h     Clixon handle
+ * @param[in]  from  Source datastore
+ * @param[in]  to    Destination datastore
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_journal_copy(clixon_handle h,
+                   const char   *from,
+                   const char   *to)
+{
+    int         retval = -1;
+    char       *fromfile = NULL;
+    char       *tofile = NULL;
+    char       *dbfile = NULL;
+    FILE       *fin = NULL;
+    FILE       *fout = NULL;
+    char       *line = NULL;
+    size_t      linesz = 0;
+    char        buf[4096];
+    size_t      n;
+    struct stat st = {0,};
+
+    if (xmldb_journal_file(h, from, &fromfile) < 0)
+        goto done;
+    if (xmldb_journal_file(h, to, &tofile) < 0)
+        goto done;
+    if ((fin = fopen(fromfile, "r")) == NULL ||
+        getline(&line, &linesz, fin) < 0){
+        if (unlink(tofile) < 0 && errno != ENOENT){
+            clixon_err(OE_UNIX, errno, "unlink(%s)", tofile);
+            goto done;
+        }
+        goto ok;
+    }
+    if (xmldb_db2file(h, to, &dbfile) < 0)
+        goto done;
+    if (stat(dbfile, &st) < 0){
+        clixon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+        goto done;
+    }
+    if ((fout = fopen(tofile, "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", tofile);
+        goto done;
+    }
+    fprintf(fout, "%s %" PRIuMAX "\n", XMLDB_JOURNAL_MAGIC, (uintmax_t)st.st_ino);
+    while ((n = fread(buf, 1, sizeof(buf), fin)) > 0)
+        if (fwrite(buf, 1, n, fout) != n){
+            clixon_err(OE_UNIX, errno, "fwrite(%s)", tofile);
+            goto done;
+        }
+    if (fflush(fout) != 0 || fsync(fileno(fout)) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", tofile);
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (line)
+        free(line);
+    if (fin)
+        fclose(fin);
+    if (fout)
+        fclose(fout);
+    if (dbfile)
+        free(dbfile);
+    if (fromfile)
+        free(fromfile);
+    if (tofile)
+        free(tofile);
+    return retval;
+}
+
+/*! Prepare datastore file for in-place rewrite: unlink it if hard-linked to other datastores
+ *
+ * Snapshots may be shared between datastores in journal mode, see xmldb_file_link
+ * @param[in]  filename  Datastore file
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+int
+xmldb_file_unshare(const char *filename)
+{
+    struct stat st = {0,};
+
+    if (lstat(filename, &st) == 0 && st.st_nlink > 1){
+        if (unlink(filename) < 0){
+            clixon_err(OE_UNIX, errno, "unlink(%s)", filename);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*! Make datastore file a hard link to another datastore file, copy if link fails
+ *
+ * Used in journal mode where snapshots are replaced, never rewritten in place
+ * @param[in]  from  Source datastore file
+ * @param[in]  to    Destination datastore file
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_file_link(const char *from,
+                const char *to)
+{
+    if (unlink(to) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", to);
+        return -1;
+    }
+    if (link(from, to) < 0)
+        return clicon_file_copy((char*)from, (char*)to);
+    return 0;
+}
+
+/*! Datastore files are replaced by rename instead of rewritten in place
+ *
+ * In journal mode the journal refers to the snapshot and snapshots may be linked to
+ * other datastores. With worker processes, a worker may read the file concurrently.
+ * Replacing a file requires write access to XMLDB_DIR.
+ * @param[in]  h  Clixon handle
+ * @retval     1  Replace datastore files by rename
+ * @retval     0  Rewrite datastore files in place
+ */
+int
+xmldb_file_replace(clixon_handle h)
+{
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI"))
+        return 0;
+    return clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") ||
+        clicon_option_int(h, "CLICON_BACKEND_READ_WORKERS") > 0;
+}
+
+/*! Get names of file to replace and of temporary file to rename to it
+ *
+ * Symlinks are resolved so that the target is replaced, not the link itself
+ * @param[in]  filename  Datastore file
+ * @param[out] realfile  File to replace, free after use
+ * @param[out] tmpfile   Temporary file, free after use
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+int
+xmldb_file_tmp(const char *filename,
+               char      **realfile,
+               char      **tmpfile)
+{
+    char  *rf = NULL;
+    size_t len;
+
+    if ((rf = realpath(filename, NULL)) == NULL){
+        if (errno != ENOENT){
+            clixon_err(OE_UNIX, errno, "realpath(%s)", filename);
+            return -1;
+        }
+        if ((rf = strdup(filename)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            return -1;
+        }
+    }
+    len = strlen(rf) + strlen(".tmp") + 1;
+    if ((*tmpfile = malloc(len)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        free(rf);
+        return -1;
+    }
+    snprintf(*tmpfile, len, "%s.tmp", rf);
+    *realfile = rf;
+    return 0;
+}
+
+/*! Give temporary file the mode and owner of the datastore file it replaces
+ *
+ * @param[in]  filename  Datastore file, may not exist
+ * @param[in]  fd        Open temporary file
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+int
+xmldb_file_attr_copy(const char *filename,
+                     int         fd)
+{
+    struct stat st = {0,};
+    struct stat st1 = {0,};
+
+    if (stat(filename, &st) < 0){
+        if (errno == ENOENT)
+            return 0;
+        clixon_err(OE_UNIX, errno, "stat(%s)", filename);
+        return -1;
+    }
+    if (fstat(fd, &st1) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        return -1;
+    }
+    if ((st1.st_uid != st.st_uid || st1.st_gid != st.st_gid) &&
+        fchown(fd, st.st_uid, st.st_gid) < 0){
+        clixon_err(OE_UNIX, errno, "fchown(%s)", filename);
+        return -1;
+    }
+    if (fchmod(fd, st.st_mode & 07777) < 0){
+        clixon_err(OE_UNIX, errno, "fchmod(%s)", filename);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Copy datastore file by writing a temporary file and renaming it
+ *
+ * The destination is never rewritten in place, a concurrent reader, eg a backend
+ * worker process, sees either the old or the new file
+ * @param[in]  from  Source datastore file
+ * @param[in]  to    Destination datastore file
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_file_replace
+ */
+int
+xmldb_file_copy(const char *from,
+                const char *to)
+{
+    int   retval = -1;
+    char *realfile = NULL;
+    char *tmpfile = NULL;
+    int   fd = -1;
+
+    if (xmldb_file_tmp(to, &realfile, &tmpfile) < 0)
+        goto done;
+    if (clicon_file_copy((char*)from, tmpfile) < 0)
+        goto done;
+    if ((fd = open(tmpfile, O_RDONLY)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", tmpfile);
+        goto done;
+    }
+    if (xmldb_file_attr_copy(realfile, fd) < 0)
+        goto done;
+    if (rename(tmpfile, realfile) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", realfile);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (retval < 0 && tmpfile)
+        unlink(tmpfile);
+    if (tmpfile)
+        free(tmpfile);
+    if (realfile)
+        free(realfile);
+    return retval;
+}
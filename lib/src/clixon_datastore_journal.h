@@ -0,0 +1,62 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Datastore edit journal
+ * @see clixon_datastore_journal.c
+ */
+#ifndef _CLIXON_DATASTORE_JOURNAL_H
+#define _CLIXON_DATASTORE_JOURNAL_H
+
+/*
+ * Constants
+ */
+/* Journal file is datastore file with this suffix, eg candidate_db.journal */
+#define XMLDB_JOURNAL_SUFFIX ".journal"
+
+/*
+ * Prototypes
+ */
+int xmldb_journal_entry(enum operation_type op, cxobj *x1, cbuf **cbp);
+int xmldb_journal_append(clixon_handle h, const char *db, cbuf *cbe);
+int xmldb_journal_full(clixon_handle h, const char *db);
+int xmldb_journal_replay(clixon_handle h, const char *db, yang_stmt *yspec, cxobj *xt, cxobj **xerr);
+int xmldb_journal_remove(clixon_handle h, const char *db);
+int xmldb_journal_copy(clixon_handle h, const char *from, const char *to);
+int xmldb_file_unshare(const char *filename);
+int xmldb_file_link(const char *from, const char *to);
+int xmldb_file_replace(clixon_handle h);
+int xmldb_file_tmp(const char *filename, char **realfile, char **tmpfile);
+int xmldb_file_attr_copy(const char *filename, int fd);
+int xmldb_file_copy(const char *from, const char *to);
+
+#endif /* _CLIXON_DATASTORE_JOURNAL_H */
@@ -0,0 +1,690 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Lazy loading of multi-file datastore sub-files, see CLICON_XMLDB_MULTI
+ *
+ * A multi-file datastore is split at YANG nodes with the xmldb-split extension. The
+ * top-level file contains a stub for each such node on the form:
+ *   <root xmlns:cl="http://clicon.org/lib" cl:link="<digest>.xml"/>
+ * where <digest> is computed from the xpath of the node, and the sub-file in the datastore
+ * directory contains its children.
+ * When a datastore is read, the stubs are kept in the cache, and a sub-file is loaded only
+ * when an xpath in xmldb_get or an edit in xmldb_put reaches it.
+ * The number of loaded sub-trees in a cache can be bounded by CLICON_XMLDB_MULTI_RESIDENT.
+ * Beyond that, the least recently used sub-trees that are in sync with their sub-file are
+ * evicted, ie turned into stubs again.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_string.h"
+#include "clixon_map.h"
+#include "clixon_data.h"
+#include "clixon_options.h"
+#include "clixon_digest.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_default.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_io.h"
+#include "clixon_json.h"
+#include "clixon_xml_bind.h"
+#include "clixon_datastore.h"
+#include "clixon_datastore_multi.h"
+
+/*! Mark loaded sub-tree as most recently used
+ *
+ * Loaded sub-trees are kept in the LRU list of the cache tree, see xml_lru_touch
+ * @param[in]  x    Loaded split node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_multi_touch(cxobj *x)
+{
+    return xml_lru_touch(xml_root(x), x);
+}
+
+/*! Check if XML node is a stub of a sub-tree that is not loaded
+ *
+ * @param[in]  x    XML node
+ * @retval     1    Stub, ie has a link attribute
+ * @retval     0    Not a stub
+ */
+int
+xmldb_multi_stub(cxobj *x)
+{
+    return xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR) != NULL;
+}
+
+/*! Remove all children of a split node except attributes and list keys
+ *
+ * @param[in]  x    Split node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_multi_purge(cxobj *x)
+{
+    int        i;
+    cxobj     *xc;
+    yang_stmt *y;
+
+    y = xml_spec(x);
+    for (i = xml_child_nr(x) - 1; i >= 0; i--){
+        xc = xml_child_i(x, i);
+        if (xml_type(xc) == CX_ATTR)
+            continue;
+        if (y && yang_keyword_get(y) == Y_LIST &&
+            xml_type(xc) == CX_ELMNT &&
+            yang_key_match(y, xml_name(xc), NULL) == 1)
+            continue;
+        if (xml_purge(xc) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Mark split node as loaded, ie it has been written to its sub-file
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @param[in]  x    Split node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_multi_write_applyfn
+ */
+int
+xmldb_multi_mark(clixon_handle h,
+                 const char   *db,
+                 cxobj        *x)
+{
+    if (xml_flag(x, XML_FLAG_MULTI) == 0){
+        xml_flag_set(x, XML_FLAG_MULTI);
+        if (xmldb_multi_touch(x) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Load the sub-file of a stub into the cache
+ *
+ * The stub is bound to YANG when the top-level file is read. The children read from the
+ * sub-file are bound from the stub (including mount-points), sorted and populated with
+ * default values.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @param[in]  x    Stub node with link attribute
+ * @param[out] xerr XML error if retval is 0
+ * @retval     1    OK
+ * @retval     0    Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1    Error
+ */
+int
+xmldb_multi_load(clixon_handle h,
+                 const char   *db,
+                 cxobj        *x,
+                 cxobj       **xerr)
+{
+    int              retval = -1;
+    cxobj           *xa;
+    char            *filename;
+    char            *subdir = NULL;
+    cbuf            *cb = NULL;
+    char            *dbfile;
+    FILE            *fp = NULL;
+    char            *formatstr;
+    enum format_enum format;
+    yang_stmt       *yspec;
+    int              ret;
+
+    if ((xa = xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR)) == NULL ||
+        (filename = xml_value(xa)) == NULL)
+        goto ok;
+    yspec = clicon_dbspec_yang(h);
+    if ((formatstr = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
+        clixon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
+        goto done;
+    }
+    format = format_str2int(formatstr);
+    if (xmldb_db2subdir(h, db, &subdir) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s/%s", subdir, filename);
+    dbfile = cbuf_get(cb);
+    clixon_debug(CLIXON_DBG_DATASTORE, "Parsing: %s", dbfile);
+    if ((fp = fopen(dbfile, "r")) == NULL){
+        clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+        goto done;
+    }
+    /* Remove link and any default values added to the stub */
+    if (xmldb_multi_purge(x) < 0)
+        goto done;
+    if (xml_purge(xa) < 0)
+        goto done;
+    if ((xa = xml_find_type(x, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR)) != NULL)
+        if (xml_purge(xa) < 0)
+            goto done;
+    switch (format){
+    case FORMAT_JSON:
+        if (clixon_json_parse_file(fp, 1, YB_NONE, yspec, &x, xerr) < 0)
+            goto done;
+        break;
+    case FORMAT_XML:
+        if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x, xerr) < 0)
+            goto done;
+        break;
+    default:
+        clixon_err(OE_DB, 0, "Format %s not supported", formatstr);
+        goto done;
+        break;
+    }
+    if (xml_spec(x) != NULL){
+        /* Mount-point without children may have been treated as anydata */
+        xml_flag_reset(x, XML_FLAG_ANYDATA);
+        if ((ret = xml_bind_yang_parent(h, x, yspec, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (xml_sort_recurse(x) < 0)
+            goto done;
+        if (xml_default_recurse(x, 0, 0) < 0)
+            goto done;
+    }
+    if (xmldb_multi_mark(h, db, x) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    if (fp)
+        fclose(fp);
+    if (cb)
+        cbuf_free(cb);
+    if (subdir)
+        free(subdir);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Load all stubs in a sub-tree
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @param[in]  x    XML tree
+ * @param[out] xerr XML error if retval is 0
+ * @retval     1    OK
+ * @retval     0    Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1    Error
+ */
+int
+xmldb_multi_load_all(clixon_handle h,
+                     const char   *db,
+                     cxobj        *x,
+                     cxobj       **xerr)
+{
+    int    retval = -1;
+    cxobj *xc;
+    int    ret;
+
+    if (xmldb_multi_stub(x)){
+        if ((ret = xmldb_multi_load(h, db, x, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    else if (xml_flag(x, XML_FLAG_MULTI)){
+        if (xmldb_multi_touch(x) < 0)
+            goto done;
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if ((ret = xmldb_multi_load_all(h, db, xc, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Load stubs matching an xpath, and mark loaded sub-trees as used
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @param[in]  xt    XML tree
+ * @param[in]  nsc   XML namespace context for XPath
+ * @param[in]  xpath XPath
+ * @param[out] xerr  XML error if retval is 0
+ * @retval     1     OK
+ * @retval     0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error
+ */
+static int
+xmldb_multi_load_match(clixon_handle h,
+                       const char   *db,
+                       cxobj        *xt,
+                       cvec         *nsc,
+                       const char   *xpath,
+                       cxobj       **xerr)
+{
+    int     retval = -1;
+    cxobj **xvec = NULL;
+    size_t  xlen;
+    int     i;
+    cxobj  *x;
+    int     ret;
+
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+        goto done;
+    for (i=0; i<xlen; i++){
+        x = xvec[i];
+        if (xmldb_multi_stub(x)){
+            if ((ret = xmldb_multi_load(h, db, x, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        else if (xml_flag(x, XML_FLAG_MULTI)){
+            if (xmldb_multi_touch(x) < 0)
+                goto done;
+        }
+    }
+    retval = 1;
+ done:
+    if (xvec)
+        free(xvec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Load the stubs that an xpath reaches, and all stubs below the matching nodes
+ *
+ * A simple absolute xpath, eg /a/b[k='x']/c, is evaluated step by step: first /a,
+ * then /a/b, /a/b[k='x']/c, etc, loading stubs on the way so that the next step and its
+ * predicates see the loaded children.
+ * Otherwise, eg "/", descendants, reverse axes and unions, all stubs are loaded.
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @param[in]  xt    XML tree
+ * @param[in]  nsc   XML namespace context for XPath
+ * @param[in]  xpath XPath, or NULL for all
+ * @param[out] xerr  XML error if retval is 0
+ * @retval     1     OK
+ * @retval     0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error
+ */
+int
+xmldb_multi_load_xpath(clixon_handle h,
+                       const char   *db,
+                       cxobj        *xt,
+                       cvec         *nsc,
+                       const char   *xpath,
+                       cxobj       **xerr)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen;
+    size_t  len;
+    size_t  i;
+    size_t  b;       /* End of step name, ie start of predicates */
+    int     depth = 0;
+    char    quote = 0;
+    char    c;
+    int     ret;
+
+    if (xpath == NULL || xpath[0] != '/' || strcmp(xpath, "/") == 0 ||
+        strstr(xpath, "//") != NULL || strstr(xpath, "..") != NULL ||
+        strstr(xpath, "::") != NULL || strchr(xpath, '|') != NULL)
+        return xmldb_multi_load_all(h, db, xt, xerr);
+    len = strlen(xpath);
+    /* Paths in predicates may reach below the step, load all */
+    for (i=0; i<len; i++){
+        c = xpath[i];
+        if (quote){
+            if (c == quote)
+                quote = 0;
+        }
+        else if (c == '\'' || c == '"')
+            quote = c;
+        else if (c == '[')
+            depth++;
+        else if (c == ']')
+            depth--;
+        else if (c == '/' && depth > 0)
+            return xmldb_multi_load_all(h, db, xt, xerr);
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    /* For each step, evaluate prefix up to the step name */
+    i = 1;
+    while (i < len){
+        b = 0;
+        for (; i<len; i++){
+            c = xpath[i];
+            if (quote){
+                if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '\'' || c == '"')
+                quote = c;
+            else if (c == '['){
+                if (depth++ == 0 && b == 0)
+                    b = i;
+            }
+            else if (c == ']')
+                depth--;
+            else if (c == '/' && depth == 0)
+                break;
+        }
+        if (b == 0)
+            b = i;
+        cbuf_reset(cb);
+        cprintf(cb, "%.*s", (int)b, xpath);
+        if ((ret = xmldb_multi_load_match(h, db, xt, nsc, cbuf_get(cb), xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        i++;
+    }
+    /* Then load all below the matching nodes */
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+        goto done;
+    for (i=0; i<xlen; i++){
+        if ((ret = xmldb_multi_load_all(h, db, xvec[i], xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    if (xvec)
+        free(xvec);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Load the stubs that an edit reaches
+ *
+ * Walk the modification tree x1 and the cache x0 in parallel and load stubs on the way.
+ * Where an operation attribute is set, or if the default operation is not merge or none,
+ * the sub-tree is loaded completely, since it may be replaced or checked for existence.
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @param[in]  x0    Cache XML tree
+ * @param[in]  x1    Modification XML tree
+ * @param[in]  op    Default operation
+ * @param[in]  nacm  NACM write access is checked, load all
+ * @param[out] xerr  XML error if retval is 0
+ * @retval     1     OK
+ * @retval     0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error
+ * @see xmldb_put
+ */
+int
+xmldb_multi_load_edit(clixon_handle       h,
+                      const char         *db,
+                      cxobj              *x0,
+                      cxobj              *x1,
+                      enum operation_type op,
+                      int                 nacm,
+                      cxobj             **xerr)
+{
+    int        retval = -1;
+    cxobj     *x1c;
+    cxobj     *x0c;
+    yang_stmt *yc;
+    int        ret;
+
+    if (x0 == NULL || x1 == NULL)
+        goto ok;
+    if (nacm || (op != OP_MERGE && op != OP_NONE))
+        return xmldb_multi_load_all(h, db, x0, xerr);
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+        if ((yc = xml_spec(x1c)) == NULL)
+            continue;
+        x0c = NULL;
+        if (match_base_child(x0, x1c, yc, &x0c) < 0)
+            goto done;
+        if (x0c == NULL)
+            continue;
+        if (xml_find_type(x1c, NULL, "operation", CX_ATTR) != NULL)
+            ret = xmldb_multi_load_all(h, db, x0c, xerr);
+        else{
+            if (xmldb_multi_stub(x0c)){
+                if ((ret = xmldb_multi_load(h, db, x0c, xerr)) < 0)
+                    goto done;
+                if (ret == 0)
+                    goto fail;
+            }
+            else if (xml_flag(x0c, XML_FLAG_MULTI)){
+                if (xmldb_multi_touch(x0c) < 0)
+                    goto done;
+            }
+            ret = xmldb_multi_load_edit(h, db, x0c, x1c, op, nacm, xerr);
+        }
+        if (ret < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Add loaded sub-trees of a copied cache tree to its LRU list
+ *
+ * A copy of a cache tree, eg by xmldb_copy, has the loaded split nodes but not the
+ * LRU list. The order of use is not copied, sub-trees are added in document order.
+ * @param[in]  xt   Top of cache XML tree
+ * @param[in]  x    XML node in xt, start with xt
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_multi_relink(cxobj *xt,
+                   cxobj *x)
+{
+    cxobj *xc;
+
+    if (x != xt && xml_flag(x, XML_FLAG_MULTI))
+        if (xml_lru_touch(xt, x) < 0)
+            return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+        if (xmldb_multi_relink(xt, xc) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Evict a loaded sub-tree, ie replace it with a stub
+ *
+ * Only if the sub-tree is in sync with its sub-file
+ * @param[in]  h       Clixon handle
+ * @param[in]  subdir  Datastore sub-directory
+ * @param[in]  x       Loaded split node
+ * @retval     1       Evicted
+ * @retval     0       Not evicted
+ * @retval    -1       Error
+ */
+static int
+xmldb_multi_evict1(clixon_handle h,
+                   const char   *subdir,
+                   cxobj        *x)
+{
+    int         retval = -1;
+    char       *xpath = NULL;
+    char       *hexstr = NULL;
+    cbuf       *cb = NULL;
+    struct stat st = {0,};
+
+    if (xml_flag(x, XML_FLAG_CACHE_DIRTY))
+        goto skip;
+    if (xml2xpath(x, NULL, 1, 0, &xpath) < 0)
+        goto done;
+    if (clixon_digest_hex(xpath, &hexstr) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s/%s.xml", subdir, hexstr);
+    if (lstat(cbuf_get(cb), &st) < 0)
+        goto skip;
+    clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "Evict: %s", xpath);
+    if (xmldb_multi_purge(x) < 0)
+        goto done;
+    cbuf_reset(cb);
+    cprintf(cb, "%s.xml", hexstr);
+    if (xml_add_attr(x, "link", cbuf_get(cb), CLIXON_LIB_PREFIX, CLIXON_LIB_NS) == NULL)
+        goto done;
+    xml_flag_reset(x, XML_FLAG_MULTI);
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (hexstr)
+        free(hexstr);
+    if (xpath)
+        free(xpath);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! Evict least recently used sub-trees beyond CLICON_XMLDB_MULTI_RESIDENT
+ *
+ * Loaded sub-trees are evicted from the tail of the LRU list of the cache tree.
+ * Modified sub-trees that are not yet written to their sub-file are kept, as well as all
+ * sub-trees of volatile datastores.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_multi_evict(clixon_handle h,
+                  const char   *db)
+{
+    int    retval = -1;
+    int    max;
+    cxobj *xt;
+    cxobj *x;
+    cxobj *xp;
+    cxobj *xn;
+    char  *subdir = NULL;
+    int    ret;
+
+    if ((max = clicon_option_int(h, "CLICON_XMLDB_MULTI_RESIDENT")) <= 0)
+        goto ok;
+    if (xmldb_volatile_get(h, db))
+        goto ok;
+    if ((xt = xmldb_cache_get(h, db)) == NULL)
+        goto ok;
+    if (xml_lru_len(xt) <= max)
+        goto ok;
+    if (xmldb_db2subdir(h, db, &subdir) < 0)
+        goto done;
+    x = xml_lru_last(xt);
+    while (x != NULL && xml_lru_len(xt) > max){
+        xp = xml_lru_prev(x);
+        /* Next candidate if x is evicted: sub-trees of x are then freed */
+        xn = xp;
+        while (xn != NULL && xml_isancestor(xn, x))
+            xn = xml_lru_prev(xn);
+        if ((ret = xmldb_multi_evict1(h, subdir, x)) < 0)
+            goto done;
+        if (ret == 1){
+            xml_lru_rm(x);
+            xp = xn;
+        }
+        x = xp;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (subdir)
+        free(subdir);
+    return retval;
+}
@@ -75,6 +75,7 @@
 #include "clixon_nacm.h"
 #include "clixon_path.h"
 #include "clixon_netconf_lib.h"
+#include "clixon_xml_bin.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_parse_lib.h"
 #include "clixon_xml_map.h"
@@ -83,20 +84,11 @@
 #include "clixon_xml_nsctx.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
+#include "clixon_datastore_multi.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
-/* Local types */
-/* Argument to apply for recursive call to xmldb_multi calls 
- * @see xmldb_multi_write_arg
- */
-struct xmldb_multi_read_arg {
-    char            *mr_subdir;
-    yang_stmt       *mr_yspec;
-    enum format_enum mr_format;
-    cxobj          **mr_xerr;
-};
-
 /*! Ensure that xt only has a single sub-element and that is "config" 
  *
  * @retval     0     There exists a single "config" sub-element
@@ -463,68 +455,6 @@ disable_nacm_on_empty(cxobj     *xt,
     return retval;
 }
 
-/*! Callback function for xmldb-multi read
- *
- * Look for link attribute in XML, and if found open the linked file for parsing
- * @param[in]  x    XML node
- * @param[in]  arg
- * @retval     2    Locally abort this subtree, continue with others
- * @retval     1    Abort, dont continue with others, return 1 to end user
- * @retval     0    OK, continue
- * @retval    -1    Error, aborted at first error encounter, return -1 to end user
- */
-static int
-xmldb_multi_read_applyfn(cxobj *x,
-                         void  *arg)
-{
-    struct xmldb_multi_read_arg *mr = (struct xmldb_multi_read_arg *) arg;
-    int                     retval = -1;
-    cxobj                  *xa;
-    char                   *filename;
-    cbuf                   *cb = NULL;
-    char                   *dbfile;
-    FILE                   *fp = NULL;
-
-    if ((xa = xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR)) != NULL &&
-        (filename = xml_value(xa)) != NULL){
-        if ((cb = cbuf_new()) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-        cprintf(cb, "%s/%s", mr->mr_subdir, filename);
-        xml_purge(xa);
-        if ((xa = xml_find_type(x, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR)) != NULL)
-            xml_purge(xa);
-        dbfile = cbuf_get(cb);
-        clixon_debug(CLIXON_DBG_DATASTORE, "Parsing: %s", dbfile);
-        if ((fp = fopen(dbfile, "r")) == NULL){
-            clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
-            goto done;
-        }
-        switch (mr->mr_format){
-        case FORMAT_JSON:
-            if (clixon_json_parse_file(fp, 1, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
-                goto done;
-            break;
-        case FORMAT_XML:
-            if (clixon_xml_parse_file(fp, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
-                goto done;
-            break;
-        default:
-            clixon_err(OE_DB, 0, "Format not supported");
-            goto done;
-            break;
-        }
-    }
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    if (fp)
-        fclose(fp);
-    return retval;
-}
-
 /*! Common read function that reads an XML tree from file
  *
  * @param[in]  th     Datastore text handle
@@ -569,7 +499,7 @@ xmldb_readfile(clixon_handle    h,
     cxobj           *xmodfile = NULL;
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
-    struct xmldb_multi_read_arg mr = {0, };
+    int              bound = 0;      /* Bound when read, see FORMAT_BINARY */
 
     if (yb != YB_MODULE && yb != YB_NONE){
         clixon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
@@ -610,20 +540,17 @@ xmldb_readfile(clixon_handle    h,
         if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        /* Bind directly from pre-resolved schema ids, fallback to xml_bind_yang below */
+        if ((bound = clixon_bin_parse_file(fp, yb==YB_MODULE?yspec:NULL, &x0)) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_DB, 0, "Format %s not supported", formatstr);
         goto done;
         break;
     }
-    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
-        if (xmldb_db2subdir(h, db, &mr.mr_subdir) < 0)
-            goto done;
-        mr.mr_format = format;
-        mr.mr_yspec = yspec;
-        mr.mr_xerr = xerr;
-        if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_read_applyfn, &mr) < 0)
-            goto done;
-    }
+    /* With CLICON_XMLDB_MULTI, sub-file links are kept as stubs, see xmldb_multi_load */
     /* Always assert a top-level called "config". 
      * To ensure that, deal with two cases:
      * 1. File is empty <top/> -> rename top-level to "config" 
@@ -726,14 +653,24 @@ xmldb_readfile(clixon_handle    h,
             }
         } /* if msdiff */
         /* xml looks like: <top><config><x>... actually YB_MODULE_NEXT 
+         * Binary format is already bound and sorted if written with same yang modules
          */
-        if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        if (xml_sort_recurse(x0) < 0)
-            goto done;
+        if (!bound){
+            if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (xml_sort_recurse(x0) < 0)
+                goto done;
+        }
     }
+    /* Replay edits appended since file was written, see CLICON_XMLDB_JOURNAL */
+    if ((ret = xmldb_journal_replay(h, db, yspec1?yspec1:yspec, x0, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (de && xml_child_nr(x0) != 0)
+        de->de_empty = 0;
     if (xp){
         *xp = x0;
         x0 = NULL;
@@ -745,8 +682,6 @@ xmldb_readfile(clixon_handle    h,
     }
     retval = 1;
  done:
-    if (mr.mr_subdir)
-        free(mr.mr_subdir);
     if (yspec1)
         ys_free1(yspec1, 1);
     if (xmodfile)
@@ -765,18 +700,14 @@ xmldb_readfile(clixon_handle    h,
     goto done;
 }
 
-/*! Get content of database using xpath. return a set of matching sub-trees
+/*! Get cached XML tree of a database, read it from file if not cached
  *
- * The function returns a minimal tree that includes all sub-trees that match
- * xpath.
- * This is a clixon datastore plugin of the the xmldb api
  * @param[in]  h      Clixon handle
  * @param[in]  db     Name of database to search in (filename including dir path
  * @param[in]  yb     How to bind yang to XML top-level when parsing
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPath syntax. or NULL for all
- * @param[in]  wdef   With-defaults parameter, see RFC 6243
- * @param[out] xret   Single return XML tree. Free with xml_free()
+ * @param[out] xtp    Cached XML tree, do not free
  * @param[out] msdiff If set, return modules-state differences
  * @param[out] xerr   XML error if retval is 0
  * @retval     1      OK
@@ -784,33 +715,22 @@ xmldb_readfile(clixon_handle    h,
  * @retval    -1      Error
  */
 static int
-xmldb_get_cache(clixon_handle     h,
-                const char       *db,
-                yang_bind         yb,
-                cvec             *nsc,
-                const char       *xpath,
-                withdefaults_type wdef,
-                cxobj           **xret,
-                modstate_diff_t  *msdiff,
-                cxobj           **xerr)
+xmldb_get_cache_top(clixon_handle     h,
+                    const char       *db,
+                    yang_bind         yb,
+                    cvec             *nsc,
+                    const char       *xpath,
+                    cxobj           **xtp,
+                    modstate_diff_t  *msdiff,
+                    cxobj           **xerr)
 {
     int        retval = -1;
     yang_stmt *yspec;
     cxobj     *x0t = NULL; /* (cached) top of tree */
-    cxobj     *x0;
-    cxobj    **xvec = NULL;
-    size_t     xlen;
-    int        i;
     db_elmnt  *de = NULL;
-    cxobj     *x1t = NULL;
     db_elmnt   de0 = {0,};
     int        ret;
 
-    clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
-    if (xret == NULL){
-        clixon_err(OE_DB, EINVAL, "xret is NULL");
-        return -1;
-    }
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_YANG, ENOENT, "No yang spec");
         goto done;
@@ -842,6 +762,98 @@ xmldb_get_cache(clixon_handle     h,
     } /* x0t == NULL */
     else
         x0t = de->de_xml;
+    /* Load sub-files reached by xpath */
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+        if ((ret = xmldb_multi_load_xpath(h, db, x0t, nsc, xpath, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    *xtp = x0t;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Mark nodes in a view: XML_FLAG_VIEW on matching nodes and XML_FLAG_VIEW_PATH on ancestors
+ *
+ * The view flags are only set by views, and are all reset when the view is released, so that
+ * ancestors already marked are on a marked path to the top
+ * @param[in]  xvec   Vector of matching nodes
+ * @param[in]  xlen   Length of vector
+ * @see xmldb_view_release
+ */
+static void
+xmldb_view_mark(cxobj **xvec,
+                size_t  xlen)
+{
+    int    i;
+    cxobj *x;
+
+    for (i=0; i<xlen; i++){
+        xml_flag_set(xvec[i], XML_FLAG_VIEW);
+        x = xvec[i];
+        while ((x = xml_parent(x)) != NULL && xml_flag(x, XML_FLAG_VIEW_PATH) == 0)
+            xml_flag_set(x, XML_FLAG_VIEW_PATH);
+    }
+}
+
+/*! Get content of database using xpath. return a set of matching sub-trees
+ *
+ * The function returns a minimal tree that includes all sub-trees that match
+ * xpath.
+ * This is a clixon datastore plugin of the the xmldb api
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of database to search in (filename including dir path
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[in]  wdef   With-defaults parameter, see RFC 6243
+ * @param[out] xret   Single return XML tree. Free with xml_free()
+ * @param[out] msdiff If set, return modules-state differences
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ * @see xmldb_get_view  Zero-copy variant
+ */
+static int
+xmldb_get_cache(clixon_handle     h,
+                const char       *db,
+                yang_bind         yb,
+                cvec             *nsc,
+                const char       *xpath,
+                withdefaults_type wdef,
+                cxobj           **xret,
+                modstate_diff_t  *msdiff,
+                cxobj           **xerr)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    cxobj     *x0t = NULL; /* (cached) top of tree */
+    cxobj     *x0;
+    cxobj    **xvec = NULL;
+    size_t     xlen;
+    int        i;
+    cxobj     *x1t = NULL;
+    int        ret;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
+    if (xret == NULL){
+        clixon_err(OE_DB, EINVAL, "xret is NULL");
+        return -1;
+    }
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if ((ret = xmldb_get_cache_top(h, db, yb, nsc, xpath, &x0t, msdiff, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
     /* Here x0t looks like: <config>...</config> */
     /* Given the xpath, return a vector of matches in xvec 
      * Can we do everything in one go?
@@ -853,9 +865,10 @@ xmldb_get_cache(clixon_handle     h,
      */
     if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
         goto done;
-    // XXX: Remove copying and return x0 eventually
-    /* Make new tree by copying top-of-tree from x0t to x1t */
-    if ((x1t = xml_new(xml_name(x0t), NULL, CX_ELMNT)) == NULL)
+    /* Make new tree by copying top-of-tree from x0t to x1t
+     * Read-only consumers may avoid the copy, see xmldb_get_view
+     * The copy is allocated from an arena, it is usually freed after use */
+    if ((x1t = xml_new_arena(xml_name(x0t), CX_ELMNT)) == NULL)
         goto done;
     xml_flag_set(x1t, XML_FLAG_TOP);
     xml_spec_set(x1t, xml_spec(x0t));
@@ -873,7 +886,6 @@ xmldb_get_cache(clixon_handle     h,
     else {
         /* Iterate through the match vector
          * For every node found in x0, mark the tree up to t1
-         * XXX can we do this directly from xvec?
          */
         for (i=0; i<xlen; i++){
             x0 = xvec[i];
@@ -887,6 +899,11 @@ xmldb_get_cache(clixon_handle     h,
         if (xml_apply(x1t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
             goto done;
     }
+    /* Bound number of loaded sub-files */
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+        if (xmldb_multi_evict(h, db) < 0)
+            goto done;
+    }
     /* If empty NACM config, then disable NACM if loaded
      */
     if (clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
@@ -906,6 +923,107 @@ xmldb_get_cache(clixon_handle     h,
     goto done;
 }
 
+/*! Get a read-only view of the content of a database using xpath, zero-copy variant of xmldb_get0
+ *
+ * Instead of copying matching sub-trees to a new tree, return the cached tree where
+ * matching nodes are marked with XML_FLAG_VIEW and their ancestors with XML_FLAG_VIEW_PATH.
+ * The view is valid until xmldb_view_release is called, and the database must not be
+ * modified in between. The cached tree is not to be modified or freed.
+ * Print the view using clixon_xml2cbuf_marked.
+ * Values are reported as WITHDEFAULTS_REPORT_ALL, ie filter on output.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of database to search in, eg "running"
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[out] xtp    Cached XML tree, do not free
+ * @param[out] xvecp  Vector of matching nodes. Free with free() after release
+ * @param[out] xlenp  Length of vector
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ * @code
+ *   if ((ret = xmldb_get_view(h, "running", nsc, xpath, &xt, &xvec, &xlen, &xerr)) < 0)
+ *      err;
+ *   if (ret == 1){
+ *      clixon_xml2cbuf_marked(cb, xt, 0, 0, NULL, -1, 1, WITHDEFAULTS_REPORT_ALL);
+ *      xmldb_view_release(h, "running", xvec, xlen);
+ *   }
+ *   if (xvec)
+ *      free(xvec);
+ * @endcode
+ * @see xmldb_get0  Copy variant
+ */
+int
+xmldb_get_view(clixon_handle h,
+               const char   *db,
+               cvec         *nsc,
+               const char   *xpath,
+               cxobj       **xtp,
+               cxobj      ***xvecp,
+               size_t       *xlenp,
+               cxobj       **xerr)
+{
+    int    retval = -1;
+    cxobj *x0t = NULL;
+    int    ret;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
+    if (xtp == NULL || xvecp == NULL || xlenp == NULL){
+        clixon_err(OE_DB, EINVAL, "xtp, xvecp or xlenp is NULL");
+        goto done;
+    }
+    if ((ret = xmldb_get_cache_top(h, db, YB_MODULE, nsc, xpath, &x0t, NULL, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (xpath_vec(x0t, nsc, "%s", xvecp, xlenp, xpath?xpath:"/") < 0)
+        goto done;
+    xmldb_view_mark(*xvecp, *xlenp);
+    *xtp = x0t;
+    retval = 1;
+ done:
+    clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Release a view of a database
+ *
+ * Reset view flags on matching nodes and their ancestors.
+ * Other flags of the cached tree, eg set by edits and validation, are not used by views
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of database, or NULL
+ * @param[in]  xvec   Vector of matching nodes, see xmldb_get_view
+ * @param[in]  xlen   Length of vector
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xmldb_view_release(clixon_handle h,
+                   const char   *db,
+                   cxobj       **xvec,
+                   size_t        xlen)
+{
+    int    i;
+    cxobj *x;
+
+    for (i=0; i<xlen; i++){
+        xml_flag_reset(xvec[i], XML_FLAG_VIEW);
+        x = xvec[i];
+        while ((x = xml_parent(x)) != NULL && xml_flag(x, XML_FLAG_VIEW_PATH))
+            xml_flag_reset(x, XML_FLAG_VIEW_PATH);
+    }
+    /* Bound number of loaded sub-files */
+    if (db && clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+        if (xmldb_multi_evict(h, db) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 /*! Get content of datastore and return a copy of the XML tree
  *
  * @param[in]  h      Clixon handle
@@ -76,6 +76,7 @@
 #include "clixon_json.h"
 #include "clixon_nacm.h"
 #include "clixon_netconf_lib.h"
+#include "clixon_xml_bin.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_schema_mount.h"
@@ -87,10 +88,12 @@
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
+#include "clixon_datastore_multi.h"
 
 /* Local types */
 /* Argument to apply for recursive call to xmldb_multi write calls
- * @see xmldb_multi_read_arg
+ * @see xmldb_multi_load
 */
 struct xmldb_multi_write_arg {
     clixon_handle    *mw_h;
@@ -1303,6 +1306,76 @@ xml_mark_cache_dirty(cxobj *x,
     return 2;
 }
 
+/*! Modify a datastore tree in memory with a modification tree
+ *
+ * Apply edit, remove NONE nodes and empty non-presence containers, and add defaults.
+ * Nodes are left flagged with ADD/DEL/CHANGE/CACHE_DIRTY, caller resets flags.
+ * @param[in]  h        Clixon handle
+ * @param[in]  x0       Datastore tree, top-level is <config>
+ * @param[in]  x1       Modification tree, top-level is <config>
+ * @param[in]  yspec    Top-level yang spec
+ * @param[in]  op       Top-level operation, can be superceded by other op in tree
+ * @param[in]  username User name for nacm
+ * @param[in]  xnacm    NACM XML tree (only if !permit)
+ * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[out] cbret    Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1        OK
+ * @retval     0        Failed, cbret contains error xml message
+ * @retval    -1        Error
+ * @see xmldb_put
+ * @see xmldb_journal_replay
+ */
+int
+xmldb_put_tree(clixon_handle       h,
+               cxobj              *x0,
+               cxobj              *x1,
+               yang_stmt          *yspec,
+               enum operation_type op,
+               char               *username,
+               cxobj              *xnacm,
+               int                 permit,
+               cbuf               *cbret)
+{
+    int retval = -1;
+    int ret;
+
+    /*
+     * Modify base tree x with modification x1. This is where the
+     * new tree is made.
+     */
+    if ((ret = text_modify_top(h, x0, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+        goto done;
+    /* If xml return - ie netconf error xml tree, then stop and return OK */
+    if (ret == 0)
+        goto fail;
+    /* Remove NONE nodes if all subs recursively are also NONE */
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+        goto done;
+    /* Mark ancestor if any changes to children. */
+    if (xml_apply(x0, CX_ELMNT, xml_mark_added_ancestors, (void*)(XML_FLAG_ADD|XML_FLAG_DEL)) < 0)
+        goto done;
+    /* Mark changed xml as cache dirty */
+    if (xml_apply(x0, CX_ELMNT, xml_mark_cache_dirty, NULL) < 0)
+        goto done;
+    /* Remove empty non-presence containers recursively.
+     */
+    if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+        goto done;
+    /* Complete defaults in incoming x1
+     */
+    if (xml_global_defaults(h, x0, NULL, "/", yspec, 0) < 0)
+        goto done;
+    /* Add default recursive values */
+    if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -1344,9 +1417,10 @@ xmldb_put(clixon_handle       h,
     int         ret;
     cxobj      *xnacm = NULL;
     int         permit = 0; /* nacm permit all */
-    cvec       *nsc = NULL; /* nacm namespace context */
     int         firsttime = 0;
     cxobj      *xerr = NULL;
+    cbuf       *cbj = NULL; /* journal entry, see CLICON_XMLDB_JOURNAL */
+    int         compact = 1;
 
     clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
     if (cbret == NULL){
@@ -1385,11 +1459,28 @@ xmldb_put(clixon_handle       h,
     permit = (xnacm==NULL);
     /* Here assume if xnacm is set and !permit do NACM */
     clicon_data_del(h, "objectexisted");
-    /*
-     * Modify base tree x with modification x1. This is where the
-     * new tree is made.
-     */
-    if ((ret = text_modify_top(h, x0, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+    /* Journal entry must be made before edit since operation attributes are stripped */
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+        xmldb_volatile_get(h, db) == 0){
+        if (xmldb_journal_entry(op, x1, &cbj) < 0)
+            goto done;
+    }
+    /* Load sub-files reached by edit */
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+        if ((ret = xmldb_multi_load_edit(h, db, x0, x1, op, !permit, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            if (firsttime && x0){
+                xml_free(x0);
+                x0 = NULL;
+            }
+            goto fail;
+        }
+    }
+    if ((ret = xmldb_put_tree(h, x0, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
         goto done;
     /* If xml return - ie netconf error xml tree, then stop and return OK */
     if (ret == 0){
@@ -1400,26 +1491,6 @@ xmldb_put(clixon_handle       h,
         }
         goto fail;
     }
-    /* Remove NONE nodes if all subs recursively are also NONE */
-    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
-        goto done;
-    /* Mark ancestor if any changes to children. */
-    if (xml_apply(x0, CX_ELMNT, xml_mark_added_ancestors, (void*)(XML_FLAG_ADD|XML_FLAG_DEL)) < 0)
-        goto done;
-    /* Mark changed xml as cache dirty */
-    if (xml_apply(x0, CX_ELMNT, xml_mark_cache_dirty, NULL) < 0)
-        goto done;
-    /* Remove empty non-presence containers recursively.
-     */
-    if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
-        goto done;
-    /* Complete defaults in incoming x1
-     */
-    if (xml_global_defaults(h, x0, nsc, "/", yspec, 0) < 0)
-        goto done;
-    /* Add default recursive values */
-    if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
-        goto done;
     /* Write back to datastore cache if first time */
     if (de != NULL)
         de0 = *de;
@@ -1429,12 +1500,24 @@ xmldb_put(clixon_handle       h,
     clicon_db_elmnt_set(h, db, &de0);
     /* Write cache to file unless volatile (ie stop syncing to store) */
     if (xmldb_volatile_get(h, db) == 0){
-        if (xmldb_write_cache2file(h, db) < 0)
+        /* Append edit to journal, write whole cache only if journal is larger than file */
+        if (cbj != NULL){
+            if (xmldb_journal_append(h, db, cbj) < 0)
+                goto done;
+            if ((compact = xmldb_journal_full(h, db)) < 0)
+                goto done;
+        }
+        if (compact &&
+            xmldb_write_cache2file(h, db) < 0)
             goto done;
         /* Clear flags from previous steps + dirty */
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                       (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_CACHE_DIRTY)) < 0)
             goto done;
+        /* Bound number of loaded sub-files */
+        if (clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+            xmldb_multi_evict(h, db) < 0)
+            goto done;
     }
     else {
         /* Clear flags from previous steps */
@@ -1447,8 +1530,8 @@ xmldb_put(clixon_handle       h,
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
     if (xerr)
         xml_free(xerr);
-    if (nsc)
-        xml_nsctx_free(nsc);
+    if (cbj)
+        cbuf_free(cbj);
     return retval;
  fail:
     retval = 0;
@@ -1483,6 +1566,11 @@ xmldb_multi_write_applyfn(cxobj *x,
     int           fd = -1;
     FILE         *fsub = NULL;
 
+    /* Not loaded, sub-file is unchanged */
+    if (xmldb_multi_stub(x)){
+        retval = 2;
+        goto done;
+    }
     if (xml_child_nr_type(x, CX_ELMNT) > 0 &&
         (y = xml_spec(x)) != NULL){
         if (yang_extension_value(y, "xmldb-split", CLIXON_LIB_NS, &exist, NULL) < 0)
@@ -1515,6 +1603,9 @@ xmldb_multi_write_applyfn(cxobj *x,
                 if (clixon_xml2file1(fsub, x, 0, mw->mw_pretty, NULL, fprintf, 1, 0, mw->mw_wdef, 0) < 0)
                     goto done;
             }
+            /* Sub-tree is now in sync with sub-file and may be evicted */
+            if (xmldb_multi_mark(h, mw->mw_db, x) < 0)
+                goto done;
             retval = 2; /* Locally abort */
             goto done;
         }
@@ -1599,6 +1690,14 @@ xmldb_dump(clixon_handle     h,
         if (clixon_json2file(f, xt, pretty, fprintf, 0, 0) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        if (multi){
+            clixon_err(OE_CFG, 0, "Binary+multi not supported");
+            goto done;
+        }
+        if (clixon_bin2file(f, xt, clicon_dbspec_yang(h), wdef) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_XML, 0, "Format %s not supported", format_int2str(format));
         goto done;
@@ -1631,8 +1730,11 @@ xmldb_write_cache2file(clixon_handle h,
     withdefaults_type wdef = WITHDEFAULTS_EXPLICIT;
     int               pretty;
     int               multi;
+    int               journal;
     FILE             *f = NULL;
     char             *dbfile = NULL;
+    char             *realfile = NULL;
+    char             *tmpfile = NULL;
 
     if ((xt = xmldb_cache_get(h, db)) == NULL){
         clixon_err(OE_XML, 0, "XML cache not found");
@@ -1646,19 +1748,60 @@ xmldb_write_cache2file(clixon_handle h,
             goto done;
         }
     }
+    journal = !multi && clicon_option_bool(h, "CLICON_XMLDB_JOURNAL");
     if (xmldb_db2file(h, db, &dbfile) < 0)
         goto done;
-    if ((f = fopen(dbfile, "w")) == NULL){
-        clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
-        goto done;
+    if (xmldb_file_replace(h)){
+        /* Write to temporary file and rename, do not rewrite the datastore file in place:
+         * a worker process may read it concurrently, and in journal mode the snapshot
+         * may be linked to other datastores and the journal refers to it */
+        if (xmldb_file_tmp(dbfile, &realfile, &tmpfile) < 0)
+            goto done;
+        if ((f = fopen(tmpfile, "w")) == NULL){
+            clixon_err(OE_CFG, errno, "fopen(%s)", tmpfile);
+            goto done;
+        }
+        if (xmldb_file_attr_copy(realfile, fileno(f)) < 0)
+            goto done;
+    }
+    else {
+        if (xmldb_file_unshare(dbfile) < 0)
+            goto done;
+        if ((f = fopen(dbfile, "w")) == NULL){
+            clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+            goto done;
+        }
     }
     if (xmldb_dump(h, f, xt, format, pretty, wdef, multi, db) < 0)
         goto done;
+    if (fflush(f) != 0){
+        clixon_err(OE_UNIX, errno, "fflush(%s)", dbfile);
+        goto done;
+    }
+    if (journal && fsync(fileno(f)) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", dbfile);
+        goto done;
+    }
+    fclose(f);
+    f = NULL;
+    if (tmpfile && rename(tmpfile, realfile) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", realfile);
+        goto done;
+    }
+    /* File is now complete, any journal is obsolete */
+    if (xmldb_journal_remove(h, db) < 0)
+        goto done;
     retval = 0;
  done:
-    if (dbfile)
-        free(dbfile);
     if (f)
         fclose(f);
+    if (retval < 0 && tmpfile)
+        unlink(tmpfile);
+    if (tmpfile)
+        free(tmpfile);
+    if (realfile)
+        free(realfile);
+    if (dbfile)
+        free(dbfile);
     return retval;
 }
@@ -45,6 +45,8 @@
 /*
  * Prototypes
  */
+int xmldb_put_tree(clixon_handle h, cxobj *x0, cxobj *x1, yang_stmt *yspec, enum operation_type op,
+                   char *username, cxobj *xnacm, int permit, cbuf *cbret);
 int xmldb_put(clixon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
 int xmldb_write_cache2file(clixon_handle h, const char *db);
 int xmldb_dump(clixon_handle h, FILE *f, cxobj *xt, enum format_enum format, int pretty, withdefaults_type wdef, int multi, const char *multidb);
@@ -47,12 +47,17 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <string.h>
 #include <signal.h>
 #include <syslog.h>
 #include <sys/param.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -74,17 +79,29 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of ready file descriptors returned by one epoll_wait */
+#define EVENT_EPOLL_MAX 64
+
+/* Event flags */
+#define EVENT_FLAG_EPOLL  0x01 /* FD is registered in epoll set */
+#define EVENT_FLAG_ALWAYS 0x02 /* FD not supported by epoll (eg regular file): always ready */
+
 /*
  * Types
  */
 struct event_data{
     struct event_data          *e_next;                 /* Next in list */
+    struct event_data          *e_fdnext;               /* Next FD event of same fd (epoll only) */
     int                       (*e_fn)(int, void*);      /* Callback function */
     enum {EVENT_FD, EVENT_TIME} e_type;                 /* Type of event */
     int                         e_fd;                   /* File descriptor */
     int                         e_prio;                 /* 1: high-prio FD:s only*/
+    int                         e_flags;                /* See EVENT_FLAG_* (epoll only) */
+    uint32_t                    e_seq;                  /* Registration sequence nr (epoll and timers) */
+    int                         e_index;                /* Index in timer heap, -1 if not in heap */
     struct timeval              e_time;                 /* Timeout */
     void                       *e_arg;                  /* Function argument */
+    void                      **e_ref;                  /* Timer reference, cleared when removed */
     char                        e_string[EVENT_STRLEN]; /* String for debugging */
 };
 
@@ -93,11 +110,41 @@ struct event_data{
  * XXX consider use handle variables instead of global
  */
 static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+
+/* Timers as a binary min-heap ordered by time and registration order */
+static struct event_data **ee_timers = NULL;
+static int                 ee_tlen = 0;  /* Number of timers in heap */
+static int                 ee_tsize = 0; /* Allocated size of heap */
+static uint32_t            _ee_tseq = 0; /* Timer registration sequence number */
+
+/* Timers registered by timer callbacks, added to heap after all expired timers are called,
+ * see event_timeouts_call */
+#define EVENT_TIMER_PENDING -2           /* e_index of pending timer */
+static struct event_data  *ee_tpending = NULL;
+static int                 ee_tpnr = 0;   /* Number of pending timers */
+static int                 _ee_tcalling = 0; /* Set while expired timers are called */
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
 
+#ifdef HAVE_SYS_EPOLL_H
+/* epoll file descriptor, -1 if select is used. Created in clixon_event_loop */
+static int _ee_epfd = -1;
+
+/* Vector of FD events indexed by file descriptor, only used with epoll */
+static struct event_data **ee_fdvec = NULL;
+static int                 ee_fdlen = 0;
+
+/* Number of FD events with EVENT_FLAG_ALWAYS set */
+static int _ee_always = 0;
+
+/* Registration sequence number. Together with fd identifies an epoll registration */
+static uint32_t _ee_seq = 0;
+
+/* Set when the select loop is chosen, then fds must not exceed FD_SETSIZE */
+static int _ee_select = 0;
+#endif
+
 /* If set (eg by signal handler) exit select loop on next run and return 0 */
 static int _clicon_exit = 0;
 
@@ -168,6 +215,134 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/*! Add file descriptor event to the epoll set
+ *
+ * File descriptors not supported by epoll, such as regular files, are instead marked as
+ * always ready, which is how select treats them.
+ * As with select, a file descriptor may be registered by several events, which are then all
+ * called when it is ready. The epoll set has one entry per file descriptor.
+ * @param[in]  e   FD event
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_epoll_add(struct event_data *e)
+{
+    struct epoll_event  ev = {0,};
+    struct event_data **vec;
+    int                 len;
+
+    if (e->e_fd >= ee_fdlen){
+        len = 2*ee_fdlen > e->e_fd ? 2*ee_fdlen : e->e_fd + 1;
+        if ((vec = realloc(ee_fdvec, len*sizeof(*vec))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            return -1;
+        }
+        memset(&vec[ee_fdlen], 0, (len-ee_fdlen)*sizeof(*vec));
+        ee_fdvec = vec;
+        ee_fdlen = len;
+    }
+    e->e_seq = ++_ee_seq;
+    ev.events = EPOLLIN;
+    ev.data.fd = e->e_fd;
+    if (epoll_ctl(_ee_epfd, EPOLL_CTL_ADD, e->e_fd, &ev) < 0){
+        if (errno == EEXIST){ /* Already added by another event of same fd */
+            if (epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev) < 0){
+                clixon_err(OE_EVENTS, errno, "epoll_ctl %s", e->e_string);
+                return -1;
+            }
+            e->e_flags |= EVENT_FLAG_EPOLL;
+        }
+        else if (errno == EPERM){
+            e->e_flags |= EVENT_FLAG_ALWAYS;
+            _ee_always++;
+        }
+        else {
+            clixon_err(OE_EVENTS, errno, "epoll_ctl %s", e->e_string);
+            return -1;
+        }
+    }
+    else
+        e->e_flags |= EVENT_FLAG_EPOLL;
+    e->e_fdnext = ee_fdvec[e->e_fd];
+    ee_fdvec[e->e_fd] = e;
+    return 0;
+}
+
+/*! Remove file descriptor event from the epoll set
+ *
+ * The fd is removed from the epoll set when no other event of the fd is in it.
+ * The file descriptor may already be closed, in which case the kernel has already removed it
+ * @param[in]  e   FD event
+ */
+static void
+event_epoll_del(struct event_data *e)
+{
+    struct event_data **ep;
+    struct event_data  *e1;
+    int                 epoll = 0;
+
+    if (e->e_fd < ee_fdlen){
+        for (ep = &ee_fdvec[e->e_fd]; *ep; ep = &(*ep)->e_fdnext)
+            if (*ep == e){
+                *ep = e->e_fdnext;
+                break;
+            }
+        for (e1 = ee_fdvec[e->e_fd]; e1; e1 = e1->e_fdnext)
+            if (e1->e_flags & EVENT_FLAG_EPOLL)
+                epoll++;
+    }
+    if ((e->e_flags & EVENT_FLAG_EPOLL) && epoll == 0)
+        (void)epoll_ctl(_ee_epfd, EPOLL_CTL_DEL, e->e_fd, NULL);
+    if (e->e_flags & EVENT_FLAG_ALWAYS)
+        _ee_always--;
+    e->e_fdnext = NULL;
+    e->e_flags = 0;
+}
+
+/*! Create epoll set and add all registered file descriptors
+ *
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_epoll_init(void)
+{
+    struct event_data *e;
+
+    if ((_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+        clixon_err(OE_EVENTS, errno, "epoll_create1");
+        return -1;
+    }
+    for (e=ee; e; e=e->e_next)
+        if (event_epoll_add(e) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Find FD event from ready key
+ *
+ * The key is the fd and the registration sequence number. A registration that has been
+ * removed or replaced by a callback earlier in the same dispatch round is not found.
+ * @param[in]  key  Ready key, see event_loop_epoll
+ * @retval     e    FD event
+ * @retval     NULL Not found
+ */
+static struct event_data *
+event_epoll_find(uint64_t key)
+{
+    struct event_data *e;
+    int                fd = (int)(key & 0xffffffff);
+
+    if (fd < ee_fdlen)
+        for (e = ee_fdvec[fd]; e; e = e->e_fdnext)
+            if (e->e_seq == (uint32_t)(key >> 32))
+                return e;
+    return NULL;
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * @param[in]  fd   File descriptor
@@ -175,11 +350,16 @@ clicon_sig_ignore_get(void)
  * @param[in]  arg  Argument to function fn
  * @param[in]  str  Describing string for logging
  * @param[in]  prio Priority (0 or 1)
+ * @retval     0    OK
+ * @retval    -1    Error, eg fd exceeds FD_SETSIZE and select is used
  * @code
  * int fn(int fd, void *arg){
  * }
  * clixon_event_reg_fd(fd, fn, (void*)42, "call fn on input on fd");
  * @endcode 
+ * @note If epoll is available, whether select or epoll is used is known when the event
+ *       loop starts, an fd registered before that exceeding FD_SETSIZE is instead rejected by
+ *       clixon_event_loop if select is used
  * @see clixon_event_unreg_fd
  */
 int
@@ -191,6 +371,15 @@ clixon_event_reg_fd_prio(int   fd,
 {
     struct event_data *e;
 
+#ifdef HAVE_SYS_EPOLL_H
+    if (fd >= FD_SETSIZE && _ee_select){
+#else
+    if (fd >= FD_SETSIZE){
+#endif
+        clixon_err(OE_EVENTS, EMFILE, "fd %d of %s exceeds FD_SETSIZE, consider CLICON_EVENT_EPOLL",
+                   fd, str);
+        return -1;
+    }
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
         clixon_err(OE_EVENTS, errno, "malloc");
         return -1;
@@ -202,6 +391,12 @@ clixon_event_reg_fd_prio(int   fd,
     e->e_arg = arg;
     e->e_type = EVENT_FD;
     e->e_prio = prio;
+#ifdef HAVE_SYS_EPOLL_H
+    if (_ee_epfd != -1 && event_epoll_add(e) < 0){
+        free(e);
+        return -1;
+    }
+#endif
     e->e_next = ee;
     ee = e;
     clixon_debug(CLIXON_DBG_EVENT, "registering %s", e->e_string);
@@ -241,6 +436,10 @@ clixon_event_unreg_fd(int   s,
             found++;
             *e_prev = e->e_next;
             _ee_unreg++;
+#ifdef HAVE_SYS_EPOLL_H
+            if (_ee_epfd != -1)
+                event_epoll_del(e);
+#endif
             free(e);
             break;
         }
@@ -249,6 +448,133 @@ clixon_event_unreg_fd(int   s,
     return found?0:-1;
 }
 
+/*! Timer a expires before timer b
+ *
+ * Timers with same time expire in registration order
+ */
+static inline int
+timer_lt(struct event_data *a,
+         struct event_data *b)
+{
+    if (a->e_time.tv_sec != b->e_time.tv_sec)
+        return a->e_time.tv_sec < b->e_time.tv_sec;
+    if (a->e_time.tv_usec != b->e_time.tv_usec)
+        return a->e_time.tv_usec < b->e_time.tv_usec;
+    return (int32_t)(a->e_seq - b->e_seq) < 0;
+}
+
+/*! Set timer at heap position i
+ */
+static inline void
+timer_heap_set(int                i,
+               struct event_data *e)
+{
+    ee_timers[i] = e;
+    e->e_index = i;
+}
+
+/*! Move timer at position i up the heap until heap order is restored
+ */
+static void
+timer_heap_up(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                p;
+
+    while (i > 0){
+        p = (i-1)/2;
+        if (!timer_lt(e, ee_timers[p]))
+            break;
+        timer_heap_set(i, ee_timers[p]);
+        i = p;
+    }
+    timer_heap_set(i, e);
+}
+
+/*! Move timer at position i down the heap until heap order is restored
+ */
+static void
+timer_heap_down(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                c;
+
+    while ((c = 2*i+1) < ee_tlen){
+        if (c+1 < ee_tlen && timer_lt(ee_timers[c+1], ee_timers[c]))
+            c++;
+        if (!timer_lt(ee_timers[c], e))
+            break;
+        timer_heap_set(i, ee_timers[c]);
+        i = c;
+    }
+    timer_heap_set(i, e);
+}
+
+/*! Remove timer from heap, but do not free it
+ *
+ * Also clear reference to the timer, see clixon_event_reg_timeout_ref
+ * @param[in]  e   Timer event in heap
+ */
+static void
+timer_heap_rm(struct event_data *e)
+{
+    int                i = e->e_index;
+    struct event_data *last;
+
+    e->e_index = -1;
+    if (e->e_ref){
+        *e->e_ref = NULL;
+        e->e_ref = NULL;
+    }
+    last = ee_timers[--ee_tlen];
+    if (i == ee_tlen)
+        return;
+    timer_heap_set(i, last);
+    if (i > 0 && timer_lt(last, ee_timers[(i-1)/2]))
+        timer_heap_up(i);
+    else
+        timer_heap_down(i);
+}
+
+/*! Remove pending timer, registered by a timer callback, but do not free it
+ *
+ * Also clear reference to the timer, see clixon_event_reg_timeout_ref
+ * @param[in]  e   Pending timer event
+ */
+static void
+timer_pending_rm(struct event_data *e)
+{
+    struct event_data **e_prev;
+
+    for (e_prev = &ee_tpending; *e_prev != e; e_prev = &(*e_prev)->e_next)
+        ;
+    *e_prev = e->e_next;
+    ee_tpnr--;
+    e->e_index = -1;
+    if (e->e_ref){
+        *e->e_ref = NULL;
+        e->e_ref = NULL;
+    }
+}
+
+/*! Add pending timers to heap
+ *
+ * The heap is allocated for them when they are registered
+ */
+static void
+timer_pending_flush(void)
+{
+    struct event_data *e;
+
+    while ((e = ee_tpending) != NULL){
+        ee_tpending = e->e_next;
+        e->e_next = NULL;
+        ee_timers[ee_tlen] = e;
+        timer_heap_up(ee_tlen++);
+    }
+    ee_tpnr = 0;
+}
+
 /*! Call a callback function at an absolute time
  *
  * @param[in]  t   Absolute (not relative!) timestamp when callback is called
@@ -272,25 +598,60 @@ clixon_event_unreg_fd(int   s,
  * @note  The first argument to fn is a dummy, just to get the same signature as for file-descriptor callbacks.
  * @see clixon_event_reg_fd
  * @see clixon_event_unreg_timeout
+ * @see clixon_event_reg_timeout_ref  which also returns a reference for unregistering
  */
 int
 clixon_event_reg_timeout(struct timeval t, 
                          int          (*fn)(int, void*),
                          void          *arg,
                          char          *str)
+{
+    return clixon_event_reg_timeout_ref(t, fn, arg, str, NULL);
+}
+
+/*! Call a callback function at an absolute time, return reference to timer
+ *
+ * Same as clixon_event_reg_timeout but also returns a reference that can be used to
+ * unregister the timer without searching for it.
+ * @param[in]  t   Absolute (not relative!) timestamp when callback is called
+ * @param[in]  fn  Function to call at time t
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @param[out] ref Timer reference (if not NULL)
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @note  The reference is set to NULL when the timer fires (before fn is called) or is
+ *        unregistered, ref must therefore be valid as long as the timer is registered
+ * @see clixon_event_unreg_timeout_ref
+ */
+int
+clixon_event_reg_timeout_ref(struct timeval t, 
+                             int          (*fn)(int, void*),
+                             void          *arg,
+                             char          *str,
+                             void         **ref)
 {
     int                 retval = -1;
     struct event_data  *e;
-    struct event_data  *e1;
-    struct event_data **e_prev;
+    struct event_data **vec;
+    int                 size;
 
     if (str == NULL || fn == NULL){
         clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
         goto done;
     }
+    if (ee_tlen + ee_tpnr == ee_tsize){
+        size = ee_tsize ? 2*ee_tsize : 32;
+        if ((vec = realloc(ee_timers, size*sizeof(*vec))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            goto done;
+        }
+        ee_timers = vec;
+        ee_tsize = size;
+    }
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
         clixon_err(OE_EVENTS, errno, "malloc");
-        return -1;
+        goto done;
     }
     memset(e, 0, sizeof(struct event_data));
     strncpy(e->e_string, str, EVENT_STRLEN-1);
@@ -298,15 +659,22 @@ clixon_event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
+    e->e_seq = ++_ee_tseq;
+    if (_ee_tcalling){ /* Registered by timer callback, see event_timeouts_call */
+        e->e_index = EVENT_TIMER_PENDING;
+        e->e_next = ee_tpending;
+        ee_tpending = e;
+        ee_tpnr++;
+    }
+    else {
+        /* Add last in heap and restore heap order */
+        ee_timers[ee_tlen] = e;
+        timer_heap_up(ee_tlen++);
+    }
+    if (ref){
+        *ref = e;
+        e->e_ref = ref;
     }
-    e->e_next = e1;
-    *e_prev = e;
     clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
     retval = 0;
  done:
@@ -322,6 +690,7 @@ clixon_event_reg_timeout(struct timeval t,
  * @param[in]  arg  Argument to function fn
  * @retval     0    OK, timeout unregistered
  * @retval    -1    OK, but timeout not found
+ * @note  Linear search of all timers, use clixon_event_unreg_timeout_ref if many timers
  * @see clixon_event_reg_timeout
  * @see clixon_event_unreg_fd
  */
@@ -330,20 +699,47 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
                            void *arg)
 {
     struct event_data  *e;
-    int                 found = 0;
-    struct event_data **e_prev;
+    int                 i;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
+    for (i=0; i<ee_tlen; i++){
+        e = ee_timers[i];
         if (fn == e->e_fn && arg == e->e_arg) {
-            found++;
-            *e_prev = e->e_next;
+            timer_heap_rm(e);
             free(e);
-            break;
+            return 0;
         }
-        e_prev = &e->e_next;
     }
-    return found?0:-1;
+    for (e = ee_tpending; e; e = e->e_next)
+        if (fn == e->e_fn && arg == e->e_arg) {
+            timer_pending_rm(e);
+            free(e);
+            return 0;
+        }
+    return -1;
+}
+
+/*! Deregister a timeout callback using reference from clixon_event_reg_timeout_ref()
+ *
+ * @param[in]  ref  Timer reference, NULL if the timer has fired or been unregistered
+ * @retval     0    OK, timeout unregistered
+ * @retval    -1    OK, but timeout not found (eg it is being called)
+ * @see clixon_event_reg_timeout_ref
+ */
+int
+clixon_event_unreg_timeout_ref(void *ref)
+{
+    struct event_data *e = (struct event_data *)ref;
+
+    if (e == NULL || e->e_type != EVENT_TIME)
+        return -1;
+    if (e->e_index == EVENT_TIMER_PENDING)
+        timer_pending_rm(e);
+    else if (e->e_index < 0)
+        return -1;
+    else
+        timer_heap_rm(e);
+    free(e);
+    return 0;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -356,40 +752,293 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
 int
 clixon_event_poll(int fd)
 {
-    int            retval = -1;
-    fd_set         fdset;
-    struct timeval tnull = {0,};
+    int           retval = -1;
+    struct pollfd pfd = {0,};
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if ((retval = poll(&pfd, 1, 0)) < 0)
+        clixon_err(OE_EVENTS, errno, "poll");
+    return retval;
+}
+
+/*! Handle error from select or epoll_wait
+ *
+ * Signals are checked and are in three classes:
+ * (1) Signals that exit gracefully, the function returns 0
+ *     Must be registered such as by set_signal() of SIGTERM,SIGINT, etc with a handler that calls
+ *     clicon_exit_set().
+ * (2) SIGCHILD Childs that exit(), go through clixon_proc list and cal waitpid
+ *     New select loop is called
+ * (2) Signals are ignored, and the select is rerun, ie handler calls clicon_sig_ignore_get
+ *     New select loop is called
+ * (3) Other signals result in an error and return -1.
+ * @param[in] h       Clixon handle
+ * @param[in] syscall Name of failed system call, for logging
+ * @retval    1       Continue event loop
+ * @retval    0       Break event loop
+ */
+static int
+event_intr(clixon_handle h,
+           const char   *syscall)
+{
+    int err = errno;
+
+    if (err != EINTR){
+        clixon_err(OE_EVENTS, err, "%s", syscall);
+        return 0;
+    }
+    clixon_debug(CLIXON_DBG_EVENT, "%s: %s", syscall, strerror(err));
+    if (clixon_exit_get() == 1){
+        clixon_err(OE_EVENTS, err, "%s", syscall);
+        return 0;
+    }
+    else if (clicon_sig_child_get()){
+        /* Go through processes and wait for child processes */
+        if (clixon_process_waitpid(h) < 0)
+            return 0;
+        clicon_sig_child_set(0);
+        return 1;
+    }
+    else if (clicon_sig_ignore_get()){
+        clicon_sig_ignore_set(0);
+        return 1;
+    }
+    clixon_err(OE_EVENTS, err, "%s", syscall);
+    return 0;
+}
+
+/*! Call all expired timeouts
+ *
+ * Expired timers are called in time order, and in registration order if same time.
+ * Timers registered by the callbacks themselves are kept pending and not called until next
+ * round, even if they have already expired. This avoids starving file descriptors.
+ * @retval    0  OK
+ * @retval   -1  Error in callback
+ */
+static int
+event_timeouts_call(void)
+{
+    int                retval = -1;
+    struct event_data *e;
+    struct timeval     now;
+    int                ret;
+
+    gettimeofday(&now, NULL);
+    _ee_tcalling = 1;
+    while (ee_tlen > 0){
+        e = ee_timers[0];
+        if (timercmp(&e->e_time, &now, >))
+            break;
+        timer_heap_rm(e);
+        clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
+        ret = (*e->e_fn)(0, e->e_arg);
+        free(e);
+        if (ret < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    _ee_tcalling = 0;
+    timer_pending_flush();
+    return retval;
+}
+
+/*! Compute time until first timer expires
+ *
+ * @param[out] t   Relative time until first timer, zero if already expired
+ * @retval     1   Timer exists, t is set
+ * @retval     0   No timers
+ */
+static int
+event_timeout_next(struct timeval *t)
+{
+    struct timeval t0;
+
+    if (ee_tlen == 0)
+        return 0;
+    gettimeofday(&t0, NULL);
+    timersub(&ee_timers[0]->e_time, &t0, t);
+    if (t->tv_sec < 0)
+        timerclear(t);
+    return 1;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/*! Call callbacks of ready file descriptors from epoll
+ *
+ * Same priority semantics as select: if CLICON_SOCK_PRIO is set, all ready prio events are
+ * served first, then at most one non-prio event.
+ * Events are looked up by key before each call since earlier callbacks may unregister them.
+ * @param[in] h      Clixon handle
+ * @param[in] ready  Vector of epoll keys
+ * @param[in] nready Length of ready
+ * @retval    0      OK
+ * @retval   -1      Error in callback
+ */
+static int
+event_epoll_dispatch(clixon_handle h,
+                     uint64_t     *ready,
+                     int           nready)
+{
+    struct event_data *e;
+    int                prio;
+    int                i;
+
+    prio = clicon_option_bool(h, "CLICON_SOCK_PRIO");
+    if (prio){
+        for (i=0; i<nready; i++){
+            if (clixon_exit_get() == 1)
+                break;
+            if ((e = event_epoll_find(ready[i])) == NULL || e->e_prio == 0)
+                continue;
+            clixon_debug(CLIXON_DBG_EVENT, "epoll: %s prio:%d", e->e_string, e->e_prio);
+            if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+                clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
+                return -1;
+            }
+        }
+    }
+    for (i=0; i<nready; i++){
+        if (clixon_exit_get() == 1)
+            break;
+        if ((e = event_epoll_find(ready[i])) == NULL || e->e_prio)
+            continue;
+        clixon_debug(CLIXON_DBG_EVENT, "epoll: %s", e->e_string);
+        if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+            clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
+            return -1;
+        }
+        if (prio)
+            break;
+    }
+    return 0;
+}
+
+/*! Event loop using epoll, see clixon_event_loop
+ *
+ * Level-triggered, so callbacks need not drain a file descriptor on each call.
+ * @param[in] h  Clixon handle
+ * @retval    0  OK
+ * @retval   -1  Error
+ */
+static int
+event_loop_epoll(clixon_handle h)
+{
+    int                retval = -1;
+    struct epoll_event evs[EVENT_EPOLL_MAX];
+    struct event_data *e;
+    struct timeval     t;
+    uint64_t          *ready = NULL;
+    int                readylen = 0;
+    int                nready;
+    int                timeout;
+    int                n;
+    int                i;
+    int                j;
 
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if ((retval = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull)) < 0)
-        clixon_err(OE_EVENTS, errno, "select");
+    if (_ee_epfd == -1 && event_epoll_init() < 0)
+        goto done;
+    while (clixon_exit_get() != 1){
+        if (clicon_sig_child_get()){
+            /* Go through processes and wait for child processes */
+            if (clixon_process_waitpid(h) < 0)
+                break;
+            clicon_sig_child_set(0);
+        }
+        if (_ee_always)
+            timeout = 0;
+        else if (event_timeout_next(&t)){
+            if (t.tv_sec >= INT_MAX/1000 - 1)
+                timeout = INT_MAX;
+            else /* Round up to not wake up before timer expires */
+                timeout = t.tv_sec*1000 + (t.tv_usec+999)/1000;
+        }
+        else
+            timeout = -1;
+        n = epoll_wait(_ee_epfd, evs, EVENT_EPOLL_MAX, timeout);
+        if (clixon_exit_get() == 1)
+            break;
+        if (n == -1) {
+            if (event_intr(h, "epoll_wait") == 1)
+                continue;
+            break;
+        }
+        /* One key per event of each ready fd, since an fd may have several events */
+        nready = _ee_always;
+        for (i=0; i<n; i++)
+            if (evs[i].data.fd < ee_fdlen)
+                for (e = ee_fdvec[evs[i].data.fd]; e; e = e->e_fdnext)
+                    if (e->e_flags & EVENT_FLAG_EPOLL)
+                        nready++;
+        if (nready > readylen){
+            if ((ready = realloc(ready, nready*sizeof(*ready))) == NULL){
+                clixon_err(OE_EVENTS, errno, "realloc");
+                break;
+            }
+            readylen = nready;
+        }
+        j = 0;
+        for (i=0; i<n; i++)
+            if (evs[i].data.fd < ee_fdlen)
+                for (e = ee_fdvec[evs[i].data.fd]; e; e = e->e_fdnext)
+                    if (e->e_flags & EVENT_FLAG_EPOLL)
+                        ready[j++] = ((uint64_t)e->e_seq << 32) | (uint32_t)e->e_fd;
+        if (_ee_always)
+            for (e=ee; e; e=e->e_next)
+                if (e->e_flags & EVENT_FLAG_ALWAYS)
+                    ready[j++] = ((uint64_t)e->e_seq << 32) | (uint32_t)e->e_fd;
+        if (event_epoll_dispatch(h, ready, nready) < 0)
+            break;
+        if (clixon_exit_get() != 1 && event_timeouts_call() < 0)
+            break;
+        clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
+    }
+    if (clixon_exit_get() == 1)
+        retval = 0;
+ done:
+    if (ready)
+        free(ready);
+    clixon_debug(CLIXON_DBG_EVENT, "retval:%d", retval);
     return retval;
 }
+#endif /* HAVE_SYS_EPOLL_H */
 
 /*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
  *
  * @param[in] h  Clixon handle
  * @retval    0  OK
  * @retval   -1  Error: eg select, callback, timer, 
- * @note There is an issue with fairness between timeouts and events
- *       Currently a socket that is not read/emptied properly starve timeouts.
- *       One could try to poll the file descriptors after a timeout?
+ * All expired timeouts are called in each round, after ready file descriptors, so that busy
+ * file descriptors do not starve timeouts.
+ * @see CLICON_EVENT_EPOLL for using epoll instead of select
  */
 int
 clixon_event_loop(clixon_handle h)
 {
     struct event_data *e;
     int                n;
+    int                maxfd;
     struct timeval     t;
-    struct timeval     t0;
-    struct timeval     tnull = {0,};
     fd_set             fdset;
     int                retval = -1;
     struct event_data *e_next;
 
+#ifdef HAVE_SYS_EPOLL_H
+    if (clicon_option_bool(h, "CLICON_EVENT_EPOLL"))
+        return event_loop_epoll(h);
+    /* fds registered before select was chosen, see clixon_event_reg_fd_prio */
+    _ee_select = 1;
+    for (e=ee; e; e=e->e_next)
+        if (e->e_type == EVENT_FD && e->e_fd >= FD_SETSIZE){
+            clixon_err(OE_EVENTS, EMFILE, "fd %d of %s exceeds FD_SETSIZE, consider CLICON_EVENT_EPOLL",
+                       e->e_fd, e->e_string);
+            return -1;
+        }
+#endif
     while (clixon_exit_get() != 1){
         FD_ZERO(&fdset);
+        maxfd = -1;
         if (clicon_sig_child_get()){
             /* Go through processes and wait for child processes */
             if (clixon_process_waitpid(h) < 0)
@@ -397,66 +1046,23 @@ clixon_event_loop(clixon_handle h)
             clicon_sig_child_set(0);
         }
         for (e=ee; e; e=e->e_next)
-            if (e->e_type == EVENT_FD)
+            if (e->e_type == EVENT_FD){ /* fd < FD_SETSIZE, see clixon_event_reg_fd_prio */
                 FD_SET(e->e_fd, &fdset);
-        if (ee_timers != NULL){
-            gettimeofday(&t0, NULL);
-            timersub(&ee_timers->e_time, &t0, &t);
-            if (t.tv_sec < 0)
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull);
-            else
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &t);
-        }
+                if (e->e_fd > maxfd)
+                    maxfd = e->e_fd;
+            }
+        if (event_timeout_next(&t))
+            n = select(maxfd+1, &fdset, NULL, NULL, &t);
         else
-            n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+            n = select(maxfd+1, &fdset, NULL, NULL, NULL);
         if (clixon_exit_get() == 1){
             break;
         }
         if (n == -1) {
-            if (errno == EINTR){
-                /* Signals are checked and are in three classes:
-                 * (1) Signals that exit gracefully, the function returns 0
-                 *     Must be registered such as by set_signal() of SIGTERM,SIGINT, etc with a handler that calls
-                 *     clicon_exit_set().
-                 * (2) SIGCHILD Childs that exit(), go through clixon_proc list and cal waitpid
-                 *     New select loop is called
-                 * (2) Signals are ignored, and the select is rerun, ie handler calls clicon_sig_ignore_get
-                 *     New select loop is called
-                 * (3) Other signals result in an error and return -1.
-                 */
-                clixon_debug(CLIXON_DBG_EVENT, "select: %s", strerror(errno));
-                if (clixon_exit_get() == 1){
-                    clixon_err(OE_EVENTS, errno, "select");
-                    retval = 0;
-                }
-                else if (clicon_sig_child_get()){
-                    /* Go through processes and wait for child processes */
-                    if (clixon_process_waitpid(h) < 0)
-                        goto err;
-                    clicon_sig_child_set(0);
-                    continue;
-                }
-                else if (clicon_sig_ignore_get()){
-                    clicon_sig_ignore_set(0);
-                    continue;
-                }
-                else
-                    clixon_err(OE_EVENTS, errno, "select");
-            }
-            else
-                clixon_err(OE_EVENTS, errno, "select");
+            if (event_intr(h, "select") == 1)
+                continue;
             goto err;
         }
-        if (n==0){ /* Timeout */
-            e = ee_timers;
-            ee_timers = ee_timers->e_next;
-            clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
-            if ((*e->e_fn)(0, e->e_arg) < 0){
-                free(e);
-                goto err;
-            }
-            free(e);
-        }
         _ee_unreg = 0;
         if (clicon_option_bool(h, "CLICON_SOCK_PRIO")){
             for (e=ee; e; e=e_next) {
@@ -497,6 +1103,9 @@ clixon_event_loop(clixon_handle h)
                     break;
             }
         }
+        /* Timeouts after file descriptors since these may be unregistered by timer callbacks */
+        if (clixon_exit_get() != 1 && event_timeouts_call() < 0)
+            goto err;
         clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
         continue;
       err:
@@ -514,6 +1123,7 @@ clixon_event_exit(void)
 {
     struct event_data *e;
     struct event_data *e_next;
+    int                i;
 
     e_next = ee;
     while ((e = e_next) != NULL){
@@ -521,11 +1131,32 @@ clixon_event_exit(void)
         free(e);
     }
     ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
+    for (i=0; i<ee_tlen; i++){
+        if (ee_timers[i]->e_ref)
+            *ee_timers[i]->e_ref = NULL;
+        free(ee_timers[i]);
+    }
+    while ((e = ee_tpending) != NULL){
+        timer_pending_rm(e);
         free(e);
     }
+    if (ee_timers)
+        free(ee_timers);
     ee_timers = NULL;
+    ee_tlen = 0;
+    ee_tsize = 0;
+#ifdef HAVE_SYS_EPOLL_H
+    if (_ee_epfd != -1){
+        close(_ee_epfd);
+        _ee_epfd = -1;
+    }
+    _ee_select = 0;
+    if (ee_fdvec){
+        free(ee_fdvec);
+        ee_fdvec = NULL;
+    }
+    ee_fdlen = 0;
+    _ee_always = 0;
+#endif
     return 0;
 }
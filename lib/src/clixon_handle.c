@@ -61,6 +61,7 @@
 #include "clixon_stream.h"
 #include "clixon_data.h"
 #include "clixon_options.h"
+#include "clixon_proto.h"
 
 #define CLIXON_MAGIC 0x99aafabe
 
@@ -160,9 +161,15 @@ clixon_handle_exit(clixon_handle h)
     int                   retval = -1;
     struct clixon_handle *ch = handle(h);
     clicon_hash_t        *ha;
+    clixon_msg_rcvbuf    *rb = NULL;
 
     if ((ha = clicon_options(h)) != NULL)
         clicon_hash_free(ha);
+    /* Receive buffer of cached client socket, see clicon_client_rcvbuf */
+    if (clicon_ptr_get(h, "client-rcvbuf", (void**)&rb) == 0 && rb != NULL){
+        clixon_msg_rcvbuf_free(rb);
+        clicon_ptr_del(h, "client-rcvbuf");
+    }
     if ((ha = clicon_data(h)) != NULL)
         clicon_hash_free(ha);
     if ((ha = clicon_db_elmnt(h)) != NULL)
@@ -0,0 +1,256 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * String interning of XML names and prefixes
+ *
+ * A process-wide table where each distinct string is stored once. XML nodes with the
+ * same name share the same string, and names can be compared by pointer.
+ * Strings are reference counted and removed from the table when the last reference is
+ * released, so names of arbitrary input do not accumulate.
+ * Not thread-safe, as the rest of libclixon.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_intern.h"
+
+/* Initial number of hash buckets, power of two */
+#define INTERN_SIZE_INIT 256
+
+/* Interned string
+ */
+struct intern_str{
+    struct intern_str *is_next;  /* Next in hash bucket */
+    uint32_t           is_hash;  /* Hash value of string */
+    uint32_t           is_ref;   /* Reference count */
+    char               is_str[]; /* Null-terminated string */
+};
+
+/* Hash buckets, number of buckets is a power of two */
+static struct intern_str **_intern_vec = NULL;
+static size_t              _intern_size = 0;
+
+/* Number of interned strings */
+static size_t              _intern_nr = 0;
+
+/* Total memory of interned strings (not including buckets) */
+static size_t              _intern_sz = 0;
+
+/*! FNV-1a hash of string
+ */
+static inline uint32_t
+intern_hash(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Get interned string struct from its string
+ */
+static inline struct intern_str *
+intern_str_get(char *str)
+{
+    return (struct intern_str *)(str - offsetof(struct intern_str, is_str));
+}
+
+/*! Find interned string given hash
+ */
+static struct intern_str *
+intern_lookup(const char *str,
+              uint32_t    h)
+{
+    struct intern_str *is;
+
+    if (_intern_vec == NULL)
+        return NULL;
+    for (is = _intern_vec[h & (_intern_size-1)]; is; is = is->is_next)
+        if (is->is_hash == h && strcmp(is->is_str, str) == 0)
+            return is;
+    return NULL;
+}
+
+/*! Double the number of hash buckets, or create initial buckets
+ */
+static int
+intern_grow(void)
+{
+    struct intern_str **vec;
+    struct intern_str  *is;
+    size_t              size;
+    size_t              i;
+
+    size = _intern_size ? _intern_size*2 : INTERN_SIZE_INIT;
+    if ((vec = calloc(size, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    for (i=0; i<_intern_size; i++)
+        while ((is = _intern_vec[i]) != NULL){
+            _intern_vec[i] = is->is_next;
+            is->is_next = vec[is->is_hash & (size-1)];
+            vec[is->is_hash & (size-1)] = is;
+        }
+    if (_intern_vec)
+        free(_intern_vec);
+    _intern_vec = vec;
+    _intern_size = size;
+    return 0;
+}
+
+/*! Intern string, return shared copy
+ *
+ * @param[in]  str   String
+ * @retval     istr  Interned string, release with clixon_intern_free. Do not modify
+ * @retval     NULL  Error
+ * @code
+ *   char *name;
+ *   if ((name = clixon_intern("interface")) == NULL)
+ *      err;
+ *   ...
+ *   clixon_intern_free(name);
+ * @endcode
+ */
+char *
+clixon_intern(const char *str)
+{
+    struct intern_str *is;
+    uint32_t           h;
+    size_t             len;
+
+    h = intern_hash(str);
+    if ((is = intern_lookup(str, h)) != NULL){
+        is->is_ref++;
+        return is->is_str;
+    }
+    if (_intern_nr >= _intern_size &&
+        intern_grow() < 0)
+        return NULL;
+    len = strlen(str) + 1;
+    if ((is = malloc(sizeof(*is) + len)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    is->is_hash = h;
+    is->is_ref = 1;
+    memcpy(is->is_str, str, len);
+    is->is_next = _intern_vec[h & (_intern_size-1)];
+    _intern_vec[h & (_intern_size-1)] = is;
+    _intern_nr++;
+    _intern_sz += sizeof(*is) + len;
+    return is->is_str;
+}
+
+/*! Find interned string without adding a reference
+ *
+ * Use to compare a string with interned strings by pointer
+ * @param[in]  str   String
+ * @retval     istr  Interned string
+ * @retval     NULL  Not interned, ie no XML node has this name
+ */
+char *
+clixon_intern_find(const char *str)
+{
+    struct intern_str *is;
+
+    if ((is = intern_lookup(str, intern_hash(str))) == NULL)
+        return NULL;
+    return is->is_str;
+}
+
+/*! Release reference to interned string, remove it when unreferenced
+ *
+ * @param[in]  str   Interned string as returned by clixon_intern
+ * @retval     0     OK
+ */
+int
+clixon_intern_free(char *str)
+{
+    struct intern_str  *is;
+    struct intern_str **isp;
+
+    is = intern_str_get(str);
+    if (--is->is_ref > 0)
+        return 0;
+    for (isp = &_intern_vec[is->is_hash & (_intern_size-1)]; *isp; isp = &(*isp)->is_next)
+        if (*isp == is){
+            *isp = is->is_next;
+            break;
+        }
+    _intern_nr--;
+    _intern_sz -= sizeof(*is) + strlen(is->is_str) + 1;
+    free(is);
+    return 0;
+}
+
+/*! Get statistics of interned strings
+ *
+ * @param[out]  nrp  Number of interned strings
+ * @param[out]  szp  Memory of interned strings and hash buckets
+ * @retval      0    OK
+ */
+int
+clixon_intern_stats(uint64_t *nrp,
+                    size_t   *szp)
+{
+    if (nrp)
+        *nrp = _intern_nr;
+    if (szp)
+        *szp = _intern_sz + _intern_size*sizeof(struct intern_str *);
+    return 0;
+}
@@ -77,6 +77,7 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_json.h"
 #include "clixon_json_parse.h"
+#include "clixon_writer.h"
 
 /* Let xml2json_cbuf_vec() return json array: [a,b].
    ALternative is to create a pseudo-object and return that: {top:{a,b}}
@@ -244,6 +245,8 @@ array_eval(cxobj *xprev,
 
 /*! Escape a json string as well as decode xml cdata
  *
+ * Runs of characters that need no escaping are found with strcspn(3) and appended with
+ * one copy.
  * @param[out] cb   cbuf   (encoded)
  * @param[in]  str  string (unencoded)
  * @retval     0    OK
@@ -253,39 +256,43 @@ json_str_escape_cdata(cbuf *cb,
                       char *str)
 {
     int    retval = -1;
-    size_t len;
-    int    i;
+    size_t n;
 
-    len = strlen(str);
-    for (i=0; i<len; i++)
-        switch (str[i]){
+    while (1){
+        if ((n = strcspn(str, "\"\\\b\f\n\r\t")) > 0){
+            cbuf_append_buf(cb, str, n);
+            str += n;
+        }
+        switch (*str){
+        case '\0':
+            goto ok;
+            break;
         case '\"':
-            cprintf(cb, "\\\"");
+            cbuf_append_str(cb, "\\\"");
             break;
         case '\\':
-            cprintf(cb, "\\\\");
+            cbuf_append_str(cb, "\\\\");
             break;
         case '\b':
-            cprintf(cb, "\\b");
+            cbuf_append_str(cb, "\\b");
             break;
         case '\f':
-            cprintf(cb, "\\f");
+            cbuf_append_str(cb, "\\f");
             break;
         case '\n':
-            cprintf(cb, "\\n");
+            cbuf_append_str(cb, "\\n");
             break;
         case '\r':
-            cprintf(cb, "\\r");
+            cbuf_append_str(cb, "\\r");
             break;
         case '\t':
-            cprintf(cb, "\\t");
-            break;
-        default: /* fall thru */
-            cprintf(cb, "%c", str[i]);
+            cbuf_append_str(cb, "\\t");
             break;
         }
+        str++;
+    }
+ ok:
     retval = 0;
-    // done:
     return retval;
 }
 
@@ -850,7 +857,7 @@ xml2json1_cbuf(cbuf                   *cb,
         modname = yang_argument_get(ymod);
         /* Special case for ietf-netconf -> ietf-restconf translation 
          * A special case is for return data on the form {"data":...}
-         * See also json_xmlns_translate()
+         * See also json_parse_element_start()
          */
         if (strcmp(modname, "ietf-netconf") == 0)
             modname = "ietf-restconf";
@@ -963,6 +970,9 @@ xml2json1_cbuf(cbuf                   *cb,
                            level+1, pretty, 0, modname0,
                            metacbc) < 0)
             goto done;
+        /* Stream output if a writer is registered */
+        if (clixon_writer_check(cb) < 0)
+            goto done;
         if (commas > 0) {
             cprintf(cb, ",%s", pretty?"\n":"");
             --commas;
@@ -1333,77 +1343,11 @@ xml2json_vec(FILE             *f,
     return retval;
 }
 
-/*! Translate from JSON module:name to XML default ns: xmlns="uri" recursively
- *
- * Assume an xml tree where prefix:name have been split into "module":"name"
- * In other words, from JSON to XML namespace trees
- * 
- * @param[in]     yspec Yang spec
- * @param[in,out] x     XML tree. Translate it in-line
- * @param[out]    xerr  Reason for invalid tree returned as netconf err msg or NULL
- * @retval        1     OK 
- * @retval        0     Invalid, wrt namespace.  xerr set
- * @retval       -1     Error
- * @note the opposite - xml2ns is made inline in xml2json1_cbuf
- * Example: <top><module:input> --> <top><input xmlns="">
- * @see RFC7951 Sec 4
- */
-static int
-json_xmlns_translate(yang_stmt *yspec,
-                     cxobj     *x,
-                     cxobj    **xerr)
-{
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *namespace;
-    char      *modname = NULL;
-    cxobj     *xc;
-    int        ret;
-
-    if ((modname = xml_prefix(x)) != NULL){ /* prefix is here module name */
-        /* Special case for ietf-netconf -> ietf-restconf translation
-         * A special case is for return data on the form {"data":...}
-         * See also xml2json1_cbuf
-         */
-        if (strcmp(modname, "ietf-restconf") == 0)
-            modname = "ietf-netconf";
-        if ((ymod = yang_find_module_by_name(yspec, modname)) == NULL){
-            if (xerr &&
-                netconf_unknown_namespace_xml(xerr, "application",
-                                              modname,
-                                              "No yang module found corresponding to prefix") < 0)
-                goto done;
-            goto fail;
-        }
-        namespace = yang_find_mynamespace(ymod);
-        /* It would be possible to use canonical prefixes here, but probably not
-         * necessary or even right. Therefore, the namespace given by the JSON prefix / module
-         * is always the default namespace with prefix NULL.
-         * If not, this would be the prefix to pass instead of NULL
-         * prefix = yang_find_myprefix(ymod);
-         */
-        if (xml_namespace_change(x, namespace, NULL) < 0)
-            goto done;
-    }
-    xc = NULL;
-    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
-        if ((ret = json_xmlns_translate(yspec, xc, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-    }
-    retval = 1;
- done:
-    return retval;
- fail:
-    retval = 0;
-    goto done;
-}
-
 /*! Parse a string containing JSON and return an XML tree
  *
- * Parsing using yacc according to JSON syntax. Names with <prefix>:<id>
- * are split and interpreted as in RFC7951
+ * Names with <prefix>:<id> are split and interpreted as in RFC7951.
+ * Module names are translated to namespaces, and yang is bound, identityrefs decoded and
+ * children sorted while parsing, except for rpc which is bound and sorted afterwards.
  *
  * @param[in]  str    Input string containing JSON
  * @param[in]  rfc7951 Do sanity checks according to RFC 7951 JSON Encoding of Data Modeled with YANG
@@ -1416,6 +1360,7 @@ json_xmlns_translate(yang_stmt *yspec,
  * @retval    -1      Error
  * 
  * @see _xml_parse for XML variant
+ * @see json_parse  The JSON parser
  * @see http://www.ecma-international.org/publications/files/ECMA-ST/ECMA-404.pdf
  * @see RFC 7951
  */
@@ -1427,107 +1372,64 @@ _json_parse(char      *str,
             cxobj     *xt,
             cxobj    **xerr)
 {
-    int              retval = -1;
-    clixon_json_yacc jy = {0,};
-    int              ret;
-    cxobj           *x;
-    cbuf            *cberr = NULL;
-    int              i;
-    int              failed = 0; /* yang assignment */
+    int                retval = -1;
+    clixon_json_parser jp = {0,};
+    int                ret;
+    cxobj             *x;
+    int                i;
+    int                failed = 0; /* yang assignment */
 
     clixon_debug(CLIXON_DBG_PARSE, "%s", str);
-    jy.jy_parse_string = str;
-    jy.jy_linenum = 1;
-    jy.jy_current = xt;
-    jy.jy_xtop = xt;
-    if (json_scan_init(&jy) < 0)
-        goto done;
-    if (json_parse_init(&jy) < 0)
-        goto done;
-    if (clixon_json_parseparse(&jy) != 0) { /* yacc returns 1 on error */
-        clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
-        if (clixon_err_category() == 0)
-            clixon_err(OE_JSON, 0, "JSON parser error with no error code (should not happen)");
+    jp.jp_str = str;
+    jp.jp_linenum = 1;
+    jp.jp_xtop = xt;
+    jp.jp_rfc7951 = rfc7951;
+    jp.jp_yb = yb;
+    jp.jp_yspec = yspec;
+    jp.jp_xerr = xerr;
+    i = xml_child_nr(xt); /* First new top-level object */
+    if ((ret = json_parse(&jp)) < 0){
+        clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jp.jp_linenum);
         goto done;
     }
-    /* Traverse new objects */
-    for (i = 0; i < jy.jy_xlen; i++) {
-        x = jy.jy_xvec[i];
-        /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all 
-         * members of a top-level JSON object 
-         */
-        if (rfc7951 && xml_prefix(x) == NULL){
-            /* XXX: For top-level config file: */
-            if (yb != YB_NONE || strcmp(xml_name(x),DATASTORE_TOP_SYMBOL)!=0){
-                if ((cberr = cbuf_new()) == NULL){
-                    clixon_err(OE_UNIX, errno, "cbuf_new");
-                    goto done;
-                }
-                cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", xml_name(x));
-                if (xerr && netconf_malformed_message_xml(xerr, cbuf_get(cberr)) < 0)
-                    goto done;
-                goto fail;
-            }
-        }
-        /* Names are split into name/prefix, but now add namespace info */
-        if ((ret = json_xmlns_translate(yspec, x, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        /* Now assign yang stmts to each XML node 
-         * XXX should be xml_bind_yang0_parent() sometimes.
-         */
-        switch (yb){
-        case YB_PARENT:
-            if ((ret = xml_bind_yang0(NULL, x, yb, yspec, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        case YB_MODULE_NEXT:
-            if ((ret = xml_bind_yang(NULL, x, YB_MODULE, yspec, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        case YB_MODULE:
-            if ((ret = xml_bind_yang0(NULL, x, yb, yspec, xerr)) < 0)
+    if (ret == 0)
+        goto fail;
+    switch (yb){
+    case YB_NONE:
+        break;
+    case YB_RPC:
+        /* Now assign yang stmts to each new top-level object, then find leafs with
+         * identityrefs and translate prefixes in values to XML namespaces */
+        for (; i < xml_child_nr(xt); i++){
+            x = xml_child_i(xt, i);
+            if (xml_type(x) != CX_ELMNT)
+                continue;
+            if ((ret = xml_bind_yang_rpc(NULL, x, yspec, xerr)) < 0)
                 goto done;
             if (ret == 0)
                 failed++;
-            break;
-        case YB_NONE:
-            break;
-        case YB_RPC:
-            if ((ret = xml_bind_yang_rpc(NULL, x, yspec, xerr)) < 0)
+            if ((ret = json2xml_decode(x, xerr)) < 0)
                 goto done;
             if (ret == 0)
-                failed++;
-            break;
+                goto fail;
         }
-        /* Now find leafs with identityrefs (+transitive) and translate 
-         * prefixes in values to XML namespaces */
-        if ((ret = json2xml_decode(x, xerr)) < 0)
-            goto done;
-        if (ret == 0) /* XXX necessary? */
+        if (failed)
             goto fail;
-    }
-    if (failed)
-        goto fail;
-    /* Sort the complete tree after parsing. Sorting is not really meaningful if Yang 
-       not bound */
-    if (yb != YB_NONE)
         if (xml_sort_recurse(xt) < 0)
             goto done;
+        break;
+    default:
+        /* Sub-trees are sorted while parsing */
+        if (xml_sort_verify(xt, NULL) == -1 &&
+            xml_sort(xt) < 0)
+            goto done;
+        break;
+    }
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
-    if (cberr)
-        cbuf_free(cberr);
-    json_parse_exit(&jy);
-    json_scan_exit(&jy);
-    if (jy.jy_xvec)
-        free(jy.jy_xvec);
+    if (jp.jp_cb)
+        cbuf_free(jp.jp_cb);
     return retval;
  fail: /* invalid */
     retval = 0;
@@ -1621,11 +1523,9 @@ clixon_json_parse_file(FILE      *fp,
     int       retval = -1;
     int       ret;
     char     *jsonbuf = NULL;
-    int       jsonbuflen = BUFLEN; /* start size */
-    int       oldjsonbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
+    size_t    jsonbuflen = BUFLEN; /* start size */
+    size_t    len = 0;
+    size_t    n;
 
     if (xt==NULL){
         clixon_err(OE_JSON, EINVAL, "xt is NULL");
@@ -1635,42 +1535,35 @@ clixon_json_parse_file(FILE      *fp,
         clixon_err(OE_JSON, errno, "malloc");
         goto done;
     }
-    memset(jsonbuf, 0, jsonbuflen);
-    ptr = jsonbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_JSON, errno, "read");
-            break;
-        }
-        if (ret != 0)
-            jsonbuf[len++] = ch;
-        if (ret == 0){
-            if (*xt == NULL)
-                if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if (len){
-                if ((ret = _json_parse(ptr, rfc7951, yb, yspec, *xt, xerr)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            break;
-        }
-        if (len >= jsonbuflen-1){ /* Space: one for the null character */
-            oldjsonbuflen = jsonbuflen;
+    /* Read whole file in blocks, one byte is for the null character */
+    while ((n = fread(jsonbuf+len, 1, jsonbuflen-len-1, fp)) > 0){
+        len += n;
+        if (len == jsonbuflen-1){
             jsonbuflen *= 2;
             if ((jsonbuf = realloc(jsonbuf, jsonbuflen)) == NULL){
                 clixon_err(OE_JSON, errno, "realloc");
                 goto done;
             }
-            memset(jsonbuf+oldjsonbuflen, 0, jsonbuflen-oldjsonbuflen);
-            ptr = jsonbuf;
         }
     }
+    if (ferror(fp)){
+        clixon_err(OE_JSON, errno, "fread");
+        goto done;
+    }
+    jsonbuf[len] = '\0';
+    if (*xt == NULL)
+        if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (len){
+        if ((ret = _json_parse(jsonbuf, rfc7951, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
     retval = 1;
  done:
     if (retval < 0 && *xt){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
     if (jsonbuf)
@@ -0,0 +1,682 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+
+ * JSON Parser
+ * @see http://www.ecma-international.org/publications/files/ECMA-ST/ECMA-404.pdf
+ *  and RFC 7951 JSON Encoding of Data Modeled with YANG
+ *  and RFC 8259 The JavaScript Object Notation (JSON) Data Interchange Format
+
+A JSON value is an object, array, number, string, true, false, or null
+
+value    ::= object  |
+             array   |
+             number  |
+             string  |
+             'true'  |
+             'false' |
+             'null'  ;
+
+object   ::= '{' [objlist] '}';
+objlist  ::= pair [',' objlist];
+pair     ::= string ':' value;
+
+array    ::= '[' [vallist] ']';
+vallist  ::= value [',' vallist];
+
+XML translation:
+<a>34</a>  <--> { "a": "34" }
+An array value of a pair is translated to one element per array value:
+{ "a": [1, 2] } --> <a>1</a><a>2</a>
+
+ * The parser is a single-pass recursive descent parser on the input string. XML nodes are
+ * created directly while parsing, and each element is also completed while parsing:
+ * - When a member name is parsed: its RFC 7951 module name is translated to an XML
+ *   namespace and the element is bound to YANG
+ * - When its value is parsed: identityref values are translated and its children are sorted
+ * After the first YANG or namespace failure, only the syntax is parsed.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <ctype.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_string.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_map.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_json.h"
+#include "clixon_json_parse.h"
+
+/* Max nesting of JSON objects and arrays */
+#define JSON_PARSE_DEPTH_MAX 10000
+
+/* Max number of input characters shown in error messages */
+#define JSON_PARSE_ERRLEN 16
+
+static int json_parse_value(clixon_json_parser *jp, cxobj **xp, const char *prefix, int depth);
+
+/*! Syntax error, set clixon error with line number and input position
+ *
+ * @param[in]  jp      JSON parser
+ * @param[in]  reason  Reason of error
+ * @retval    -1       Always
+ */
+static int
+json_parse_error(clixon_json_parser *jp,
+                 const char         *reason)
+{
+    clixon_err(OE_JSON, 0, "json_parse: line %d: %s at or before: '%.*s'",
+               jp->jp_linenum, reason, JSON_PARSE_ERRLEN, jp->jp_p);
+    return -1;
+}
+
+/*! Skip whitespace and count lines
+ */
+static void
+json_parse_ws(clixon_json_parser *jp)
+{
+    const char *p = jp->jp_p;
+
+    for (;;){
+        switch (*p){
+        case '\n':
+            jp->jp_linenum++;
+            /* fall through */
+        case ' ':
+        case '\t':
+        case '\r':
+            p++;
+            break;
+        default:
+            jp->jp_p = p;
+            return;
+        }
+    }
+}
+
+/*! Element is created: translate module name to namespace and bind it to YANG
+ *
+ * @param[in]  jp  JSON parser
+ * @param[in]  x   New element, without children
+ * @retval     0   OK, or failed and jp_failed is set
+ * @retval    -1   Error
+ * @see json_parse_element_end
+ */
+static int
+json_parse_element_start(clixon_json_parser *jp,
+                         cxobj              *x)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    cxobj     *xs = NULL;
+    char      *modname;
+    yang_stmt *ymod;
+    yang_bind  yb;
+    cbuf      *cberr = NULL;
+    int        i;
+    int        ret;
+
+    if (jp->jp_failed)
+        goto ok;
+    xp = xml_parent(x);
+    modname = xml_prefix(x);
+    /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all
+     * members of a top-level JSON object, except for the top-level of config files
+     */
+    if (xp == jp->jp_xtop && jp->jp_rfc7951 && modname == NULL &&
+        (jp->jp_yb != YB_NONE || strcmp(xml_name(x), DATASTORE_TOP_SYMBOL) != 0)){
+        if ((cberr = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", xml_name(x));
+        if (jp->jp_xerr && netconf_malformed_message_xml(jp->jp_xerr, cbuf_get(cberr)) < 0)
+            goto done;
+        goto fail;
+    }
+    /* Module name is default namespace of element, see xml2json1_cbuf for the opposite */
+    if (modname != NULL){
+        /* Special case for return data on the form {"ietf-restconf:data":...} */
+        if (strcmp(modname, "ietf-restconf") == 0)
+            modname = "ietf-netconf";
+        if ((ymod = yang_find_module_by_name(jp->jp_yspec, modname)) == NULL){
+            if (jp->jp_xerr &&
+                netconf_unknown_namespace_xml(jp->jp_xerr, "application",
+                                              modname,
+                                              "No yang module found corresponding to prefix") < 0)
+                goto done;
+            goto fail;
+        }
+        if (xml_namespace_change(x, yang_find_mynamespace(ymod), NULL) < 0)
+            goto done;
+    }
+    /* Bind yang as in xml_parse_element_start, rpc is bound after parsing */
+    if (jp->jp_yb == YB_NONE || jp->jp_yb == YB_RPC)
+        goto ok;
+    if (xp == jp->jp_xtop){
+        if (jp->jp_yb == YB_MODULE_NEXT)
+            goto ok;
+        yb = jp->jp_yb;
+    }
+    else if (jp->jp_yb == YB_MODULE_NEXT && xml_parent(xp) == jp->jp_xtop)
+        yb = YB_MODULE;
+    else if (xml_spec(xp) != NULL)
+        yb = YB_PARENT;
+    else /* Parent is anydata or not bound */
+        goto ok;
+    /* Use previous sibling with same name as role model, eg list entries of an array */
+    if (yb == YB_PARENT &&
+        (i = xml_child_nr(xp)) > 1){
+        xs = xml_child_i(xp, i-2);
+        if (xml_type(xs) != CX_ELMNT ||
+            xml_spec(xs) == NULL ||
+            clicon_strcmp(xml_name(xs), xml_name(x)) != 0 ||
+            clicon_strcmp(xml_prefix(xs), xml_prefix(x)) != 0)
+            xs = NULL;
+    }
+    if ((ret = xml_bind_yang_node(NULL, x, yb, jp->jp_yspec, xs, jp->jp_xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+ ok:
+    retval = 0;
+ done:
+    if (cberr)
+        cbuf_free(cberr);
+    return retval;
+ fail:
+    jp->jp_failed = 1;
+    retval = 0;
+    goto done;
+}
+
+/*! Element is complete: translate identityref values, complete yang binding and sort
+ *
+ * @param[in]  jp  JSON parser
+ * @param[in]  x   Complete element
+ * @retval     0   OK, or failed and jp_failed is set
+ * @retval    -1   Error
+ * @see json_parse_element_start
+ */
+static int
+json_parse_element_end(clixon_json_parser *jp,
+                       cxobj              *x)
+{
+    yang_stmt    *y;
+    enum rfc_6020 keyword;
+    int           ret;
+
+    if (jp->jp_failed || jp->jp_yb == YB_NONE || jp->jp_yb == YB_RPC)
+        return 0;
+    if ((y = xml_spec(x)) != NULL){
+        keyword = yang_keyword_get(y);
+        if (keyword == Y_LEAF || keyword == Y_LEAF_LIST){
+            if ((ret = json2xml_decode(x, jp->jp_xerr)) < 0)
+                return -1;
+            if (ret == 0){
+                jp->jp_failed = 1;
+                return 0;
+            }
+        }
+        if (xml_bind_yang_node_done(x) < 0)
+            return -1;
+    }
+    if (xml_sort_verify(x, NULL) == -1 &&
+        xml_sort(x) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Parse JSON string, after the initial double quote, and decode escapes
+ *
+ * @param[in]  jp  JSON parser
+ * @param[in]  cb  String value, reset before parsing
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+json_parse_string(clixon_json_parser *jp,
+                  cbuf               *cb)
+{
+    const char *p = jp->jp_p;
+    size_t      n;
+    char        hex[5];
+    char        utf[5];
+    int         i;
+
+    cbuf_reset(cb);
+    for (;;){
+        /* Copy run of characters without escapes */
+        if ((n = strcspn(p, "\"\\\b\f\n\r\t")) > 0){
+            cbuf_append_buf(cb, (void*)p, n);
+            p += n;
+        }
+        switch (*p){
+        case '"':
+            jp->jp_p = p + 1;
+            return 0;
+        case '\\':
+            p++;
+            switch (*p){
+            case '"':
+            case '\\':
+            case '/':
+                cbuf_append(cb, *p);
+                break;
+            case 'b':
+                cbuf_append(cb, '\b');
+                break;
+            case 'f':
+                cbuf_append(cb, '\f');
+                break;
+            case 'n':
+                cbuf_append(cb, '\n');
+                break;
+            case 'r':
+                cbuf_append(cb, '\r');
+                break;
+            case 't':
+                cbuf_append(cb, '\t');
+                break;
+            case 'u':
+                for (i=0; i<4; i++){
+                    if (!isxdigit((unsigned char)p[i+1])){
+                        jp->jp_p = p;
+                        return json_parse_error(jp, "invalid unicode escape");
+                    }
+                    hex[i] = p[i+1];
+                }
+                hex[4] = '\0';
+                if (clixon_unicode2utf8(hex, utf, sizeof(utf)) < 0)
+                    return -1;
+                cbuf_append_str(cb, utf);
+                p += 4;
+                break;
+            default:
+                jp->jp_p = p;
+                return json_parse_error(jp, "invalid escape");
+            }
+            p++;
+            break;
+        default: /* Control character or end of input */
+            jp->jp_p = p;
+            return json_parse_error(jp, "unterminated string");
+        }
+    }
+}
+
+/*! Parse JSON number
+ *
+ * Leading zeros and a leading or trailing decimal point are accepted
+ * @param[in]  jp  JSON parser
+ * @param[in]  cb  Number as string, reset before parsing
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+json_parse_number(clixon_json_parser *jp,
+                  cbuf               *cb)
+{
+    const char *p = jp->jp_p;
+    const char *s;
+    size_t      ndigits;
+
+    if (*p == '-')
+        p++;
+    s = p;
+    while (isdigit((unsigned char)*p))
+        p++;
+    ndigits = p - s;
+    if (*p == '.'){
+        s = ++p;
+        while (isdigit((unsigned char)*p))
+            p++;
+        ndigits += p - s;
+    }
+    if (ndigits == 0)
+        return json_parse_error(jp, "invalid number");
+    if (*p == 'e' || *p == 'E'){
+        p++;
+        if (*p == '+' || *p == '-')
+            p++;
+        s = p;
+        while (isdigit((unsigned char)*p))
+            p++;
+        if (p == s)
+            return json_parse_error(jp, "invalid number");
+    }
+    cbuf_reset(cb);
+    cbuf_append_buf(cb, (void*)jp->jp_p, p - jp->jp_p);
+    jp->jp_p = p;
+    return 0;
+}
+
+/*! Add body to element
+ *
+ * @param[in]  x      Element
+ * @param[in]  value  Body value, or NULL for JSON null
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+json_parse_body(cxobj *x,
+                char  *value)
+{
+    cxobj *xb;
+
+    if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+        return -1;
+    if (value && xml_value_set(xb, value) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Next value of an array: complete element and create a new element with same name
+ *
+ * @param[in]     jp      JSON parser
+ * @param[in,out] xp      Element of previous value, on return new element
+ * @param[in]     prefix  JSON module name of element, or NULL
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+static int
+json_parse_copy(clixon_json_parser *jp,
+                cxobj             **xp,
+                const char         *prefix)
+{
+    cxobj *x = *xp;
+    cxobj *xn;
+
+    if (json_parse_element_end(jp, x) < 0)
+        return -1;
+    if ((xn = xml_new(xml_name(x), xml_parent(x), CX_ELMNT)) == NULL)
+        return -1;
+    if (prefix && xml_prefix_set(xn, (char*)prefix) < 0)
+        return -1;
+    if (json_parse_element_start(jp, xn) < 0)
+        return -1;
+    *xp = xn;
+    return 0;
+}
+
+/*! Parse object member: name : value
+ *
+ * @param[in]  jp     JSON parser
+ * @param[in]  xp     Parent element
+ * @param[in]  name   Member name, on the form <module>:<name> or <name>, modified
+ * @param[in]  depth  Nesting depth
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+json_parse_member(clixon_json_parser *jp,
+                  cxobj              *xp,
+                  char               *name,
+                  int                 depth)
+{
+    int    retval = -1;
+    cxobj *x;
+    char  *prefix = NULL;
+    char  *id;
+    char  *prefix0 = NULL;
+
+    /* Split name into prefix:name (extended JSON RFC7951) */
+    if ((id = strchr(name, ':')) != NULL){
+        *id++ = '\0';
+        prefix = name;
+    }
+    else
+        id = name;
+    if ((x = xml_new(id, xp, CX_ELMNT)) == NULL)
+        goto done;
+    if (prefix && xml_prefix_set(x, prefix) < 0)
+        goto done;
+    json_parse_ws(jp);
+    /* Module name is needed for new elements of an array, but is cleared by start */
+    if (prefix && *jp->jp_p == '[' &&
+        (prefix0 = strdup(prefix)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (json_parse_element_start(jp, x) < 0)
+        goto done;
+    if (json_parse_value(jp, &x, prefix0, depth) < 0)
+        goto done;
+    if (json_parse_element_end(jp, x) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (prefix0)
+        free(prefix0);
+    return retval;
+}
+
+/*! Parse JSON object, members are added as child elements
+ *
+ * @param[in]  jp     JSON parser
+ * @param[in]  xp     Element of object
+ * @param[in]  depth  Nesting depth
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+json_parse_object(clixon_json_parser *jp,
+                  cxobj              *xp,
+                  int                 depth)
+{
+    jp->jp_p++; /* { */
+    json_parse_ws(jp);
+    if (*jp->jp_p == '}'){
+        jp->jp_p++;
+        return 0;
+    }
+    for (;;){
+        json_parse_ws(jp);
+        if (*jp->jp_p != '"')
+            return json_parse_error(jp, "expected member name");
+        jp->jp_p++;
+        if (json_parse_string(jp, jp->jp_cb) < 0)
+            return -1;
+        json_parse_ws(jp);
+        if (*jp->jp_p != ':')
+            return json_parse_error(jp, "expected ':'");
+        jp->jp_p++;
+        if (json_parse_member(jp, xp, cbuf_get(jp->jp_cb), depth+1) < 0)
+            return -1;
+        json_parse_ws(jp);
+        switch (*jp->jp_p){
+        case ',':
+            jp->jp_p++;
+            break;
+        case '}':
+            jp->jp_p++;
+            return 0;
+        default:
+            return json_parse_error(jp, "expected ',' or '}'");
+        }
+    }
+}
+
+/*! Parse JSON array, each value is parsed into a new element with the same name
+ *
+ * An empty array gives an empty element. Values of a top-level array are all
+ * added to the top element.
+ * @param[in]     jp      JSON parser
+ * @param[in,out] xp      Element of array, on return element of last value
+ * @param[in]     prefix  JSON module name of element, or NULL
+ * @param[in]     depth   Nesting depth
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+static int
+json_parse_array(clixon_json_parser *jp,
+                 cxobj             **xp,
+                 const char         *prefix,
+                 int                 depth)
+{
+    jp->jp_p++; /* [ */
+    json_parse_ws(jp);
+    if (*jp->jp_p == ']'){
+        jp->jp_p++;
+        return 0;
+    }
+    for (;;){
+        if (json_parse_value(jp, xp, prefix, depth+1) < 0)
+            return -1;
+        json_parse_ws(jp);
+        switch (*jp->jp_p){
+        case ',':
+            jp->jp_p++;
+            if (*xp != jp->jp_xtop &&
+                json_parse_copy(jp, xp, prefix) < 0)
+                return -1;
+            break;
+        case ']':
+            jp->jp_p++;
+            return 0;
+        default:
+            return json_parse_error(jp, "expected ',' or ']'");
+        }
+    }
+}
+
+/*! Parse JSON value into an element
+ *
+ * @param[in]     jp      JSON parser
+ * @param[in,out] xp      Element of value, arrays may replace it, see json_parse_array
+ * @param[in]     prefix  JSON module name of element, or NULL
+ * @param[in]     depth   Nesting depth
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+static int
+json_parse_value(clixon_json_parser *jp,
+                 cxobj             **xp,
+                 const char         *prefix,
+                 int                 depth)
+{
+    const char *p;
+
+    if (depth > JSON_PARSE_DEPTH_MAX)
+        return json_parse_error(jp, "too deep nesting");
+    json_parse_ws(jp);
+    p = jp->jp_p;
+    switch (*p){
+    case '{':
+        return json_parse_object(jp, *xp, depth);
+    case '[':
+        return json_parse_array(jp, xp, prefix, depth);
+    case '"':
+        jp->jp_p++;
+        if (json_parse_string(jp, jp->jp_cb) < 0)
+            return -1;
+        return json_parse_body(*xp, cbuf_get(jp->jp_cb));
+    case 't':
+        if (strncmp(p, "true", 4) != 0)
+            break;
+        jp->jp_p += 4;
+        return json_parse_body(*xp, "true");
+    case 'f':
+        if (strncmp(p, "false", 5) != 0)
+            break;
+        jp->jp_p += 5;
+        return json_parse_body(*xp, "false");
+    case 'n':
+        if (strncmp(p, "null", 4) != 0)
+            break;
+        jp->jp_p += 4;
+        return json_parse_body(*xp, NULL);
+    case '-': case '.':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        if (json_parse_number(jp, jp->jp_cb) < 0)
+            return -1;
+        return json_parse_body(*xp, cbuf_get(jp->jp_cb));
+    default:
+        break;
+    }
+    return json_parse_error(jp, "syntax error");
+}
+
+/*! Parse a JSON string into the top element of the parser
+ *
+ * @param[in]  jp  JSON parser, with input string and top element set
+ * @retval     1   OK
+ * @retval     0   Parse OK but yang or namespace failed and jp_xerr set
+ * @retval    -1   Error
+ */
+int
+json_parse(clixon_json_parser *jp)
+{
+    cxobj *xt = jp->jp_xtop;
+
+    if (jp->jp_cb == NULL && (jp->jp_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        return -1;
+    }
+    if (jp->jp_p == NULL)
+        jp->jp_p = jp->jp_str;
+    json_parse_ws(jp);
+    if (*jp->jp_p == '\0')
+        return json_parse_error(jp, "empty input");
+    if (json_parse_value(jp, &xt, NULL, 0) < 0)
+        return -1;
+    json_parse_ws(jp);
+    if (*jp->jp_p != '\0')
+        return json_parse_error(jp, "trailing characters");
+    return jp->jp_failed ? 0 : 1;
+}
@@ -133,7 +133,6 @@ netconf_input_read2(int            s,
     int     restarts = 0;
     int     maxrestarts = 5;
 
-    memset(buf, 0, buflen);
     while ((len = read(s, buf, buflen)) < 0) {
         switch (errno){
         case EINTR:
@@ -197,6 +196,7 @@ netconf_input_msg2(unsigned char      **bufp,
     int       ret;
     int       found = 0;
     size_t    len;
+    size_t    n;
     char      ch;
 
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
@@ -205,6 +205,16 @@ netconf_input_msg2(unsigned char      **bufp,
         if ((ch = (*bufp)[i]) == 0)
             continue; /* Skip NULL chars (eg from terminals) */
         if (framing_type == NETCONF_SSH_CHUNKED){
+            /* Inside chunk-data: append rest of chunk in one go unless it contains NULL chars */
+            if (*frame_state == 4 && *frame_size > 0){
+                n = (*frame_size < len - i) ? *frame_size : len - i;
+                if (memchr(*bufp + i, 0, n) == NULL){
+                    cbuf_append_buf(cbmsg, *bufp + i, n);
+                    *frame_size -= n;
+                    i += n - 1;
+                    continue;
+                }
+            }
             /* Track chunked framing defined in RFC6242 */
             if ((ret = netconf_input_chunked_framing(ch, frame_state, frame_size)) < 0)
                 goto done;
@@ -2218,6 +2218,81 @@ netconf_output(int   s,
     return retval;
 }
             
+/*! Write all of a buffer on socket, continue on partial writes
+ *
+ * @param[in]   s    Socket
+ * @param[in]   buf  Buffer
+ * @param[in]   len  Length of buffer
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+netconf_write(int         s,
+              const char *buf,
+              size_t      len)
+{
+    ssize_t n;
+
+    while (len > 0){
+        if ((n = write(s, buf, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            if (errno == EPIPE)
+                clixon_debug(CLIXON_DBG_DEFAULT, "write err SIGPIPE");
+            else
+                clixon_log(NULL, LOG_ERR, "%s: write: %s", __FUNCTION__, strerror(errno));
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Send a part of an outgoing netconf message on socket with framing
+ *
+ * A message may be sent in several parts while it is serialized, where the last part
+ * has eom set. In chunked framing each part is sent as a chunk, in EOM framing the
+ * end-of-message marker is sent after the last part.
+ * The message is not copied to add framing, as with netconf_output_encap.
+ * @param[in]   s       Socket
+ * @param[in]   framing Framing type, ie EOM(1.0) or chunked (1.1)
+ * @param[in]   buf     Part of XML message
+ * @param[in]   len     Length of part, may be 0
+ * @param[in]   eom     If set, this is the last part of the message
+ * @retval      0       OK
+ * @retval     -1       Error
+ * @see clixon_writer_new  for streaming serialized output
+ */
+int
+netconf_output_part(int                  s,
+                    netconf_framing_type framing,
+                    char                *buf,
+                    size_t               len,
+                    int                  eom)
+{
+    char  hdr[32];
+    char *end;
+
+    clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Send ext part: len=%zu eom=%d", len, eom);
+    if (framing == NETCONF_SSH_CHUNKED && len > 0){
+        snprintf(hdr, sizeof(hdr), "\n#%zu\n", len);
+        if (netconf_write(s, hdr, strlen(hdr)) < 0)
+            return -1;
+    }
+    if (netconf_write(s, buf, len) < 0)
+        return -1;
+    if (eom){
+        if (framing == NETCONF_SSH_CHUNKED)
+            end = "\n##\n";     /* RFC6242 chunked-end */
+        else
+            end = "]]>]]>";     /* RFC4742 end-of-message marker */
+        if (netconf_write(s, end, strlen(end)) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 /*! Encapsulate and send outgoing netconf packet as cbuf on socket
  *
  * @param[in]   framing Framing type, ie EOM(1.0) or chunked (1.1)
@@ -136,6 +136,7 @@ static const map_str2int _FORMATS[] = {
     {"json",    FORMAT_JSON},
     {"cli",     FORMAT_CLI},
     {"netconf", FORMAT_NETCONF},
+    {"binary",  FORMAT_BINARY},
     {"default", FORMAT_DEFAULT},
     {NULL,      -1}
 };
@@ -168,7 +169,8 @@ format_str2int(char *str)
  * @param[in] dbglevel Debug level
  * @retval    0        OK
  * @retval   -1        Error
- * @note CLICON_FEATURE, CLICON_YANG_DIR and CLICON_SNMP_MIB are treated specially since they are lists
+ * @note CLICON_FEATURE, CLICON_YANG_DIR, CLICON_YANG_SEARCH_INDEX and CLICON_SNMP_MIB are treated
+ *       specially since they are lists
  * @note sub-config structs not shown: eg autocli/restconf
  * @see clicon_option_dump1  different formats
  * @see cli_show_options
@@ -220,6 +222,12 @@ clicon_option_dump(clixon_handle h,
             continue;
         clixon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
     }
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_YANG_SEARCH_INDEX") != 0)
+            continue;
+        clixon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
+    }
    retval = 0;
  done:
     if (keys)
@@ -380,6 +388,7 @@ merge_control_xml(clixon_handle h,
         /* List options for configure options that are lists or leaf-lists: append to main */
         if (strcmp(name,"CLICON_FEATURE") == 0 ||
             strcmp(name,"CLICON_YANG_DIR") == 0 ||
+            strcmp(name,"CLICON_YANG_SEARCH_INDEX") == 0 ||
             strcmp(name,"CLICON_SNMP_MIB") == 0){
             if ((x = xml_dup(xec)) == NULL)
                 goto done;
@@ -533,6 +542,8 @@ parse_configfile(clixon_handle  h,
             continue;
         if (strcmp(name,"CLICON_YANG_DIR")==0)
             continue;
+        if (strcmp(name,"CLICON_YANG_SEARCH_INDEX")==0)
+            continue;
         if (strcmp(name,"CLICON_SNMP_MIB")==0)
             continue;
         if (clicon_hash_add(copt,
@@ -587,6 +598,7 @@ clicon_option_add(clixon_handle h,
     }
     if (strcmp(name, "CLICON_FEATURE")==0 ||
         strcmp(name, "CLICON_YANG_DIR")==0 ||
+        strcmp(name, "CLICON_YANG_SEARCH_INDEX")==0 ||
         strcmp(name, "CLICON_SNMP_MIB")==0){
         if (clixon_xml_parse_va(YB_NONE, NULL, &xconfig, NULL, "<%s>%s</%s>",
                                 name, value, name) < 0)
@@ -55,6 +55,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/stat.h>
 #include <sys/param.h>
 #include <netinet/in.h>
@@ -84,6 +85,26 @@
 
 static int _atomicio_sig = 0;
 
+/* Size of read buffer of a connection, see clixon_msg_rcv11_buf */
+#define CLIXON_MSG_RCVBUF_SIZE 65536
+
+/*! Receive buffer of a connection
+ *
+ * Both the read buffer and the message buffer are reused for all messages on the
+ * connection. Input read beyond the end of one message is kept for the next.
+ * The framing state is kept between reads so that partial messages are not re-scanned
+ * @see clixon_msg_rcv11_buf
+ */
+struct clixon_msg_rcvbuf {
+    unsigned char *rb_buf;         /* Read buffer */
+    size_t         rb_off;         /* Start of unframed input in rb_buf */
+    size_t         rb_len;         /* End of input in rb_buf */
+    cbuf          *rb_msg;         /* Message being assembled */
+    int            rb_eom;         /* rb_msg is complete and was returned to caller */
+    int            rb_frame_state; /* Chunked framing state */
+    size_t         rb_frame_size;  /* Chunked framing size */
+};
+
 /*! Given family, addr str, port, return sockaddr and length
  *
  * @param[in]  addrtype  Address family: inet:ipv4-address or inet:ipv6-address
@@ -150,9 +171,15 @@ clicon_msg_encode(uint32_t    id,
     uint32_t           len;
     struct clicon_msg *msg = NULL;
     int                hdrlen = sizeof(*msg);
+    char              *str = NULL;
 
     va_start(args, format);
-    xmllen = vsnprintf(NULL, 0, format, args) + 1;
+    if (strcmp(format, "%s") == 0){ /* Common case: body is a single string, format once */
+        str = va_arg(args, char *);
+        xmllen = strlen(str) + 1;
+    }
+    else
+        xmllen = vsnprintf(NULL, 0, format, args) + 1;
     va_end(args);
 
     len = hdrlen + xmllen;
@@ -160,15 +187,17 @@ clicon_msg_encode(uint32_t    id,
         clixon_err(OE_PROTO, errno, "malloc");
         return NULL;
     }
-    memset(msg, 0, len);
     /* hdr */
     msg->op_len = htonl(len);
     msg->op_id = htonl(id);
     /* body */
-    va_start(args, format);
-    vsnprintf(msg->op_body, xmllen, format, args);
-    va_end(args);
-
+    if (str)
+        memcpy(msg->op_body, str, xmllen);
+    else {
+        va_start(args, format);
+        vsnprintf(msg->op_body, xmllen, format, args);
+        va_end(args);
+    }
     return msg;
 }
 
@@ -346,6 +375,60 @@ atomicio(ssize_t (*fn) (int, void *, size_t),
     return (pos);
 }
 
+/*! Ensure all of an I/O vector is written on socket
+ *
+ * Same as atomicio but for writev(2), error handling is the same.
+ * @param[in]     fd      File descriptor, eg socket
+ * @param[in,out] iov     I/O vector, modified on partial writes
+ * @param[in]     iovcnt  Number of elements in iov
+ * @retval        n       Bytes written
+ * @retval        0       EOF
+ * @retval       -1       Error
+ */
+static ssize_t
+atomicwritev(int           fd,
+             struct iovec *iov,
+             int           iovcnt)
+{
+    ssize_t res;
+    ssize_t pos = 0;
+
+    while (iovcnt > 0) {
+        _atomicio_sig = 0;
+        res = writev(fd, iov, iovcnt);
+        switch (res) {
+        case -1:
+            if (errno == EINTR){
+                if (_atomicio_sig == 0)
+                    continue;
+            }
+            else if (errno == EAGAIN)
+                continue;
+            else if (errno == ECONNRESET)/* Connection reset by peer */
+                res = 0;
+            else if (errno == EPIPE)     /* Client shutdown */
+                res = 0;
+            else if (errno == EBADF)     /* client shutdown - freebsd */
+                res = 0;
+        case 0: /* fall thru */
+            return (res);
+        default:
+            pos += res;
+            /* Skip written segments and adjust partially written segment */
+            while (iovcnt > 0 && (size_t)res >= iov->iov_len){
+                res -= iov->iov_len;
+                iov++;
+                iovcnt--;
+            }
+            if (iovcnt > 0){
+                iov->iov_base = (char*)iov->iov_base + res;
+                iov->iov_len -= res;
+            }
+        }
+    }
+    return (pos);
+}
+
 static int
 clixon_msg_send(int         s,
                 const char *descr,
@@ -494,27 +577,125 @@ clixon_rpc10(int         sock,
 
 /*================= NETCONF 1.1 Chunked framing ================*/
 
+/*! Send a part of a message given as segments using NETCONF 1.1 chunked framing
+ *
+ * The segments are sent as one chunk using writev(2), ie the message is not copied to
+ * add framing. A message may be sent as several chunks, where the last call has eom set
+ * and terminates the message with end-of-chunks. This is used to stream large replies
+ * while they are serialized.
+ * @param[in]   s       socket (unix or inet) to communicate with backend
+ * @param[in]   descr   Description of peer for logging
+ * @param[in]   iov     Message segments
+ * @param[in]   iovcnt  Number of segments, at most CLIXON_MSG_IOV_MAX
+ * @param[in]   eom     If set, terminate message with end-of-chunks
+ * @retval      0       OK
+ * @retval     -1       Error
+ * @see clixon_msg_send11_iov  Complete message
+ */
+int
+clixon_msg_send11_chunk(int                 s,
+                        const char         *descr,
+                        const struct iovec *iov,
+                        int                 iovcnt,
+                        int                 eom)
+{
+    int          retval = -1;
+    struct iovec v[CLIXON_MSG_IOV_MAX+2];
+    char         hdr[32];
+    size_t       len = 0;
+    int          n = 0;
+    int          i;
+    cbuf        *cb = NULL;
+
+    if (iovcnt > CLIXON_MSG_IOV_MAX){
+        clixon_err(OE_PROTO, EINVAL, "Too many segments: %d", iovcnt);
+        goto done;
+    }
+    for (i=0; i<iovcnt; i++)
+        len += iov[i].iov_len;
+    clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "send msg len=%zu eom=%d", len, eom);
+    if (clixon_debug_isset(CLIXON_DBG_MSG)){
+        if ((cb = cbuf_new_alloc(len+1)) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+            goto done;
+        }
+        for (i=0; i<iovcnt; i++)
+            cbuf_append_buf(cb, iov[i].iov_base, iov[i].iov_len);
+        if (descr)
+            clixon_debug(CLIXON_DBG_MSG, "Send [%s]: %s", descr, cbuf_get(cb));
+        else
+            clixon_debug(CLIXON_DBG_MSG, "Send: %s", cbuf_get(cb));
+    }
+    /* RFC6242 chunk-size is [1-9][0-9]*, an empty message is only end-of-chunks */
+    if (len > 0){
+        snprintf(hdr, sizeof(hdr), "\n#%zu\n", len);
+        v[n].iov_base = hdr;
+        v[n++].iov_len = strlen(hdr);
+        for (i=0; i<iovcnt; i++)
+            v[n++] = iov[i];
+    }
+    if (eom){
+        v[n].iov_base = "\n##\n";
+        v[n++].iov_len = strlen("\n##\n");
+    }
+    if (n > 0 && atomicwritev(s, v, n) < 0){
+        clixon_err(OE_CFG, errno, "atomicwritev");
+        clixon_log(NULL, LOG_WARNING, "%s: writev: %s", __FUNCTION__, strerror(errno));
+        goto done;
+    }
+    retval = 0;
+  done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send a message given as segments using NETCONF 1.1 chunked framing
+ *
+ * The segments are sent as one chunk using writev(2), ie the message is not copied to
+ * add framing.
+ * @param[in]   s       socket (unix or inet) to communicate with backend
+ * @param[in]   descr   Description of peer for logging
+ * @param[in]   iov     Message segments
+ * @param[in]   iovcnt  Number of segments, at most CLIXON_MSG_IOV_MAX
+ * @retval      0       OK
+ * @retval     -1       Error
+ * @code
+ *   struct iovec iov[2] = {{hdr, strlen(hdr)}, {cbuf_get(cb), cbuf_len(cb)}};
+ *   if (clixon_msg_send11_iov(s, NULL, iov, 2) < 0)
+ *      err;
+ * @endcode
+ * @see clixon_msg_send11  Message in a single cbuf
+ */
+int
+clixon_msg_send11_iov(int                 s,
+                      const char         *descr,
+                      const struct iovec *iov,
+                      int                 iovcnt)
+{
+    return clixon_msg_send11_chunk(s, descr, iov, iovcnt, 1);
+}
+
 /*! Send a message using NETCONF 1.1 w chunked framing
  *
  * @param[in]   s      socket (unix or inet) to communicate with backend
  * @param[in]   descr  Description of peer for logging
- * @param[out]  msg    CLICON msg data reply structure. Free with free()
+ * @param[in]   cb     Message, not modified
+ * @retval      0      OK
+ * @retval     -1      Error
  * @see clixon_msg_send10  1.0 EOM
+ * @see clixon_msg_send11_iov  Message in several segments
  */
-static int
+int
 clixon_msg_send11(int         s,
                   const char *descr,
                   cbuf       *cb)
 {
-    int retval = -1;
+    struct iovec iov[1];
 
-    if (netconf_output_encap(NETCONF_SSH_CHUNKED, cb) < 0)
-        goto done;
-    if (clixon_msg_send(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
-  done:
-    return retval;
+    iov[0].iov_base = cbuf_get(cb);
+    iov[0].iov_len = cbuf_len(cb);
+    return clixon_msg_send11_iov(s, descr, iov, 1);
 }
 
 static void
@@ -627,6 +808,164 @@ clixon_msg_rcv11(int         s,
     return retval;
 }
 
+/*! Create receive buffer of a connection
+ *
+ * @retval  rb    Receive buffer, free with clixon_msg_rcvbuf_free
+ * @retval  NULL  Error
+ */
+clixon_msg_rcvbuf *
+clixon_msg_rcvbuf_new(void)
+{
+    clixon_msg_rcvbuf *rb;
+
+    if ((rb = malloc(sizeof(*rb))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(rb, 0, sizeof(*rb));
+    if ((rb->rb_buf = malloc(CLIXON_MSG_RCVBUF_SIZE)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        clixon_msg_rcvbuf_free(rb);
+        return NULL;
+    }
+    if ((rb->rb_msg = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        clixon_msg_rcvbuf_free(rb);
+        return NULL;
+    }
+    return rb;
+}
+
+/*! Free receive buffer
+ *
+ * @param[in]  rb   Receive buffer
+ * @retval     0    OK
+ */
+int
+clixon_msg_rcvbuf_free(clixon_msg_rcvbuf *rb)
+{
+    if (rb->rb_buf)
+        free(rb->rb_buf);
+    if (rb->rb_msg)
+        cbuf_free(rb->rb_msg);
+    free(rb);
+    return 0;
+}
+
+/*! Frame unframed input of receive buffer into the message being assembled
+ *
+ * @param[in]  rb    Receive buffer
+ * @param[out] eom   Set if a complete message is in rb_msg
+ * @retval     0     OK
+ * @retval    -1     Framing error
+ */
+static int
+clixon_msg_rcvbuf_frame(clixon_msg_rcvbuf *rb,
+                        int               *eom)
+{
+    unsigned char *p = rb->rb_buf + rb->rb_off;
+    size_t         plen = rb->rb_len - rb->rb_off;
+
+    *eom = 0;
+    while (plen > 0 && *eom == 0){
+        if (netconf_input_msg2(&p, &plen,
+                               rb->rb_msg,
+                               NETCONF_SSH_CHUNKED,
+                               &rb->rb_frame_state,
+                               &rb->rb_frame_size,
+                               eom) < 0)
+            return -1;
+    }
+    rb->rb_off = rb->rb_len - plen;
+    return 0;
+}
+
+/*! Receive one message using NETCONF 1.1 chunked framing, keeping any remaining input
+ *
+ * Several messages may be in transit on the socket. Input following a complete message
+ * is saved in the receive buffer and is returned on the next call.
+ * A buffered message is returned without reading. Otherwise, if s is a socket, at most
+ * one read is made, ie the call does not block if s is readable.
+ * The returned message is owned by the receive buffer and is valid until the next call,
+ * its buffer is reused for the next message.
+ * Typical use is in an event callback:
+ * @code
+ *   if (clixon_msg_rcv11_buf(s, descr, rb, &cb, &eof) < 0)
+ *      err;
+ *   while (!eof && cb != NULL){
+ *      handle(cb);
+ *      if (clixon_msg_rcv11_buf(-1, descr, rb, &cb, &eof) < 0)
+ *         err;
+ *   }
+ * @endcode
+ * @param[in]   s      Socket to read from, or -1 to only return buffered messages
+ * @param[in]   descr  Description of peer for logging
+ * @param[in]   rb     Receive buffer of this connection
+ * @param[out]  cb     Complete message, or NULL if none available yet. Do not free
+ * @param[out]  eof    Set if eof or framing error encountered
+ * @retval      0      OK (check eof and cb)
+ * @retval     -1      Error
+ * @see clixon_msg_rcv11  Receive of a single message in a new buffer
+ */
+int
+clixon_msg_rcv11_buf(int                s,
+                     const char        *descr,
+                     clixon_msg_rcvbuf *rb,
+                     cbuf             **cb,
+                     int               *eof)
+{
+    int     retval = -1;
+    ssize_t len;
+    int     eom = 0;
+
+    *cb = NULL;
+    *eof = 0;
+    if (rb->rb_eom){
+        cbuf_reset(rb->rb_msg);
+        rb->rb_eom = 0;
+    }
+    /* First frame input remaining from previous read */
+    if (rb->rb_off < rb->rb_len &&
+        clixon_msg_rcvbuf_frame(rb, &eom) < 0)
+        goto fail;
+    if (eom == 0 && s >= 0){
+        if ((len = netconf_input_read2(s, rb->rb_buf, CLIXON_MSG_RCVBUF_SIZE, eof)) < 0)
+            goto done;
+        if (*eof)
+            goto eof;
+        rb->rb_off = 0;
+        rb->rb_len = len;
+        if (clixon_msg_rcvbuf_frame(rb, &eom) < 0)
+            goto fail;
+    }
+    if (eom){
+        if (descr)
+            clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: %s", descr, cbuf_get(rb->rb_msg));
+        else
+            clixon_debug(CLIXON_DBG_MSG, "Recv: %s", cbuf_get(rb->rb_msg));
+        *cb = rb->rb_msg;
+        rb->rb_eom = 1;
+        rb->rb_frame_state = 0;
+        rb->rb_frame_size = 0;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+ fail: /* Errors from input are only framing errors, non-fatal, return eof */
+    *eof = 1;
+ eof: /* Discard any partial message, the connection is not usable */
+    cbuf_reset(rb->rb_msg);
+    rb->rb_off = rb->rb_len = 0;
+    rb->rb_frame_state = 0;
+    rb->rb_frame_size = 0;
+    if (descr)
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: EOF", descr);
+    else
+        clixon_debug(CLIXON_DBG_MSG, "Recv: EOF");
+    goto ok;
+}
+
 /*! Send a NETCONF message and wait for result.
  *
  * TBD: timeout, interrupt?
@@ -649,21 +988,15 @@ clicon_rpc(int                sock,
            char             **ret,
            int               *eof)
 {
-    int                retval = -1;
-    struct clicon_msg *reply = NULL;
-    cbuf              *cbsend = NULL;
-    cbuf              *cbrcv = NULL;
+    int          retval = -1;
+    cbuf        *cbrcv = NULL;
+    struct iovec iov[1];
 
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
-    if ((cbsend = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(cbsend, "%s", msg->op_body);
-    if (clixon_msg_send11(sock, descr, cbsend) < 0)
+    iov[0].iov_base = msg->op_body;
+    iov[0].iov_len = strlen(msg->op_body);
+    if (clixon_msg_send11_iov(sock, descr, iov, 1) < 0)
         goto done;
-    if (cbsend)
-        cbuf_free(cbsend);
     if (clixon_msg_rcv11(sock, descr, 0, &cbrcv, eof) < 0)
         goto done;
     if (*eof)
@@ -673,14 +1006,54 @@ clicon_rpc(int                sock,
             clixon_err(OE_UNIX, errno, "strdup");
             goto done;
         }
-        cbuf_free(cbrcv);
     }
  ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "retval:%d", retval);
-    if (reply)
-        free(reply);
+    if (cbrcv)
+        cbuf_free(cbrcv);
+    return retval;
+}
+
+/*! Send a NETCONF message and wait for result using a receive buffer of the connection
+ *
+ * As clicon_rpc but the reply is not copied, the buffers of rb are reused by all
+ * requests on the connection
+ * @param[in]  sock   Socket / file descriptor
+ * @param[in]  descr  Description of peer for logging
+ * @param[in]  msg    Clixon msg data structure. It has fixed header and variable body.
+ * @param[in]  rb     Receive buffer of socket
+ * @param[out] cbret  Reply, owned by rb and valid until next receive on rb
+ * @param[out] eof    Set if eof encountered
+ * @retval     0      OK (check eof)
+ * @retval    -1      Error
+ * @see clicon_rpc
+ */
+int
+clicon_rpc_buf(int                sock,
+               const char        *descr,
+               struct clicon_msg *msg,
+               clixon_msg_rcvbuf *rb,
+               cbuf             **cbret,
+               int               *eof)
+{
+    int          retval = -1;
+    struct iovec iov[1];
+
+    clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
+    *cbret = NULL;
+    iov[0].iov_base = msg->op_body;
+    iov[0].iov_len = strlen(msg->op_body);
+    if (clixon_msg_send11_iov(sock, descr, iov, 1) < 0)
+        goto done;
+    do {
+        if (clixon_msg_rcv11_buf(sock, descr, rb, cbret, eof) < 0)
+            goto done;
+    } while (*eof == 0 && *cbret == NULL);
+    retval = 0;
+ done:
+    clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "retval:%d", retval);
     return retval;
 }
 
@@ -699,24 +1072,14 @@ send_msg_reply(int         s,
                char       *data,
                uint32_t    datalen)
 {
-    int                retval = -1;
-    cbuf          *cb = NULL;
+    struct iovec iov[1];
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    if (cbuf_append_buf(cb, data, datalen) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
-        goto done;
-    }
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    /* Trailing null character is not sent */
+    if (datalen > 0 && data[datalen-1] == '\0')
+        datalen--;
+    iov[0].iov_base = data;
+    iov[0].iov_len = datalen;
+    return clixon_msg_send11_iov(s, descr, iov, 1);
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
@@ -733,21 +1096,11 @@ send_msg_notify(int         s,
                 const char *descr,
                 char       *msg)
 {
-    int   retval = -1;
-    cbuf *cb = NULL;
+    struct iovec iov[1];
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(cb, "%s", msg);
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    iov[0].iov_base = msg;
+    iov[0].iov_len = strlen(msg);
+    return clixon_msg_send11_iov(s, descr, iov, 1);
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
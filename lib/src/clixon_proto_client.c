@@ -184,6 +184,94 @@ clicon_rpc_msg_once(clixon_handle      h,
     return retval;
 }
 
+/*! Get receive buffer of cached client socket
+ *
+ * The buffer is reused by all requests on the cached socket
+ * @param[in]  h    Clixon handle
+ * @retval     rb   Receive buffer
+ * @retval     NULL Error
+ */
+static clixon_msg_rcvbuf *
+clicon_client_rcvbuf(clixon_handle h)
+{
+    clixon_msg_rcvbuf *rb = NULL;
+
+    if (clicon_ptr_get(h, "client-rcvbuf", (void**)&rb) < 0 || rb == NULL){
+        if ((rb = clixon_msg_rcvbuf_new()) == NULL)
+            return NULL;
+        if (clicon_ptr_set(h, "client-rcvbuf", rb) < 0){
+            clixon_msg_rcvbuf_free(rb);
+            return NULL;
+        }
+    }
+    return rb;
+}
+
+/*! Close cached client socket and free its receive buffer
+ *
+ * @param[in]  h    Clixon handle
+ * @see clicon_client_rcvbuf
+ */
+static void
+clicon_client_socket_close(clixon_handle h)
+{
+    int                s;
+    clixon_msg_rcvbuf *rb = NULL;
+
+    if ((s = clicon_client_socket_get(h)) >= 0){
+        close(s);
+        clicon_client_socket_set(h, -1);
+    }
+    if (clicon_ptr_get(h, "client-rcvbuf", (void**)&rb) == 0){
+        if (rb)
+            clixon_msg_rcvbuf_free(rb);
+        clicon_ptr_del(h, "client-rcvbuf");
+    }
+}
+
+/*! Connect to backend or use cached socket and send RPC, receive reply without copying
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  msg      Encoded message
+ * @param[out] retdata  Returned data, valid until next request on cached socket
+ * @param[out] eof      Set if eof encountered
+ * @param[out] sp       Returned socket
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see clicon_rpc_msg_once
+ */
+static int
+clicon_rpc_msg_cached(clixon_handle      h,
+                      struct clicon_msg *msg,
+                      char             **retdata,
+                      int               *eof,
+                      int               *sp)
+{
+    int                retval = -1;
+    int                s;
+    clixon_msg_rcvbuf *rb;
+    cbuf              *cb = NULL;
+
+    if ((rb = clicon_client_rcvbuf(h)) == NULL)
+        goto done;
+    if ((s = clicon_client_socket_get(h)) < 0){
+        if (clicon_rpc_connect(h, &s) < 0)
+            goto done;
+        clicon_client_socket_set(h, s);
+    }
+    if (clicon_rpc_buf(s, clicon_sock_str(h), msg, rb, &cb, eof) < 0){
+        /* 2. check socket shutdown AFTER rpc, also discard partial input */
+        clicon_client_socket_close(h);
+        goto done;
+    }
+    *retdata = cb ? cbuf_get(cb) : NULL;
+    if (sp)
+        *sp = s;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Send internal netconf rpc from client to backend
  *
  * @param[in]    h      Clixon handle
@@ -202,7 +290,7 @@ clicon_rpc_msg(clixon_handle      h,
                cxobj            **xret0)
 {
     int     retval = -1;
-    char   *retdata = NULL;
+    char   *retdata = NULL; /* Owned by receive buffer of cached socket */
     cxobj  *xret = NULL;
     int     s = -1;
     int     eof = 0;
@@ -212,21 +300,18 @@ clicon_rpc_msg(clixon_handle      h,
     assert(strstr(msg->op_body, "username")!=NULL); /* XXX */
 #endif
     /* Create a socket and connect to it, either UNIX, IPv4 or IPv6 per config options */
-    if (clicon_rpc_msg_once(h, msg, 1, &retdata, &eof, &s) < 0)
+    if (clicon_rpc_msg_cached(h, msg, &retdata, &eof, &s) < 0)
         goto done;
     if (eof){
         /* 2. check socket shutdown AFTER rpc */
-        close(s);
+        clicon_client_socket_close(h);
         s = -1;
-        clicon_client_socket_set(h, -1);
 #ifdef PROTO_RESTART_RECONNECT
         if (!clixon_exit_get()) { /* May be part of termination */
-            if (clicon_rpc_msg_once(h, msg, 1, &retdata, &eof, NULL) < 0)
+            if (clicon_rpc_msg_cached(h, msg, &retdata, &eof, NULL) < 0)
                 goto done;
             if (eof){
-                close(s);
-                s = -1;
-                clicon_client_socket_set(h, -1);
+                clicon_client_socket_close(h);
                 clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
                 goto done;
             }
@@ -245,6 +330,8 @@ clicon_rpc_msg(clixon_handle      h,
         /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
          * to reply.
          */
+        if ((xret = xml_new_arena(XML_TOP_SYMBOL, CX_ELMNT)) == NULL)
+            goto done;
         if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
             goto done;
     }
@@ -255,8 +342,6 @@ clicon_rpc_msg(clixon_handle      h,
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
-    if (retdata)
-        free(retdata);
     if (xret)
         xml_free(xret);
     return retval;
@@ -313,6 +398,8 @@ clicon_rpc_msg_persistent(clixon_handle      h,
         /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
          * to reply.
          */
+        if ((xret = xml_new_arena(XML_TOP_SYMBOL, CX_ELMNT)) == NULL)
+            goto done;
         if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
             goto done;
     }
@@ -1317,7 +1404,6 @@ clicon_rpc_close_session(clixon_handle h)
     cxobj             *xerr;
     char              *username;
     uint32_t           session_id;
-    int                s;
     cbuf              *cb = NULL;
 
     if (session_id_check(h, &session_id) < 0)
@@ -1340,16 +1426,13 @@ clicon_rpc_close_session(clixon_handle h)
         goto done;
     if (clicon_rpc_msg(h, msg, &xret) < 0)
         goto done;
-    if ((s = clicon_client_socket_get(h)) >= 0){
-        close(s);
-        clicon_client_socket_set(h, -1);
-    }
     if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
         clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Close session");
         goto done;
     }
     retval = 0;
  done:
+    clicon_client_socket_close(h);
     if (cb)
         cbuf_free(cb);
     if (xret)
@@ -1980,3 +2063,304 @@ clicon_rpc_restart_plugin(clixon_handle h,
         xml_free(xret);
     return retval;
 }
+
+/*! Outstanding request on a pipelined backend connection
+ */
+struct clicon_rpc_pending {
+    qelem_t             rp_qelem; /* List header */
+    char               *rp_id;    /* Message-id of request */
+    clicon_rpc_pipe_cb *rp_fn;    /* Completion callback */
+    void               *rp_arg;   /* Callback argument */
+};
+
+/*! Pipelined backend connection with several outstanding requests
+ */
+struct clicon_rpc_pipe {
+    clixon_handle              cp_h;       /* Clixon handle */
+    int                        cp_s;       /* Socket to backend */
+    int                        cp_depth;   /* Max number of outstanding requests */
+    int                        cp_nr;      /* Current number of outstanding requests */
+    struct clicon_rpc_pending *cp_pending; /* Outstanding requests in send order */
+    clixon_msg_rcvbuf         *cp_rb;      /* Input following last received reply */
+};
+
+/*! Open a pipelined connection to the backend
+ *
+ * Up to depth requests may be outstanding on the connection. Replies are correlated with
+ * requests by message-id and delivered to the completion callback of each request.
+ * The connection uses its own socket and is therefore a separate backend session, ie
+ * locks are not shared with clicon_rpc_msg
+ * @param[in]  h      Clixon handle
+ * @param[in]  depth  Max number of outstanding requests, >= 1
+ * @retval     cp     Pipelined connection, free with clicon_rpc_pipe_free
+ * @retval     NULL   Error
+ * @code
+ *   clicon_rpc_pipe *cp;
+ *
+ *   if ((cp = clicon_rpc_pipe_new(h, 64)) == NULL)
+ *      err;
+ *   for (i=0; i<n; i++)
+ *      if (clicon_rpc_pipe_send(cp, "<get-config><source><running/></source></get-config>", reply_cb, arg) < 0)
+ *         err;
+ *   if (clicon_rpc_pipe_drain(cp) < 0)
+ *      err;
+ *   clicon_rpc_pipe_free(cp);
+ * @endcode
+ * @see clicon_rpc_pipe_input  For use as event loop callback
+ */
+clicon_rpc_pipe *
+clicon_rpc_pipe_new(clixon_handle h,
+                    int           depth)
+{
+    clicon_rpc_pipe *cp = NULL;
+    int              s = -1;
+
+    if (depth < 1){
+        clixon_err(OE_PROTO, EINVAL, "Pipeline depth %d < 1", depth);
+        goto done;
+    }
+    if (clicon_rpc_connect(h, &s) < 0)
+        goto done;
+    if ((cp = malloc(sizeof(*cp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(cp, 0, sizeof(*cp));
+    cp->cp_h = h;
+    cp->cp_s = s;
+    cp->cp_depth = depth;
+    s = -1;
+    if ((cp->cp_rb = clixon_msg_rcvbuf_new()) == NULL){
+        clicon_rpc_pipe_free(cp);
+        cp = NULL;
+        goto done;
+    }
+ done:
+    if (s >= 0)
+        close(s);
+    return cp;
+}
+
+/*! Close a pipelined connection
+ *
+ * Outstanding requests are discarded without calling their callbacks
+ * @param[in]  cp   Pipelined connection
+ * @retval     0    OK
+ */
+int
+clicon_rpc_pipe_free(clicon_rpc_pipe *cp)
+{
+    struct clicon_rpc_pending *rp;
+
+    while ((rp = cp->cp_pending) != NULL){
+        DELQ(rp, cp->cp_pending, struct clicon_rpc_pending *);
+        if (rp->rp_id)
+            free(rp->rp_id);
+        free(rp);
+    }
+    if (cp->cp_rb)
+        clixon_msg_rcvbuf_free(cp->cp_rb);
+    if (cp->cp_s >= 0)
+        close(cp->cp_s);
+    free(cp);
+    return 0;
+}
+
+/*! Get socket of pipelined connection, eg for registering in event loop
+ *
+ * @param[in]  cp   Pipelined connection
+ * @retval     s    Socket
+ */
+int
+clicon_rpc_pipe_fd(clicon_rpc_pipe *cp)
+{
+    return cp->cp_s;
+}
+
+/*! Get number of outstanding requests of pipelined connection
+ *
+ * @param[in]  cp   Pipelined connection
+ * @retval     nr   Number of requests sent but not yet replied to
+ */
+int
+clicon_rpc_pipe_outstanding(clicon_rpc_pipe *cp)
+{
+    return cp->cp_nr;
+}
+
+/*! Dispatch one reply to the callback of its request
+ *
+ * @param[in]  cp    Pipelined connection
+ * @param[in]  str   Reply message
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+clicon_rpc_pipe_reply(clicon_rpc_pipe *cp,
+                      char            *str)
+{
+    int                        retval = -1;
+    cxobj                     *xret = NULL;
+    cxobj                     *xreply;
+    char                      *id = NULL;
+    struct clicon_rpc_pending *rp;
+
+    if ((xret = xml_new_arena(XML_TOP_SYMBOL, CX_ELMNT)) == NULL)
+        goto done;
+    if (clixon_xml_parse_string(str, YB_NONE, NULL, &xret, NULL) < 0)
+        goto done;
+    if ((xreply = xml_find_type(xret, NULL, "rpc-reply", CX_ELMNT)) != NULL)
+        id = xml_find_type_value(xreply, NULL, "message-id", CX_ATTR);
+    /* Without message-id, eg a framing error, the backend replies in request order */
+    if ((rp = cp->cp_pending) != NULL && id != NULL){
+        do {
+            if (strcmp(rp->rp_id, id) == 0)
+                break;
+            rp = NEXTQ(struct clicon_rpc_pending *, rp);
+        } while (rp != cp->cp_pending);
+        if (strcmp(rp->rp_id, id) != 0)
+            rp = NULL;
+    }
+    if (rp == NULL){
+        clixon_err(OE_PROTO, EINVAL, "Unexpected reply message-id:%s", id?id:"none");
+        goto done;
+    }
+    DELQ(rp, cp->cp_pending, struct clicon_rpc_pending *);
+    cp->cp_nr--;
+    if (rp->rp_fn && rp->rp_fn(cp->cp_h, xret, rp->rp_arg) < 0){
+        free(rp->rp_id);
+        free(rp);
+        goto done;
+    }
+    free(rp->rp_id);
+    free(rp);
+    retval = 0;
+ done:
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Read replies from pipelined connection and call request callbacks
+ *
+ * Makes one read from the socket, which blocks if no input is available, and dispatches
+ * all complete replies.
+ * Can be registered as event callback:
+ * @code
+ *   clixon_event_reg_fd(clicon_rpc_pipe_fd(cp), clicon_rpc_pipe_input, cp, "backend pipe");
+ * @endcode
+ * @param[in]  s    Socket of pipelined connection
+ * @param[in]  arg  Pipelined connection
+ * @retval     0    OK
+ * @retval    -1    Error, including unexpected close of backend socket
+ */
+int
+clicon_rpc_pipe_input(int   s,
+                      void *arg)
+{
+    int              retval = -1;
+    clicon_rpc_pipe *cp = (clicon_rpc_pipe *)arg;
+    cbuf            *cb = NULL;
+    int              eof = 0;
+
+    if (clixon_msg_rcv11_buf(s, clicon_sock_str(cp->cp_h), cp->cp_rb, &cb, &eof) < 0)
+        goto done;
+    while (!eof && cb != NULL){
+        if (clicon_rpc_pipe_reply(cp, cbuf_get(cb)) < 0)
+            goto done;
+        if (clixon_msg_rcv11_buf(-1, NULL, cp->cp_rb, &cb, &eof) < 0)
+            goto done;
+    }
+    if (eof){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send a request on a pipelined connection without waiting for its reply
+ *
+ * If the max number of requests are outstanding, wait for replies first.
+ * The request is wrapped in an <rpc> with a new message-id.
+ * The callback is called with the reply as: fn(h, xret, arg), where xret is
+ * <rpc-reply> or an error, as in clicon_rpc_msg. xret is freed after the callback returns.
+ * @param[in]  cp    Pipelined connection
+ * @param[in]  body  RPC body as XML string, eg <get-config>...</get-config>
+ * @param[in]  fn    Completion callback, or NULL
+ * @param[in]  arg   Argument to callback
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+clicon_rpc_pipe_send(clicon_rpc_pipe    *cp,
+                     const char         *body,
+                     clicon_rpc_pipe_cb *fn,
+                     void               *arg)
+{
+    int                        retval = -1;
+    clixon_handle              h = cp->cp_h;
+    cbuf                      *cb = NULL;
+    char                      *username;
+    struct clicon_rpc_pending *rp = NULL;
+    int                        id;
+
+    while (cp->cp_nr >= cp->cp_depth)
+        if (clicon_rpc_pipe_input(cp->cp_s, cp) < 0)
+            goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    id = netconf_message_id_next(h);
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " message-id=\"%d\">%s</rpc>", id, body);
+    if ((rp = malloc(sizeof(*rp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(rp, 0, sizeof(*rp));
+    if ((rp->rp_id = malloc(16)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    snprintf(rp->rp_id, 16, "%d", id);
+    rp->rp_fn = fn;
+    rp->rp_arg = arg;
+    if (clixon_msg_send11(cp->cp_s, clicon_sock_str(h), cb) < 0)
+        goto done;
+    ADDQ(rp, cp->cp_pending);
+    rp = NULL;
+    cp->cp_nr++;
+    retval = 0;
+ done:
+    if (rp){
+        if (rp->rp_id)
+            free(rp->rp_id);
+        free(rp);
+    }
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Wait for replies to all outstanding requests on a pipelined connection
+ *
+ * @param[in]  cp    Pipelined connection
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+clicon_rpc_pipe_drain(clicon_rpc_pipe *cp)
+{
+    while (cp->cp_nr > 0)
+        if (clicon_rpc_pipe_input(cp->cp_s, cp) < 0)
+            return -1;
+    return 0;
+}
@@ -458,6 +458,10 @@ uri_percent_decode(char  *enc,
     return retval;
 }
 
+/* Characters that are encoded by xml_chardata_cbuf_append, without and with quote */
+#define XML_CHARDATA_ESC       "&<>"
+#define XML_CHARDATA_ESC_QUOTE "&<>'\""
+
 /*! Encode escape characters according to XML definition
  *
  * @param[out]  encp   Encoded malloced output string
@@ -482,7 +486,7 @@ uri_percent_decode(char  *enc,
  * @see https://www.w3.org/TR/2008/REC-xml-20081126/#syntax chapter 2.6
  * @see uri_percent_encode
  * @see AMPERSAND mode in clixon_xml_parse.l, implicit decoding
- * @see xml_chardata_cbuf_append for a specialized version
+ * @see xml_chardata_cbuf_append which does the encoding
  * @see xml_chardata_decode for decoding
  */
 int
@@ -494,12 +498,8 @@ xml_chardata_encode(char      **escp,
     char   *str = NULL;  /* Expanded format string w stdarg */
     int     fmtlen;
     char   *esc = NULL;
-    int     l;
-    int     len;
-    int     i, j;
-    int     cdata; /* when set, skip encoding */
+    cbuf   *cb = NULL;
     va_list args;
-    size_t  slen;
 
     /* Two steps: (1) read in the complete format string */
     va_start(args, fmt); /* dryrun */
@@ -513,134 +513,39 @@ xml_chardata_encode(char      **escp,
     va_start(args, fmt); /* real */
     fmtlen = vsnprintf(str, fmtlen, fmt, args) + 1;
     va_end(args);
-    /* Now str is the combined fmt + ... 
+    /* Now str is the combined fmt + ...
      * Step (2) encode and expand str --> enc
-     * First compute length (do nothing) */
-    len = 0; cdata = 0;
-    slen = strlen(str);
-    for (i=0; i<slen; i++){
-        if (cdata){
-            if (strncmp(&str[i], "]]>", strlen("]]>")) == 0)
-                cdata = 0;
-            len++;
-        }
-        else
-            switch (str[i]){
-            case '&':
-                len += strlen("&amp;");
-                break;
-            case '<':
-                if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-                    len++;
-                    cdata++;
-                }
-                else
-                    len += strlen("&lt;");
-                break;
-            case '>':
-                len += strlen("&gt;");
-                break;
-            case '\'':
-                if (quote)
-                    len += strlen("&apos;");
-                else
-                    len++;
-            break;
-            case '"':
-                if (quote)
-                    len += strlen("&quot;");
-                else
-                    len++;
-                break;
-            default:
-                len++;
-            }
+     * Common case is nothing to encode: then str is the result */
+    if (str[strcspn(str, quote?XML_CHARDATA_ESC_QUOTE:XML_CHARDATA_ESC)] == '\0'){
+        esc = str;
+        str = NULL;
     }
-    len++; /* trailing \0 */
-    /* We know length, allocate encoding buffer  */
-    if ((esc = malloc(len)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    memset(esc, 0, len);
-    /* Same code again, but now actually encode into output buffer */
-    j = 0; cdata = 0;
-    slen = strlen(str);
-    for (i=0; i<slen; i++){
-        if (cdata){
-            if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-                cdata = 0;
-                esc[j++] = str[i++];
-                esc[j++] = str[i++];
-            }
-            esc[j++] = str[i];
+    else {
+        if ((cb = cbuf_new_alloc(fmtlen + 32)) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+            goto done;
         }
-        else
-        switch (str[i]){
-        case '&':
-            if ((l=snprintf(&esc[j], 6, "&amp;")) < 0){
-                clixon_err(OE_UNIX, errno, "snprintf");
-                goto done;
-            }
-            j += l;
-            break;
-        case '<':
-            if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-                esc[j++] = str[i];
-                cdata++;
-                break;
-            }
-            if ((l=snprintf(&esc[j], 5, "&lt;")) < 0){
-                clixon_err(OE_UNIX, errno, "snprintf");
-                goto done;
-            }
-            j += l;
-            break;
-        case '>':
-            if ((l=snprintf(&esc[j], 5, "&gt;")) < 0){
-                clixon_err(OE_UNIX, errno, "snprintf");
-                goto done;
-            }
-            j += l;
-            break;
-        case '\'':
-            if (quote){
-                if ((l=snprintf(&esc[j], 7, "&apos;")) < 0){
-                    clixon_err(OE_UNIX, errno, "snprintf");
-                    goto done;
-                }
-                j += l;
-            }
-            else
-                esc[j++] = str[i];
-            break;
-        case '"':
-            if (quote){
-                if ((l=snprintf(&esc[j], 7, "&quot;")) < 0){
-                    clixon_err(OE_UNIX, errno, "snprintf");
-                    goto done;
-                }
-                j += l;
-            }
-            else
-                esc[j++] = str[i];
-            break;
-        default:
-            esc[j++] = str[i];
+        if (xml_chardata_cbuf_append(cb, quote, str) < 0)
+            goto done;
+        if ((esc = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
         }
     }
     *escp = esc;
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     if (str)
         free(str);
-    if (retval < 0 && esc)
-        free(esc);
     return retval;
 }
 
 /*! Escape characters according to XML definition and append to cbuf
  *
+ * Runs of characters that need no encoding are found with strcspn(3) and appended with
+ * one copy. CDATA sections are appended as is.
  * @param[in]   cb     CLIgen buf
  * @param[in]   quote  Also encode ' and " (eg for attributes)
  * @param[in]   str    Not-encoded input string
@@ -652,57 +557,50 @@ xml_chardata_cbuf_append(cbuf *cb,
                          int   quote,
                          char *str)
 {
-    int    retval = -1;
-    int    i;
-    int    cdata; /* when set, skip encoding */
-    size_t len;
+    int         retval = -1;
+    const char *reject;
+    size_t      n;
+    char       *p;
 
-    /* The orignal of this code is in xml_chardata_encode */
-    /* Step: encode and expand str --> enc */
-    /* Same code again, but now actually encode into output buffer */
-    cdata = 0;
-    len = strlen(str);
-    for (i=0; i<len; i++){
-        if (cdata){
-            if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-                cdata = 0;
-                cbuf_append(cb, str[i++]);
-                cbuf_append(cb, str[i++]);
-            }
-            cbuf_append(cb, str[i]);
+    reject = quote ? XML_CHARDATA_ESC_QUOTE : XML_CHARDATA_ESC;
+    while (1){
+        if ((n = strcspn(str, reject)) > 0){
+            cbuf_append_buf(cb, str, n);
+            str += n;
         }
-        else
-            switch (str[i]){
-            case '&':
-                cbuf_append_str(cb, "&amp;");
-                break;
-            case '<':
-                if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-                    cbuf_append(cb, str[i]);
-                    cdata++;
-                    break;
-                }
-                cbuf_append_str(cb, "&lt;");
-                break;
-            case '>':
-                cbuf_append_str(cb, "&gt;");
-                break;
-            case '\'':
-                if (quote)
-                    cbuf_append_str(cb, "&apos;");
-                else
-                    cbuf_append(cb, str[i]);
-                break;
-            case '"':
-                if (quote)
-                    cbuf_append_str(cb, "&quot;");
+        switch (*str){
+        case '\0':
+            goto ok;
+            break;
+        case '&':
+            cbuf_append_str(cb, "&amp;");
+            break;
+        case '<':
+            if (strncmp(str, "<![CDATA[", strlen("<![CDATA[")) == 0){
+                /* Append until and including end of CDATA, or rest of string */
+                if ((p = strstr(str, "]]>")) != NULL)
+                    n = p - str + strlen("]]>");
                 else
-                    cbuf_append(cb, str[i]);
-                break;
-            default:
-                cbuf_append(cb, str[i]);
+                    n = strlen(str);
+                cbuf_append_buf(cb, str, n);
+                str += n;
+                continue;
             }
+            cbuf_append_str(cb, "&lt;");
+            break;
+        case '>':
+            cbuf_append_str(cb, "&gt;");
+            break;
+        case '\'':
+            cbuf_append_str(cb, "&apos;");
+            break;
+        case '"':
+            cbuf_append_str(cb, "&quot;");
+            break;
+        }
+        str++;
     }
+ ok:
     retval = 0;
     return retval;
 }
@@ -801,6 +699,7 @@ xml_chardata_decode(char      **decp,
     int     j;
     char    ch;
     int     ret;
+    char   *p;
 
     /* Two steps: (1) read in the complete format string */
     va_start(args, fmt); /* dryrun */
@@ -816,8 +715,15 @@ xml_chardata_decode(char      **decp,
     va_end(args);
     /* Now str is the combined fmt + ... */
 
-    /* Step (2) decode str --> dec 
-     * First allocate decoded string, encoded is always >= larger */
+    /* Step (2) decode str --> dec
+     * Common case is nothing to decode: then str is the result */
+    if ((p = strchr(str, '&')) == NULL){
+        *decp = str;
+        str = NULL;
+        retval = 0;
+        goto done;
+    }
+    /* First allocate decoded string, encoded is always >= larger */
     slen = strlen(str);
     if ((dec = malloc(slen+1)) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
@@ -825,21 +731,22 @@ xml_chardata_decode(char      **decp,
     }
     j = 0;
     memset(dec, 0, slen+1);
-    for (i=0; i<slen; i++){
-        ch = str[i];
-        switch (ch){
-        case '&':
-            if ((ret = xml_chardata_decode_ampersand(&str[i+1], &ch, &i)) < 0)
-                goto done;
-            if (ret == 0)
-                dec[j++] = str[i];
-            else
-                dec[j++] = ch;
-            break;
-        default:
+    i = 0;
+    while (p != NULL){
+        /* Copy run until & */
+        memcpy(&dec[j], &str[i], p - &str[i]);
+        j += p - &str[i];
+        i = p - str;
+        if ((ret = xml_chardata_decode_ampersand(&str[i+1], &ch, &i)) < 0)
+            goto done;
+        if (ret == 0)
             dec[j++] = str[i];
-        }
+        else
+            dec[j++] = ch;
+        i++;
+        p = strchr(&str[i], '&');
     }
+    strcpy(&dec[j], &str[i]);
     *decp = dec;
     retval = 0;
  done:
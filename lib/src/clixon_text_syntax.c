@@ -69,6 +69,7 @@
 #include "clixon_xml_bind.h"
 #include "clixon_text_syntax.h"
 #include "clixon_text_syntax_parse.h"
+#include "clixon_writer.h"
 
 /* Size of json read buffer when reading from file*/
 #define BUFLEN 1024
@@ -443,6 +444,9 @@ text2cbuf(cbuf  *cb,
                 continue; /* Skip keys, already printed */
             if (text2cbuf(cb, xc, level+1, prepend, autocliext, leafl, leaflname) < 0)
                 break;
+            /* Stream output if a writer is registered */
+            if (clixon_writer_check(cb) < 0)
+                goto done;
         }
     }
     /* Stop leaf-list printing (ie []) if no longer leaflist and same name */
@@ -1203,7 +1207,7 @@ clixon_text_syntax_parse_file(FILE      *fp,
     retval = 1;
  done:
     if (retval < 0 && *xt){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
     if (textbuf)
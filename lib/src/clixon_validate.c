@@ -45,6 +45,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <string.h>
 #include <syslog.h>
 #include <fcntl.h>
@@ -71,6 +72,7 @@
 #include "clixon_options.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_sort.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_yang_module.h"
@@ -80,8 +82,283 @@
 #include "clixon_xml_map.h"
 #include "clixon_xml_bind.h"
 #include "clixon_validate_minmax.h"
+#include "clixon_validate_deps.h"
 #include "clixon_validate.h"
 
+/* Hash index of the values of the target nodes of a leafref path
+ *
+ * The target nodes of a leafref path without predicates or functions only depend on the
+ * context of the path, ie the root for an absolute path, or the ancestor reached by the
+ * leading "../" steps of a relative path. One index is built per path and context on the
+ * first lookup, and used by all leafref instances sharing them.
+ * Open addressing with linear probing, at most half full.
+ */
+struct leafref_index{
+    cxobj      *li_xctx;  /* Context of path, NULL if slot is empty */
+    yang_stmt  *li_ypath; /* Yang path statement of leafref type */
+    yang_stmt  *li_ymod;  /* Module of leafref leaf, for namespace context */
+    size_t      li_size;  /* Number of slots, power of 2 */
+    cxobj     **li_slots; /* Target nodes with distinct values, NULL if empty */
+};
+
+/* Leafref indexes of an ongoing validation, see leafref_index_init
+ * Open addressing with linear probing on context, path and module, at most half full.
+ * The indexes are only valid while the validated tree is not modified.
+ */
+static struct leafref_index *_leafref_ivec = NULL;
+static size_t                _leafref_isize = 0;
+static size_t                _leafref_inr = 0;
+static int                   _leafref_active = 0;
+
+/*! FNV-1a hash of string
+ */
+static uint32_t
+leafref_hash_str(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Hash of leafref index key
+ */
+static size_t
+leafref_hash_key(cxobj     *xctx,
+                 yang_stmt *ypath,
+                 yang_stmt *ymod)
+{
+    uintptr_t h;
+
+    h = (uintptr_t)xctx;
+    h = h*31 + (uintptr_t)ypath;
+    h = h*31 + (uintptr_t)ymod;
+    return (size_t)(h ^ (h >> 7) ^ (h >> 17));
+}
+
+/*! Start using leafref indexes in a validation
+ *
+ * May be nested, indexes are freed by the outermost leafref_index_free
+ * @see leafref_index_free
+ */
+static void
+leafref_index_init(void)
+{
+    _leafref_active++;
+}
+
+/*! Stop using leafref indexes and free them
+ *
+ * @see leafref_index_init
+ */
+static void
+leafref_index_free(void)
+{
+    size_t i;
+
+    if (_leafref_active > 0)
+        _leafref_active--;
+    if (_leafref_active > 0)
+        return;
+    if (_leafref_ivec){
+        for (i = 0; i < _leafref_isize; i++)
+            if (_leafref_ivec[i].li_slots)
+                free(_leafref_ivec[i].li_slots);
+        free(_leafref_ivec);
+        _leafref_ivec = NULL;
+    }
+    _leafref_isize = 0;
+    _leafref_inr = 0;
+}
+
+/*! Get context of leafref path for indexing
+ *
+ * @param[in]  xt       XML leaf node of type leafref
+ * @param[in]  path_arg Leafref path
+ * @param[out] xctx     Root for absolute path, ancestor after leading "../" for relative path
+ * @retval     1        OK, xctx set
+ * @retval     0        Path has predicates or functions, eg current(), and can not be indexed
+ */
+static int
+leafref_index_context(cxobj  *xt,
+                      char   *path_arg,
+                      cxobj **xctx)
+{
+    cxobj *x = xt;
+    char  *p = path_arg;
+
+    if (strchr(path_arg, '[') != NULL || strchr(path_arg, '(') != NULL)
+        return 0;
+    if (*p == '/'){
+        while (xml_parent(x) != NULL)
+            x = xml_parent(x);
+    }
+    else {
+        while (strncmp(p, "../", 3) == 0 && xml_parent(x) != NULL){
+            x = xml_parent(x);
+            p += 3;
+        }
+    }
+    *xctx = x;
+    return 1;
+}
+
+/*! Grow leafref index table so that one more index can be added
+ */
+static int
+leafref_index_grow(void)
+{
+    int                   retval = -1;
+    struct leafref_index *ivec;
+    struct leafref_index *li;
+    size_t                size;
+    size_t                i;
+    size_t                j;
+
+    if ((_leafref_inr + 1)*2 <= _leafref_isize)
+        return 0;
+    size = _leafref_isize ? 2*_leafref_isize : 64;
+    if ((ivec = calloc(size, sizeof(*ivec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i = 0; i < _leafref_isize; i++){
+        li = &_leafref_ivec[i];
+        if (li->li_xctx == NULL)
+            continue;
+        j = leafref_hash_key(li->li_xctx, li->li_ypath, li->li_ymod) & (size-1);
+        while (ivec[j].li_xctx != NULL)
+            j = (j+1) & (size-1);
+        ivec[j] = *li;
+    }
+    if (_leafref_ivec)
+        free(_leafref_ivec);
+    _leafref_ivec = ivec;
+    _leafref_isize = size;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Build index of the values of the target nodes of a leafref path
+ *
+ * @param[in]  li       Empty index with key set
+ * @param[in]  xt       XML leaf node of type leafref, path is evaluated from here
+ * @param[in]  nsc      Namespace context of path
+ * @param[in]  ypath    Yang path statement of leafref
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+leafref_index_build(struct leafref_index *li,
+                    cxobj                *xt,
+                    cvec                 *nsc,
+                    yang_stmt            *ypath)
+{
+    int                retval = -1;
+    struct xpath_tree *xpt;
+    cxobj            **xvec = NULL;
+    size_t             xlen = 0;
+    size_t             i;
+    size_t             j;
+    char              *body;
+    char              *b;
+
+    if (yang_xpath_tree_get(ypath, &xpt) < 0)
+        goto done;
+    if (xpath_vec_tree(xt, nsc, xpt, &xvec, &xlen) < 0)
+        goto done;
+    li->li_size = 4;
+    while (li->li_size < 2*xlen)
+        li->li_size *= 2;
+    if ((li->li_slots = calloc(li->li_size, sizeof(cxobj *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i = 0; i < xlen; i++){
+        if ((body = xml_body(xvec[i])) == NULL)
+            continue;
+        j = leafref_hash_str(body) & (li->li_size-1);
+        while (li->li_slots[j] != NULL){
+            if ((b = xml_body(li->li_slots[j])) != NULL && strcmp(b, body) == 0)
+                break;
+            j = (j+1) & (li->li_size-1);
+        }
+        if (li->li_slots[j] == NULL)
+            li->li_slots[j] = xvec[i];
+    }
+    retval = 0;
+ done:
+    if (xvec)
+        free(xvec);
+    return retval;
+}
+
+/*! Find a leafref value among the target nodes of its path using an index
+ *
+ * Only used in an ongoing validation, and if the path can be indexed.
+ * @param[in]  xt       XML leaf node of type leafref
+ * @param[in]  ys       Yang spec of leaf
+ * @param[in]  ypath    Yang path statement of leafref type
+ * @param[in]  nsc      Namespace context of path
+ * @param[in]  value    Leafref value
+ * @param[out] found    1 if a target node has the value, 0 if not
+ * @retval     1        OK, found set
+ * @retval     0        No index used
+ * @retval    -1        Error
+ * @see leafref_index_init
+ */
+static int
+leafref_index_find(cxobj     *xt,
+                   yang_stmt *ys,
+                   yang_stmt *ypath,
+                   cvec      *nsc,
+                   char      *value,
+                   int       *found)
+{
+    struct leafref_index *li;
+    cxobj                *xctx = NULL;
+    yang_stmt            *ymod;
+    char                 *path_arg;
+    char                 *b;
+    size_t                j;
+
+    path_arg = yang_argument_get(ypath);
+    if (_leafref_active == 0 ||
+        leafref_index_context(xt, path_arg, &xctx) == 0)
+        return 0;
+    ymod = ys_module(ys);
+    if (leafref_index_grow() < 0)
+        return -1;
+    j = leafref_hash_key(xctx, ypath, ymod) & (_leafref_isize-1);
+    while ((li = &_leafref_ivec[j])->li_xctx != NULL){
+        if (li->li_xctx == xctx && li->li_ypath == ypath && li->li_ymod == ymod)
+            break;
+        j = (j+1) & (_leafref_isize-1);
+    }
+    if (li->li_xctx == NULL){
+        li->li_xctx = xctx;
+        li->li_ypath = ypath;
+        li->li_ymod = ymod;
+        _leafref_inr++;
+        if (leafref_index_build(li, xt, nsc, ypath) < 0)
+            return -1;
+    }
+    *found = 0;
+    j = leafref_hash_str(value) & (li->li_size-1);
+    while (li->li_slots[j] != NULL){
+        if ((b = xml_body(li->li_slots[j])) != NULL && strcmp(b, value) == 0){
+            *found = 1;
+            break;
+        }
+        j = (j+1) & (li->li_size-1);
+    }
+    return 1;
+}
+
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
  *
  * @param[in]  xt    XML leaf node of type leafref
@@ -114,6 +391,8 @@
  *   o  Otherwise, the context node is the node in the data tree for which
  *      the "path" statement is defined. (ie ys)
  * 
+ * In a validation of a whole tree, target values are looked up in an index instead of
+ * evaluating the path for each leafref instance, see leafref_index_find
  */
 static int
 validate_leafref(cxobj     *xt,
@@ -135,6 +414,9 @@ validate_leafref(cxobj     *xt,
     char        *path_arg;
     cg_var      *cv;
     int          require_instance = 1;
+    int          found = 0;
+    int          ret;
+    struct xpath_tree *xpt;
 
     /* require instance */
     if ((yreqi = yang_find(ytype, Y_REQUIRE_INSTANCE, NULL)) != NULL){
@@ -164,16 +446,23 @@ validate_leafref(cxobj     *xt,
         goto ok;
     if (xml_nsctx_yang(ys, &nsc) < 0)
         goto done;
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0)
+    if ((ret = leafref_index_find(xt, ys, ypath, nsc, leafrefbody, &found)) < 0)
         goto done;
-    for (i = 0; i < xlen; i++) {
-        x = xvec[i];
-        if ((leafbody = xml_body(x)) == NULL)
-            continue;
-        if (strcmp(leafbody, leafrefbody) == 0)
-            break;
+    if (ret == 0){
+        if (yang_xpath_tree_get(ypath, &xpt) < 0)
+            goto done;
+        if (xpath_vec_tree(xt, nsc, xpt, &xvec, &xlen) < 0)
+            goto done;
+        for (i = 0; i < xlen; i++) {
+            x = xvec[i];
+            if ((leafbody = xml_body(x)) == NULL)
+                continue;
+            if (strcmp(leafbody, leafrefbody) == 0)
+                break;
+        }
+        found = i < xlen;
     }
-    if (i==xlen){
+    if (!found){
         if ((cberr = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
@@ -1023,6 +1312,7 @@ xml_yang_validate_add(clixon_handle h,
     int          ret;
     cxobj       *x;
     cg_var      *cv0;
+    cg_var      *cvc;
     enum cv_type cvtype;
     validate_level vl = VL_NONE;
 
@@ -1048,6 +1338,19 @@ xml_yang_validate_add(clixon_handle h,
             /* validate value against ranges, etc */
             if ((cv0 = yang_cv_get(yt)) == NULL)
                 break;
+            /* Use typed value cached when bound if same type, see xml_cv_cache_bind */
+            if ((cvc = xml_cv(xt)) != NULL &&
+                xml_body(xt) != NULL &&
+                cv_type_get(cvc) == cv_type_get(cv0)){
+                if ((ret = ys_cv_validate(h, cvc, yt, NULL, &reason)) < 0)
+                    goto done;
+                if (ret == 0){
+                    if (xret && netconf_bad_element_xml(xret, "application",  yang_argument_get(yt), reason) < 0)
+                        goto done;
+                    goto fail;
+                }
+                break;
+            }
             if ((cv = cv_dup(cv0)) == NULL){
                 clixon_err(OE_UNIX, errno, "cv_dup");
                 goto done;
@@ -1209,6 +1512,156 @@ xml_yang_validate_leaf_union(clixon_handle h,
     goto done;
 }
 
+/*! Validate constraints of a single XML node, but not of its children
+ *
+ * Checks when, mandatory, leafref, identityref, union and must constraints of the node.
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    XML node to be validated
+ * @param[in]  yt    Yang spec of xt, config true
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see xml_yang_validate_all
+ */
+static int
+xml_yang_validate_node(clixon_handle h,
+                       cxobj        *xt,
+                       yang_stmt    *yt,
+                       cxobj       **xret)
+{
+    int        retval = -1;
+    yang_stmt *yc;  /* yang child */
+    yang_stmt *ye;  /* yang must error-message */
+    char      *xpath;
+    char      *xpath1 = NULL;
+    int        nr;
+    int        ret;
+    cbuf      *cb = NULL;
+    cvec      *nsc = NULL;
+    int        hit = 0;
+    int        saw_node = 0;
+    int        inext;
+    struct xpath_tree *xpt;
+
+    ret = yang_check_when_xpath(xt, xml_parent(xt), yt, &hit, &nr, &xpath1);
+    clixon_debug(CLIXON_DBG_XPATH|CLIXON_DBG_DETAIL, "nr:%d xpath:%s return:%d", nr, xpath1, ret);
+    if (ret < 0)
+        goto done;
+
+    if (hit && nr == 0){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "Failed WHEN condition of %s in module %s (WHEN xpath is %s)",
+                xml_name(xt),
+                yang_argument_get(ys_module(yt)),
+                xpath1);
+        if (xret && netconf_operation_failed_xml(xret, "application",
+                                                 cbuf_get(cb)) < 0)
+            goto done;
+        goto fail;
+    }
+    if ((ret = check_mandatory(xt, yt, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    /* Node-specific validation */
+    switch (yang_keyword_get(yt)){
+    case Y_ANYXML:
+    case Y_ANYDATA:
+        goto ok;
+        break;
+    case Y_LEAF:
+        /* fall thru */
+    case Y_LEAF_LIST:
+        /* Special case if leaf is leafref, then first check against
+           current xml tree
+        */
+        /* Get base type yc */
+        if (yang_type_get(yt, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
+            goto done;
+        if (strcmp(yang_argument_get(yc), "leafref") == 0){
+            if ((ret = validate_leafref(xt, yt, yc, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            }
+        else if (strcmp(yang_argument_get(yc), "identityref") == 0){
+            if ((ret = validate_identityref(xt, yt, yc, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        else if (strcmp("union", yang_argument_get(yc)) == 0){
+            if ((ret = xml_yang_validate_leaf_union(h, xt, yt, yc, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        break;
+    default:
+        break;
+    }
+    /* must sub-node RFC 7950 Sec 7.5.3. Can be several. 
+     * XXX. use yang path instead? */
+    inext = 0;
+    while ((yc = yn_iter(yt, &inext)) != NULL) {
+        if (yang_keyword_get(yc) != Y_MUST)
+            continue;
+        if (!saw_node)
+            clixon_debug_xml(CLIXON_DBG_XPATH, xt, "");
+        saw_node = 1;
+
+        xpath = yang_argument_get(yc); /* "must" has xpath argument */
+        clixon_debug(CLIXON_DBG_XPATH, "xpath '%s'", xpath);
+        /* the context node is the node in the accessible tree for
+         * which the "must" statement is defined. 
+         * The set of namespace declarations is the set of all "import" statements' 
+         */
+        if (xml_nsctx_yang(yc, &nsc) < 0)
+            goto done;
+        clixon_debug(CLIXON_DBG_XPATH, "namespace '%s'", xml_nsctx_get(nsc, NULL));
+        if (yang_xpath_tree_get(yc, &xpt) < 0)
+            goto done;
+        nr = xpath_vec_bool_tree(xt, nsc, xpt);
+        clixon_debug(CLIXON_DBG_XPATH, "result %s", (nr < 0 ? "error" : (nr != 0 ? "true" : "false")));
+        if (nr < 0)
+            goto done;
+        if (!nr){
+            ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
+            if ((cb = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cb, "Failed MUST xpath '%s' of '%s' in module %s",
+                    xpath, xml_name(xt),  yang_argument_get(ys_module(yt)));
+            if (xret && netconf_operation_failed_xml(xret, "application",
+                                             ye?yang_argument_get(ye):cbuf_get(cb)) < 0)
+                goto done;
+            goto fail;
+        }
+        if (nsc){
+            xml_nsctx_free(nsc);
+            nsc = NULL;
+        }
+    }
+ ok:
+    retval = 1;
+ done:
+    if (xpath1)
+        free(xpath1);
+    if (cb)
+        cbuf_free(cb);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Validate a single XML node with yang specification for all (not only added) entries
  *
  * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
@@ -1236,21 +1689,12 @@ xml_yang_validate_all(clixon_handle h,
 {
     int        retval = -1;
     yang_stmt *yt;  /* yang node associated with xt */
-    yang_stmt *yc;  /* yang child */
-    yang_stmt *ye;  /* yang must error-message */
-    char      *xpath;
-    char      *xpath1 = NULL;
-    int        nr;
     int        ret;
     cxobj     *x;
     cxobj     *xp;
     char      *ns = NULL;
     cbuf      *cb = NULL;
-    cvec      *nsc = NULL;
-    int        hit = 0;
     validate_level vl = VL_NONE;
-    int        saw_node = 0;
-    int        inext;
 
     if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         if ((ret = xml_yang_mount_get(h, xt, &vl, NULL)) < 0)
@@ -1284,107 +1728,12 @@ xml_yang_validate_all(clixon_handle h,
         goto fail;
     }
     if (yang_config(yt) != 0){
-        ret = yang_check_when_xpath(xt, xml_parent(xt), yt, &hit, &nr, &xpath1);
-        clixon_debug(CLIXON_DBG_XPATH|CLIXON_DBG_DETAIL, "nr:%d xpath:%s return:%d", nr, xpath1, ret);
-        if (ret < 0)
-            goto done;
-
-        if (hit && nr == 0){
-            if ((cb = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
-                goto done;
-            }
-            cprintf(cb, "Failed WHEN condition of %s in module %s (WHEN xpath is %s)",
-                    xml_name(xt),
-                    yang_argument_get(ys_module(yt)),
-                    xpath1);
-            if (xret && netconf_operation_failed_xml(xret, "application",
-                                                     cbuf_get(cb)) < 0)
-                goto done;
-            goto fail;
-        }
-        if ((ret = check_mandatory(xt, yt, xret)) < 0)
+        if ((ret = xml_yang_validate_node(h, xt, yt, xret)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
-        /* Node-specific validation */
-        switch (yang_keyword_get(yt)){
-        case Y_ANYXML:
-        case Y_ANYDATA:
+        if (yang_keyword_get(yt) == Y_ANYXML || yang_keyword_get(yt) == Y_ANYDATA)
             goto ok;
-            break;
-        case Y_LEAF:
-            /* fall thru */
-        case Y_LEAF_LIST:
-            /* Special case if leaf is leafref, then first check against
-               current xml tree
-            */
-            /* Get base type yc */
-            if (yang_type_get(yt, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
-                goto done;
-            if (strcmp(yang_argument_get(yc), "leafref") == 0){
-                if ((ret = validate_leafref(xt, yt, yc, xret)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-                }
-            else if (strcmp(yang_argument_get(yc), "identityref") == 0){
-                if ((ret = validate_identityref(xt, yt, yc, xret)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            else if (strcmp("union", yang_argument_get(yc)) == 0){
-                if ((ret = xml_yang_validate_leaf_union(h, xt, yt, yc, xret)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            break;
-        default:
-            break;
-        }
-        /* must sub-node RFC 7950 Sec 7.5.3. Can be several. 
-         * XXX. use yang path instead? */
-        inext = 0;
-        while ((yc = yn_iter(yt, &inext)) != NULL) {
-            if (yang_keyword_get(yc) != Y_MUST)
-                continue;
-            if (!saw_node)
-                clixon_debug_xml(CLIXON_DBG_XPATH, xt, "");
-            saw_node = 1;
-
-            xpath = yang_argument_get(yc); /* "must" has xpath argument */
-            clixon_debug(CLIXON_DBG_XPATH, "xpath '%s'", xpath);
-            /* the context node is the node in the accessible tree for
-             * which the "must" statement is defined. 
-             * The set of namespace declarations is the set of all "import" statements' 
-             */
-            if (xml_nsctx_yang(yc, &nsc) < 0)
-                goto done;
-            clixon_debug(CLIXON_DBG_XPATH, "namespace '%s'", xml_nsctx_get(nsc, NULL));
-            nr = xpath_vec_bool(xt, nsc, "%s", xpath);
-            clixon_debug(CLIXON_DBG_XPATH, "result %s", (nr < 0 ? "error" : (nr != 0 ? "true" : "false")));
-            if (nr < 0)
-                goto done;
-            if (!nr){
-                ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
-                if ((cb = cbuf_new()) == NULL){
-                    clixon_err(OE_UNIX, errno, "cbuf_new");
-                    goto done;
-                }
-                cprintf(cb, "Failed MUST xpath '%s' of '%s' in module %s",
-                        xpath, xml_name(xt),  yang_argument_get(ys_module(yt)));
-                if (xret && netconf_operation_failed_xml(xret, "application",
-                                                 ye?yang_argument_get(ye):cbuf_get(cb)) < 0)
-                    goto done;
-                goto fail;
-            }
-            if (nsc){
-                xml_nsctx_free(nsc);
-                nsc = NULL;
-            }
-        }
     }
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
@@ -1404,12 +1753,8 @@ xml_yang_validate_all(clixon_handle h,
  ok:
     retval = 1;
  done:
-    if (xpath1)
-        free(xpath1);
     if (cb)
         cbuf_free(cb);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
@@ -1429,17 +1774,193 @@ xml_yang_validate_all_top(clixon_handle h,
                           cxobj        *xt,
                           cxobj       **xret)
 {
+    int    retval = -1;
     int    ret;
     cxobj *x;
 
+    leafref_index_init();
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
-            return ret;
+        if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
-    if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 1)
-        return ret;
-    return 1;
+    if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    retval = 1;
+ done:
+    leafref_index_free();
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate changed XML nodes and nodes whose constraints depend on changes
+ *
+ * Added sub-trees are validated as in xml_yang_validate_all.
+ * Changed nodes, ie nodes with changed descendants, and nodes whose yang spec is marked by
+ * yang_deps_mark are validated, but not their unchanged children.
+ * Other sub-trees are only traversed if they contain marked yang nodes.
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    XML node to be validated
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see xml_yang_validate_all
+ */
+static int
+xml_yang_validate_diff(clixon_handle h,
+                       cxobj        *xt,
+                       cxobj       **xret)
+{
+    int        retval = -1;
+    yang_stmt *yt;
+    int        changed;
+    int        ret;
+    cxobj     *x;
+
+    changed = xml_flag(xt, XML_FLAG_CHANGE) != 0;
+    if ((yt = xml_spec(xt)) == NULL || xml_flag(xt, XML_FLAG_ADD))
+        return xml_yang_validate_all(h, xt, xret);
+    if (!changed &&
+        yang_flag_get(yt, YANG_FLAG_DEPS|YANG_FLAG_DEPS_PATH) == 0)
+        goto ok;
+    if (yang_config(yt) != 0 &&
+        (changed || yang_flag_get(yt, YANG_FLAG_DEPS))){
+        if ((ret = xml_yang_validate_node(h, xt, yt, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (yang_keyword_get(yt) == Y_ANYXML || yang_keyword_get(yt) == Y_ANYDATA)
+            goto ok;
+    }
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if ((ret = xml_yang_validate_diff(h, x, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if (yang_config(yt) != 0 &&
+        (changed || yang_flag_get(yt, YANG_FLAG_DEPS))){
+        if ((ret = xml_yang_validate_minmax(xt, 1, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Mark nodes of new tree whose children are deleted as changed
+ *
+ * Deleted nodes are only marked in the previous tree, and their parents may remain in the
+ * new tree with no other changes. Mark such parents and their ancestors with XML_FLAG_CHANGE
+ * so that mandatory and min/max-elements constraints of the parent are checked.
+ * @param[in]  xsrc  Node of previous tree, with deleted nodes marked
+ * @param[in]  xt    Corresponding node in new tree
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_diff_mark_del(cxobj *xsrc,
+                       cxobj *xt)
+{
+    int    retval = -1;
+    cxobj *x0;
+    cxobj *x1;
+    int    del = 0;
+
+    x0 = NULL;
+    while ((x0 = xml_child_each(xsrc, x0, CX_ELMNT)) != NULL) {
+        if (xml_flag(x0, XML_FLAG_DEL))
+            del++;
+        else if (xml_flag(x0, XML_FLAG_CHANGE)){
+            if (match_base_child(xt, x0, xml_spec(x0), &x1) < 0)
+                goto done;
+            if (x1 && validate_diff_mark_del(x0, x1) < 0)
+                goto done;
+        }
+    }
+    if (del && xml_parent(xt) != NULL){
+        xml_flag_set(xt, XML_FLAG_CHANGE);
+        xml_apply_ancestor(xt, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Validate a tree incrementally given the diff to a previous valid tree
+ *
+ * Instead of validating the whole tree as xml_yang_validate_all_top, only re-check
+ * constraints that may be affected by the changes, that is:
+ * - All constraints of added or changed nodes, including parents of deleted nodes
+ * - must, when and leafref constraints whose xpaths refer to added, deleted or changed nodes,
+ *   according to the static dependencies computed by yang_deps_build
+ * Both trees are marked with XML_FLAG_ADD, XML_FLAG_DEL and XML_FLAG_CHANGE as in a commit.
+ * @param[in]  h     Clixon handle
+ * @param[in]  yspec Yang spec
+ * @param[in]  xsrc  Previous valid tree, with deleted nodes marked
+ * @param[in]  xt    Tree to validate, with added and changed nodes marked
+ * @param[out] xret  Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @note Schema mount is not supported, the whole tree is validated
+ * @see xml_yang_validate_all_top
+ */
+int
+xml_yang_validate_diff_top(clixon_handle h,
+                           yang_stmt    *yspec,
+                           cxobj        *xsrc,
+                           cxobj        *xt,
+                           cxobj       **xret)
+{
+    int         retval = -1;
+    yang_stmt **yvec = NULL;
+    size_t      ylen = 0;
+    int         ret;
+    cxobj      *x;
+
+    if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT"))
+        return xml_yang_validate_all_top(h, xt, xret);
+    leafref_index_init();
+    if (xsrc && validate_diff_mark_del(xsrc, xt) < 0)
+        goto done;
+    if (yang_deps_mark(yspec, xsrc, xt, &yvec, &ylen) < 0)
+        goto done;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if ((ret = xml_yang_validate_diff(h, x, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    retval = 1;
+ done:
+    leafref_index_free();
+    yang_deps_reset(yvec, ylen);
+    if (yvec)
+        free(yvec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
 /*! Check validity of outgoing RPC
@@ -0,0 +1,709 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Static dependencies of YANG must/when/leafref constraints for incremental validation
+ *
+ * The dependencies of a constraint are the names of the data nodes its xpath refers to,
+ * computed from the xpath parse tree. Names of all steps in a location path are existence
+ * dependencies: if a node with that name is added or deleted, the constraint may change.
+ * The name of the last step is also a value dependency: if a node with that name changes
+ * value, the constraint may change. An ancestor of a changed node also changes value.
+ * Names are local, ie prefixes are ignored, which may give false positives but not misses.
+ * Constraints using wildcards, deref() or ending with other than a name test, are
+ * always re-evaluated.
+ *
+ * The dependency graph is an index from name to constraint yang nodes, one for existence
+ * and one for value. It is built when yangs are loaded, and extended with the constraints
+ * of modules loaded later. When validating a commit,
+ * the names of the added, deleted and changed nodes are looked up in the index, and the
+ * yang nodes of the constraints and their ancestors are marked. Only the data nodes of the
+ * marked yang nodes need to be re-validated, in addition to the changed nodes themselves.
+ * @see xml_yang_validate_diff_top
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_debug.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_yang_type.h"
+#include "clixon_validate_deps.h"
+
+/* Vector of constraint yang nodes
+ */
+struct deps_vec {
+    yang_stmt **dv_vec;
+    size_t      dv_len;
+};
+
+/* Dependency graph of one yang spec
+ */
+struct yang_deps {
+    struct yang_deps *yd_next;    /* Next yang spec */
+    yang_stmt        *yd_yspec;   /* Top-level yang spec */
+    clicon_hash_t    *yd_exist;   /* Name -> deps_vec depending on existence of nodes */
+    clicon_hash_t    *yd_value;   /* Name -> deps_vec depending on value of nodes */
+    struct deps_vec   yd_global;  /* Constraints with unknown dependencies */
+};
+
+/* Dependency graphs of all yang specs, typically few */
+static struct yang_deps *_yang_deps = NULL;
+
+/*! Add yang node to vector, unless it is already the last
+ */
+static int
+deps_vec_add(struct deps_vec *dv,
+             yang_stmt       *ys)
+{
+    yang_stmt **vec;
+
+    if (dv->dv_len && dv->dv_vec[dv->dv_len-1] == ys)
+        return 0;
+    if ((vec = realloc(dv->dv_vec, (dv->dv_len+1)*sizeof(yang_stmt *))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    vec[dv->dv_len++] = ys;
+    dv->dv_vec = vec;
+    return 0;
+}
+
+/*! Add yang node to index of name
+ */
+static int
+deps_hash_add(clicon_hash_t   *hash,
+              char            *name,
+              yang_stmt       *ys)
+{
+    struct deps_vec *dv;
+    struct deps_vec  dv0 = {0,};
+
+    if ((dv = clicon_hash_value(hash, name, NULL)) == NULL){
+        if (clicon_hash_add(hash, name, &dv0, sizeof(dv0)) == NULL)
+            return -1;
+        if ((dv = clicon_hash_value(hash, name, NULL)) == NULL)
+            return -1;
+    }
+    return deps_vec_add(dv, ys);
+}
+
+/*! Free index and its vectors
+ */
+static int
+deps_hash_free(clicon_hash_t *hash)
+{
+    char           **keys = NULL;
+    size_t           len = 0;
+    size_t           i;
+    struct deps_vec *dv;
+
+    if (clicon_hash_keys(hash, &keys, &len) < 0)
+        return -1;
+    for (i=0; i<len; i++)
+        if ((dv = clicon_hash_value(hash, keys[i], NULL)) != NULL && dv->dv_vec)
+            free(dv->dv_vec);
+    if (keys)
+        free(keys);
+    clicon_hash_free(hash);
+    return 0;
+}
+
+/*! Last step of a location path
+ *
+ * @param[in]  xs  XP_LOCPATH, XP_ABSPATH or XP_RELLOCPATH
+ * @retval     xs  XP_STEP
+ * @retval     NULL Root path "/"
+ */
+static xpath_tree *
+deps_xpath_last_step(xpath_tree *xs)
+{
+    while (xs != NULL){
+        switch (xs->xs_type){
+        case XP_STEP:
+            return xs;
+        case XP_RELLOCPATH:
+            xs = xs->xs_c1 ? xs->xs_c1 : xs->xs_c0;
+            break;
+        default: /* XP_LOCPATH, XP_ABSPATH */
+            xs = xs->xs_c0;
+            break;
+        }
+    }
+    return NULL;
+}
+
+/*! Add dependencies of an xpath parse tree of a constraint
+ *
+ * @param[in]  yd     Dependency graph
+ * @param[in]  xs     XPath parse tree
+ * @param[in]  ys     Yang node of constraint
+ * @param[in]  value  Value of result is used, not only existence (eg count())
+ * @param[in]  self   Name of node that "." refers to, or NULL if unknown
+ * @param[out] global Dependencies are unknown
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+deps_xpath(struct yang_deps *yd,
+           xpath_tree       *xs,
+           yang_stmt        *ys,
+           int               value,
+           char             *self,
+           int              *global)
+{
+    xpath_tree *xl;
+    xpath_tree *xn;
+    char       *name = NULL;
+
+    if (xs == NULL || *global)
+        return 0;
+    switch (xs->xs_type){
+    case XP_STEP:
+        if ((xn = xs->xs_c0) != NULL){
+            if (xn->xs_type != XP_NODE ||
+                (name = xn->xs_s1) == NULL || strcmp(name, "*") == 0){
+                *global = 1; /* node(), text() or wildcard */
+                return 0;
+            }
+            if (deps_hash_add(yd->yd_exist, name, ys) < 0)
+                return -1;
+        }
+        else if (xs->xs_int == A_SELF)
+            name = self;
+        /* Predicates, where "." refers to the node of this step */
+        return deps_xpath(yd, xs->xs_c1, ys, 1, name, global);
+    case XP_LOCPATH:
+        if (value){
+            if ((xl = deps_xpath_last_step(xs)) != NULL){
+                xn = xl->xs_c0;
+                if (xn != NULL && xn->xs_type == XP_NODE && xn->xs_s1 != NULL){
+                    if (deps_hash_add(yd->yd_value, xn->xs_s1, ys) < 0)
+                        return -1;
+                }
+                else if (xn == NULL && xl->xs_int == A_SELF){
+                    if (self == NULL){
+                        *global = 1; /* Value of unknown node */
+                        return 0;
+                    }
+                    if (deps_hash_add(yd->yd_value, self, ys) < 0)
+                        return -1;
+                }
+                else if (xn == NULL || xn->xs_type != XP_NODE){
+                    *global = 1; /* Value of parent, node() or text() */
+                    return 0;
+                }
+            }
+        }
+        break;
+    case XP_PATHEXPR:
+        /* filterexpr / rellocpath, eg current()/../x */
+        if (value && xs->xs_c1 != NULL){
+            if ((xl = deps_xpath_last_step(xs->xs_c1)) != NULL){
+                xn = xl->xs_c0;
+                if (xn != NULL && xn->xs_type == XP_NODE && xn->xs_s1 != NULL){
+                    if (deps_hash_add(yd->yd_value, xn->xs_s1, ys) < 0)
+                        return -1;
+                }
+                else if (xn == NULL && xl->xs_int == A_SELF && self != NULL){
+                    if (deps_hash_add(yd->yd_value, self, ys) < 0)
+                        return -1;
+                }
+                else {
+                    *global = 1;
+                    return 0;
+                }
+            }
+        }
+        break;
+    case XP_PRIME_FN:
+        if (xs->xs_s0 && strcmp(xs->xs_s0, "deref") == 0){
+            *global = 1; /* Follows leafref to anywhere */
+            return 0;
+        }
+        if (xs->xs_s0 && strcmp(xs->xs_s0, "count") == 0)
+            value = 0;
+        break;
+    default:
+        break;
+    }
+    if (deps_xpath(yd, xs->xs_c0, ys, value, self, global) < 0)
+        return -1;
+    if (deps_xpath(yd, xs->xs_c1, ys, value, self, global) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Add dependencies of the xpath of a must, when or leafref path statement
+ *
+ * @param[in]  yd     Dependency graph
+ * @param[in]  yx     Yang must, when or path statement
+ * @param[in]  ys     Yang node of constraint
+ * @param[in]  yctx   Yang node of xpath context node, or NULL if not a data node
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note If the value of the context node, ".", is used and yctx is NULL, the constraint is
+ *       global
+ */
+static int
+deps_xpath_stmt(struct yang_deps *yd,
+                yang_stmt        *yx,
+                yang_stmt        *ys,
+                yang_stmt        *yctx)
+{
+    xpath_tree *xptree = NULL;
+    int         global = 0;
+
+    if (yang_xpath_tree_get(yx, &xptree) < 0)
+        return -1;
+    if (deps_xpath(yd, xptree, ys, 1, yctx?yang_argument_get(yctx):NULL, &global) < 0)
+        return -1;
+    if (global && deps_vec_add(&yd->yd_global, ys) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Add dependencies of leafref paths of a resolved type, also in unions
+ *
+ * @param[in]  yd     Dependency graph
+ * @param[in]  ys     Yang leaf or leaf-list
+ * @param[in]  ytype  Resolved type
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml_yang_validate_leaf_union
+ */
+static int
+deps_type(struct yang_deps *yd,
+          yang_stmt        *ys,
+          yang_stmt        *ytype)
+{
+    yang_stmt *ypath;
+    yang_stmt *ytsub;
+    yang_stmt *yrestype;
+    char      *restype;
+    int        inext;
+
+    if (ytype == NULL || (restype = yang_argument_get(ytype)) == NULL)
+        return 0;
+    if (strcmp(restype, "leafref") == 0){
+        if ((ypath = yang_find(ytype, Y_PATH, NULL)) != NULL &&
+            deps_xpath_stmt(yd, ypath, ys, ys) < 0)
+            return -1;
+    }
+    else if (strcmp(restype, "union") == 0){
+        inext = 0;
+        while ((ytsub = yn_iter(ytype, &inext)) != NULL){
+            if (yang_keyword_get(ytsub) != Y_TYPE)
+                continue;
+            if (yang_type_resolve(ys, ys, ytsub, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+                return -1;
+            if (deps_type(yd, ys, yrestype) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*! Add dependencies of constraints of one yang node, yang_apply callback
+ *
+ * @param[in]  ys   Yang node
+ * @param[in]  arg  Dependency graph
+ * @retval     2    OK, skip sub-tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+deps_node(yang_stmt *ys,
+          void      *arg)
+{
+    struct yang_deps *yd = (struct yang_deps *)arg;
+    yang_stmt        *yc;
+    yang_stmt        *yp;
+    yang_stmt        *ytype = NULL;
+    yang_stmt        *yctx = NULL;
+    int               inext;
+
+    switch (yang_keyword_get(ys)){
+    case Y_GROUPING:  /* Not expanded or not data */
+    case Y_AUGMENT:
+    case Y_RPC:
+    case Y_ACTION:
+    case Y_NOTIFICATION:
+    case Y_TYPEDEF:
+    case Y_EXTENSION:
+    case Y_DEVIATION:
+    case Y_UNKNOWN:
+        return 2;
+    case Y_LEAF:
+    case Y_LEAF_LIST:
+        if (yang_type_get(ys, NULL, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+            return -1;
+        if (deps_type(yd, ys, ytype) < 0)
+            return -1;
+        /* fall through */
+    case Y_CONTAINER:
+    case Y_LIST:
+    case Y_ANYDATA:
+    case Y_ANYXML:
+        inext = 0;
+        while ((yc = yn_iter(ys, &inext)) != NULL){
+            if (yang_keyword_get(yc) == Y_MUST &&
+                deps_xpath_stmt(yd, yc, ys, ys) < 0)
+                return -1;
+        }
+        /* A when condition also decides if the node is mandatory in its parent */
+        yp = ys;
+        while ((yp = yang_parent_get(yp)) != NULL &&
+               (yang_keyword_get(yp) == Y_CHOICE || yang_keyword_get(yp) == Y_CASE))
+            ;
+        if (yp && !yang_datanode(yp))
+            yp = NULL;
+        /* Context node of augment or uses when is the data parent, otherwise the node itself */
+        if ((yc = yang_when_get(NULL, ys)) != NULL)
+            yctx = yp;
+        else if ((yc = yang_find(ys, Y_WHEN, NULL)) != NULL)
+            yctx = ys;
+        if (yc != NULL){
+            if (deps_xpath_stmt(yd, yc, ys, yctx) < 0)
+                return -1;
+            if (yp && deps_xpath_stmt(yd, yc, yp, yctx) < 0)
+                return -1;
+        }
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*! Find dependency graph of yang spec
+ */
+static struct yang_deps *
+yang_deps_find(yang_stmt *yspec)
+{
+    struct yang_deps *yd;
+
+    for (yd = _yang_deps; yd; yd = yd->yd_next)
+        if (yd->yd_yspec == yspec)
+            return yd;
+    return NULL;
+}
+
+/*! Check if a module may change yang nodes of other modules
+ *
+ * @param[in]  ymod  Yang module or submodule
+ * @retval     1     Module has augment or deviation statements
+ * @retval     0     No
+ */
+static int
+deps_module_external(yang_stmt *ymod)
+{
+    yang_stmt *yc;
+    int        inext = 0;
+
+    while ((yc = yn_iter(ymod, &inext)) != NULL)
+        if (yang_keyword_get(yc) == Y_AUGMENT ||
+            yang_keyword_get(yc) == Y_DEVIATION)
+            return 1;
+    return 0;
+}
+
+/*! Build dependency graph of must, when and leafref constraints of a yang spec
+ *
+ * If a graph exists, the constraints of the modules loaded since then, from modmin, are
+ * added to it. The graph is instead rebuilt if one of the new modules augments or deviates
+ * other modules, since their yang nodes may then be added or removed.
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  modmin Index of first new module in yspec
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see yang_deps_free
+ */
+int
+yang_deps_build(yang_stmt *yspec,
+                int        modmin)
+{
+    int               retval = -1;
+    struct yang_deps *yd = NULL;
+    int               i;
+
+    if (modmin > 0 && (yd = yang_deps_find(yspec)) != NULL){
+        for (i=modmin; i<yang_len_get(yspec); i++)
+            if (deps_module_external(yang_child_i(yspec, i)))
+                break;
+        if (i == yang_len_get(yspec)){
+            clixon_debug(CLIXON_DBG_YANG | CLIXON_DBG_DETAIL, "add modules from %d", modmin);
+            for (i=modmin; i<yang_len_get(yspec); i++)
+                if (yang_apply(yang_child_i(yspec, i), -1, deps_node, 1, yd) < 0){
+                    yd = NULL; /* Not freed, remains in graph list */
+                    goto done;
+                }
+            yd = NULL;
+            goto ok;
+        }
+        yd = NULL;
+    }
+    if (yang_deps_free(yspec) < 0)
+        goto done;
+    if ((yd = malloc(sizeof(*yd))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(yd, 0, sizeof(*yd));
+    yd->yd_yspec = yspec;
+    if ((yd->yd_exist = clicon_hash_init()) == NULL ||
+        (yd->yd_value = clicon_hash_init()) == NULL)
+        goto done;
+    if (yang_apply(yspec, -1, deps_node, 1, yd) < 0)
+        goto done;
+    yd->yd_next = _yang_deps;
+    _yang_deps = yd;
+    yd = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (yd){
+        if (yd->yd_exist)
+            deps_hash_free(yd->yd_exist);
+        if (yd->yd_value)
+            deps_hash_free(yd->yd_value);
+        if (yd->yd_global.dv_vec)
+            free(yd->yd_global.dv_vec);
+        free(yd);
+    }
+    return retval;
+}
+
+/*! Free dependency graph of yang spec, if any
+ *
+ * Called when yang spec is changed or freed
+ * @param[in]  yspec  Top-level yang spec
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+yang_deps_free(yang_stmt *yspec)
+{
+    struct yang_deps **ydp;
+    struct yang_deps  *yd;
+
+    for (ydp = &_yang_deps; *ydp; ydp = &(*ydp)->yd_next){
+        yd = *ydp;
+        if (yd->yd_yspec != yspec)
+            continue;
+        *ydp = yd->yd_next;
+        deps_hash_free(yd->yd_exist);
+        deps_hash_free(yd->yd_value);
+        if (yd->yd_global.dv_vec)
+            free(yd->yd_global.dv_vec);
+        free(yd);
+        break;
+    }
+    return 0;
+}
+
+/*! Mark yang nodes of constraints and their ancestors
+ *
+ * @param[in]     dv    Constraint yang nodes
+ * @param[in,out] mark  Marked yang nodes
+ */
+static int
+deps_mark_vec(struct deps_vec *dv,
+              struct deps_vec *mark)
+{
+    size_t     i;
+    yang_stmt *ys;
+
+    for (i=0; i<dv->dv_len; i++){
+        ys = dv->dv_vec[i];
+        if (yang_flag_get(ys, YANG_FLAG_DEPS))
+            continue;
+        if (yang_flag_get(ys, YANG_FLAG_DEPS_PATH) == 0 &&
+            deps_vec_add(mark, ys) < 0)
+            return -1;
+        yang_flag_set(ys, YANG_FLAG_DEPS);
+        while ((ys = yang_parent_get(ys)) != NULL &&
+               yang_keyword_get(ys) != Y_MODULE &&
+               yang_keyword_get(ys) != Y_SUBMODULE &&
+               yang_flag_get(ys, YANG_FLAG_DEPS|YANG_FLAG_DEPS_PATH) == 0){
+            if (deps_vec_add(mark, ys) < 0)
+                return -1;
+            yang_flag_set(ys, YANG_FLAG_DEPS_PATH);
+        }
+    }
+    return 0;
+}
+
+/*! Mark constraints depending on a name
+ */
+static int
+deps_mark_name(clicon_hash_t   *hash,
+               char            *name,
+               struct deps_vec *mark)
+{
+    struct deps_vec *dv;
+
+    if ((dv = clicon_hash_value(hash, name, NULL)) == NULL)
+        return 0;
+    return deps_mark_vec(dv, mark);
+}
+
+/*! Mark constraints depending on all nodes in an added or deleted sub-tree
+ */
+static int
+deps_mark_tree(struct yang_deps *yd,
+               cxobj            *xt,
+               struct deps_vec  *mark)
+{
+    cxobj *x;
+
+    if (deps_mark_name(yd->yd_exist, xml_name(xt), mark) < 0)
+        return -1;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+        if (deps_mark_tree(yd, x, mark) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Mark constraints depending on changes in a tree, following changed nodes
+ *
+ * @param[in]     yd    Dependency graph
+ * @param[in]     xt    XML node marked as changed or top
+ * @param[in]     flag  XML_FLAG_ADD or XML_FLAG_DEL
+ * @param[in,out] mark  Marked yang nodes
+ */
+static int
+deps_mark_diff(struct yang_deps *yd,
+               cxobj            *xt,
+               int               flag,
+               struct deps_vec  *mark)
+{
+    cxobj *x;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
+        if (xml_flag(x, flag)){
+            if (deps_mark_tree(yd, x, mark) < 0)
+                return -1;
+        }
+        else if (xml_flag(x, XML_FLAG_CHANGE)){
+            if (deps_mark_name(yd->yd_value, xml_name(x), mark) < 0)
+                return -1;
+            if (deps_mark_diff(yd, x, flag, mark) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*! Mark yang nodes of constraints that may be affected by the changes between two trees
+ *
+ * Constraint yang nodes are marked with YANG_FLAG_DEPS and their ancestors with
+ * YANG_FLAG_DEPS_PATH. Reset marks with yang_deps_reset after use.
+ * The dependency graph is built if it does not exist.
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  xsrc   Previous tree with deleted nodes marked with XML_FLAG_DEL
+ * @param[in]  xt     New tree with added and changed nodes marked
+ * @param[out] yvec   Marked yang nodes, free after use
+ * @param[out] ylen   Length of yvec
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+yang_deps_mark(yang_stmt   *yspec,
+               cxobj       *xsrc,
+               cxobj       *xt,
+               yang_stmt ***yvec,
+               size_t      *ylen)
+{
+    int               retval = -1;
+    struct yang_deps *yd;
+    struct deps_vec   mark = {0,};
+
+    if ((yd = yang_deps_find(yspec)) == NULL){
+        if (yang_deps_build(yspec, 0) < 0)
+            goto done;
+        if ((yd = yang_deps_find(yspec)) == NULL)
+            goto done;
+    }
+    if (deps_mark_vec(&yd->yd_global, &mark) < 0)
+        goto done;
+    if (xsrc && deps_mark_diff(yd, xsrc, XML_FLAG_DEL, &mark) < 0)
+        goto done;
+    if (deps_mark_diff(yd, xt, XML_FLAG_ADD, &mark) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_DEFAULT|CLIXON_DBG_DETAIL, "marked: %zu", mark.dv_len);
+    retval = 0;
+ done:
+    *yvec = mark.dv_vec;
+    *ylen = mark.dv_len;
+    return retval;
+}
+
+/*! Reset marks of yang_deps_mark
+ *
+ * @param[in]  yvec   Marked yang nodes
+ * @param[in]  ylen   Length of yvec
+ * @retval     0      OK
+ */
+int
+yang_deps_reset(yang_stmt **yvec,
+                size_t      ylen)
+{
+    size_t i;
+
+    for (i=0; i<ylen; i++)
+        yang_flag_reset(yvec[i], YANG_FLAG_DEPS|YANG_FLAG_DEPS_PATH);
+    return 0;
+}
@@ -45,6 +45,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <string.h>
 #include <syslog.h>
 #include <fcntl.h>
@@ -79,53 +80,172 @@
 #include "clixon_xml_bind.h"
 #include "clixon_validate_minmax.h"
 
-/*! New element last in list, check if already exists if sp return -1
+/* Hash set of tuples of strings, for detecting duplicate list keys, unique values and
+ * leaf-list values in one pass over the entries.
+ * Strings are by reference, eg XML bodies. Two tuples are equal if all strings are equal.
+ * Open addressing with linear probing, at most half full.
+ */
+struct tuple_set{
+    int      ts_width; /* Number of strings in a tuple */
+    char   **ts_vec;   /* Tuples, ts_width strings each */
+    size_t   ts_nr;    /* Number of tuples */
+    size_t   ts_max;   /* Number of allocated tuples in ts_vec */
+    size_t   ts_size;  /* Number of slots, power of 2 */
+    size_t  *ts_slots; /* Tuple index + 1, 0 if slot is empty */
+};
+
+/*! FNV-1a hash of tuple of strings
+ */
+static uint32_t
+tuple_hash(char **tuple,
+           int    width)
+{
+    uint32_t h = 2166136261u;
+    char    *str;
+    int      v;
+
+    for (v=0; v<width; v++){
+        for (str = tuple[v]; *str; str++){
+            h ^= (uint8_t)*str;
+            h *= 16777619u;
+        }
+        h ^= 0xff; /* separator */
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Check if two tuples of strings are equal
+ */
+static int
+tuple_eq(char **t1,
+         char **t2,
+         int    width)
+{
+    int v;
+
+    for (v=0; v<width; v++)
+        if (strcmp(t1[v], t2[v]) != 0)
+            return 0;
+    return 1;
+}
+
+/*! Free the contents of a tuple set
+ */
+static void
+tuple_set_free(struct tuple_set *ts)
+{
+    if (ts->ts_vec)
+        free(ts->ts_vec);
+    if (ts->ts_slots)
+        free(ts->ts_slots);
+    memset(ts, 0, sizeof(*ts));
+}
+
+/*! Grow tuple set so that one more tuple can be added
+ */
+static int
+tuple_set_grow(struct tuple_set *ts)
+{
+    int     retval = -1;
+    size_t  size;
+    size_t *slots;
+    size_t  i;
+    size_t  j;
+    char  **vec;
+
+    if (ts->ts_nr == ts->ts_max){
+        size = ts->ts_max ? 2*ts->ts_max : 16;
+        if ((vec = realloc(ts->ts_vec, size*ts->ts_width*sizeof(char*))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        ts->ts_vec = vec;
+        ts->ts_max = size;
+    }
+    if ((ts->ts_nr + 1)*2 > ts->ts_size){
+        size = ts->ts_size ? 2*ts->ts_size : 32;
+        if ((slots = calloc(size, sizeof(*slots))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        for (i=0; i<ts->ts_nr; i++){
+            j = tuple_hash(&ts->ts_vec[i*ts->ts_width], ts->ts_width) & (size-1);
+            while (slots[j] != 0)
+                j = (j+1) & (size-1);
+            slots[j] = i+1;
+        }
+        if (ts->ts_slots)
+            free(ts->ts_slots);
+        ts->ts_slots = slots;
+        ts->ts_size = size;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add a tuple to a tuple set unless an equal tuple already exists
+ *
+ * @param[in]  ts    Tuple set, with ts_width set
+ * @param[in]  tuple Tuple of ts_width strings, copied by reference
+ * @retval     1     OK, added
+ * @retval     0     Duplicate, an equal tuple exists
+ * @retval    -1     Error
+ */
+static int
+tuple_set_add(struct tuple_set *ts,
+              char            **tuple)
+{
+    size_t j;
+    size_t i;
+
+    if (tuple_set_grow(ts) < 0)
+        return -1;
+    j = tuple_hash(tuple, ts->ts_width) & (ts->ts_size-1);
+    while ((i = ts->ts_slots[j]) != 0){
+        if (tuple_eq(&ts->ts_vec[(i-1)*ts->ts_width], tuple, ts->ts_width))
+            return 0;
+        j = (j+1) & (ts->ts_size-1);
+    }
+    memcpy(&ts->ts_vec[ts->ts_nr*ts->ts_width], tuple, ts->ts_width*sizeof(char*));
+    ts->ts_slots[j] = ++ts->ts_nr;
+    return 1;
+}
+
+/*! Check that the results of a unique descendant path of a list entry are unique
  *
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+ * @param[in]  x     List entry
+ * @param[in]  xpath Canonical descendant schema node identifier
+ * @param[in]  nsc   Namespace context of xpath
+ * @param[in]  ts    Tuple set of width 1 of results of previous list entries
  * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
+ * @retval     0     Validation failed, a result is a duplicate
  * @retval    -1     Error
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
  */
 static int
-unique_search_xpath(cxobj  *x,
-                    char   *xpath,
-                    cvec   *nsc,
-                    char ***svec,
-                    size_t *slen)
+unique_search_xpath(cxobj            *x,
+                    char             *xpath,
+                    cvec             *nsc,
+                    struct tuple_set *ts)
 {
     int     retval = -1;
     cxobj **xvec = NULL;
     size_t  xveclen;
     int     i;
-    int     s;
-    cxobj  *xi;
+    int     ret;
     char   *bi;
 
     /* Collect tuples */
     if (xpath_vec(x, nsc, "%s", &xvec, &xveclen, xpath) < 0)
         goto done;
     for (i=0; i<xveclen; i++){
-        xi = xvec[i];
-        if ((bi = xml_body(xi)) == NULL)
+        if ((bi = xml_body(xvec[i])) == NULL)
             break;
-        /* Check if bi is duplicate? 
-         * XXX: sort svec?
-         */
-        for (s=0; s<(*slen); s++){
-            if (strcmp(bi, (*svec)[s]) == 0){
-                goto fail;
-            }
-        }
-        (*slen) ++;
-        if (((*svec) = realloc((*svec), (*slen)*sizeof(char*))) == NULL){
-            clixon_err(OE_UNIX, errno, "realloc");
+        if ((ret = tuple_set_add(ts, &bi)) < 0)
             goto done;
-        }
-        (*svec)[(*slen)-1] = bi;
+        if (ret == 0)
+            goto fail;
     } /* i search results */
     retval = 1;
  done:
@@ -137,53 +257,6 @@ unique_search_xpath(cxobj  *x,
     goto done;
 }
 
-/*! New element last in list, return error if already exists 
- *
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of vec
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
- * @retval     0     OK, entry is unique
- * @retval    -1     Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
- */
-static int
-check_insert_duplicate(char **vec,
-                       int    i1,
-                       int    vlen,
-                       int    sorted)
-{
-    int i;
-    int v;
-    char *b;
-
-    if (sorted){
-        /* Just go look at previous element to see if it is duplicate (sorted by system) */
-        if (i1 == 0)
-            return 0;
-        i = i1-1;
-        for (v=0; v<vlen; v++){
-            b = vec[i*vlen+v];
-            if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                return 0;
-        }
-        /* here we have passed thru all keys of previous element and they are all equal */
-        return -1;
-    }
-    else{
-        for (i=0; i<i1; i++){
-            for (v=0; v<vlen; v++){
-                b = vec[i*vlen+v];
-                if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                    break;
-            }
-            if (v==vlen) /* duplicate */
-                break;
-        }
-        return i==i1?0:-1;
-    }
-}
-
 /*! Given a list with unique constraint, detect duplicates
  *
  * @param[in]  x     The first element in the list (on return the last)
@@ -215,21 +288,24 @@ check_unique_list_direct(cxobj     *x,
                          yang_stmt *yu,
                          cxobj    **xret)
 {
-    int       retval = -1;
-    cg_var   *cvi; /* unique node name */
-    cxobj    *xi;
-    char    **vec = NULL; /* 2xmatrix */
-    int       clen;
-    int       i;
-    int       v;
-    char     *bi;
-    int       sorted;
-    char     *str;
-    cvec     *cvk;
-
-    /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
+    int              retval = -1;
+    cg_var          *cvi; /* unique node name */
+    cxobj           *xi;
+    char           **tuple = NULL; /* Values of this entry, followed by previous if sorted */
+    int              clen;
+    int              v;
+    char            *bi;
+    int              sorted;
+    int              prev = 0;
+    char            *str;
+    cvec            *cvk;
+    struct tuple_set ts = {0,};
+    int              ret;
+
+    /* If list and is sorted by system, then it is assumed elements are in key-order and
+     * a duplicate is next to the previous element.
+     * Other cases are "unique" constraint or list sorted by user where values are
+     * looked up in a hashed set of the values of previous elements.
      */
     sorted = (yang_keyword_get(yu) == Y_LIST &&
               yang_find(y, Y_ORDERED_BY, "user") == NULL);
@@ -239,18 +315,14 @@ check_unique_list_direct(cxobj     *x,
         /* No keys: no checks necessary */
         goto ok;
     }
-    if ((vec = calloc(clen*xml_child_nr(xt), sizeof(char*))) == NULL){
+    if ((tuple = calloc(2*clen, sizeof(char*))) == NULL){
         clixon_err(OE_UNIX, errno, "calloc");
         goto done;
     }
-    /* A vector is built with key-values, for each iteration check "backward" in the vector
-     * for duplicates
-     */
-    i = 0; /* x element index */
+    ts.ts_width = clen;
     do {
         cvi = NULL;
         v = 0; /* index in each tuple */
-        /* XXX Quadratic if clen > 1 */
         while ((cvi = cvec_each(cvk, cvi)) != NULL){
             /* RFC7950: Sec 7.8.3.1: entries that do not have value for all
              * referenced leafs are not taken into account */
@@ -263,25 +335,33 @@ check_unique_list_direct(cxobj     *x,
                 break;
             if ((bi = xml_body(xi)) == NULL)
                 break;
-            vec[i*clen + v++] = bi;
+            tuple[v++] = bi;
         }
-        if (cvi==NULL){
-            /* Last element (i) is newly inserted, see if it is already there */
-            if (check_insert_duplicate(vec, i, clen, sorted) < 0){
+        if (cvi != NULL)
+            prev = 0;
+        else{
+            if (sorted){
+                /* Just look at previous element to see if it is duplicate */
+                ret = prev && tuple_eq(tuple, tuple+clen, clen) ? 0 : 1;
+                memcpy(tuple+clen, tuple, clen*sizeof(char*));
+                prev = 1;
+            }
+            else if ((ret = tuple_set_add(&ts, tuple)) < 0)
+                goto done;
+            if (ret == 0){
                 if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
                     goto done;
                 goto fail;
             }
         }
         x = xml_child_each(xt, x, CX_ELMNT);
-        i++;
     } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
  ok:
-    /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
-    if (vec)
-        free(vec);
+    tuple_set_free(&ts);
+    if (tuple)
+        free(tuple);
     return retval;
  fail:
     retval = 0;
@@ -319,16 +399,15 @@ check_unique_list(cxobj     *x,
                   yang_stmt *yu,
                   cxobj    **xret)
 {
-    int       retval = -1;
-    cg_var    *cvi; /* unique node name */
-    char     **svec = NULL; /* vector of search results */
-    size_t     slen = 0;
-    char      *xpath0 = NULL;
-    char      *xpath1 = NULL;
-    int        ret;
-    cvec      *cvk;
-    cvec      *nsc0 = NULL;
-    cvec      *nsc1 = NULL;
+    int              retval = -1;
+    cg_var          *cvi; /* unique node name */
+    struct tuple_set ts = {0,}; /* set of search results */
+    char            *xpath0 = NULL;
+    char            *xpath1 = NULL;
+    int              ret;
+    cvec            *cvk;
+    cvec            *nsc0 = NULL;
+    cvec            *nsc1 = NULL;
 
     /* Check if multiple direct children */
     cvk = yang_cvec_get(yu);
@@ -354,9 +433,10 @@ check_unique_list(cxobj     *x,
         goto done;
     if (ret == 0)
         goto fail; // XXX set xret
+    ts.ts_width = 1;
     do {
         /* Collect search results from one */
-        if ((ret = unique_search_xpath(x, xpath1, nsc1, &svec, &slen)) < 0)
+        if ((ret = unique_search_xpath(x, xpath1, nsc1, &ts)) < 0)
             goto done;
         if (ret == 0){
             if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
@@ -366,7 +446,6 @@ check_unique_list(cxobj     *x,
         x = xml_child_each(xt, x, CX_ELMNT);
     } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
     // ok:
-    /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
     if (nsc0)
@@ -375,8 +454,7 @@ check_unique_list(cxobj     *x,
         cvec_free(nsc1);
     if (xpath1)
         free(xpath1);
-    if (svec)
-        free(svec);
+    tuple_set_free(&ts);
     return retval;
  fail:
     retval = 0;
@@ -542,7 +620,7 @@ xml_yang_minmax_new_list(cxobj     *x,
  * @retval     1     Validation OK
  * @retval     0     Validation failed (xret set)
  * @retval    -1     Error
- * @note works for both ordered-by user and system. But worst case quadratic
+ * @note works for both ordered-by user and system
  */
 static int
 xml_yang_minmax_new_leaf_list(cxobj     *x0,
@@ -550,38 +628,36 @@ xml_yang_minmax_new_leaf_list(cxobj     *x0,
                               yang_stmt *y0,
                               cxobj    **xret)
 {
-    int        retval = -1;
-    cxobj     *xi;
-    cxobj     *xj;
-    char      *bi;
-    char      *bj;
-    cvec      *cvv = NULL;
+    int              retval = -1;
+    cxobj           *xi;
+    char            *bi;
+    cvec            *cvv = NULL;
+    struct tuple_set ts = {0,};
+    int              ret;
 
+    ts.ts_width = 1;
     xi = x0;
     do {
         if ((bi = xml_body(xi)) == NULL)
             continue;
-        xj = xi;
-        while ((xj = xml_child_each(xt, xj, CX_ELMNT)) != NULL &&
-               xml_spec(xj) == y0) {
-            if ((bj = xml_body(xj)) == NULL)
-                continue;
-            if (bi && bj && strcmp(bi, bj) == 0){
-                if ((cvv = cvec_new(0)) == NULL){
-                    clixon_err(OE_UNIX, errno, "cvec_new");
-                    goto done;
-                }
-                cvec_add_string(cvv, "name", bi);
-                if (xret && netconf_data_not_unique_xml(xret, xi, cvv) < 0)
-                    goto done;
-                goto fail;
+        if ((ret = tuple_set_add(&ts, &bi)) < 0)
+            goto done;
+        if (ret == 0){
+            if ((cvv = cvec_new(0)) == NULL){
+                clixon_err(OE_UNIX, errno, "cvec_new");
+                goto done;
             }
+            cvec_add_string(cvv, "name", bi);
+            if (xret && netconf_data_not_unique_xml(xret, xi, cvv) < 0)
+                goto done;
+            goto fail;
         }
     }
     while ((xi = xml_child_each(xt, xi, CX_ELMNT)) != NULL &&
            xml_spec(xi) == y0);
     retval = 1;
  done:
+    tuple_set_free(&ts);
     if (cvv)
         cvec_free(cvv);
     return retval;
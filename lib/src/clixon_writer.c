@@ -0,0 +1,199 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Streaming writers of serialized output
+ *
+ * A writer is registered on the cbuf that XML, JSON or text output is serialized into.
+ * The serializers call clixon_writer_check() between children, and when the cbuf has
+ * grown beyond the writer size, its content is passed to a flush callback, eg a socket
+ * write, and the cbuf is reset. In this way a large reply is sent while it is serialized
+ * and the text buffer is bounded by the writer size plus the size of one subtree leaf.
+ * Output is flushed only between complete children, never inside a name or value.
+ * If no writer is registered the check is a single comparison.
+ * Not thread-safe, as the rest of libclixon.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_writer.h"
+
+/* Streaming writer
+ */
+struct clixon_writer{
+    struct clixon_writer *cw_next;    /* Next registered writer */
+    cbuf                 *cw_cb;      /* Serialization buffer */
+    size_t                cw_size;    /* Flush when buffer has grown to this size */
+    clixon_writer_fn     *cw_fn;      /* Flush callback */
+    void                 *cw_arg;     /* Flush callback argument */
+    size_t                cw_flushed; /* Number of bytes flushed */
+};
+
+/* List of registered writers, usually at most one */
+static clixon_writer *_writers = NULL;
+
+/*! Create and register a streaming writer on a cbuf
+ *
+ * @param[in]  cb    Buffer that output is serialized into
+ * @param[in]  size  Flush when cbuf has grown to this size, > 0
+ * @param[in]  fn    Flush callback
+ * @param[in]  arg   Argument to flush callback
+ * @retval     w     Writer, free with clixon_writer_free
+ * @retval     NULL  Error
+ * @code
+ *   if ((w = clixon_writer_new(cb, 65536, my_flush, &s)) == NULL)
+ *      err;
+ *   if (clixon_xml2cbuf(cb, xt, 0, 0, NULL, -1, 0) < 0)
+ *      err;
+ *   if (clixon_writer_flush(w) < 0)
+ *      err;
+ *   clixon_writer_free(w);
+ * @endcode
+ */
+clixon_writer *
+clixon_writer_new(cbuf             *cb,
+                  size_t            size,
+                  clixon_writer_fn *fn,
+                  void             *arg)
+{
+    clixon_writer *w;
+
+    if (cb == NULL || size == 0 || fn == NULL){
+        clixon_err(OE_UNIX, EINVAL, "cb, size or fn is zero");
+        return NULL;
+    }
+    if ((w = malloc(sizeof(*w))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(w, 0, sizeof(*w));
+    w->cw_cb = cb;
+    w->cw_size = size;
+    w->cw_fn = fn;
+    w->cw_arg = arg;
+    w->cw_next = _writers;
+    _writers = w;
+    return w;
+}
+
+/*! Unregister and free a streaming writer
+ *
+ * Remaining output in the cbuf is not flushed
+ * @param[in]  w   Writer
+ * @retval     0   OK
+ */
+int
+clixon_writer_free(clixon_writer *w)
+{
+    clixon_writer **wp;
+
+    for (wp = &_writers; *wp; wp = &(*wp)->cw_next)
+        if (*wp == w){
+            *wp = w->cw_next;
+            break;
+        }
+    free(w);
+    return 0;
+}
+
+/*! Flush the content of the cbuf of a writer to its callback and reset the cbuf
+ *
+ * @param[in]  w   Writer
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+clixon_writer_flush(clixon_writer *w)
+{
+    size_t len;
+
+    if ((len = cbuf_len(w->cw_cb)) == 0)
+        return 0;
+    if ((*w->cw_fn)(w->cw_arg, cbuf_get(w->cw_cb), len) < 0)
+        return -1;
+    w->cw_flushed += len;
+    cbuf_reset(w->cw_cb);
+    return 0;
+}
+
+/*! Flush a cbuf if a writer is registered on it and it has grown beyond the writer size
+ *
+ * Called by serializers between complete children
+ * @param[in]  cb  Buffer output is serialized into
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+clixon_writer_check(cbuf *cb)
+{
+    clixon_writer *w;
+
+    if (_writers == NULL)
+        return 0;
+    for (w = _writers; w; w = w->cw_next)
+        if (w->cw_cb == cb){
+            if (cbuf_len(cb) >= w->cw_size)
+                return clixon_writer_flush(w);
+            break;
+        }
+    return 0;
+}
+
+/*! Return number of bytes flushed by a writer
+ *
+ * @param[in]  w   Writer
+ * @retval     n   Number of bytes passed to the flush callback, 0 if nothing flushed
+ */
+size_t
+clixon_writer_flushed(clixon_writer *w)
+{
+    return w->cw_flushed;
+}
@@ -61,6 +61,7 @@
 #include "clixon_map.h"
 #include "clixon_queue.h"
 #include "clixon_hash.h"
+#include "clixon_intern.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
@@ -99,8 +100,13 @@
  * Types
  */
 
+static void xml_node_release(cxobj *x);
+
 #ifdef XML_EXPLICIT_INDEX
 static int xml_search_index_free(cxobj *x);
+static int xml_search_entry_update(cxobj *xp, cxobj *xe, int add);
+static int xml_search_index_pre(cxobj *xp, cxobj *xc, cxobj **xep);
+static int xml_search_index_post(cxobj *xe);
 
 /* A search index pair consisting of a name of an (index) variable and a vector of xml children
  * the variable should be a potential child of the XML node
@@ -119,15 +125,72 @@ static int xml_search_index_free(cxobj *x);
  *                +---+ +---+ +---+
  * value of "i"   | 5 | | 0 | | 2 |
  *                +---+ +---+ +---+
-
+ *
+ * The index variable may also be a path below the list entry, eg "x/i"
  */
 struct search_index{
     qelem_t      si_q;    /* Queue header */
-    char        *si_name; /* Name of index variable (must be (potential) child of xml node at hand */
+    char        *si_name; /* Name or path of index variable relative to list entry */
     clixon_xvec *si_xvec; /* Sorted vector of xml object pointers (should be of YANG type LIST) */
 };
 #endif
 
+#ifdef XML_HASH_INDEX
+static void xml_hash_index_free(cxobj *xp);
+static int  xml_hash_entry_update(cxobj *xp, cxobj *x, int add);
+static int  xml_hash_index_pre(cxobj *xp, cxobj *xc, cxobj **xep);
+static int  xml_hash_index_post(cxobj *xe);
+
+/* Slot in hash index, empty if xhs_x is NULL */
+struct xml_hash_slot{
+    struct xml  *xhs_x;    /* List or leaf-list entry */
+    uint32_t     xhs_hash; /* Hash of key values of entry, see xml_hash_key */
+};
+
+/* Hash index of the entries of one yang list or leaf-list among the children of an XML node
+ *
+ * Keyed on list key values (or leaf-list value) and matched as in xml_cmp.
+ * Built on the first search when the node has at least XML_HASH_INDEX_MIN children, see
+ * xml_hash_index_search. Then kept up-to-date when entries are added or removed, and
+ * when a key of an entry changes the entry is removed before and added again after the
+ * change, see xml_hash_index_pre.
+ * Entries that cannot be hashed, eg with a missing key, are counted and the index is not
+ * used while there are such entries.
+ * Open addressing with linear probing, at most half full.
+ */
+struct xml_hash_index{
+    qelem_t               xh_q;     /* Queue header */
+    yang_stmt            *xh_yang;  /* Yang list or leaf-list of indexed entries */
+    size_t                xh_size;  /* Number of slots, power of 2 */
+    size_t                xh_nr;    /* Number of entries */
+    struct xml_hash_slot *xh_slots; /* Slot vector */
+    size_t                xh_unhashable; /* Number of entries not hashable, not in slots */
+};
+#endif
+
+/* LRU list of nodes of an XML tree, see xml_lru_touch
+ *
+ * The top node of the tree has a list head (xl_x is NULL), and each node in the list has a
+ * link (xl_x is the node). A node is unlinked when it is freed, and all nodes are unlinked
+ * when the top node is freed.
+ * Heads and links are kept in a side table keyed by node, see xml_lru_get, since only few
+ * nodes, eg split nodes of multi-file datastores, are in a list.
+ */
+struct xml_lru{
+    qelem_t         xl_q;     /* Queue header of link, most recently used first */
+    struct xml     *xl_x;     /* Link: node in list. Head: NULL */
+    struct xml_lru *xl_head;  /* Link: list head of tree */
+    struct xml_lru *xl_first; /* Head: most recently used link */
+    int             xl_len;   /* Head: number of nodes in list */
+    struct xml     *xl_node;  /* Node of head or link, key of side table */
+    struct xml_lru *xl_next;  /* Next in side table bucket */
+};
+
+/* Side table of LRU heads and links, nodes in it have XML_FLAG_LRU set */
+static struct xml_lru **_xml_lru_vec = NULL;
+static size_t           _xml_lru_size = 0; /* Number of buckets, power of 2 */
+static size_t           _xml_lru_nr = 0;   /* Number of heads and links */
+
 /*! xml tree node, with name, type, parent, children, etc 
  *
  * Note that this is a private type not visible from externally, use
@@ -168,6 +231,7 @@ struct xml{
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           x_arena;      /* Arena bits, see XML_ARENA_NODE and xml_new_arena */
     struct xml       *x_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *x_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -175,10 +239,7 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for stable sorting:
                                        see xml_enumerate and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-                                       memory) cv? */
-    /*----- up to here is common to all next is element only */
+    /*----- up to here is common to all next is element only, see struct xmlbody */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
     int               x_childvec_max;/* Length of allocated vector */
@@ -186,10 +247,28 @@ struct xml{
     cvec             *x_ns_cache;   /* Cached vector of namespaces (set by bind-yang) */
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
                                        by reference, dont free */
-    cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
+    cg_var           *x_cv;         /* Cached typed value as cligen variable, see xml_cv */
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
+#ifdef XML_HASH_INDEX
+    struct xml_hash_index *x_hash_index; /* hash indexes of list children */
+#endif
+};
+
+/* Max length of body and attribute values stored inline in node, including null */
+#define XML_VALUE_INLINE 16
+
+/* Representation of body and attribute values
+ * Values are set once and rarely changed. A cbuf is only used when a value is appended to
+ * @see struct xmlbody
+ */
+enum xml_value_kind{
+    XV_NONE = 0,   /* No value */
+    XV_INLINE,     /* Short value stored in node: xv_inline */
+    XV_STR,        /* Exact-length value: xv_str */
+    XV_ARENA,      /* Exact-length value allocated from arena of node: xv_str */
+    XV_CBUF,       /* Appended value: xv_cb */
 };
 
 /* Variant of struct xml for use by non-elements to save space
@@ -200,6 +279,8 @@ struct xmlbody{
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           xb_arena;      /* Arena bits, see XML_ARENA_NODE and xml_new_arena */
+    uint8_t           xb_vkind;      /* Value representation, see enum xml_value_kind */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *xb_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -207,9 +288,67 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
                                        see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    union {                          /* attribute and body nodes have values */
+        char          xv_inline[XML_VALUE_INLINE];
+        char         *xv_str;
+        cbuf         *xv_cb;
+    }                 xb_value;
+};
+
+/* Size of arena memory chunks */
+#define XML_ARENA_CHUNK 65536
+
+/* Arena memory chunk, allocations are made from xac_data */
+struct xml_arena_chunk{
+    struct xml_arena_chunk *xac_next; /* Next (older) chunk */
+    size_t                  xac_len;  /* Size of xac_data */
+    size_t                  xac_off;  /* Offset of next free byte in xac_data */
+    char                    xac_data[];
 };
 
+/* Node with memory outside the arena, eg typed value or namespace cache, see xml_arena_hold */
+struct xml_arena_held{
+    struct xml_arena_held *xah_next;
+    struct xml            *xah_x;
+};
+
+/* Arena for the nodes of a temporary XML tree
+ *
+ * Nodes are allocated from large chunks instead of one malloc per node. Freed nodes are
+ * kept in free lists per node size and reused. Child vectors and values longer than
+ * XML_VALUE_INLINE are also allocated from the chunks and are not reused.
+ * Each node is preceded by a pointer to its arena. Nodes created with xml_new under an
+ * arena node are allocated from the same arena.
+ * The arena holds one reference to each interned name of its nodes, and keeps a list of
+ * nodes with memory outside the arena. If all nodes of the arena are in the tree of the top
+ * node, and all nodes in the tree are from the arena, freeing the top node releases the
+ * arena at once, without visiting the nodes.
+ * Otherwise the nodes are freed one by one and the arena is released when its last node is
+ * freed. Nodes moved to another tree therefore pin the arena, and after the top node is
+ * freed, no more memory is allocated from the arena, see XML_ARENA_PINNED_MAX.
+ * @see xml_new_arena
+ */
+struct xml_arena{
+    struct xml_arena_chunk *xa_chunk;      /* Current chunk, linked to older chunks */
+    size_t                  xa_size;       /* Size of all chunks */
+    uint64_t                xa_nr;         /* Number of allocated nodes */
+    void                   *xa_free_elmnt; /* Free list of element nodes */
+    void                   *xa_free_body;  /* Free list of body and attribute nodes */
+    struct xml             *xa_top;        /* Top node, NULL when freed */
+    int                     xa_closed;     /* Top node freed, arena is pinned by other nodes */
+    uint64_t                xa_out;        /* Nodes of arena not in tree of top, or of other
+                                              arenas or heap in the tree of top */
+    struct xml_arena_held  *xa_held;       /* Nodes with memory outside the arena */
+    char                  **xa_names;      /* Interned names of nodes, one reference each */
+    size_t                  xa_names_size; /* Number of name slots, power of 2 */
+    size_t                  xa_names_nr;   /* Number of names */
+};
+
+/* Bits of x_arena of node */
+#define XML_ARENA_NODE 0x01 /* Node allocated from arena */
+#define XML_ARENA_HELD 0x02 /* Node in held list of arena, see xml_arena_hold */
+#define XML_ARENA_VEC  0x04 /* Child vector allocated from arena */
+
 /*
  * Variables
  */
@@ -262,10 +401,7 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
-        sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
-        sz += strlen(x->x_prefix) + 1;
+    /* Names and prefixes are interned and shared, see clixon_intern_stats */
     switch (xml_type(x)){
     case CX_ELMNT:
         sz += sizeof(struct xml);
@@ -283,13 +419,31 @@ xml_stats_one(cxobj    *x,
             if (x->x_search_index->si_xvec)
                 sz += clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*);
         }
+#endif
+#ifdef XML_HASH_INDEX
+        if (x->x_hash_index){
+            struct xml_hash_index *xh = x->x_hash_index;
+            do {
+                sz += sizeof(struct xml_hash_index) + xh->xh_size*sizeof(struct xml_hash_slot);
+                xh = NEXTQ(struct xml_hash_index *, xh);
+            } while (xh && xh != x->x_hash_index);
+        }
 #endif
         break;
     case CX_BODY:
     case CX_ATTR:
         sz += sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            sz += cbuf_buflen(x->x_value_cb);
+        switch (((struct xmlbody*)x)->xb_vkind){
+        case XV_STR:
+        case XV_ARENA:
+            sz += strlen(((struct xmlbody*)x)->xb_value.xv_str) + 1;
+            break;
+        case XV_CBUF:
+            sz += cbuf_buflen(((struct xmlbody*)x)->xb_value.xv_cb);
+            break;
+        default:
+            break;
+        }
         break;
     default:
         break;
@@ -336,6 +490,319 @@ xml_stats(cxobj    *xt,
     return retval;
 }
 
+/* Number of arenas, and memory of arenas whose top node is freed, see xml_arena_stats */
+static uint64_t _xml_arena_nr = 0;
+static size_t   _xml_arena_pinned = 0;
+
+/*! Allocate memory from XML arena
+ *
+ * @param[in]  xa   XML arena
+ * @param[in]  sz   Size in bytes
+ * @retval     ptr  Allocated memory, aligned for pointers, released with the arena
+ * @retval     NULL Error
+ */
+static void *
+xml_arena_alloc(struct xml_arena *xa,
+                size_t            sz)
+{
+    struct xml_arena_chunk *xac;
+    size_t                  len;
+    void                   *ptr;
+
+    sz = (sz + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    if ((xac = xa->xa_chunk) == NULL ||
+        xac->xac_off + sz > xac->xac_len){
+        len = sz > XML_ARENA_CHUNK ? sz : XML_ARENA_CHUNK;
+        if ((xac = malloc(sizeof(*xac) + len)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return NULL;
+        }
+        xac->xac_len = len;
+        xac->xac_off = 0;
+        xac->xac_next = xa->xa_chunk;
+        xa->xa_chunk = xac;
+        xa->xa_size += sizeof(*xac) + len;
+        if (xa->xa_closed)
+            _xml_arena_pinned += sizeof(*xac) + len;
+    }
+    ptr = xac->xac_data + xac->xac_off;
+    xac->xac_off += sz;
+    return ptr;
+}
+
+/*! Keep one reference of interned name in XML arena
+ *
+ * @param[in]  xa    XML arena
+ * @param[in]  name  Interned name with one reference, which is given to the arena
+ * @retval     0     OK
+ * @retval    -1     Error, reference is released
+ */
+static int
+xml_arena_name(struct xml_arena *xa,
+               char             *name)
+{
+    char  **names;
+    size_t  size;
+    size_t  i;
+    size_t  j;
+
+    if (xa->xa_names_size){
+        for (i = ((uintptr_t)name >> 3) & (xa->xa_names_size-1);
+             xa->xa_names[i] != NULL;
+             i = (i+1) & (xa->xa_names_size-1))
+            if (xa->xa_names[i] == name){
+                clixon_intern_free(name); /* Arena already has a reference */
+                return 0;
+            }
+    }
+    if (2*(xa->xa_names_nr + 1) > xa->xa_names_size){
+        size = xa->xa_names_size ? 2*xa->xa_names_size : 64;
+        if ((names = calloc(size, sizeof(*names))) == NULL){
+            clixon_err(OE_XML, errno, "calloc");
+            clixon_intern_free(name);
+            return -1;
+        }
+        for (i = 0; i < xa->xa_names_size; i++){
+            if (xa->xa_names[i] == NULL)
+                continue;
+            j = ((uintptr_t)xa->xa_names[i] >> 3) & (size-1);
+            while (names[j] != NULL)
+                j = (j+1) & (size-1);
+            names[j] = xa->xa_names[i];
+        }
+        if (xa->xa_names)
+            free(xa->xa_names);
+        xa->xa_names = names;
+        xa->xa_names_size = size;
+    }
+    i = ((uintptr_t)name >> 3) & (xa->xa_names_size-1);
+    while (xa->xa_names[i] != NULL)
+        i = (i+1) & (xa->xa_names_size-1);
+    xa->xa_names[i] = name;
+    xa->xa_names_nr++;
+    return 0;
+}
+
+/*! Get arena of XML node allocated from an arena
+ *
+ * @param[in]  x    XML node with x_arena set
+ * @retval     xa   XML arena
+ */
+static inline struct xml_arena *
+xml_arena_get(cxobj *x)
+{
+    return ((struct xml_arena **)x)[-1];
+}
+
+/*! Get arena to allocate new memory of XML node from
+ *
+ * @param[in]  x    XML node, or NULL
+ * @retval     xa   XML arena of x
+ * @retval     NULL x is not from an arena, or its top node is freed: use heap
+ */
+static inline struct xml_arena *
+xml_arena_open(cxobj *x)
+{
+    struct xml_arena *xa;
+
+    if (x == NULL || !x->x_arena || (xa = xml_arena_get(x))->xa_closed)
+        return NULL;
+    return xa;
+}
+
+/*! Add XML node with memory outside its arena to the held list of the arena
+ *
+ * The memory is freed when the node is freed, or when the arena is released at once.
+ * @param[in]  x    XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_node_release
+ */
+static int
+xml_arena_hold(cxobj *x)
+{
+    struct xml_arena      *xa;
+    struct xml_arena_held *xah;
+
+    if ((x->x_arena & XML_ARENA_HELD) ||
+        (xa = xml_arena_open(x)) == NULL)
+        return 0;
+    if ((xah = xml_arena_alloc(xa, sizeof(*xah))) == NULL)
+        return -1;
+    xah->xah_x = x;
+    xah->xah_next = xa->xa_held;
+    xa->xa_held = xah;
+    x->x_arena |= XML_ARENA_HELD;
+    return 0;
+}
+
+/*! Count XML node as outside the tree of the top node of its arena, or of its parent's
+ *
+ * @param[in]  x    XML node
+ * @param[in]  xp   Parent of x, or NULL
+ * @param[in]  n    1 when x is added to xp, -1 when removed
+ * @see xml_parent_set
+ */
+static void
+xml_arena_link(cxobj *x,
+               cxobj *xp,
+               int    n)
+{
+    struct xml_arena *xa = NULL;
+    struct xml_arena *xap = NULL;
+
+    if (x->x_arena)
+        xa = xml_arena_get(x);
+    if (xp && xp->x_arena)
+        xap = xml_arena_get(xp);
+    if (xa && xa != xap && xa->xa_top != x)
+        xa->xa_out += n;
+    if (xap && xap != xa)
+        xap->xa_out += n;
+}
+
+/*! Release all memory of XML arena
+ *
+ * @param[in]  xa   XML arena
+ */
+static void
+xml_arena_release(struct xml_arena *xa)
+{
+    struct xml_arena_chunk *xac;
+    size_t                  i;
+
+    if (xa->xa_closed)
+        _xml_arena_pinned -= xa->xa_size;
+    for (i = 0; i < xa->xa_names_size; i++)
+        if (xa->xa_names[i])
+            clixon_intern_free(xa->xa_names[i]);
+    if (xa->xa_names)
+        free(xa->xa_names);
+    while ((xac = xa->xa_chunk) != NULL){
+        xa->xa_chunk = xac->xac_next;
+        free(xac);
+    }
+    free(xa);
+    _xml_arena_nr--;
+}
+
+/*! Allocate XML node of given size, from arena or heap
+ *
+ * @param[in]  xa   XML arena, or NULL for heap
+ * @param[in]  type XML type, selects arena free list
+ * @param[in]  sz   Size of node
+ * @retval     x    Zeroed XML node
+ * @retval     NULL Error
+ */
+static cxobj *
+xml_node_alloc(struct xml_arena *xa,
+               enum cxobj_type   type,
+               size_t            sz)
+{
+    cxobj *x;
+    void **freelist;
+    void **p;
+
+    if (xa == NULL){
+        if ((x = malloc(sz)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return NULL;
+        }
+        memset(x, 0, sz);
+        return x;
+    }
+    freelist = type==CX_ELMNT ? &xa->xa_free_elmnt : &xa->xa_free_body;
+    if ((x = *freelist) != NULL)
+        *freelist = *(void**)x;
+    else {
+        if ((p = xml_arena_alloc(xa, sizeof(struct xml_arena*) + sz)) == NULL)
+            return NULL;
+        *p = xa;
+        x = (cxobj*)(p + 1);
+    }
+    memset(x, 0, sz);
+    x->x_arena = XML_ARENA_NODE;
+    xa->xa_nr++;
+    xa->xa_out++; /* No parent yet */
+    return x;
+}
+
+/*! Free XML node, to arena free list or heap
+ *
+ * The arena is released when its last node is freed
+ * @param[in]  x    XML node, other memory of node is already freed
+ */
+static void
+xml_node_free(cxobj *x)
+{
+    struct xml_arena *xa;
+    void            **freelist;
+
+    if (!x->x_arena){
+        free(x);
+        return;
+    }
+    xa = xml_arena_get(x);
+    if (xa->xa_top == x){ /* Remaining nodes pin the arena */
+        xa->xa_top = NULL;
+        xa->xa_closed = 1;
+        _xml_arena_pinned += xa->xa_size;
+    }
+    if (--xa->xa_nr == 0){
+        xml_arena_release(xa);
+        return;
+    }
+    if (x->x_arena & XML_ARENA_HELD) /* Still in held list, not reused */
+        return;
+    freelist = xml_type(x)==CX_ELMNT ? &xa->xa_free_elmnt : &xa->xa_free_body;
+    *(void**)x = *freelist;
+    *freelist = x;
+}
+
+/*! Release all memory of XML arena given its top node, without visiting the nodes
+ *
+ * @param[in]  x    XML node
+ * @retval     1    Released, x and all nodes of its arena are freed
+ * @retval     0    Not released: x is not an arena top node, or nodes are in other trees
+ */
+static int
+xml_arena_free(cxobj *x)
+{
+    struct xml_arena      *xa;
+    struct xml_arena_held *xah;
+
+    if (!x->x_arena ||
+        x->x_up != NULL ||
+        (xa = xml_arena_get(x))->xa_top != x ||
+        xa->xa_out != 0)
+        return 0;
+    for (xah = xa->xa_held; xah; xah = xah->xah_next)
+        xml_node_release(xah->xah_x);
+    _stats_xml_nr -= xa->xa_nr;
+    xml_arena_release(xa);
+    return 1;
+}
+
+/*! Make removed child the top node of arena, before the old top node is freed
+ *
+ * Both are roots, so the number of nodes outside the tree of the top node is the same
+ * @param[in]  xp   Top node of arena
+ * @param[in]  xc   Child removed from xp
+ * @see xml_rootchild
+ */
+static void
+xml_arena_top_move(cxobj *xp,
+                   cxobj *xc)
+{
+    struct xml_arena *xa;
+
+    if (!xp->x_arena || !xc->x_arena ||
+        (xa = xml_arena_get(xp))->xa_top != xp ||
+        xml_arena_get(xc) != xa)
+        return;
+    xa->xa_top = xc;
+}
+
 /*
  * Access functions
  */
@@ -353,27 +820,32 @@ xml_name(cxobj *xn)
     return xn->x_name;
 }
 
-/*! Set name of xnode, name is copied
+/*! Set name of xnode, name is interned
  *
  * @param[in]  xn    xml node
  * @param[in]  name  new name, null-terminated string, copied by function
  * @retval     0     OK
  * @retval    -1     On error with clicon-err set
+ * @note The name is shared with other nodes of same name and must not be modified
+ * @see clixon_intern
  */
 int
 xml_name_set(cxobj *xn,
              char  *name)
 {
-    if (xn->x_name){
-        free(xn->x_name);
-        xn->x_name = NULL;
-    }
-    if (name){
-        if ((xn->x_name = strdup(name)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
+    char *iname = NULL;
+
+    /* Intern new name before releasing old, name may be the old name */
+    if (name &&
+        (iname = clixon_intern(name)) == NULL)
+        return -1;
+    if (xn->x_arena){ /* Arena keeps reference */
+        if (iname && xml_arena_name(xml_arena_get(xn), iname) < 0)
             return -1;
-        }
     }
+    else if (xn->x_name)
+        clixon_intern_free(xn->x_name);
+    xn->x_name = iname;
     return 0;
 }
 
@@ -388,27 +860,30 @@ xml_prefix(cxobj *xn)
     return xn->x_prefix;
 }
 
-/*! Set prefix of xnode, prefix is copied
+/*! Set prefix of xnode, prefix is interned
  *
  * @param[in]  xn      XML node
  * @param[in]  prefix  New prefix, null-terminated string, copied by function
  * @retval     0       OK
  * @retval    -1       Error with clicon-err set
+ * @see clixon_intern
  */
 int
 xml_prefix_set(cxobj *xn,
                char  *prefix)
 {
-    if (xn->x_prefix){
-        free(xn->x_prefix);
-        xn->x_prefix = NULL;
-    }
-    if (prefix){
-        if ((xn->x_prefix = strdup(prefix)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
+    char *iprefix = NULL;
+
+    if (prefix &&
+        (iprefix = clixon_intern(prefix)) == NULL)
+        return -1;
+    if (xn->x_arena){ /* Arena keeps reference */
+        if (iprefix && xml_arena_name(xml_arena_get(xn), iprefix) < 0)
             return -1;
-        }
     }
+    else if (xn->x_prefix)
+        clixon_intern_free(xn->x_prefix);
+    xn->x_prefix = iprefix;
     return 0;
 }
 
@@ -485,6 +960,8 @@ nscache_set(cxobj *x,
     if (!is_element(x))
         return 0;
     if (x->x_ns_cache == NULL){
+        if (xml_arena_hold(x) < 0)
+            goto done;
         if ((x->x_ns_cache = xml_nsctx_init(prefix, namespace)) == NULL)
             goto done;
     }
@@ -515,9 +992,13 @@ nscache_replace(cxobj *x,
         xml_nsctx_free(x->x_ns_cache);
         x->x_ns_cache = NULL;
     }
+    if (nsc && xml_arena_hold(x) < 0){
+        xml_nsctx_free(nsc);
+        goto done;
+    }
     x->x_ns_cache = nsc;
     retval = 0;
-    // done:
+ done:
     return retval;
 }
 
@@ -567,6 +1048,12 @@ int
 xml_parent_set(cxobj *xn,
                cxobj *parent)
 {
+    if (xn->x_arena ||
+        (xn->x_up && xn->x_up->x_arena) ||
+        (parent && parent->x_arena)){
+        xml_arena_link(xn, xn->x_up, -1);
+        xml_arena_link(xn, parent, 1);
+    }
     xn->x_up = parent;
     return 0;
 }
@@ -639,6 +1126,95 @@ xml_flag_reset(cxobj   *xn,
     return 0;
 }
 
+/*! Clear cached typed value of element whose body changed
+ *
+ * @param[in]  xp    XML element, parent of changed body, or NULL
+ * @see xml_cv
+ */
+static inline void
+xml_cv_clear(cxobj *xp)
+{
+    if (xp && xp->x_cv){
+        cv_free(xp->x_cv);
+        xp->x_cv = NULL;
+    }
+}
+
+/*! Get element of body node if it is bound to yang
+ *
+ * Typed value cache and indexes of the element depend on its body and are only kept
+ * when the element has a yang spec
+ * @param[in]  xn    XML body or attribute node
+ * @retval     xp    XML element, parent of body node
+ * @retval     NULL  Not a body, no parent, or parent not bound to yang
+ */
+static inline cxobj *
+xml_body_bound_parent(cxobj *xn)
+{
+    cxobj *xp;
+
+    if (xml_type(xn) != CX_BODY ||
+        (xp = xml_parent(xn)) == NULL ||
+        xml_spec(xp) == NULL)
+        return NULL;
+    return xp;
+}
+
+/*! Free value of body or attribute node
+ *
+ * @param[in]  xb    XML body or attribute node
+ */
+static void
+xml_value_free(struct xmlbody *xb)
+{
+    switch (xb->xb_vkind){
+    case XV_STR:
+        free(xb->xb_value.xv_str);
+        break;
+    case XV_CBUF:
+        cbuf_free(xb->xb_value.xv_cb);
+        break;
+    default:
+        break;
+    }
+    xb->xb_vkind = XV_NONE;
+}
+
+/*! Store value of body or attribute node in compact form, inline or exact-length
+ *
+ * @param[in]  xb    XML body or attribute node with no value
+ * @param[in]  val   Value, null-terminated string, copied by function
+ * @param[in]  len   Length of value
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_value_store(struct xmlbody *xb,
+                char           *val,
+                size_t          len)
+{
+    struct xml_arena *xa;
+    char             *str;
+
+    if (len < XML_VALUE_INLINE){ /* val may be the current inline value */
+        memmove(xb->xb_value.xv_inline, val, len + 1);
+        xb->xb_vkind = XV_INLINE;
+        return 0;
+    }
+    if ((xa = xml_arena_open((cxobj*)xb)) != NULL){
+        if ((str = xml_arena_alloc(xa, len + 1)) == NULL)
+            return -1;
+    }
+    else if ((str = malloc(len + 1)) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        return -1;
+    }
+    memcpy(str, val, len + 1);
+    xb->xb_value.xv_str = str;
+    xb->xb_vkind = xa ? XV_ARENA : XV_STR;
+    return 0;
+}
+
 /*! Get value of xnode
  *
  * @param[in]  xn    xml node
@@ -647,9 +1223,22 @@ xml_flag_reset(cxobj   *xn,
 char*
 xml_value(cxobj *xn)
 {
+    struct xmlbody *xb = (struct xmlbody*)xn;
+
     if (!is_bodyattr(xn))
         return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    switch (xb->xb_vkind){
+    case XV_INLINE:
+        return xb->xb_value.xv_inline;
+    case XV_STR:
+    case XV_ARENA:
+        return xb->xb_value.xv_str;
+    case XV_CBUF:
+        return cbuf_get(xb->xb_value.xv_cb);
+    default:
+        break;
+    }
+    return NULL;
 }
 
 /*! Set value of xml node, value is copied
@@ -658,13 +1247,23 @@ xml_value(cxobj *xn)
  * @param[in]  val   new value, null-terminated string, copied by function
  * @retval     0     OK
  * @retval    -1     On error with clicon-err set
+ * @note Short values are stored inline in the node, others in an exact-length copy
+ * @note val may point into the current value, which is freed after the new value is stored
  */
 int
 xml_value_set(cxobj *xn,
               char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb = (struct xmlbody*)xn;
+    struct xmlbody  xold;
+    cxobj          *xp;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj          *xe = NULL;
+#endif
+#ifdef XML_HASH_INDEX
+    cxobj          *xhe = NULL;
+#endif
 
     if (!is_bodyattr(xn))
         return 0;
@@ -672,18 +1271,35 @@ xml_value_set(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
+    if ((xp = xml_body_bound_parent(xn)) != NULL){
+#ifdef XML_EXPLICIT_INDEX
+        if (xml_search_index_pre(xp, xn, &xe) < 0)
             goto done;
-        }
+#endif
+#ifdef XML_HASH_INDEX
+        if (xml_hash_index_pre(xp, xn, &xhe) < 0)
+            goto done;
+#endif
+        xml_cv_clear(xp);
     }
-    else
-        cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+    xold = *xb;
+    if (xml_value_store(xb, val, strlen(val)) < 0){
+        xb->xb_value = xold.xb_value;
+        xb->xb_vkind = xold.xb_vkind;
+        goto done;
+    }
+    xml_value_free(&xold);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_post(xe) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
+#ifdef XML_HASH_INDEX
+    /* Also after error, entry is added given the value it has */
+    if (xml_hash_index_post(xhe) < 0)
+        retval = -1;
+#endif
     return retval;
 }
 
@@ -693,13 +1309,24 @@ xml_value_set(cxobj *xn,
  * @param[in]  val   appended value, null-terminated string, copied by function
  * @retval     new value
  * @retval     NULL  on error with clicon-err set, or if value is set to NULL
+ * @note Appending to a non-empty value changes its representation to a cbuf
  */
 int
 xml_value_append(cxobj *xn,
                  char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb = (struct xmlbody*)xn;
+    char           *old;
+    cbuf           *cb;
+    size_t          len;
+    cxobj          *xp;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj          *xe = NULL;
+#endif
+#ifdef XML_HASH_INDEX
+    cxobj          *xhe = NULL;
+#endif
 
     if (!is_bodyattr(xn))
         return 0;
@@ -707,19 +1334,61 @@ xml_value_append(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
+    len = strlen(val);
+    if ((xp = xml_body_bound_parent(xn)) != NULL){
+#ifdef XML_EXPLICIT_INDEX
+        if (xml_search_index_pre(xp, xn, &xe) < 0)
+            goto done;
+#endif
+#ifdef XML_HASH_INDEX
+        if (xml_hash_index_pre(xp, xn, &xhe) < 0)
+            goto done;
+#endif
+        xml_cv_clear(xp);
+    }
+    switch (xb->xb_vkind){
+    case XV_NONE: /* First append is a set */
+        if (xml_value_store(xb, val, len) < 0)
+            goto done;
+        break;
+    case XV_INLINE:
+    case XV_STR:
+    case XV_ARENA:
+        if (xml_arena_hold(xn) < 0)
+            goto done;
+        old = xml_value(xn);
+        if ((cb = cbuf_new_alloc(strlen(old) + len + 1)) == NULL){
             clixon_err(OE_XML, errno, "cbuf_new");
             goto done;
         }
+        if (cbuf_append_str(cb, old) < 0 ||
+            cbuf_append_str(cb, val) < 0){ /* val may point into old */
+            clixon_err(OE_XML, errno, "cbuf_append_str");
+            cbuf_free(cb);
+            goto done;
+        }
+        xml_value_free(xb);
+        xb->xb_value.xv_cb = cb;
+        xb->xb_vkind = XV_CBUF;
+        break;
+    case XV_CBUF:
+        if (cbuf_append_str(xb->xb_value.xv_cb, val) < 0){
+            clixon_err(OE_XML, errno, "cprintf");
+            goto done;
+        }
+        break;
     }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-        clixon_err(OE_XML, errno, "cprintf");
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_post(xe) < 0)
         goto done;
-    }
+#endif
     retval = 0;
  done:
+#ifdef XML_HASH_INDEX
+    /* Also after error, entry is added given the value it has */
+    if (xml_hash_index_post(xhe) < 0)
+        retval = -1;
+#endif
     return retval;
 }
 
@@ -879,8 +1548,13 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
         return NULL;
-    if (i < xt->x_childvec_len)
+    if (i < xt->x_childvec_len){
         xt->x_childvec[i] = xc;
+        xml_cv_clear(xt);
+#ifdef XML_HASH_INDEX
+        xml_hash_index_free(xt);
+#endif
+    }
     return 0;
 }
 
@@ -1008,39 +1682,116 @@ xml_child_each_attr(cxobj  *xparent,
     return xn;
 }
 
-/*! Extend child vector with one and insert xml node there
+/*! Grow child vector of XML node to fit one more child
  *
- * @note does not do anything with child, you may need to set its parent, etc
- * @see xml_child_insert_pos
- * XXX could insert hint if we know this is a yang list and not a leaf to increase start.
+ * Vectors of nodes from an arena are allocated from the arena and always doubled, since
+ * the old vector is not reused
+ * @param[in]  xp    XML node
+ * @param[in]  start Initial size
+ * @retval     0     OK
+ * @retval    -1     Error
  */
 static int
-xml_child_append(cxobj *xp,
-                 cxobj *xc)
+xml_childvec_grow(cxobj *xp,
+                  size_t start)
 {
-    size_t start;
-
-    if (!is_element(xp))
-        return 0;
-    start = XML_CHILDVEC_SIZE_START;
-    /* Heurestics: if child is body only single child is expected, but element children may
-     * have siblings
-     */
-    if (xml_type(xc) == CX_ELMNT)
-        start = XML_CHILDVEC_SIZE_START_ELMNT;
-    xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:start;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
+    struct xml_arena *xa;
+    cxobj           **vec;
+    size_t            max;
+
+    xa = xml_arena_open(xp);
+    if (xp->x_childvec_max == 0)
+        max = start;
+    else if (xa != NULL || xp->x_childvec_max < XML_CHILDVEC_SIZE_THRESHOLD)
+        max = 2*xp->x_childvec_max;
+    else
+        max = xp->x_childvec_max + XML_CHILDVEC_SIZE_THRESHOLD;
+    if (xa != NULL){
+        if ((vec = xml_arena_alloc(xa, max*sizeof(cxobj*))) == NULL)
+            return -1;
+    }
+    else if (xp->x_arena & XML_ARENA_VEC){ /* Arena closed: move vector to heap */
+        if ((vec = malloc(max*sizeof(cxobj*))) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return -1;
+        }
+    }
+    else {
+        if ((vec = realloc(xp->x_childvec, max*sizeof(cxobj*))) == NULL){
             clixon_err(OE_XML, errno, "realloc");
             return -1;
         }
+        xp->x_childvec = vec;
+        xp->x_childvec_max = max;
+        return 0;
+    }
+    if (xp->x_childvec){
+        memcpy(vec, xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
+        if (!(xp->x_arena & XML_ARENA_VEC))
+            free(xp->x_childvec);
     }
+    if (xa != NULL)
+        xp->x_arena |= XML_ARENA_VEC;
+    else
+        xp->x_arena &= ~XML_ARENA_VEC;
+    xp->x_childvec = vec;
+    xp->x_childvec_max = max;
+    return 0;
+}
+
+/*! Extend child vector with one and insert xml node there
+ *
+ * @note does not do anything with child, you may need to set its parent, etc
+ * @see xml_child_insert_pos
+ * XXX could insert hint if we know this is a yang list and not a leaf to increase start.
+ */
+static int
+xml_child_append(cxobj *xp,
+                 cxobj *xc)
+{
+    size_t start;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xe = NULL;
+#endif
+#ifdef XML_HASH_INDEX
+    cxobj *xhe = NULL;
+#endif
+
+    if (!is_element(xp))
+        return 0;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_pre(xp, xc, &xe) < 0)
+        return -1;
+#endif
+#ifdef XML_HASH_INDEX
+    if (xml_hash_index_pre(xp, xc, &xhe) < 0)
+        return -1;
+#endif
+    start = XML_CHILDVEC_SIZE_START;
+    /* Heurestics: if child is body only single child is expected, but element children may
+     * have siblings
+     */
+    if (xml_type(xc) == CX_ELMNT)
+        start = XML_CHILDVEC_SIZE_START_ELMNT;
+    else
+        xml_cv_clear(xp);
+    if (xp->x_childvec_len == xp->x_childvec_max &&
+        xml_childvec_grow(xp, start) < 0)
+        return -1;
+    xp->x_childvec_len++;
     xp->x_childvec[xp->x_childvec_len-1] = xc;
+#ifdef XML_HASH_INDEX
+    if (xml_hash_entry_update(xp, xc, 1) < 0)
+        return -1;
+    if (xml_hash_index_post(xhe) < 0)
+        return -1;
+#endif
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_post(xe) < 0)
+        return -1;
+    if (xml_search_entry_update(xp, xc, 1) < 0)
+        return -1;
+#endif
     return 0;
 }
 
@@ -1060,24 +1811,43 @@ xml_child_insert_pos(cxobj *xp,
                      int    pos)
 {
     size_t size;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xe = NULL;
+#endif
+#ifdef XML_HASH_INDEX
+    cxobj *xhe = NULL;
+#endif
 
     if (!is_element(xp))
         return 0;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_pre(xp, xc, &xe) < 0)
+        return -1;
+#endif
+#ifdef XML_HASH_INDEX
+    if (xml_hash_index_pre(xp, xc, &xhe) < 0)
+        return -1;
+#endif
+    xml_cv_clear(xp);
+    if (xp->x_childvec_len == xp->x_childvec_max &&
+        xml_childvec_grow(xp, XML_CHILDVEC_SIZE_START) < 0)
+        return -1;
     xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:XML_CHILDVEC_SIZE_START;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
-            clixon_err(OE_XML, errno, "realloc");
-            return -1;
-        }
-    }
     size = (xml_child_nr(xp) - pos - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[pos+1], &xp->x_childvec[pos], size);
     xp->x_childvec[pos] = xc;
+#ifdef XML_HASH_INDEX
+    if (xml_hash_entry_update(xp, xc, 1) < 0)
+        return -1;
+    if (xml_hash_index_post(xhe) < 0)
+        return -1;
+#endif
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_post(xe) < 0)
+        return -1;
+    if (xml_search_entry_update(xp, xc, 1) < 0)
+        return -1;
+#endif
     return 0;
 }
 
@@ -1093,13 +1863,29 @@ int
 xml_childvec_set(cxobj *x,
                  int    len)
 {
+    struct xml_arena *xa;
+
     if (!is_element(x))
         return 0;
+    xml_cv_clear(x);
+#ifdef XML_EXPLICIT_INDEX
+    xml_search_index_free(x);
+#endif
+#ifdef XML_HASH_INDEX
+    xml_hash_index_free(x);
+#endif
     x->x_childvec_len = len;
     x->x_childvec_max = len;
-    if (x->x_childvec)
+    if (x->x_childvec && !(x->x_arena & XML_ARENA_VEC))
         free(x->x_childvec);
-    if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
+    x->x_arena &= ~XML_ARENA_VEC;
+    if ((xa = xml_arena_open(x)) != NULL){
+        if ((x->x_childvec = xml_arena_alloc(xa, len*sizeof(cxobj*))) == NULL)
+            return -1;
+        memset(x->x_childvec, 0, len*sizeof(cxobj*));
+        x->x_arena |= XML_ARENA_VEC;
+    }
+    else if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
         clixon_err(OE_XML, errno, "calloc");
         return -1;
     }
@@ -1142,27 +1928,20 @@ clixon_child_xvec_append(cxobj       *xn,
     return retval;
 }
 
-/*! Create new xml node given a name and parent. Free with xml_free().
+/*! Create new xml node given a name and parent, from arena or heap
  *
+ * @param[in]  xa        XML arena, or NULL for heap
  * @param[in]  name      Name of XML node
  * @param[in]  xp        The parent where the new xml node will be appended
  * @param[in]  type      XML type
  * @retval     xml       Created xml object if successful. Free with xml_free()
  * @retval     NULL      Error and clixon_err() called
- * @code
- *   cxobj *x;
- *   if ((x = xml_new(name, xparent, CX_ELMNT)) == NULL)
- *     err;
- *   ...
- *   xml_free(x);
- * @endcode
- * @note Differentiates between body/attribute vs element to reduce mem allocation
- * @see xml_insert
  */
-cxobj *
-xml_new(char           *name,
-        cxobj          *xp,
-        enum cxobj_type type)
+static cxobj *
+xml_new_alloc(struct xml_arena *xa,
+              char             *name,
+              cxobj            *xp,
+              enum cxobj_type   type)
 {
     struct xml *x = NULL;
     size_t      sz;
@@ -1180,11 +1959,8 @@ xml_new(char           *name,
         return NULL;
         break;
     }
-    if ((x = malloc(sz)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    if ((x = xml_node_alloc(xa, type, sz)) == NULL)
         return NULL;
-    }
-    memset(x, 0, sz);
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
         return NULL;
@@ -1198,6 +1974,102 @@ xml_new(char           *name,
     return x;
 }
 
+/*! Create new xml node given a name and parent. Free with xml_free().
+ *
+ * @param[in]  name      Name of XML node
+ * @param[in]  xp        The parent where the new xml node will be appended
+ * @param[in]  type      XML type
+ * @retval     xml       Created xml object if successful. Free with xml_free()
+ * @retval     NULL      Error and clixon_err() called
+ * @code
+ *   cxobj *x;
+ *   if ((x = xml_new(name, xparent, CX_ELMNT)) == NULL)
+ *     err;
+ *   ...
+ *   xml_free(x);
+ * @endcode
+ * @note Differentiates between body/attribute vs element to reduce mem allocation
+ * @note If parent is allocated from an arena, so is the new node, unless the top node of
+ *       the arena is freed
+ * @see xml_insert
+ * @see xml_new_arena
+ */
+cxobj *
+xml_new(char           *name,
+        cxobj          *xp,
+        enum cxobj_type type)
+{
+    return xml_new_alloc(xml_arena_open(xp), name, xp, type);
+}
+
+/*! Create new top xml node allocated from a new arena. Free with xml_free().
+ *
+ * All nodes created under the node with xml_new, eg by the parsers or xml_copy, are
+ * allocated from the same arena. This avoids one malloc and free per node.
+ * Freeing the top node releases the arena at once, unless nodes of the tree have been moved
+ * to other trees, or nodes of other trees moved into it. Then the memory of the arena is
+ * released when its last node is freed.
+ * Use for temporary trees, such as RPC requests and replies, not for long-lived trees
+ * since memory of freed nodes is only reused within the arena.
+ * While more than XML_ARENA_PINNED_MAX bytes of memory is kept by nodes of arenas whose
+ * top node is freed, the node is allocated from the heap instead.
+ * @param[in]  name      Name of XML node
+ * @param[in]  type      XML type
+ * @retval     xml       Created xml object if successful. Free with xml_free()
+ * @retval     NULL      Error and clixon_err() called
+ * @code
+ *   cxobj *xt;
+ *   if ((xt = xml_new_arena(XML_TOP_SYMBOL, CX_ELMNT)) == NULL)
+ *     err;
+ *   if (clixon_xml_parse_string(str, YB_NONE, NULL, &xt, NULL) < 0)
+ *     err;
+ *   ...
+ *   xml_free(xt);
+ * @endcode
+ */
+cxobj *
+xml_new_arena(char           *name,
+              enum cxobj_type type)
+{
+    struct xml_arena *xa;
+    cxobj            *x;
+
+    if (_xml_arena_pinned > XML_ARENA_PINNED_MAX)
+        return xml_new(name, NULL, type);
+    if ((xa = malloc(sizeof(*xa))) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        return NULL;
+    }
+    memset(xa, 0, sizeof(*xa));
+    _xml_arena_nr++;
+    if ((x = xml_new_alloc(xa, name, NULL, type)) == NULL){
+        if (xa->xa_nr == 0)
+            xml_arena_release(xa);
+        return NULL;
+    }
+    xa->xa_top = x;
+    xa->xa_out--; /* Top is in its own tree */
+    return x;
+}
+
+/*! Get statistics of XML arenas
+ *
+ * @param[out]  nr      Number of arenas
+ * @param[out]  pinned  Memory in bytes of arenas whose top node is freed
+ * @retval      0       OK
+ * @see xml_new_arena
+ */
+int
+xml_arena_stats(uint64_t *nr,
+                size_t   *pinned)
+{
+    if (nr)
+        *nr = _xml_arena_nr;
+    if (pinned)
+        *pinned = _xml_arena_pinned;
+    return 0;
+}
+
 /*! Create a new XML node and set it's body to a value
  *
  * @param[in]   name    The name of the new node
@@ -1250,8 +2122,50 @@ int
 xml_spec_set(cxobj     *x,
              yang_stmt *spec)
 {
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xe = NULL;
+#endif
+#ifdef XML_HASH_INDEX
+    cxobj *xhe = NULL;
+#endif
+
     if (!is_element(x))
         return 0;
+    if (x->x_spec != spec){
+#ifdef XML_HASH_INDEX
+        /* Remove from hash index given old spec, re-add given new. The hash key of the
+         * list entry of x also changes if x is a key, since the typed value changes */
+        if (x->x_up){
+            if (xml_hash_index_pre(x->x_up, x, &xhe) < 0)
+                return -1;
+            if (xml_hash_entry_update(x->x_up, x, 0) < 0)
+                return -1;
+        }
+#endif
+        xml_cv_clear(x); /* Typed value depends on yang type */
+#ifdef XML_EXPLICIT_INDEX
+        /* Remove from search indexes given old spec, re-add given new */
+        if (xml_search_entry_update(x->x_up, x, 0) < 0)
+            return -1;
+        if (xml_search_index_pre(x->x_up, x, &xe) < 0)
+            return -1;
+        x->x_spec = spec;
+        if (xe == NULL &&
+            xml_search_index_pre(x->x_up, x, &xe) < 0)
+            return -1;
+        if (xml_search_index_post(xe) < 0)
+            return -1;
+        if (xml_search_entry_update(x->x_up, x, 1) < 0)
+            return -1;
+#endif
+#ifdef XML_HASH_INDEX
+        x->x_spec = spec;
+        if (xml_hash_entry_update(x->x_up, x, 1) < 0)
+            return -1;
+        if (xml_hash_index_post(xhe) < 0)
+            return -1;
+#endif
+    }
     x->x_spec = spec;
     return 0;
 }
@@ -1262,7 +2176,7 @@ xml_spec_set(cxobj     *x,
  * @retval     cv   CLIgen variable containing value of x body
  * @retval     NULL
  * Only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Only accessed by xml_cv_cache as part of sorting in xml_cmp
+ * Set by xml_cv_cache when bound or compared, and cleared when the body or yang spec changes
  * @see xml_cv_cache
  */
 cg_var *
@@ -1276,10 +2190,10 @@ xml_cv(cxobj *x)
 /*! Set (cached) cligen variable value of xml node
  *
  * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[in]  cv  CLIgen variable containing value of x body
+ * @param[in]  cv  CLIgen variable containing value of x body, consumed if OK
  * @retval     0   OK
+ * @retval    -1   Error
  * Only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Only accessed by xml_cv_cache as part of sorting in xml_cmp
  * @see xml_cv_cache
  */
 int
@@ -1290,6 +2204,9 @@ xml_cv_set(cxobj  *x,
         return 0;
     if (x->x_cv)
         cv_free(x->x_cv);
+    x->x_cv = NULL;
+    if (cv && xml_arena_hold(x) < 0)
+        return -1;
     x->x_cv = cv;
     return 0;
 }
@@ -1322,8 +2239,11 @@ xml_find(cxobj *xp,
     }
     if (!is_element(xp))
         return NULL;
+    /* Names are interned: if name is not interned, no node has it */
+    if ((name = clixon_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xp, x, -1)) != NULL)
-        if (strcmp(name, xml_name(x)) == 0)
+        if (xml_name(x) == name)
             break; /* x is set */
     return x;
 }
@@ -1381,10 +2301,6 @@ xml_addsub(cxobj *xp,
         }
         /* clear namespace context cache of child */
         nscache_clear(xc);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xc))
-            xml_search_child_insert(xp, xc);
-#endif
     }
     retval = 0;
  done:
@@ -1497,6 +2413,12 @@ xml_child_rm(cxobj *xp,
 {
     int    retval = -1;
     cxobj *xc = NULL;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xe = NULL;
+#endif
+#ifdef XML_HASH_INDEX
+    cxobj *xhe = NULL;
+#endif
 
     if (!is_element(xp))
         return 0;
@@ -1504,17 +2426,31 @@ xml_child_rm(cxobj *xp,
         clixon_err(OE_XML, 0, "Child not found");
         goto done;
     }
+#ifdef XML_HASH_INDEX
+    if (xml_hash_entry_update(xp, xc, 0) < 0)
+        goto done;
+    if (xml_hash_index_pre(xp, xc, &xhe) < 0)
+        goto done;
+#endif
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_entry_update(xp, xc, 0) < 0)
+        goto done;
+    if (xml_search_index_pre(xp, xc, &xe) < 0)
+        goto done;
+#endif
     xml_parent_set(xc, NULL);
+    xml_cv_clear(xp);
     xp->x_childvec[i] = NULL;
     xp->x_childvec_len--;
     if (i<xp->x_childvec_len)
         memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
 #ifdef XML_EXPLICIT_INDEX
-    if (xml_type(xc) == CX_ELMNT){
-        if (xml_search_index_p(xc))
-            xml_search_child_rm(xp, xc);
-
-    }
+    if (xml_search_index_post(xe) < 0)
+        goto done;
+#endif
+#ifdef XML_HASH_INDEX
+    if (xml_hash_index_post(xhe) < 0)
+        goto done;
 #endif
     retval = 0;
  done:
@@ -1630,6 +2566,7 @@ xml_rootchild(cxobj  *xp,
     }
     if (xml_child_rm(xp, i) < 0)
         goto done;
+    xml_arena_top_move(xp, xc);
     if (xml_free(xp) < 0)
         goto done;
     *xcp = xc;
@@ -1672,6 +2609,7 @@ xml_rootchild_node(cxobj  *xp,
     }
     if (xml_child_rm(xp, i) < 0)
         goto done;
+    xml_arena_top_move(xp, xc);
     if (xml_free(xp) < 0)
         goto done;
     retval = 0;
@@ -1827,19 +2765,20 @@ xml_find_type(cxobj          *xt,
               enum cxobj_type type)
 {
     cxobj *x = NULL;
-    int    pmatch;  /* prefix match */
-    char  *xprefix; /* xprefix */
+    char  *iprefix = NULL;
+    char  *iname = NULL;
 
     if (!is_element(xt))
         return NULL;
+    /* Names and prefixes are interned, compare pointers */
+    if (prefix && (iprefix = clixon_intern_find(prefix)) == NULL)
+        return NULL;
+    if (name && (iname = clixon_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, type)) != NULL) {
-        if (prefix){
-            xprefix = xml_prefix(x);
-            pmatch = xprefix ? strcmp(prefix,xprefix)==0 : 0;
-        }
-        else
-            pmatch = 1;
-        if (pmatch && (name==NULL || strcmp(name, xml_name(x)) == 0))
+        if (iprefix && xml_prefix(x) != iprefix)
+            continue;
+        if (iname == NULL || xml_name(x) == iname)
             return x;
     }
     return NULL;
@@ -1868,8 +2807,10 @@ xml_find_value(cxobj      *xt,
 
     if (!is_element(xt))
         return NULL;
+    if ((name = clixon_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, -1)) != NULL)
-        if (strcmp(name, xml_name(x)) == 0)
+        if (xml_name(x) == name)
             return xml_value(x);
     return NULL;
 }
@@ -1894,8 +2835,10 @@ xml_find_body(cxobj      *xt,
 
     if (!is_element(xt))
         return NULL;
+    if ((name = clixon_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, -1)) != NULL)
-        if (strcmp(name, xml_name(x)) == 0)
+        if (xml_name(x) == name)
             return xml_body(x);
     return NULL;
 }
@@ -1924,8 +2867,10 @@ xml_find_body_obj(cxobj      *xt,
 
     if (!is_element(xt))
         return NULL;
+    if ((name = clixon_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if (strcmp(name, xml_name(x)))
+        if (xml_name(x) != name)
             continue;
         if ((bstr = xml_body(x)) == NULL)
             continue;
@@ -1935,8 +2880,45 @@ xml_find_body_obj(cxobj      *xt,
     return x;
 }
 
+/*! Free memory of XML node outside of its node, child vector and arena
+ *
+ * @param[in]  x  XML node, pointers are cleared
+ */
+static void
+xml_node_release(cxobj *x)
+{
+    switch (xml_type(x)){
+    case CX_ELMNT:
+        if (x->x_flags & XML_FLAG_LRU)
+            xml_lru_rm(x);
+        if (x->x_cv){
+            cv_free(x->x_cv);
+            x->x_cv = NULL;
+        }
+        if (x->x_ns_cache){
+            xml_nsctx_free(x->x_ns_cache);
+            x->x_ns_cache = NULL;
+        }
+#ifdef XML_EXPLICIT_INDEX
+        xml_search_index_free(x);
+#endif
+#ifdef XML_HASH_INDEX
+        xml_hash_index_free(x);
+#endif
+        break;
+    case CX_BODY:
+    case CX_ATTR:
+        xml_value_free((struct xmlbody*)x);
+        break;
+    default:
+        break;
+    }
+}
+
 /*! Free an xl sub-tree recursively, but do not remove it from parent
  *
+ * If x is the top node of an arena, and the tree is all the nodes of the arena, the arena
+ * is released at once, see xml_new_arena
  * @param[in]  x  the xml tree to be freed.
  * @see xml_purge where x is also removed from parent
  */
@@ -1949,37 +2931,30 @@ xml_free(cxobj *x)
     if (x == NULL){
         return 0;
     }
-    if (x->x_name)
-        free(x->x_name);
-    if (x->x_prefix)
-        free(x->x_prefix);
-    switch (xml_type(x)){
-    case CX_ELMNT:
+    if (x->x_arena && xml_arena_free(x) == 1)
+        return 0;
+    if (!x->x_arena){ /* Names of arena nodes are kept by the arena */
+        if (x->x_name)
+            clixon_intern_free(x->x_name);
+        if (x->x_prefix)
+            clixon_intern_free(x->x_prefix);
+    }
+    xml_node_release(x);
+    if (xml_type(x) == CX_ELMNT){
         for (i=0; i<x->x_childvec_len; i++){
             if ((xc = x->x_childvec[i]) != NULL){
                 xml_free(xc);
                 x->x_childvec[i] = NULL;
             }
         }
-        if (x->x_childvec)
+        if (x->x_childvec && !(x->x_arena & XML_ARENA_VEC))
             free(x->x_childvec);
-        if (x->x_cv)
-            cv_free(x->x_cv);
-        if (x->x_ns_cache)
-            xml_nsctx_free(x->x_ns_cache);
-#ifdef XML_EXPLICIT_INDEX
-        xml_search_index_free(x);
-#endif
-        break;
-    case CX_BODY:
-    case CX_ATTR:
-        if (x->x_value_cb)
-            cbuf_free(x->x_value_cb);
-        break;
-    default:
-        break;
+        x->x_childvec = NULL;
+        x->x_childvec_len = 0;
     }
-    free(x);
+    if (x->x_arena || (x->x_up && x->x_up->x_arena))
+        xml_arena_link(x, x->x_up, -1);
+    xml_node_free(x);
     _stats_xml_nr--;
     return 0;
 }
@@ -2024,7 +2999,7 @@ xml_copy_one(cxobj *x0,
     default:
         break;
     }
-    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY)); /* Maybe more flags */
+    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY | XML_FLAG_MULTI)); /* Maybe more flags */
     retval = 0;
  done:
     return retval;
@@ -2049,12 +3024,15 @@ int
 xml_copy(cxobj *x0,
          cxobj *x1)
 {
-    int    retval = -1;
-    cxobj *x;
-    cxobj *xcopy;
+    int     retval = -1;
+    cxobj  *x;
+    cxobj  *xcopy;
+    int     empty;
+    cg_var *cv;
 
     if (xml_copy_one(x0, x1) <0)
         goto done;
+    empty = xml_child_nr(x1) == 0;
     x = NULL;
     while ((x = xml_child_each(x0, x, -1)) != NULL) {
         if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
@@ -2062,6 +3040,17 @@ xml_copy(cxobj *x0,
         if (xml_copy(x, xcopy) < 0) /* recursion */
             goto done;
     }
+    /* Copy typed value, cleared when body was copied */
+    if (empty && xml_cv(x0) != NULL){
+        if ((cv = cv_dup(xml_cv(x0))) == NULL){
+            clixon_err(OE_XML, errno, "cv_dup");
+            goto done;
+        }
+        if (xml_cv_set(x1, cv) < 0){
+            cv_free(cv);
+            goto done;
+        }
+    }
     retval = 0;
   done:
     return retval;
@@ -2308,24 +3297,270 @@ xml_apply_ancestor(cxobj        *xn,
     return retval;
 }
 
-/*! Is xpp ancestor of x?
+/*! Side table bucket of XML node
  *
- * @param[in]   x       XML node
- * @param[in]   xpp     Potential ancestor of x in XML tree
- * @retval      1       Yes, xpp is ancestor of x
- * @retval      0       No, xpp is not ancestor of x
+ * @param[in]  x    XML node
+ * @param[in]  size Number of buckets, power of 2
  */
-int
-xml_isancestor(cxobj *x,
-               cxobj *xpp)
+static inline size_t
+xml_lru_bucket(cxobj *x,
+               size_t size)
 {
-    cxobj     *xp = NULL;
-    cxobj     *xn = NULL;
+    uint64_t h = (uint64_t)(uintptr_t)x;
 
-    xn = x;
-    while ((xp = xml_parent(xn)) != NULL) {
-        if (xp == xpp)
-            return 1;
+    h = (h >> 4) * 0x9e3779b97f4a7c15ULL;
+    return (size_t)(h >> 32) & (size - 1);
+}
+
+/*! Get LRU list head or link of XML node from side table
+ *
+ * @param[in]  x    XML element
+ * @retval     xl   LRU list head or link
+ * @retval     NULL Node is not in a list
+ */
+static struct xml_lru *
+xml_lru_get(cxobj *x)
+{
+    struct xml_lru *xl;
+
+    if (xml_type(x) != CX_ELMNT || (x->x_flags & XML_FLAG_LRU) == 0 ||
+        _xml_lru_vec == NULL)
+        return NULL;
+    for (xl = _xml_lru_vec[xml_lru_bucket(x, _xml_lru_size)]; xl; xl = xl->xl_next)
+        if (xl->xl_node == x)
+            return xl;
+    return NULL;
+}
+
+/*! Add LRU list head or link of XML node to side table
+ *
+ * @param[in]  x    XML element, not in table
+ * @param[in]  xl   LRU list head or link
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_lru_put(cxobj          *x,
+            struct xml_lru *xl)
+{
+    struct xml_lru **vec;
+    struct xml_lru  *xn;
+    size_t           size;
+    size_t           i;
+    size_t           b;
+
+    if (xml_arena_hold(x) < 0)
+        return -1;
+    if (_xml_lru_nr >= _xml_lru_size){
+        size = _xml_lru_size ? 2 * _xml_lru_size : 64;
+        if ((vec = calloc(size, sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return -1;
+        }
+        for (i=0; i<_xml_lru_size; i++)
+            while ((xn = _xml_lru_vec[i]) != NULL){
+                _xml_lru_vec[i] = xn->xl_next;
+                b = xml_lru_bucket(xn->xl_node, size);
+                xn->xl_next = vec[b];
+                vec[b] = xn;
+            }
+        if (_xml_lru_vec)
+            free(_xml_lru_vec);
+        _xml_lru_vec = vec;
+        _xml_lru_size = size;
+    }
+    b = xml_lru_bucket(x, _xml_lru_size);
+    xl->xl_node = x;
+    xl->xl_next = _xml_lru_vec[b];
+    _xml_lru_vec[b] = xl;
+    _xml_lru_nr++;
+    x->x_flags |= XML_FLAG_LRU;
+    return 0;
+}
+
+/*! Remove LRU list head or link of XML node from side table
+ *
+ * The table is freed when it is empty
+ * @param[in]  xl   LRU list head or link in table
+ */
+static void
+xml_lru_del(struct xml_lru *xl)
+{
+    struct xml_lru **xlp;
+
+    xlp = &_xml_lru_vec[xml_lru_bucket(xl->xl_node, _xml_lru_size)];
+    while (*xlp != xl)
+        xlp = &(*xlp)->xl_next;
+    *xlp = xl->xl_next;
+    xl->xl_node->x_flags &= ~XML_FLAG_LRU;
+    if (--_xml_lru_nr == 0){
+        free(_xml_lru_vec);
+        _xml_lru_vec = NULL;
+        _xml_lru_size = 0;
+    }
+}
+
+/*! Mark XML node as most recently used in the LRU list of its tree
+ *
+ * The list is kept by the top node of the tree. The node is added to the list if it is
+ * not already in it, otherwise moved first.
+ * @param[in]  xt   Top node of tree, keeps the list
+ * @param[in]  x    XML element in tree, not xt
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_lru_last  to get least recently used node
+ */
+int
+xml_lru_touch(cxobj *xt,
+              cxobj *x)
+{
+    struct xml_lru *head;
+    struct xml_lru *xl;
+
+    if (xml_type(xt) != CX_ELMNT || xml_type(x) != CX_ELMNT || x == xt){
+        clixon_err(OE_XML, EINVAL, "Invalid LRU node");
+        return -1;
+    }
+    if ((head = xml_lru_get(xt)) != NULL && head->xl_x != NULL){
+        clixon_err(OE_XML, EINVAL, "LRU top node is in another list");
+        return -1;
+    }
+    if ((xl = xml_lru_get(x)) != NULL && xl->xl_x == NULL){
+        clixon_err(OE_XML, EINVAL, "LRU node is top of another list");
+        return -1;
+    }
+    if (head == NULL){
+        if ((head = malloc(sizeof(*head))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            return -1;
+        }
+        memset(head, 0, sizeof(*head));
+        if (xml_lru_put(xt, head) < 0){
+            free(head);
+            return -1;
+        }
+    }
+    if (xl == NULL){
+        if ((xl = malloc(sizeof(*xl))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            return -1;
+        }
+        memset(xl, 0, sizeof(*xl));
+        xl->xl_x = x;
+        if (xml_lru_put(x, xl) < 0){
+            free(xl);
+            return -1;
+        }
+    }
+    else if (xl == head->xl_first)
+        return 0;
+    else {
+        DELQ(xl, xl->xl_head->xl_first, struct xml_lru *);
+        xl->xl_head->xl_len--;
+    }
+    xl->xl_head = head;
+    INSQ(xl, head->xl_first);
+    head->xl_len++;
+    return 0;
+}
+
+/*! Remove XML node from LRU list, or if top node, remove all nodes from its list
+ *
+ * @param[in]  x    XML element
+ * @retval     0    OK
+ * @see xml_lru_touch
+ */
+int
+xml_lru_rm(cxobj *x)
+{
+    struct xml_lru *xl;
+    struct xml_lru *xm;
+
+    if ((xl = xml_lru_get(x)) == NULL)
+        return 0;
+    if (xl->xl_x == NULL){ /* head */
+        while ((xm = xl->xl_first) != NULL){
+            DELQ(xm, xl->xl_first, struct xml_lru *);
+            xml_lru_del(xm);
+            free(xm);
+        }
+    }
+    else {
+        DELQ(xl, xl->xl_head->xl_first, struct xml_lru *);
+        xl->xl_head->xl_len--;
+    }
+    xml_lru_del(xl);
+    free(xl);
+    return 0;
+}
+
+/*! Get number of nodes in LRU list of tree
+ *
+ * @param[in]  xt   Top node of tree
+ * @retval     len  Number of nodes in list
+ */
+int
+xml_lru_len(cxobj *xt)
+{
+    struct xml_lru *head;
+
+    if ((head = xml_lru_get(xt)) == NULL || head->xl_x != NULL)
+        return 0;
+    return head->xl_len;
+}
+
+/*! Get least recently used node in LRU list of tree
+ *
+ * @param[in]  xt   Top node of tree
+ * @retval     x    Least recently used node
+ * @retval     NULL List is empty
+ */
+cxobj *
+xml_lru_last(cxobj *xt)
+{
+    struct xml_lru *head;
+
+    if ((head = xml_lru_get(xt)) == NULL || head->xl_x != NULL ||
+        head->xl_first == NULL)
+        return NULL;
+    return PREVQ(struct xml_lru *, head->xl_first)->xl_x;
+}
+
+/*! Get next more recently used node in LRU list
+ *
+ * @param[in]  x    XML node in LRU list
+ * @retval     xp   Next more recently used node
+ * @retval     NULL x is most recently used, or not in a list
+ */
+cxobj *
+xml_lru_prev(cxobj *x)
+{
+    struct xml_lru *xl;
+
+    if ((xl = xml_lru_get(x)) == NULL || xl->xl_x == NULL ||
+        xl == xl->xl_head->xl_first)
+        return NULL;
+    return PREVQ(struct xml_lru *, xl)->xl_x;
+}
+
+/*! Is xpp ancestor of x?
+ *
+ * @param[in]   x       XML node
+ * @param[in]   xpp     Potential ancestor of x in XML tree
+ * @retval      1       Yes, xpp is ancestor of x
+ * @retval      0       No, xpp is not ancestor of x
+ */
+int
+xml_isancestor(cxobj *x,
+               cxobj *xpp)
+{
+    cxobj     *xp = NULL;
+    cxobj     *xn = NULL;
+
+    xn = x;
+    while ((xp = xml_parent(xn)) != NULL) {
+        if (xp == xpp)
+            return 1;
         xn = xp;
     }
     return 0;
@@ -2486,10 +3721,52 @@ xml_add_attr(cxobj *xn,
 }
 
 #ifdef XML_EXPLICIT_INDEX
+/*! Get list entry whose search indexes depend on a child
+ *
+ * The child is an element on the data path of a search index below the entry, or the body
+ * of a search index leaf. The entry must have a parent where the index vectors are placed.
+ * @param[in] xp  XML node, list entry or node below list entry
+ * @param[in] xc  Child of xp
+ * @retval    xe  List entry
+ * @retval    NULL  Child is not part of a search index
+ * @see yang_search_index_path  which marks the yang data path
+ */
+static cxobj *
+xml_search_index_entry(cxobj *xp,
+                       cxobj *xc)
+{
+    yang_stmt *y;
+
+    switch (xml_type(xc)){
+    case CX_ELMNT:
+        if ((y = xml_spec(xc)) == NULL ||
+            yang_flag_get(y, YANG_FLAG_INDEX) == 0 ||
+            yang_keyword_get(y) == Y_LIST)
+            return NULL;
+        break;
+    case CX_BODY:
+        if ((y = xml_spec(xp)) == NULL ||
+            yang_flag_get(y, YANG_FLAG_INDEX) == 0 ||
+            yang_keyword_get(y) != Y_LEAF)
+            return NULL;
+        break;
+    default:
+        return NULL;
+    }
+    for (; xp != NULL; xp = xml_parent(xp)){
+        if ((y = xml_spec(xp)) == NULL ||
+            yang_flag_get(y, YANG_FLAG_INDEX) == 0)
+            break;
+        if (yang_keyword_get(y) == Y_LIST)
+            return xml_parent(xp) ? xp : NULL;
+    }
+    return NULL;
+}
+
 /*! Is this XML object a search index, ie it is registered as a yang clixon cc:search_index
  *
- * Is this xml node a search index and does it have a parent that is a list and a grandparent 
- * where a search-vector can be placed
+ * Is this xml node a search index and does it have an ancestor that is a list entry and 
+ * the entry a parent where a search-vector can be placed
  * @param[in] x  XML object
  * @retval    1  Yes
  * @retval    0  No
@@ -2498,25 +3775,43 @@ int
 xml_search_index_p(cxobj *x)
 {
     yang_stmt *y;
-    cxobj     *xp;
 
     /* The index variable has a yang spec */
     if ((y = xml_spec(x)) == NULL)
         return 0;
     /* The index variable is a registered search index */
-    if (yang_flag_get(y, YANG_FLAG_INDEX) == 0)
+    if (yang_flag_get(y, YANG_FLAG_INDEX) == 0 ||
+        yang_keyword_get(y) != Y_LEAF)
         return 0;
-    /* The index variable has a parent which has a LIST yang spec  */
-    if ((xp = xml_parent(x)) == NULL)
-        return 0;
-    if ((y = xml_spec(xp)) == NULL)
-        return 0;
-    if (yang_keyword_get(y) != Y_LIST)
-        return 0;
-    /* The index variable has a grand-parent */
-    if (xml_parent(xp) == NULL)
-        return 0;
-    return 1;
+    return xml_search_index_entry(xml_parent(x), x) != NULL;
+}
+
+/*! Get search index variable of list entry given path
+ *
+ * @param[in] xe        XML list entry
+ * @param[in] indexvar  Name or path of index variable relative to list entry, eg "x/i"
+ * @retval    x         Index variable
+ * @retval    NULL      Not found
+ */
+cxobj *
+xml_search_index_leaf(cxobj *xe,
+                      char  *indexvar)
+{
+    cxobj  *x = xe;
+    char   *p;
+    char    name[64];
+    size_t  len;
+
+    while ((p = strchr(indexvar, '/')) != NULL){
+        if ((len = p - indexvar) >= sizeof(name))
+            return NULL;
+        memcpy(name, indexvar, len);
+        name[len] = '\0';
+        if ((x = xml_find_type(x, NULL, name, CX_ELMNT)) == NULL)
+            return NULL;
+        indexvar = p + 1;
+    }
+    return xml_find_type(x, NULL, indexvar, CX_ELMNT);
 }
 
 /*! Free all search vector pairs of this XML node
@@ -2554,6 +3849,8 @@ xml_search_index_add(cxobj *x,
 {
     struct search_index *si = NULL;
 
+    if (xml_arena_hold(x) < 0)
+        goto done;
     if ((si = malloc(sizeof(struct search_index))) == NULL){
         clixon_err(OE_XML, errno, "malloc");
         goto done;
@@ -2631,50 +3928,229 @@ xml_search_vector_get(cxobj        *xp,
     return 0;
 }
 
-/*! Insert a new cxobj into search index vector for list for variable "name"
+/*! Find position of list entry in search index vector
  *
- * @param[in] xp  XML parent object (the list element)
- * @param[in] xi  XML index object (that should be added)
- * @retval    0   OK
- * @retval   -1   Error
+ * @param[in]  si    Search index
+ * @param[in]  xe    XML list entry
+ * @param[out] pos   Position of xe if found, otherwise where to insert it
+ * @retval     1     Found
+ * @retval     0     Not found
+ * @retval    -1     Error
  */
-int
-xml_search_child_insert(cxobj *xp,
-                        cxobj *xi)
+static int
+xml_search_index_pos(struct search_index *si,
+                     cxobj               *xe,
+                     int                 *pos)
+{
+    int    i;
+    int    j;
+    int    len;
+    int    eq = 0;
+    cxobj *x;
+
+    len = clixon_xvec_len(si->si_xvec);
+    if ((i = xml_search_indexvar_binary_pos(xe, si->si_name, si->si_xvec, 0, len, len, &eq)) < 0)
+        return -1;
+    *pos = i;
+    if (eq == 0)
+        return 0;
+    /* Several entries may have same index value */
+    for (j=i; j>=0; j--){
+        if ((x = clixon_xvec_i(si->si_xvec, j)) == xe){
+            *pos = j;
+            return 1;
+        }
+        if (xml_cmp(xe, x, 0, 0, si->si_name) != 0)
+            break;
+    }
+    for (j=i+1; j<len; j++){
+        if ((x = clixon_xvec_i(si->si_xvec, j)) == xe){
+            *pos = j;
+            return 1;
+        }
+        if (xml_cmp(xe, x, 0, 0, si->si_name) != 0)
+            break;
+    }
+    return 0;
+}
+
+/*! Add or remove list entry in search index vectors of parent, one for each index variable
+ *
+ * Only index variables that exist and are bound to yang are indexed.
+ * @param[in]  xp   XML parent of list entry
+ * @param[in]  xe   XML list entry
+ * @param[in]  y    Yang of list, or of container, choice or case in list
+ * @param[in]  cb   Path of y relative to list entry
+ * @param[in]  add  1: add entry to index vectors, 0: remove entry from index vectors
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_search_entry_index(cxobj     *xp,
+                       cxobj     *xe,
+                       yang_stmt *y,
+                       cbuf      *cb,
+                       int        add)
 {
     int                  retval = -1;
-    char                *indexvar;
+    yang_stmt           *yc;
+    int                  inext = 0;
+    size_t               len;
     struct search_index *si;
-    cxobj               *xpp;
-    int                  i;
-    int                  len;
+    cxobj               *xi;
+    int                  pos;
+    int                  ret;
 
-    indexvar = xml_name(xi);
-    if ((xpp = xml_parent(xp)) == NULL)
-        goto ok;
-    /* Find base vector in grandparent */
-    if ((si = xml_search_index_get(xpp, indexvar)) == NULL){
-        /* If not found add base vector in grand-parent */
-        if ((si = xml_search_index_add(xpp, indexvar)) == NULL)
-            goto done;
+    len = cbuf_len(cb);
+    while ((yc = yn_iter(y, &inext)) != NULL){
+        if (yang_flag_get(yc, YANG_FLAG_INDEX) == 0)
+            continue;
+        switch (yang_keyword_get(yc)){
+        case Y_LEAF:
+            cprintf(cb, "%s", yang_argument_get(yc));
+            if ((xi = xml_search_index_leaf(xe, cbuf_get(cb))) == NULL ||
+                xml_spec(xi) == NULL)
+                break;
+            if ((si = xml_search_index_get(xp, cbuf_get(cb))) == NULL){
+                if (!add)
+                    break;
+                if ((si = xml_search_index_add(xp, cbuf_get(cb))) == NULL)
+                    goto done;
+            }
+            if ((ret = xml_search_index_pos(si, xe, &pos)) < 0)
+                goto done;
+            if (add && ret == 0){
+                if (clixon_xvec_insert_pos(si->si_xvec, xe, pos) < 0)
+                    goto done;
+            }
+            else if (!add && ret == 1){
+                if (clixon_xvec_rm_pos(si->si_xvec, pos) < 0)
+                    goto done;
+            }
+            break;
+        case Y_CONTAINER:
+            cprintf(cb, "%s/", yang_argument_get(yc));
+            if (xml_search_entry_index(xp, xe, yc, cb, add) < 0)
+                goto done;
+            break;
+        case Y_CHOICE:
+        case Y_CASE:
+            if (xml_search_entry_index(xp, xe, yc, cb, add) < 0)
+                goto done;
+            break;
+        default:
+            break;
+        }
+        cbuf_trunc(cb, len);
     }
-    /* Find element position using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add or remove list entry in all search index vectors of parent
+ *
+ * @param[in]  xp   XML parent of list entry
+ * @param[in]  xe   XML list entry, if not a list with search indexes, nothing is done
+ * @param[in]  add  1: add entry to index vectors, 0: remove entry from index vectors
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_search_entry_update(cxobj *xp,
+                        cxobj *xe,
+                        int    add)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cbuf      *cb = NULL;
+
+    if (xp == NULL ||
+        xml_type(xe) != CX_ELMNT ||
+        (y = xml_spec(xe)) == NULL ||
+        yang_flag_get(y, YANG_FLAG_INDEX) == 0 ||
+        yang_keyword_get(y) != Y_LIST)
+        goto ok;
+    if (!add && xp->x_search_index == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
-    assert(clixon_xvec_i(si->si_xvec, i) != xp);
-    if (clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
+    }
+    if (xml_search_entry_index(xp, xe, y, cb, add) < 0)
         goto done;
  ok:
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
-/*! Remove a single cxobj from search vector 
+/*! Remove list entry from its search indexes before a change affecting an index variable
+ *
+ * The change is that xc is added to or removed from xp, or that xc is a body of xp which
+ * is changed. After the change, call xml_search_index_post to add the entry again.
+ * @param[in]  xp   XML node
+ * @param[in]  xc   Child of xp
+ * @param[out] xep  List entry removed from its search indexes, or NULL if none
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_search_index_pre(cxobj  *xp,
+                     cxobj  *xc,
+                     cxobj **xep)
+{
+    cxobj *xe;
+
+    *xep = NULL;
+    if ((xe = xml_search_index_entry(xp, xc)) == NULL)
+        return 0;
+    if (xml_search_entry_update(xml_parent(xe), xe, 0) < 0)
+        return -1;
+    *xep = xe;
+    return 0;
+}
+
+/*! Add list entry to its search indexes after a change affecting an index variable
  *
- * @param[in] xp    XML parent object (the list element)
- * @param[in] xi    XML index object (that should be added)
+ * @param[in]  xe   XML list entry from xml_search_index_pre, or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_search_index_post(cxobj *xe)
+{
+    if (xe == NULL)
+        return 0;
+    return xml_search_entry_update(xml_parent(xe), xe, 1);
+}
+
+/*! Insert list entry of index variable into search index vectors
+ *
+ * Search indexes are maintained when XML nodes are added, removed or changed, this is only
+ * necessary if an index variable was changed in some other way
+ * @param[in] xp  XML parent object of index variable
+ * @param[in] xi  XML index variable
+ * @retval    0   OK
+ * @retval   -1   Error
+ */
+int
+xml_search_child_insert(cxobj *xp,
+                        cxobj *xi)
+{
+    cxobj *xe;
+
+    if ((xe = xml_search_index_entry(xp, xi)) == NULL)
+        return 0;
+    return xml_search_entry_update(xml_parent(xe), xe, 1);
+}
+
+/*! Remove list entry of index variable from search index vectors
+ *
+ * @param[in] xp    XML parent object of index variable
+ * @param[in] xi    XML index variable
  * @retval    0     OK
  * @retval   -1     Error
  */
@@ -2682,33 +4158,11 @@ int
 xml_search_child_rm(cxobj *xp,
                     cxobj *xi)
 {
-    int                 retval = -1;
-    cxobj              *xpp;
-    char               *indexvar;
-    int                 i;
-    int                 len;
-    struct search_index *si;
-    int                  eq = 0;
-
-    indexvar = xml_name(xi);
-    if ((xpp = xml_parent(xp)) == NULL)
-        goto ok;
-    /* Find base vector in grandparent */
-    if ((si = xml_search_index_get(xpp, indexvar)) == NULL)
-        goto ok;
+    cxobj *xe;
 
-    /* Find element using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
-        goto done;
-        //    if (clixon_xvec_i(si->si_xvec, i) == xp)
-    if (eq)
-        if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
-            goto done;
- ok:
-    retval = 0;
- done:
-    return retval;
+    if ((xe = xml_search_index_entry(xp, xi)) == NULL)
+        return 0;
+    return xml_search_entry_update(xml_parent(xe), xe, 0);
 }
 
 /*! Iterator over xml children objects using (explicit) index variable
@@ -2763,3 +4217,494 @@ xml_child_index_each(cxobj           *xparent,
 }
 
 #endif /* XML_EXPLICIT_INDEX */
+
+#ifdef XML_HASH_INDEX
+/*! Hash list key values of XML list or leaf-list entry
+ *
+ * Values are hashed as typed (cached) values, so that values equal according to xml_cmp
+ * have the same hash
+ * @param[in]  x     XML list or leaf-list entry
+ * @param[in]  y     Yang list or leaf-list of x
+ * @param[out] hashp Hash value
+ * @retval     1     OK
+ * @retval     0     Not hashable: missing key, or key value not valid
+ * @retval    -1     Error
+ */
+static int
+xml_hash_key(cxobj     *x,
+             yang_stmt *y,
+             uint32_t  *hashp)
+{
+    int       retval = -1;
+    uint32_t  h = 2166136261u; /* FNV-1a */
+    cg_var   *cvi = NULL;
+    cg_var   *cv;
+    cxobj    *xk;
+    char     *keyname;
+    char      buf[64];
+    char     *str;
+    char     *s;
+    int       len;
+
+    if (yang_keyword_get(y) == Y_LIST &&
+        cvec_len(yang_cvec_get(y)) == 0) /* Keyless, eg state data */
+        goto fail;
+    while (1){
+        if (yang_keyword_get(y) == Y_LEAF_LIST)
+            xk = x;
+        else {
+            if ((cvi = cvec_each(yang_cvec_get(y), cvi)) == NULL)
+                break;
+            /* Names are interned: if key name is not, x does not have the key */
+            if ((keyname = clixon_intern_find(cv_string_get(cvi))) == NULL)
+                goto fail;
+            xk = NULL;
+            while ((xk = xml_child_each(x, xk, CX_ELMNT)) != NULL)
+                if (xml_name(xk) == keyname)
+                    break;
+            if (xk == NULL)
+                goto fail;
+        }
+        if (xml_body(xk) == NULL)
+            goto fail;
+        if ((cv = xml_cv(xk)) == NULL){
+            /* Invalid values are not cached and left for validation */
+            if (xml_cv_cache_bind(xk) < 0)
+                goto done;
+            if ((cv = xml_cv(xk)) == NULL)
+                goto fail;
+        }
+        str = NULL;
+        switch (cv_type_get(cv)){
+        case CGV_STRING:
+        case CGV_REST:
+            s = cv_string_get(cv);
+            break;
+        default:
+            if ((len = cv2str(cv, buf, sizeof(buf))) < 0)
+                goto fail;
+            if ((size_t)len < sizeof(buf))
+                s = buf;
+            else if ((s = str = cv2str_dup(cv)) == NULL){
+                clixon_err(OE_UNIX, errno, "cv2str_dup");
+                goto done;
+            }
+            break;
+        }
+        for (; s && *s; s++){
+            h ^= (uint8_t)*s;
+            h *= 16777619u;
+        }
+        h ^= 0xff; /* separator between keys */
+        h *= 16777619u;
+        if (str)
+            free(str);
+        if (yang_keyword_get(y) == Y_LEAF_LIST)
+            break;
+    }
+    *hashp = h;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Free hash index
+ *
+ * @param[in]  xp   XML node
+ * @param[in]  xh   Hash index of xp
+ */
+static void
+xml_hash_index_drop(cxobj                 *xp,
+                    struct xml_hash_index *xh)
+{
+    DELQ(xh, xp->x_hash_index, struct xml_hash_index *);
+    if (xh->xh_slots)
+        free(xh->xh_slots);
+    free(xh);
+}
+
+/*! Free all hash indexes of XML node
+ *
+ * @param[in]  xp   XML node
+ */
+static void
+xml_hash_index_free(cxobj *xp)
+{
+    while (xp->x_hash_index != NULL)
+        xml_hash_index_drop(xp, xp->x_hash_index);
+}
+
+/*! Get hash index of yang list or leaf-list of XML node
+ *
+ * @param[in]  xp   XML node
+ * @param[in]  y    Yang list or leaf-list
+ * @retval     xh   Hash index
+ * @retval     NULL Not found
+ */
+static struct xml_hash_index *
+xml_hash_index_get(cxobj     *xp,
+                   yang_stmt *y)
+{
+    struct xml_hash_index *xh;
+
+    if ((xh = xp->x_hash_index) != NULL) {
+        do {
+            if (xh->xh_yang == y)
+                return xh;
+            xh = NEXTQ(struct xml_hash_index *, xh);
+        } while (xh && xh != xp->x_hash_index);
+    }
+    return NULL;
+}
+
+/*! Insert entry in hash index slots, no resize
+ */
+static void
+xml_hash_slot_insert(struct xml_hash_index *xh,
+                     cxobj                 *x,
+                     uint32_t               hash)
+{
+    size_t i;
+
+    i = hash & (xh->xh_size - 1);
+    while (xh->xh_slots[i].xhs_x != NULL)
+        i = (i + 1) & (xh->xh_size - 1);
+    xh->xh_slots[i].xhs_x = x;
+    xh->xh_slots[i].xhs_hash = hash;
+    xh->xh_nr++;
+}
+
+/*! Add entry to hash index, grow if more than half full
+ *
+ * @param[in]  xh   Hash index
+ * @param[in]  x    XML list or leaf-list entry
+ * @retval     1    OK
+ * @retval     0    Entry not hashable
+ * @retval    -1    Error
+ */
+static int
+xml_hash_index_add(struct xml_hash_index *xh,
+                   cxobj                 *x)
+{
+    int                   retval = -1;
+    uint32_t              hash;
+    struct xml_hash_slot *slots;
+    struct xml_hash_slot *old;
+    size_t                size;
+    size_t                i;
+    int                   ret;
+
+    if ((ret = xml_hash_key(x, xh->xh_yang, &hash)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (2*(xh->xh_nr + 1) > xh->xh_size){
+        size = xh->xh_size ? 2*xh->xh_size : XML_HASH_INDEX_MIN*2;
+        if ((slots = calloc(size, sizeof(*slots))) == NULL){
+            clixon_err(OE_XML, errno, "calloc");
+            goto done;
+        }
+        i = xh->xh_size;
+        old = xh->xh_slots;
+        xh->xh_slots = slots;
+        xh->xh_size = size;
+        xh->xh_nr = 0;
+        while (i-- > 0)
+            if (old[i].xhs_x)
+                xml_hash_slot_insert(xh, old[i].xhs_x, old[i].xhs_hash);
+        if (old)
+            free(old);
+    }
+    xml_hash_slot_insert(xh, x, hash);
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Remove entry from hash index
+ *
+ * Uses backward shift deletion of linear probing.
+ * An entry that is not hashable is assumed to be counted as unhashable. The slots are
+ * scanned if there is no such count, or if a hashable entry is not found where expected.
+ * @param[in]  xh   Hash index
+ * @param[in]  x    XML list or leaf-list entry
+ * @retval     1    OK, removed
+ * @retval     0    Not in slots, entry was not hashable
+ * @retval    -1    Error
+ */
+static int
+xml_hash_index_rm(struct xml_hash_index *xh,
+                  cxobj                 *x)
+{
+    uint32_t hash;
+    size_t   mask = xh->xh_size - 1;
+    size_t   i = 0;
+    size_t   j;
+    size_t   k;
+    int      ret;
+
+    if (xh->xh_size == 0)
+        return 0;
+    if ((ret = xml_hash_key(x, xh->xh_yang, &hash)) < 0)
+        return -1;
+    if (ret == 1){
+        for (i = hash & mask; xh->xh_slots[i].xhs_x != NULL; i = (i + 1) & mask)
+            if (xh->xh_slots[i].xhs_x == x)
+                break;
+    }
+    if (ret == 0 && xh->xh_unhashable > 0)
+        return 0;
+    if (ret == 0 || xh->xh_slots[i].xhs_x == NULL){
+        /* Not found where expected, eg key not hashed as when added */
+        for (i = 0; i < xh->xh_size; i++)
+            if (xh->xh_slots[i].xhs_x == x)
+                break;
+        if (i == xh->xh_size)
+            return 0;
+    }
+    xh->xh_slots[i].xhs_x = NULL;
+    xh->xh_nr--;
+    for (j = (i + 1) & mask; xh->xh_slots[j].xhs_x != NULL; j = (j + 1) & mask){
+        k = xh->xh_slots[j].xhs_hash & mask; /* Home slot of j */
+        /* Move j to i if its home is not cyclically in (i, j] */
+        if ((j > i && (k <= i || k > j)) ||
+            (j < i && (k <= i && k > j))){
+            xh->xh_slots[i] = xh->xh_slots[j];
+            xh->xh_slots[j].xhs_x = NULL;
+            i = j;
+        }
+    }
+    return 1;
+}
+
+/*! Build hash index of yang list or leaf-list of XML node
+ *
+ * @param[in]  xp   XML node
+ * @param[in]  y    Yang list or leaf-list
+ * @param[out] xhp  Hash index, with count of entries that are not hashable
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_hash_index_build(cxobj                  *xp,
+                     yang_stmt              *y,
+                     struct xml_hash_index **xhp)
+{
+    int                    retval = -1;
+    struct xml_hash_index *xh;
+    cxobj                 *x;
+    int                    ret;
+
+    *xhp = NULL;
+    if (xml_arena_hold(xp) < 0)
+        goto done;
+    if ((xh = malloc(sizeof(*xh))) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        goto done;
+    }
+    memset(xh, 0, sizeof(*xh));
+    xh->xh_yang = y;
+    ADDQ(xh, xp->x_hash_index);
+    x = NULL;
+    while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL) {
+        if (xml_spec(x) != y)
+            continue;
+        if ((ret = xml_hash_index_add(xh, x)) < 0)
+            goto done;
+        if (ret == 0)
+            xh->xh_unhashable++;
+    }
+    *xhp = xh;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add or remove XML entry in the hash index of its yang list or leaf-list
+ *
+ * @param[in]  xp   XML node
+ * @param[in]  x    Child of xp that is added or removed
+ * @param[in]  add  1: add entry, 0: remove entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_hash_entry_update(cxobj *xp,
+                      cxobj *x,
+                      int    add)
+{
+    struct xml_hash_index *xh;
+    yang_stmt             *y;
+    int                    ret;
+
+    if (xp == NULL ||
+        xp->x_hash_index == NULL ||
+        xml_type(x) != CX_ELMNT ||
+        (y = xml_spec(x)) == NULL ||
+        (xh = xml_hash_index_get(xp, y)) == NULL)
+        return 0;
+    if (add)
+        ret = xml_hash_index_add(xh, x);
+    else
+        ret = xml_hash_index_rm(xh, x);
+    if (ret < 0){
+        xml_hash_index_drop(xp, xh);
+        return -1;
+    }
+    if (ret == 0){ /* Not hashable */
+        if (add)
+            xh->xh_unhashable++;
+        else if (xh->xh_unhashable > 0)
+            xh->xh_unhashable--;
+    }
+    return 0;
+}
+
+/*! Get list or leaf-list entry whose hash key is affected by a change
+ *
+ * @param[in]  xp   XML node
+ * @param[in]  xc   Child of xp that is added or removed, or body of xp that is changed
+ * @retval     xe   Entry whose hash key may change
+ * @retval     NULL No hashed entry affected
+ */
+static cxobj *
+xml_hash_index_entry(cxobj *xp,
+                     cxobj *xc)
+{
+    cxobj     *xe;
+    yang_stmt *y;
+    char      *name;
+    cg_var    *cvi = NULL;
+
+    if (xml_type(xc) == CX_BODY){
+        if ((y = xml_spec(xp)) != NULL &&
+            yang_keyword_get(y) == Y_LEAF_LIST)
+            return xp;
+        xe = xml_parent(xp); /* xp may be a key of a list entry */
+        name = xml_name(xp);
+    }
+    else if (xml_type(xc) == CX_ELMNT){
+        xe = xp;             /* xc may be a key of list entry xp */
+        name = xml_name(xc);
+    }
+    else
+        return NULL;
+    if (xe == NULL ||
+        xml_parent(xe) == NULL ||
+        xml_parent(xe)->x_hash_index == NULL ||
+        (y = xml_spec(xe)) == NULL ||
+        yang_keyword_get(y) != Y_LIST)
+        return NULL;
+    while ((cvi = cvec_each(yang_cvec_get(y), cvi)) != NULL)
+        if (strcmp(cv_string_get(cvi), name) == 0)
+            return xe;
+    return NULL;
+}
+
+/*! Remove entry from its hash index before a change affecting its hash key
+ *
+ * The change is that xc is added to or removed from xp, or that xc is a body of xp which
+ * is changed. After the change, call xml_hash_index_post to add the entry again.
+ * @param[in]  xp   XML node
+ * @param[in]  xc   Child of xp
+ * @param[out] xep  Entry removed from its hash index, or NULL if none
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_search_index_pre
+ */
+static int
+xml_hash_index_pre(cxobj  *xp,
+                   cxobj  *xc,
+                   cxobj **xep)
+{
+    cxobj *xe;
+
+    *xep = NULL;
+    if ((xe = xml_hash_index_entry(xp, xc)) == NULL)
+        return 0;
+    if (xml_hash_entry_update(xml_parent(xe), xe, 0) < 0)
+        return -1;
+    *xep = xe;
+    return 0;
+}
+
+/*! Add entry to its hash index after a change affecting its hash key
+ *
+ * @param[in]  xe   Entry from xml_hash_index_pre, or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_hash_index_post(cxobj *xe)
+{
+    if (xe == NULL)
+        return 0;
+    return xml_hash_entry_update(xml_parent(xe), xe, 1);
+}
+
+/*! Search list or leaf-list entries of XML node using hash index
+ *
+ * The index is built on first search if the node has at least XML_HASH_INDEX_MIN children.
+ * Entries are matched as in xml_cmp.
+ * @param[in]  xp    XML parent node
+ * @param[in]  y     Yang list or leaf-list
+ * @param[in]  x1    Search object, with all list keys or leaf-list value
+ * @param[out] xvec  Matching entries appended
+ * @retval     1     OK, search made, see xvec
+ * @retval     0     No index, use other search
+ * @retval    -1     Error
+ * @see xml_search_yang
+ */
+int
+xml_hash_index_search(cxobj       *xp,
+                      yang_stmt   *y,
+                      cxobj       *x1,
+                      clixon_xvec *xvec)
+{
+    int                    retval = -1;
+    struct xml_hash_index *xh;
+    uint32_t               hash;
+    size_t                 mask;
+    size_t                 i;
+    cxobj                 *x;
+    int                    ret;
+
+    if (!is_element(xp))
+        goto fail;
+    if ((xh = xml_hash_index_get(xp, y)) == NULL){
+        if (xml_child_nr(xp) < XML_HASH_INDEX_MIN)
+            goto fail;
+        if (xml_hash_index_build(xp, y, &xh) < 0)
+            goto done;
+    }
+    if (xh->xh_unhashable)
+        goto fail;
+    if ((ret = xml_hash_key(x1, y, &hash)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (xh->xh_size == 0)
+        goto ok;
+    mask = xh->xh_size - 1;
+    for (i = hash & mask; (x = xh->xh_slots[i].xhs_x) != NULL; i = (i + 1) & mask){
+        if (xh->xh_slots[i].xhs_hash != hash)
+            continue;
+        if (xml_cmp(x1, x, 0, 0, NULL) == 0 &&
+            clixon_xvec_append(xvec, x) < 0)
+            goto done;
+    }
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+#endif /* XML_HASH_INDEX */
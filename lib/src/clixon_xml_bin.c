@@ -0,0 +1,768 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary XML tree encoding
+ *
+ * A compact encoding of a YANG-bound XML tree that can be loaded in a single pass from a
+ * memory-mapped file, without lexing or yang binding. Used as datastore format "binary",
+ * see CLICON_XMLDB_FORMAT.
+ *
+ * File layout (all integers are 32-bit in host byte order):
+ *   header      struct xml_bin_header
+ *   strings     nstrings offsets into string data
+ *   schemas     nschemas * {parent schema id, name string id, namespace string id}
+ *   nodes       nnodes * {type, name string id, prefix string id, value, nchildren}
+ *   string data strdata_len bytes of NUL-terminated strings
+ * All names, prefixes and values are interned in the string table.
+ * Nodes are stored in pre-order, the first node is the root.
+ * value is a string id for attributes and bodies, and a schema id for elements.
+ * A schema id identifies the YANG data node of an element by its parent schema id, name and
+ * namespace. The schema table is resolved once when loading, elements are then bound by
+ * lookup in the table.
+ * The byte order marker and YANG fingerprint guard against files written on another host or
+ * with other YANG modules or features. In that case, or if a schema id cannot be resolved,
+ * the tree is loaded without YANG binding.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_yang_module.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_io.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bin.h"
+
+/*
+ * Constants
+ */
+#define XML_BIN_MAGIC     "CLXB"
+#define XML_BIN_VERSION   1
+#define XML_BIN_BYTEORDER 0x01020304
+#define XML_BIN_NONE      0xffffffff  /* No string or schema */
+
+/* Header flags */
+#define XML_BIN_F_UNBOUND 0x01        /* Tree has elements without yang binding */
+
+/* Initial size of intern hash tables, power of two */
+#define XML_BIN_HASH_START 1024
+
+/*
+ * Types
+ */
+/* File header */
+struct xml_bin_header{
+    char     xh_magic[4];     /* XML_BIN_MAGIC */
+    uint32_t xh_version;      /* XML_BIN_VERSION */
+    uint32_t xh_byteorder;    /* XML_BIN_BYTEORDER as written by host */
+    uint32_t xh_flags;        /* XML_BIN_F_* */
+    uint32_t xh_fingerprint;  /* Hash of yang module names, revisions and features */
+    uint32_t xh_nstrings;     /* Number of strings */
+    uint32_t xh_nschemas;     /* Number of schema nodes */
+    uint32_t xh_nnodes;       /* Number of XML nodes */
+    uint32_t xh_strdata_len;  /* Length of string data */
+};
+
+/* Schema record */
+struct xml_bin_schema{
+    uint32_t xs_parent;       /* Parent schema id or XML_BIN_NONE if top-level */
+    uint32_t xs_name;         /* String id of yang node name */
+    uint32_t xs_ns;           /* String id of yang node namespace */
+};
+
+/* XML node record */
+struct xml_bin_node{
+    uint32_t xn_type;         /* enum cxobj_type */
+    uint32_t xn_name;         /* String id of name */
+    uint32_t xn_prefix;       /* String id of prefix or XML_BIN_NONE */
+    uint32_t xn_value;        /* Element: schema id, attr/body: string id (or XML_BIN_NONE) */
+    uint32_t xn_nchildren;    /* Number of child records following in pre-order */
+};
+
+/* Growable vector of 32-bit words */
+struct xml_bin_vec{
+    uint32_t *bv_vec;
+    size_t    bv_len;
+    size_t    bv_max;
+};
+
+/* Open addressing hash table mapping keys to ids, slots contain id+1 or 0 if empty */
+struct xml_bin_hash{
+    uint32_t *bh_slots;
+    size_t    bh_size;        /* Power of two */
+};
+
+/* Encoder state */
+struct xml_bin_writer{
+    withdefaults_type   bw_wdef;
+    uint32_t            bw_flags;
+    cbuf               *bw_strdata;   /* String data */
+    struct xml_bin_vec  bw_strings;   /* String offsets into bw_strdata */
+    struct xml_bin_hash bw_strhash;   /* String -> string id */
+    struct xml_bin_vec  bw_schemas;   /* Schema records, 3 words each */
+    yang_stmt         **bw_ys;        /* Schema id -> yang node */
+    size_t              bw_ys_max;
+    struct xml_bin_hash bw_yshash;    /* yang node -> schema id */
+    struct xml_bin_vec  bw_nodes;     /* Node records, 5 words each */
+};
+
+/* Decoder state */
+struct xml_bin_reader{
+    struct xml_bin_node *br_nodes;
+    uint32_t             br_nnodes;
+    uint32_t             br_i;        /* Next node record */
+    const uint32_t      *br_strings;
+    uint32_t             br_nstrings;
+    const char          *br_strdata;
+    yang_stmt          **br_ys;       /* Resolved schema id -> yang node, or NULL if unbound */
+    uint32_t             br_nschemas;
+};
+
+/*! FNV-1a hash of a string, continued from hash value h
+ */
+static uint32_t
+xml_bin_fnv(uint32_t    h,
+            const char *str)
+{
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619;
+    }
+    return h;
+}
+
+/*! Fingerprint of yang spec as a hash of all module names, revisions and enabled features
+ *
+ * Features are included since nodes with disabled if-features are not in the yang spec.
+ * @param[in]  yspec  Top-level yang spec
+ * @retval     fp     Fingerprint, 0 if no yang spec
+ */
+static uint32_t
+xml_bin_fingerprint(yang_stmt *yspec)
+{
+    uint32_t   h = 2166136261U;
+    yang_stmt *ymod;
+    yang_stmt *yrev;
+    yang_stmt *yf;
+    cg_var    *cv;
+    int        inext;
+    int        inext2;
+
+    if (yspec == NULL)
+        return 0;
+    inext = 0;
+    while ((ymod = yn_iter(yspec, &inext)) != NULL) {
+        h = xml_bin_fnv(h, yang_argument_get(ymod));
+        h = xml_bin_fnv(h, "@");
+        if ((yrev = yang_find(ymod, Y_REVISION, NULL)) != NULL)
+            h = xml_bin_fnv(h, yang_argument_get(yrev));
+        inext2 = 0;
+        while ((yf = yn_iter(ymod, &inext2)) != NULL) {
+            if (yang_keyword_get(yf) != Y_FEATURE)
+                continue;
+            if ((cv = yang_cv_get(yf)) != NULL && cv_bool_get(cv)){
+                h = xml_bin_fnv(h, "+");
+                h = xml_bin_fnv(h, yang_argument_get(yf));
+            }
+        }
+        h = xml_bin_fnv(h, ";");
+    }
+    return h?h:1;
+}
+
+/*! Append words to a growable vector
+ */
+static int
+xml_bin_vec_append(struct xml_bin_vec *bv,
+                   const uint32_t     *words,
+                   size_t              n)
+{
+    uint32_t *vec;
+    size_t    max;
+
+    if (bv->bv_len + n > bv->bv_max){
+        max = bv->bv_max?2*bv->bv_max:256;
+        while (max < bv->bv_len + n)
+            max *= 2;
+        if ((vec = realloc(bv->bv_vec, max*sizeof(uint32_t))) == NULL){
+            clixon_err(OE_XML, errno, "realloc");
+            return -1;
+        }
+        bv->bv_vec = vec;
+        bv->bv_max = max;
+    }
+    memcpy(&bv->bv_vec[bv->bv_len], words, n*sizeof(uint32_t));
+    bv->bv_len += n;
+    return 0;
+}
+
+/*! Allocate hash table slots
+ */
+static int
+xml_bin_hash_init(struct xml_bin_hash *bh,
+                  size_t               size)
+{
+    if ((bh->bh_slots = calloc(size, sizeof(uint32_t))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return -1;
+    }
+    bh->bh_size = size;
+    return 0;
+}
+
+/*! Hash of a yang node pointer
+ */
+static uint32_t
+xml_bin_ptrhash(yang_stmt *ys)
+{
+    uint64_t k = (uint64_t)(uintptr_t)ys;
+
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return (uint32_t)k;
+}
+
+/*! Double a hash table and rehash its ids
+ *
+ * @param[in]  bw    Encoder state
+ * @param[in]  bh    Hash table, either string or schema table of bw
+ */
+static int
+xml_bin_hash_grow(struct xml_bin_writer *bw,
+                  struct xml_bin_hash   *bh)
+{
+    struct xml_bin_hash bh1 = {0,};
+    uint32_t            id;
+    uint32_t            h;
+    size_t              i;
+    size_t              j;
+
+    if (xml_bin_hash_init(&bh1, 2*bh->bh_size) < 0)
+        return -1;
+    for (i=0; i<bh->bh_size; i++){
+        if ((id = bh->bh_slots[i]) == 0)
+            continue;
+        if (bh == &bw->bw_strhash)
+            h = xml_bin_fnv(2166136261U, cbuf_get(bw->bw_strdata) + bw->bw_strings.bv_vec[id-1]);
+        else
+            h = xml_bin_ptrhash(bw->bw_ys[id-1]);
+        for (j = h & (bh1.bh_size-1); bh1.bh_slots[j]; j = (j+1) & (bh1.bh_size-1))
+            ;
+        bh1.bh_slots[j] = id;
+    }
+    free(bh->bh_slots);
+    *bh = bh1;
+    return 0;
+}
+
+/*! Intern a string and return its string id
+ *
+ * @param[in]  bw    Encoder state
+ * @param[in]  str   String, if NULL XML_BIN_NONE is returned
+ * @param[out] id    String id
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_bin_string(struct xml_bin_writer *bw,
+               const char            *str,
+               uint32_t              *id)
+{
+    struct xml_bin_hash *bh = &bw->bw_strhash;
+    uint32_t             offset;
+    uint32_t             i;
+    size_t               j;
+
+    if (str == NULL){
+        *id = XML_BIN_NONE;
+        return 0;
+    }
+    for (j = xml_bin_fnv(2166136261U, str) & (bh->bh_size-1);
+         (i = bh->bh_slots[j]) != 0;
+         j = (j+1) & (bh->bh_size-1)){
+        if (strcmp(cbuf_get(bw->bw_strdata) + bw->bw_strings.bv_vec[i-1], str) == 0){
+            *id = i-1;
+            return 0;
+        }
+    }
+    offset = cbuf_len(bw->bw_strdata);
+    if (cbuf_append_buf(bw->bw_strdata, (void*)str, strlen(str)+1) < 0){
+        clixon_err(OE_XML, errno, "cbuf_append_buf");
+        return -1;
+    }
+    if (xml_bin_vec_append(&bw->bw_strings, &offset, 1) < 0)
+        return -1;
+    *id = bw->bw_strings.bv_len-1;
+    bh->bh_slots[j] = *id+1;
+    if (2*bw->bw_strings.bv_len > bh->bh_size &&
+        xml_bin_hash_grow(bw, bh) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Get schema id of a yang node, add it to the schema table if not found
+ *
+ * @param[in]  bw     Encoder state
+ * @param[in]  ys     Yang data node
+ * @param[in]  parent Schema id of yang node of parent XML element or XML_BIN_NONE
+ * @param[out] id     Schema id
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_bin_schema(struct xml_bin_writer *bw,
+               yang_stmt             *ys,
+               uint32_t               parent,
+               uint32_t              *id)
+{
+    struct xml_bin_hash *bh = &bw->bw_yshash;
+    yang_stmt          **vec;
+    uint32_t             rec[3];
+    uint32_t             i;
+    size_t               j;
+
+    for (j = xml_bin_ptrhash(ys) & (bh->bh_size-1);
+         (i = bh->bh_slots[j]) != 0;
+         j = (j+1) & (bh->bh_size-1)){
+        if (bw->bw_ys[i-1] == ys){
+            *id = i-1;
+            return 0;
+        }
+    }
+    rec[0] = parent;
+    if (xml_bin_string(bw, yang_argument_get(ys), &rec[1]) < 0)
+        return -1;
+    if (xml_bin_string(bw, yang_find_mynamespace(ys), &rec[2]) < 0)
+        return -1;
+    if (xml_bin_vec_append(&bw->bw_schemas, rec, 3) < 0)
+        return -1;
+    *id = bw->bw_schemas.bv_len/3 - 1;
+    if (*id >= bw->bw_ys_max){
+        bw->bw_ys_max = bw->bw_ys_max?2*bw->bw_ys_max:256;
+        if ((vec = realloc(bw->bw_ys, bw->bw_ys_max*sizeof(yang_stmt*))) == NULL){
+            clixon_err(OE_XML, errno, "realloc");
+            return -1;
+        }
+        bw->bw_ys = vec;
+    }
+    bw->bw_ys[*id] = ys;
+    bh->bh_slots[j] = *id+1;
+    if (2*(*id+1) > bh->bh_size &&
+        xml_bin_hash_grow(bw, bh) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Encode an XML node and its children in pre-order
+ *
+ * @param[in]  bw     Encoder state
+ * @param[in]  x      XML node
+ * @param[in]  parent Schema id of parent XML element or XML_BIN_NONE
+ * @param[in]  depth  Depth of x, the root has depth 0
+ * @param[in]  anydata Parent is anydata/anyxml or unbound
+ * @retval     1      OK, node encoded
+ * @retval     0      OK, node skipped according to with-defaults
+ * @retval    -1      Error
+ */
+static int
+xml_bin_encode(struct xml_bin_writer *bw,
+               cxobj                 *x,
+               uint32_t               parent,
+               int                    depth,
+               int                    anydata)
+{
+    uint32_t   rec[5];
+    size_t     i;
+    yang_stmt *y;
+    cxobj     *xc;
+    int        ret;
+    uint32_t   n = 0;
+
+    if ((y = xml_spec(x)) != NULL){
+        if ((ret = xml2output_wdef(x, bw->bw_wdef, NULL)) < 0)
+            return -1;
+        if (ret == 0)
+            return 0;
+    }
+    rec[0] = xml_type(x);
+    if (xml_bin_string(bw, xml_name(x), &rec[1]) < 0)
+        return -1;
+    if (xml_bin_string(bw, xml_prefix(x), &rec[2]) < 0)
+        return -1;
+    rec[4] = 0;
+    if (xml_type(x) == CX_ELMNT){
+        if (y == NULL){
+            rec[3] = XML_BIN_NONE;
+            if (depth > 0 && !anydata) /* Root is never bound */
+                bw->bw_flags |= XML_BIN_F_UNBOUND;
+        }
+        else if (xml_bin_schema(bw, y, parent, &rec[3]) < 0)
+            return -1;
+    }
+    else if (xml_bin_string(bw, xml_value(x), &rec[3]) < 0)
+        return -1;
+    i = bw->bw_nodes.bv_len;
+    if (xml_bin_vec_append(&bw->bw_nodes, rec, 5) < 0)
+        return -1;
+    if (xml_type(x) == CX_ELMNT){
+        if (y && (yang_keyword_get(y) == Y_ANYDATA || yang_keyword_get(y) == Y_ANYXML))
+            anydata = 1;
+        else
+            anydata = (depth > 0 && y == NULL);
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+            if ((ret = xml_bin_encode(bw, xc, rec[3], depth+1, anydata)) < 0)
+                return -1;
+            n += ret;
+        }
+        bw->bw_nodes.bv_vec[i+4] = n;
+    }
+    return 1;
+}
+
+/*! Print an XML tree in binary format to file
+ *
+ * @param[in]  f      Output file
+ * @param[in]  xt     XML tree, eg datastore top-level "config"
+ * @param[in]  yspec  Top-level yang spec, used for fingerprint
+ * @param[in]  wdef   With-defaults parameter, see xml2output_wdef
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clixon_bin_parse_file
+ */
+int
+clixon_bin2file(FILE             *f,
+                cxobj            *xt,
+                yang_stmt        *yspec,
+                withdefaults_type wdef)
+{
+    int                   retval = -1;
+    struct xml_bin_writer bw = {0,};
+    struct xml_bin_header xh = {0,};
+
+    bw.bw_wdef = wdef;
+    if ((bw.bw_strdata = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (xml_bin_hash_init(&bw.bw_strhash, XML_BIN_HASH_START) < 0)
+        goto done;
+    if (xml_bin_hash_init(&bw.bw_yshash, XML_BIN_HASH_START) < 0)
+        goto done;
+    if (xml_bin_encode(&bw, xt, XML_BIN_NONE, 0, 0) < 0)
+        goto done;
+    memcpy(xh.xh_magic, XML_BIN_MAGIC, sizeof(xh.xh_magic));
+    xh.xh_version = XML_BIN_VERSION;
+    xh.xh_byteorder = XML_BIN_BYTEORDER;
+    xh.xh_flags = bw.bw_flags;
+    xh.xh_fingerprint = xml_bin_fingerprint(yspec);
+    xh.xh_nstrings = bw.bw_strings.bv_len;
+    xh.xh_nschemas = bw.bw_schemas.bv_len/3;
+    xh.xh_nnodes = bw.bw_nodes.bv_len/5;
+    xh.xh_strdata_len = cbuf_len(bw.bw_strdata);
+    if (fwrite(&xh, sizeof(xh), 1, f) != 1 ||
+        fwrite(bw.bw_strings.bv_vec, sizeof(uint32_t), bw.bw_strings.bv_len, f) != bw.bw_strings.bv_len ||
+        fwrite(bw.bw_schemas.bv_vec, sizeof(uint32_t), bw.bw_schemas.bv_len, f) != bw.bw_schemas.bv_len ||
+        fwrite(bw.bw_nodes.bv_vec, sizeof(uint32_t), bw.bw_nodes.bv_len, f) != bw.bw_nodes.bv_len ||
+        fwrite(cbuf_get(bw.bw_strdata), 1, xh.xh_strdata_len, f) != xh.xh_strdata_len){
+        clixon_err(OE_XML, errno, "fwrite");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (bw.bw_strdata)
+        cbuf_free(bw.bw_strdata);
+    if (bw.bw_strings.bv_vec)
+        free(bw.bw_strings.bv_vec);
+    if (bw.bw_strhash.bh_slots)
+        free(bw.bw_strhash.bh_slots);
+    if (bw.bw_schemas.bv_vec)
+        free(bw.bw_schemas.bv_vec);
+    if (bw.bw_ys)
+        free(bw.bw_ys);
+    if (bw.bw_yshash.bh_slots)
+        free(bw.bw_yshash.bh_slots);
+    if (bw.bw_nodes.bv_vec)
+        free(bw.bw_nodes.bv_vec);
+    return retval;
+}
+
+/*! Get string from string id
+ *
+ * @retval  str   String
+ * @retval  NULL  XML_BIN_NONE or invalid id
+ */
+static const char *
+xml_bin_str(struct xml_bin_reader *br,
+            uint32_t               id)
+{
+    if (id >= br->br_nstrings)
+        return NULL;
+    return br->br_strdata + br->br_strings[id];
+}
+
+/*! Resolve schema table to yang nodes
+ *
+ * Top-level nodes are looked up by namespace, other nodes by name in parent yang node.
+ * @param[in]  br     Decoder state
+ * @param[in]  xs     Schema records
+ * @param[in]  yspec  Top-level yang spec
+ * @retval     1      OK, all schema ids resolved
+ * @retval     0      At least one schema id not resolved
+ */
+static int
+xml_bin_resolve(struct xml_bin_reader *br,
+                struct xml_bin_schema *xs,
+                yang_stmt             *yspec)
+{
+    uint32_t   i;
+    const char *name;
+    const char *ns;
+    char       *nsy;
+    yang_stmt  *yp;
+    yang_stmt  *y;
+
+    for (i=0; i<br->br_nschemas; i++){
+        if ((name = xml_bin_str(br, xs[i].xs_name)) == NULL ||
+            (ns = xml_bin_str(br, xs[i].xs_ns)) == NULL)
+            return 0;
+        if (xs[i].xs_parent == XML_BIN_NONE){
+            if ((yp = yang_find_module_by_namespace(yspec, (char*)ns)) == NULL)
+                return 0;
+            y = yang_find_schemanode(yp, (char*)name);
+        }
+        else if (xs[i].xs_parent < i)
+            y = yang_find_datanode(br->br_ys[xs[i].xs_parent], (char*)name);
+        else
+            return 0;
+        if (y == NULL)
+            return 0;
+        if ((nsy = yang_find_mynamespace(y)) == NULL || strcmp(ns, nsy) != 0)
+            return 0;
+        br->br_ys[i] = y;
+    }
+    return 1;
+}
+
+/*! Decode an XML node and its children in pre-order
+ *
+ * @param[in]  br     Decoder state
+ * @param[in]  xp     Parent XML node
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_bin_decode(struct xml_bin_reader *br,
+               cxobj                 *xp)
+{
+    struct xml_bin_node *xn;
+    cxobj               *x;
+    const char          *name;
+    const char          *str;
+    uint32_t             i;
+
+    if (br->br_i >= br->br_nnodes){
+        clixon_err(OE_XML, 0, "Binary XML: node record out of range");
+        return -1;
+    }
+    xn = &br->br_nodes[br->br_i++];
+    if ((name = xml_bin_str(br, xn->xn_name)) == NULL ||
+        (xn->xn_type != CX_ELMNT && xn->xn_type != CX_ATTR && xn->xn_type != CX_BODY)){
+        clixon_err(OE_XML, 0, "Binary XML: invalid node record %u", br->br_i-1);
+        return -1;
+    }
+    if ((x = xml_new((char*)name, xp, xn->xn_type)) == NULL)
+        return -1;
+    if ((str = xml_bin_str(br, xn->xn_prefix)) != NULL &&
+        xml_prefix_set(x, (char*)str) < 0)
+        return -1;
+    if (xn->xn_type != CX_ELMNT){
+        if ((str = xml_bin_str(br, xn->xn_value)) != NULL &&
+            xml_value_set(x, (char*)str) < 0)
+            return -1;
+        return 0;
+    }
+    if (br->br_ys && xn->xn_value < br->br_nschemas)
+        xml_spec_set(x, br->br_ys[xn->xn_value]);
+    for (i=0; i<xn->xn_nchildren; i++)
+        if (xml_bin_decode(br, x) < 0)
+            return -1;
+    /* After children since the typed value is of the body, as xml_bind_yang */
+    if (xml_spec(x) && xml_cv_cache_bind(x) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Read an XML tree in binary format from file using mmap
+ *
+ * @param[in]  fp     Input file, written by clixon_bin2file
+ * @param[in]  yspec  Top-level yang spec, if NULL no yang binding is made
+ * @param[out] xt     XML top-level symbol containing the tree. Free with xml_free()
+ * @retval     1      OK and tree is bound to yspec
+ * @retval     0      OK but tree is not (or only partially) bound, bind with xml_bind_yang
+ * @retval    -1      Error
+ * An empty file is read as an empty top-level symbol.
+ * @see clixon_bin2file
+ */
+int
+clixon_bin_parse_file(FILE       *fp,
+                      yang_stmt  *yspec,
+                      cxobj     **xt)
+{
+    int                    retval = -1;
+    struct stat            st;
+    char                  *buf = MAP_FAILED;
+    struct xml_bin_header *xh;
+    struct xml_bin_reader  br = {0,};
+    struct xml_bin_schema *xs;
+    uint64_t               len;
+    uint32_t               i;
+    int                    bound = 0;
+    cxobj                 *x0 = NULL;
+
+    if (xt == NULL){
+        clixon_err(OE_XML, EINVAL, "xt is NULL");
+        goto done;
+    }
+    if (fstat(fileno(fp), &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        goto done;
+    }
+    if ((x0 = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (st.st_size == 0){
+        bound = 1;
+        goto ok;
+    }
+    if (st.st_size < (off_t)sizeof(*xh)){
+        clixon_err(OE_XML, 0, "Binary XML: file too short");
+        goto done;
+    }
+    if ((buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED){
+        clixon_err(OE_UNIX, errno, "mmap");
+        goto done;
+    }
+    xh = (struct xml_bin_header *)buf;
+    if (memcmp(xh->xh_magic, XML_BIN_MAGIC, sizeof(xh->xh_magic)) != 0 ||
+        xh->xh_version != XML_BIN_VERSION){
+        clixon_err(OE_XML, 0, "Binary XML: bad magic or version");
+        goto done;
+    }
+    if (xh->xh_byteorder != XML_BIN_BYTEORDER){
+        clixon_err(OE_XML, 0, "Binary XML: file written with other byte order");
+        goto done;
+    }
+    len = sizeof(*xh) +
+        (uint64_t)xh->xh_nstrings*sizeof(uint32_t) +
+        (uint64_t)xh->xh_nschemas*sizeof(struct xml_bin_schema) +
+        (uint64_t)xh->xh_nnodes*sizeof(struct xml_bin_node) +
+        xh->xh_strdata_len;
+    if (len != (uint64_t)st.st_size || xh->xh_nnodes == 0 ||
+        (xh->xh_strdata_len && buf[st.st_size-1] != '\0')){
+        clixon_err(OE_XML, 0, "Binary XML: inconsistent file length");
+        goto done;
+    }
+    br.br_strings = (uint32_t *)(buf + sizeof(*xh));
+    br.br_nstrings = xh->xh_nstrings;
+    br.br_nschemas = xh->xh_nschemas;
+    br.br_nodes = (struct xml_bin_node *)(buf + sizeof(*xh) +
+                                          xh->xh_nstrings*sizeof(uint32_t) +
+                                          xh->xh_nschemas*sizeof(struct xml_bin_schema));
+    br.br_nnodes = xh->xh_nnodes;
+    br.br_strdata = (char*)(br.br_nodes + br.br_nnodes);
+    for (i=0; i<br.br_nstrings; i++)
+        if (br.br_strings[i] >= xh->xh_strdata_len){
+            clixon_err(OE_XML, 0, "Binary XML: string offset out of range");
+            goto done;
+        }
+    /* Bind only if whole tree can be bound */
+    if (yspec &&
+        (xh->xh_flags & XML_BIN_F_UNBOUND) == 0 &&
+        xh->xh_fingerprint == xml_bin_fingerprint(yspec)){
+        if ((br.br_ys = calloc(br.br_nschemas+1, sizeof(yang_stmt*))) == NULL){
+            clixon_err(OE_XML, errno, "calloc");
+            goto done;
+        }
+        xs = (struct xml_bin_schema *)(br.br_strings + br.br_nstrings);
+        if (xml_bin_resolve(&br, xs, yspec) == 0){
+            clixon_debug(CLIXON_DBG_DATASTORE, "Binary XML: schema not resolved, not bound");
+            free(br.br_ys);
+            br.br_ys = NULL;
+        }
+        else
+            bound = 1;
+    }
+    if (xml_bin_decode(&br, x0) < 0)
+        goto done;
+    if (br.br_i != br.br_nnodes){
+        clixon_err(OE_XML, 0, "Binary XML: %u trailing node records", br.br_nnodes - br.br_i);
+        goto done;
+    }
+ ok:
+    *xt = x0;
+    x0 = NULL;
+    retval = bound;
+ done:
+    if (br.br_ys)
+        free(br.br_ys);
+    if (buf != MAP_FAILED)
+        munmap(buf, st.st_size);
+    if (x0)
+        xml_free(x0);
+    return retval;
+}
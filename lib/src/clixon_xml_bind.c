@@ -240,10 +240,6 @@ populate_self_parent(clixon_handle h,
     }
  set:
     xml_spec_set(xt, y);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xt))
-        xml_search_child_insert(xp, xt);
-#endif
     retval = 1;
  done:
     if (cb)
@@ -461,6 +457,8 @@ xml_bind_yang0_opt(clixon_handle h,
     else if (ret == 2)     /* ret=2 for anyxml from parent^ */
         goto ok;
     strip_body_objects(xt);
+    if (xml_cv_cache_bind(xt) < 0)
+        goto done;
     ybc = YB_PARENT;
     if (h && clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         yspec1 = NULL;
@@ -573,6 +571,8 @@ xml_bind_yang0(clixon_handle h,
     else if (ret == 2)     /* ret=2 for anyxml from parent^ */
         goto ok;
     strip_body_objects(xt);
+    if (xml_cv_cache_bind(xt) < 0)
+        goto done;
     xc = NULL;     /* Apply on children */
     while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
         if ((ret = xml_bind_yang0_opt(h, xc, YB_PARENT, yspec, NULL, xerr)) < 0)
@@ -589,6 +589,81 @@ xml_bind_yang0(clixon_handle h,
     goto done;
 }
 
+/*! Find yang spec association of XML node and its children, where node is bound via its parent
+ *
+ * As xml_bind_yang0 with YB_PARENT, but also handles xt as a mount-point
+ * @param[in]   h      Clixon handle
+ * @param[in]   xt     XML tree node
+ * @param[in]   yspec  Yang spec
+ * @param[out]  xerr   Reason for failure, or NULL
+ * @retval      1      OK yang assignment made
+ * @retval      0      Partial or no yang assigment made (at least one failed) and xerr set
+ * @retval     -1      Error
+ * @see xmldb_multi_load  Bind a lazily loaded sub-tree
+ */
+int
+xml_bind_yang_parent(clixon_handle h,
+                     cxobj        *xt,
+                     yang_stmt    *yspec,
+                     cxobj       **xerr)
+{
+    return xml_bind_yang0_opt(h, xt, YB_PARENT, yspec, NULL, xerr);
+}
+
+/*! Find yang spec association of a single XML node, but not of its children
+ *
+ * Used when parsing, where a node is bound when its start-tag is parsed and its
+ * children are bound one by one as they are parsed.
+ * @param[in]   h        Clixon handle (sometimes NULL)
+ * @param[in]   xt       XML tree node, with attributes but not necessarily children
+ * @param[in]   yb       YB_MODULE or YB_PARENT
+ * @param[in]   yspec    Yang spec
+ * @param[in]   xsibling Previous sibling with same name and prefix, or NULL
+ * @param[out]  xerr     Reason for failure, or NULL
+ * @retval      2        OK Yang assignment not made since anyxml/anydata: skip children
+ * @retval      1        OK Yang assignment made
+ * @retval      0        Yang assigment not made and xerr set
+ * @retval     -1        Error
+ * @see xml_bind_yang_node_done  Call when the node is complete
+ */
+int
+xml_bind_yang_node(clixon_handle h,
+                   cxobj        *xt,
+                   yang_bind     yb,
+                   yang_stmt    *yspec,
+                   cxobj        *xsibling,
+                   cxobj       **xerr)
+{
+    int retval = -1;
+
+    switch (yb){
+    case YB_MODULE:
+        retval = populate_self_top(h, xt, yspec, xerr);
+        break;
+    case YB_PARENT:
+        retval = populate_self_parent(h, xt, xsibling, yspec, xerr);
+        break;
+    default:
+        clixon_err(OE_XML, EINVAL, "Invalid yang binding: %d", yb);
+        break;
+    }
+    return retval;
+}
+
+/*! Complete yang binding of a single XML node when all its children are present
+ *
+ * @param[in]   xt     XML tree node bound with xml_bind_yang_node
+ * @retval      0      OK
+ * @retval     -1      Error
+ * @see xml_bind_yang_node
+ */
+int
+xml_bind_yang_node_done(cxobj *xt)
+{
+    strip_body_objects(xt);
+    return xml_cv_cache_bind(xt);
+}
+
 /*! RPC-specific
  *
  * @param[in]   h      Clixon handle
@@ -85,12 +85,7 @@
 #include "clixon_xpath.h"
 #include "clixon_datastore.h"
 #include "clixon_xml_io.h"
-
-/*
- * Constants
- */
-/* Size of xml read buffer */
-#define BUFLEN 1024
+#include "clixon_writer.h"
 
 /* Forward */
 static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop);
@@ -108,7 +103,7 @@ static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop)
  * @retval      0    Remove it
  * @retval     -1    Error
  */
-static int
+int
 xml2output_wdef(cxobj            *x,
                 withdefaults_type wdef,
                 int              *tag)
@@ -192,6 +187,34 @@ xml2output_wdef(cxobj            *x,
     return retval;
 }
 
+/*! Check if element needs a with-defaults namespace declaration for tagged output
+ *
+ * A top-level yang-bound element, ie whose parent is not yang-bound, needs xmlns:wd unless
+ * it or an ancestor already declares it. The tree is not modified, not even the namespace
+ * cache, since it may be a shared datastore cache, see xmldb_get_view
+ * @param[in]  x    XML element
+ * @param[in]  wdef With-defaults parameter
+ * @retval     1    Print xmlns:wd declaration
+ * @retval     0    No declaration
+ */
+static int
+xml2output_wdns(cxobj            *x,
+                withdefaults_type wdef)
+{
+    cxobj *xp;
+
+    if (wdef != WITHDEFAULTS_REPORT_ALL_TAGGED ||
+        xml_spec(x) == NULL)
+        return 0;
+    if ((xp = xml_parent(x)) != NULL && xml_spec(xp) != NULL)
+        return 0;
+    for (xp = x; xp != NULL; xp = xml_parent(xp))
+        if (nscache_get(xp, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX) != NULL ||
+            xml_find_type_value(xp, "xmlns", IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, CX_ATTR) != NULL)
+            return 0;
+    return 1;
+}
+
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
  *
  * @param[in]   f          UNIX output stream
@@ -320,8 +343,11 @@ xml2file_recurse(FILE                *f,
                         goto done;
                     if (clixon_digest_hex(xpath, &hexstr) < 0)
                         goto done;
-                    (*fn)(f, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
-                    (*fn)(f, " %s:link=\"%s.xml\"", CLIXON_LIB_PREFIX, hexstr);
+                    /* A stub that is not loaded already has the link attribute */
+                    if (xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR) == NULL){
+                        (*fn)(f, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+                        (*fn)(f, " %s:link=\"%s.xml\"", CLIXON_LIB_PREFIX, hexstr);
+                    }
                     (*fn)(f, "/>");
                 }
             }
@@ -530,6 +556,42 @@ xml_dump(FILE  *f,
     return xml_dump1(f, x, 0);
 }
 
+/*! With-defaults check of an ancestor of marked nodes, considering marked children only
+ *
+ * @param[in]  x     XML node marked with XML_FLAG_VIEW_PATH
+ * @param[in]  wdef  With-defaults parameter
+ * @retval     1    Keep
+ * @retval     0    Do not print
+ * @retval    -1    Error
+ * @see xml2output_wdef
+ */
+static int
+xml2output_wdef_marked(cxobj            *x,
+                       withdefaults_type wdef)
+{
+    cxobj     *xc;
+    yang_stmt *y;
+    int        ret;
+
+    if ((y = xml_spec(x)) == NULL ||
+        (wdef != WITHDEFAULTS_EXPLICIT && wdef != WITHDEFAULTS_TRIM) ||
+        yang_keyword_get(y) != Y_CONTAINER ||
+        yang_find(y, Y_PRESENCE, NULL) != NULL)
+        return 1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if (xml_flag(xc, XML_FLAG_VIEW))
+            ret = xml2output_wdef(xc, wdef, NULL);
+        else if (xml_flag(xc, XML_FLAG_VIEW_PATH))
+            ret = xml2output_wdef_marked(xc, wdef);
+        else
+            continue;
+        if (ret != 0)
+            return ret;
+    }
+    return 0;
+}
+
 /*! Internal: print  XML tree structure to a cligen buffer and encode chars "<>&"
  *
  * @param[in,out] cb       Cligen buffer to write to
@@ -539,6 +601,7 @@ xml_dump(FILE  *f,
  * @param[in]     prefix   Add string to beginning of each line (if pretty)
  * @param[in]     depth    Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
  * @param[in]     wdef     With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     marked   Only print children marked with XML_FLAG_VIEW or XML_FLAG_VIEW_PATH, and list keys
  * @retval        0        OK
  * @retval       -1        Error
  * wdef changes the output as follows:
@@ -555,7 +618,8 @@ xml2cbuf_recurse(cbuf             *cb,
                  int               pretty,
                  char             *prefix,
                  int32_t           depth,
-                 withdefaults_type wdef)
+                 withdefaults_type wdef,
+                 int               marked)
 {
     int        retval = -1;
     cxobj     *xc;
@@ -568,12 +632,17 @@ xml2cbuf_recurse(cbuf             *cb,
     yang_stmt *y;
     int        tag = 0;
     int        ret;
+    int        cmarked;
 
     if (depth == 0)
         goto ok;
     if ((y = xml_spec(x)) != NULL){
         /* with-defaults: if object should be printed or not */
-        if ((ret = xml2output_wdef(x, wdef, &tag)) < 0)
+        if (marked)
+            ret = xml2output_wdef_marked(x, wdef);
+        else
+            ret = xml2output_wdef(x, wdef, &tag);
+        if (ret < 0)
             goto done;
         if (ret == 0)
             goto ok;
@@ -620,11 +689,12 @@ xml2cbuf_recurse(cbuf             *cb,
         while ((xc = xml_child_each(x, xc, -1)) != NULL)
             switch (xml_type(xc)){
             case CX_ATTR:
-                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef) < 0)
+                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef, 0) < 0)
                     goto done;
                 break;
             case CX_BODY:
-                hasbody=1;
+                if (!marked)
+                    hasbody=1;
                 break;
             case CX_ELMNT:
                 haselement=1;
@@ -632,6 +702,10 @@ xml2cbuf_recurse(cbuf             *cb,
             default:
                 break;
             }
+        /* If tagged withdefaults, declared here instead of adding attribute to tree */
+        if (xml2output_wdns(x, wdef))
+            cprintf(cb, " xmlns:%s=\"%s\"", IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX,
+                    IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE);
         /* Check for special case <a/> instead of <a></a> */
         if (hasbody==0 && haselement==0)
             cbuf_append_str(cb, "/>");
@@ -642,27 +716,24 @@ xml2cbuf_recurse(cbuf             *cb,
             xc = NULL;
             while ((xc = xml_child_each(x, xc, -1)) != NULL)
                 if (xml_type(xc) != CX_ATTR){
-                    cxobj *xa = NULL;
-                    char  *ns = NULL;
-
-                    /* If tagged withdefaults */
-                    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED &&
-                        y == NULL &&
-                        xml_spec(xc) != NULL){
-                        if (xml2ns(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, &ns) < 0)
-                            goto done;
-                        if (ns == NULL){
-                            if (xmlns_set(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE) < 0)
-                                goto done;
-                            xa = xml_find_type(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE, CX_ATTR);
-                        }
+                    cmarked = 0;
+                    if (marked){
+                        if (xml_type(xc) != CX_ELMNT)
+                            continue;
+                        if (xml_flag(xc, XML_FLAG_VIEW))
+                            ;
+                        else if (xml_flag(xc, XML_FLAG_VIEW_PATH))
+                            cmarked = 1;
+                        /* Keys of lists on the path to marked nodes, see xml_copy_marked */
+                        else if (y == NULL || yang_keyword_get(y) != Y_LIST ||
+                                 yang_key_match(y, xml_name(xc), NULL) != 1)
+                            continue;
                     }
-                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef) < 0)
+                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef, cmarked) < 0)
+                        goto done;
+                    /* Stream output if a writer is registered */
+                    if (clixon_writer_check(cb) < 0)
                         goto done;
-                    if (xa){
-                        if (xml_purge(xa) < 0)
-                            goto done;
-                    }
                 }
             if (pretty && hasbody == 0){
                 if (prefix)
@@ -728,11 +799,11 @@ clixon_xml2cbuf1(cbuf                *cb,
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef) < 0)
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, 0) < 0)
                 goto done;
     }
     else {
-        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef) < 0)
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, 0) < 0)
             goto done;
     }
     retval = 0;
@@ -774,6 +845,58 @@ clixon_xml2cbuf(cbuf   *cb,
     return clixon_xml2cbuf1(cb, xn, level, pretty, prefix, depth, skiptop, 0);
 }
 
+/*! Print the marked parts of an XML tree to a cligen buffer and encode chars "<>&"
+ *
+ * Print nodes marked with XML_FLAG_VIEW including sub-trees, their ancestors marked with
+ * XML_FLAG_VIEW_PATH, and keys of such ancestor lists. This is the same content as
+ * xml_copy_marked makes, but printed directly from the marked tree without copying.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object
+ * @param[in]     level   Indentation level for pretty
+ * @param[in]     pretty  Insert \n and spaces to make the xml more readable.
+ * @param[in]     prefix  Add string to beginning of each line (or NULL) (if pretty)
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see xmldb_get_view  which marks a cached datastore tree
+ * @see xml_copy_marked
+ */
+int
+clixon_xml2cbuf_marked(cbuf             *cb,
+                       cxobj            *xn,
+                       int               level,
+                       int               pretty,
+                       char             *prefix,
+                       int32_t           depth,
+                       int               skiptop,
+                       withdefaults_type wdef)
+{
+    int    retval = -1;
+    cxobj *xc;
+
+    if (xml_flag(xn, XML_FLAG_VIEW))
+        return clixon_xml2cbuf1(cb, xn, level, pretty, prefix, depth, skiptop, wdef);
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL){
+            if (xml_flag(xc, XML_FLAG_VIEW|XML_FLAG_VIEW_PATH) == 0)
+                continue;
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef,
+                                 xml_flag(xc, XML_FLAG_VIEW) == 0) < 0)
+                goto done;
+        }
+    }
+    else if (xml_flag(xn, XML_FLAG_VIEW_PATH)){
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, 1) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Print actual xml tree datastructures (not xml), mainly for debugging
  *
  * @param[in,out] cb          Cligen buffer to write to
@@ -817,10 +940,14 @@ xmltree2cbuf(cbuf  *cb,
 /*--------------------------------------------------------------------
  * XML parsing functions. Create XML parse tree from string and file.
  *--------------------------------------------------------------------*/
-/*! Common internal xml parsing function string to parse-tree
+/*! Common internal xml parsing function string or file to parse-tree
  *
- * Given a string containing XML, parse into existing XML tree and return
- * @param[in]     str   Pointer to string containing XML definition.
+ * Given a string or file containing XML, parse into existing XML tree and return
+ * Yang is bound to each element when its start-tag is parsed, and the children of each
+ * element are sorted when its end-tag is parsed, except for YB_RPC which binds and sorts
+ * after parsing.
+ * @param[in]     str   Pointer to string containing XML definition, if fp is NULL
+ * @param[in]     fp    File containing XML definition, read in blocks, or NULL
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
  * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
@@ -845,6 +972,7 @@ xmltree2cbuf(cbuf  *cb,
  */
 static int
 _xml_parse(const char *str,
+           FILE       *fp,
            yang_bind   yb,
            yang_stmt  *yspec,
            cxobj      *xt,
@@ -857,65 +985,44 @@ _xml_parse(const char *str,
     int             failed = 0; /* yang assignment */
     int             i;
 
-    clixon_debug(CLIXON_DBG_PARSE, "%s", str);
-    if (strlen(str) == 0){
-        return 1; /* OK */
+    if (fp == NULL){
+        clixon_debug(CLIXON_DBG_PARSE, "%s", str);
+        if (strlen(str) == 0){
+            return 1; /* OK */
+        }
     }
     if (xt == NULL){
         clixon_err(OE_XML, errno, "Unexpected NULL XML");
         return -1;
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
+    if (fp != NULL)
+        xy.xy_parse_file = fp;
+    else if ((xy.xy_parse_string = strdup(str)) == NULL){
         clixon_err(OE_XML, errno, "strdup");
         return -1;
     }
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
     xy.xy_yspec = yspec;
+    xy.xy_yb = (yb == YB_RPC) ? YB_NONE : yb;
     if (clixon_xml_parsel_init(&xy) < 0)
         goto done;
     if (clixon_xml_parseparse(&xy) != 0)  /* yacc returns 1 on error */
         goto done;
+    if (fp != NULL && ferror(fp)){
+        clixon_err(OE_XML, errno, "fread");
+        goto done;
+    }
     /* Purge all top-level body objects */
     x = NULL;
     while ((x = xml_find_type(xt, NULL, "body", CX_BODY)) != NULL)
         xml_purge(x);
-    /* Traverse new objects */
-    for (i = 0; i < xy.xy_xlen; i++) {
-        x = xy.xy_xvec[i];
-        /* Verify namespaces after parsing */
-        if (xml2ns_recurse(x) < 0)
-            goto done;
-        /* Populate, ie associate xml nodes with yang specs
-         */
-        switch (yb){
-        case YB_NONE:
-            break;
-        case YB_PARENT:
-            /* xt:n         Has spec
-             * x:   <a> <-- populate from parent
-             */
-            if ((ret = xml_bind_yang0(NULL, x, YB_PARENT, NULL, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        case YB_MODULE_NEXT:
-            if ((ret = xml_bind_yang(NULL, x, YB_MODULE, yspec, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        case YB_MODULE:
-            /* xt:<top>     nospec
-             * x:   <a> <-- populate from modules
-             */
-            if ((ret = xml_bind_yang0(NULL, x, YB_MODULE, yspec, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        case YB_RPC:
+    switch (yb){
+    case YB_NONE:
+        break;
+    case YB_RPC:
+        for (i = 0; i < xy.xy_xlen; i++) {
+            x = xy.xy_xvec[i];
             if ((ret = xml_bind_yang_rpc(NULL, x, yspec, xerr)) < 0)
                 goto done;
             if (ret == 0){ /* Add message-id */
@@ -923,16 +1030,30 @@ _xml_parse(const char *str,
                     goto done;
                 failed++;
             }
-            break;
-        } /* switch */
-    }
+        }
+        break;
+    default:
+        /* Bound while parsing, make error message of first failure now that parser is done */
+        if ((x = xy.xy_xfailed) != NULL){
+            if (xml_bind_yang_node(NULL, x, xy.xy_ybfailed, yspec, NULL, xerr) < 0)
+                goto done;
+            failed++;
+        }
+        break;
+    } /* switch */
     if (failed)
         goto fail;
     /* Sort the complete tree after parsing. Sorting is not really meaningful if Yang
-       not bound */
-    if (yb != YB_NONE)
+       not bound. Sub-trees are sorted while parsing, except rpc */
+    if (yb == YB_RPC){
         if (xml_sort_recurse(xt) < 0)
             goto done;
+    }
+    else if (yb != YB_NONE){
+        if (xml_sort_verify(xt, NULL) == -1 &&
+            xml_sort(xt) < 0)
+            goto done;
+    }
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
@@ -949,6 +1070,7 @@ _xml_parse(const char *str,
 
 /*! Read an XML definition from file and parse it into a parse-tree, advanced API
  *
+ * The file is read in blocks while parsing, it is not read into memory first
  * @param[in]     fd    A file descriptor containing the XML file (as ASCII characters)
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
@@ -981,14 +1103,6 @@ clixon_xml_parse_file(FILE      *fp,
                       cxobj    **xerr)
 {
     int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   oldxmlbuflen;
-    int   failed = 0;
     int   xtempty; /* empty on entry */
 
     if (xt == NULL || fp == NULL){
@@ -1000,49 +1114,15 @@ clixon_xml_parse_file(FILE      *fp,
         clixon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
         return -1;
     }
-    if ((xmlbuf = malloc(xmlbuflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
-        goto done;
-    }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret != 0){
-            xmlbuf[len++] = ch;
-        }
-        if (ret == 0) {
-            if (*xt == NULL)
-                if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if ((ret = _xml_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        }
-        if (len >= xmlbuflen-1){ /* Space: one for the null character */
-            oldxmlbuflen = xmlbuflen;
-            xmlbuflen *= 2;
-            if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-            ptr = xmlbuf;
-        }
-    } /* while */
-    retval = (failed==0) ? 1 : 0;
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    retval = _xml_parse(NULL, fp, yb, yspec, *xt, xerr);
  done:
     if (retval < 0 && *xt && xtempty){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
-    if (xmlbuf)
-        free(xmlbuf);
     return retval;
 }
 
@@ -1091,7 +1171,7 @@ clixon_xml_parse_string(const char *str,
         if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
             return -1;
     }
-    return _xml_parse(str, yb, yspec, *xt, xerr);
+    return _xml_parse(str, NULL, yb, yspec, *xt, xerr);
 }
 
 /*! Read XML from var-arg list and parse it into xml tree
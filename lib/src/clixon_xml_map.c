@@ -2089,6 +2089,7 @@ yang_check_when_xpath(cxobj        *xn,
     int        nr = 0;
     cvec      *nsc = NULL;
     int        variant = 0;   /* ugly help variable to clean temporary object */
+    struct xpath_tree *xpt = NULL;
 
     if (yang_when_canonical_xpath_get(yn, &xpath, &nsc) < 0)
         goto done;
@@ -2113,11 +2114,17 @@ yang_check_when_xpath(cxobj        *xn,
             x = xn;
         if (xml_nsctx_yang(yn, &nsc) < 0)
             goto done;
+        if (yang_xpath_tree_get(yc, &xpt) < 0)
+            goto done;
         *hit = 1;
     }
     else
         *hit = 0;
-    if (x && xpath){
+    if (x && xpt){ /* Parse tree kept in when statement */
+        if ((nr = xpath_vec_bool_tree(x, nsc, xpt)) < 0)
+            goto done;
+    }
+    else if (x && xpath){
         if ((nr = xpath_vec_bool(x, nsc, "%s", xpath)) < 0)
             goto done;
     }
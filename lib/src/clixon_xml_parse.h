@@ -46,6 +46,7 @@
 /*! XML parser yacc handler struct */
 struct clixon_xml_parse_yacc {
     char       *xy_parse_string; /* original (copy of) parse string */
+    FILE       *xy_parse_file;   /* If set, read from file instead of parse string */
     int         xy_linenum;      /* Number of \n in parsed buffer */
     void       *xy_lexbuf;       /* internal parse buffer from lex */
     cxobj      *xy_xtop;         /* cxobj top element (fixed) */
@@ -55,6 +56,9 @@ struct clixon_xml_parse_yacc {
     int         xy_lex_state;    /* lex return state */
     cxobj     **xy_xvec;         /* Vector of created top-level nodes (to know which are created) */
     int         xy_xlen;         /* Length of xy_xvec */
+    yang_bind   xy_yb;           /* Bind yang to elements while parsing, or YB_NONE */
+    cxobj      *xy_xfailed;      /* First element where yang binding failed */
+    yang_bind   xy_ybfailed;     /* How xy_xfailed was bound */
 };
 typedef struct clixon_xml_parse_yacc clixon_xml_yacc;
 
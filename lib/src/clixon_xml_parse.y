@@ -84,6 +84,8 @@
 #include "clixon_string.h"
 #include "clixon_handle.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_bind.h"
 #include "clixon_xml_parse.h"
 
 /* Enable for debugging, steals some cycles otherwise */
@@ -260,6 +262,100 @@ xml_parse_prefixed_name(clixon_xml_yacc *xy,
     return retval;
 }
 
+/*! Start-tag of element with attributes is parsed: check prefix and bind yang
+ *
+ * Elements are bound in document order, ie parent before children as xml_bind_yang0.
+ * Binding errors are not reported here since creating the error message invokes the parser
+ * which is not re-entrant. Instead, binding stops and the failed element is saved.
+ * @param[in] xy  XML parser yacc handler struct
+ * @retval    0   OK
+ * @retval   -1   Error
+ * @see _xml_parse  where a binding failure is reported
+ */
+static int
+xml_parse_element_start(clixon_xml_yacc *xy)
+{
+    int        retval = -1;
+    cxobj     *x = xy->xy_xelement;
+    cxobj     *xp;
+    cxobj     *xs = NULL;
+    char      *prefix;
+    char      *ns;
+    yang_bind  yb;
+    int        i;
+    int        ret;
+
+    xp = xml_parent(x);
+    /* Top-level elements are not checked, see xml2ns_recurse */
+    if (xp != xy->xy_xtop &&
+        (prefix = xml_prefix(x)) != NULL){
+        ns = NULL;
+        if (xml2ns(x, prefix, &ns) < 0)
+            goto done;
+        if (ns == NULL){
+            clixon_err(OE_XML, ENOENT, "No namespace associated with %s:%s", prefix, xml_name(x));
+            goto done;
+        }
+    }
+    if (xy->xy_yb == YB_NONE || xy->xy_xfailed != NULL)
+        goto ok;
+    if (xp == xy->xy_xtop){
+        if (xy->xy_yb == YB_MODULE_NEXT)
+            goto ok;
+        yb = xy->xy_yb;
+    }
+    else if (xy->xy_yb == YB_MODULE_NEXT && xml_parent(xp) == xy->xy_xtop)
+        yb = YB_MODULE;
+    else if (xml_spec(xp) != NULL)
+        yb = YB_PARENT;
+    else /* Parent is anydata or not bound */
+        goto ok;
+    /* Use previous sibling with same name as role model, see xml_bind_yang0_opt */
+    if (yb == YB_PARENT &&
+        (i = xml_child_nr(xp)) > 1){
+        xs = xml_child_i(xp, i-2);
+        if (xml_type(xs) != CX_ELMNT ||
+            xml_spec(xs) == NULL ||
+            clicon_strcmp(xml_name(xs), xml_name(x)) != 0 ||
+            clicon_strcmp(xml_prefix(xs), xml_prefix(x)) != 0)
+            xs = NULL;
+    }
+    if ((ret = xml_bind_yang_node(NULL, x, yb, xy->xy_yspec, xs, NULL)) < 0)
+        goto done;
+    if (ret == 0){
+        xy->xy_xfailed = x;
+        xy->xy_ybfailed = yb;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Element is complete: complete yang binding and sort its children
+ *
+ * Sorting each element when it is complete replaces xml_sort_recurse after parsing
+ * @param[in] xy  XML parser yacc handler struct
+ * @param[in] x   Complete element
+ * @retval    0   OK
+ * @retval   -1   Error
+ */
+static int
+xml_parse_element_end(clixon_xml_yacc *xy,
+                      cxobj           *x)
+{
+    if (xy->xy_yb == YB_NONE)
+        return 0;
+    if (xml_spec(x) != NULL &&
+        xml_bind_yang_node_done(x) < 0)
+        return -1;
+    if (xy->xy_xfailed == NULL &&
+        xml_sort_verify(x, NULL) == -1 &&
+        xml_sort(x) < 0)
+        return -1;
+    return 0;
+}
+
 static int
 xml_parse_endslash_pre(clixon_xml_yacc *xy)
 {
@@ -334,6 +430,8 @@ xml_parse_bslash(clixon_xml_yacc *xy,
         if (xml_rm_children(x, CX_BODY) < 0) /* remove all bodies */
             goto done;
     }
+    if (xml_parse_element_end(xy, x) < 0)
+        goto done;
     retval = 0;
   done:
     if (prefix)
@@ -435,7 +533,9 @@ sddecl      : SD '=' '\"' STRING '\"' {if ($4)free($4);}
             |
             ;
 /* [39] element ::= EmptyElemTag | STag content ETag */
-element     : '<' qname  attrs element1
+element     : '<' qname  attrs
+                   { if (xml_parse_element_start(_XY) < 0) YYABORT; }
+              element1
                    { _PARSE_DEBUG("element -> < qname attrs element1"); }
             ;
 
@@ -445,7 +545,8 @@ qname       : NAME           { if (xml_parse_prefixed_name(_XY, NULL, $1) < 0) Y
                                 _PARSE_DEBUG("qname -> NAME : NAME");}
             ;
 
-element1    :  ESLASH         {_XY->xy_xelement = NULL;
+element1    :  ESLASH         { if (xml_parse_element_end(_XY, _XY->xy_xelement) < 0) YYABORT;
+                               _XY->xy_xelement = NULL;
                                _PARSE_DEBUG("element1 -> />");}
             | '>'             { xml_parse_endslash_pre(_XY); }
               elist           { xml_parse_endslash_mid(_XY); }
@@ -59,6 +59,7 @@
 #include "clixon_map.h"
 #include "clixon_queue.h"
 #include "clixon_hash.h"
+#include "clixon_intern.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
@@ -77,20 +78,21 @@
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 
-/*! Get xml body value as cligen variable
+/*! Parse xml body value into typed cligen variable and cache it
  *
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[out] cvp Pointer to cligen variable containing value of x body
- * @retval     0   OK, cvp contains cv or NULL
- * @retval    -1   Error
- * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Move to clixon_xml.c?
- * As a side-effect sets the cache.
- * Clear cache with xml_cv_set(x, NULL)
+ * @param[in]  x      XML node (body and leaf/leaf-list)
+ * @param[in]  body   Body of x
+ * @param[out] cvp    Cached typed value
+ * @param[out] reason If retval = 0, reason for parse failure, free with free()
+ * @retval     1      OK
+ * @retval     0      Value could not be parsed, reason set
+ * @retval    -1      Error
  */
 static int
-xml_cv_cache(cxobj   *x,
-             cg_var **cvp)
+xml_cv_parse(cxobj   *x,
+             char    *body,
+             cg_var **cvp,
+             char   **reason)
 {
     int          retval = -1;
     cg_var      *cv = NULL;
@@ -98,15 +100,9 @@ xml_cv_cache(cxobj   *x,
     yang_stmt   *yrestype;
     enum cv_type cvtype;
     int          ret;
-    char        *reason=NULL;
     int          options = 0;
     uint8_t      fraction = 0;
-    char        *body;
 
-    if ((body = xml_body(x)) == NULL)
-        body="";
-    if ((cv = xml_cv(x)) != NULL)
-        goto ok;
     if ((y = xml_spec(x)) == NULL){
         clixon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
         goto done;
@@ -125,42 +121,143 @@ xml_cv_cache(cxobj   *x,
     }
     if (cvtype == CGV_DEC64)
         cv_dec64_n_set(cv, fraction);
-    if ((ret = cv_parse1(body, cv, &reason)) < 0){
+    if ((ret = cv_parse1(body, cv, reason)) < 0){
         clixon_err(OE_YANG, errno, "cv_parse1");
         goto done;
     }
     if (ret == 0){
-        clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
+        retval = 0;
         goto done;
     }
     if (xml_cv_set(x, cv) < 0)
         goto done;
- ok:
     *cvp = cv;
     cv = NULL;
+    retval = 1;
+ done:
+    if (cv)
+        cv_free(cv);
+    return retval;
+}
+
+/*! Get xml body value as cligen variable
+ *
+ * @param[in]  x   XML node (body and leaf/leaf-list)
+ * @param[out] cvp Pointer to cligen variable containing value of x body
+ * @retval     0   OK, cvp contains cv or NULL
+ * @retval    -1   Error
+ * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
+ * As a side-effect sets the cache, which is kept until the body or yang spec of x changes
+ * @see xml_cv_cache_bind  Set the cache when yang is bound
+ */
+int
+xml_cv_cache(cxobj   *x,
+             cg_var **cvp)
+{
+    int          retval = -1;
+    cg_var      *cv = NULL;
+    int          ret;
+    char        *reason=NULL;
+    char        *body;
+
+    if ((cv = xml_cv(x)) != NULL)
+        goto ok;
+    if ((body = xml_body(x)) == NULL)
+        body="";
+    if ((ret = xml_cv_parse(x, body, &cv, &reason)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
+        goto done;
+    }
+ ok:
+    *cvp = cv;
     retval = 0;
  done:
     if (reason)
         free(reason);
-    if (cv)
-        cv_free(cv);
     return retval;
 }
 
-static int
-xml_cv_cache_clear(cxobj *xt)
+/*! Set typed value cache of typed leaves and leaf-lists when yang spec is bound
+ *
+ * List keys and leaf-lists are compared when sorting and searching, see xml_cmp,
+ * other leaves are checked by validation, see xml_yang_validate_add.
+ * Non-key leaves of string type are not cached since the value would only be a
+ * copy of the body, nor union or leafref types which are re-parsed per resolved type.
+ * Values that cannot be parsed are left uncached for validation to report.
+ * @param[in]  x   XML node with yang spec
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see xml_cv_cache
+ */
+int
+xml_cv_cache_bind(cxobj *x)
 {
-    int    retval = -1;
-    cxobj *x = NULL;
+    int        retval = -1;
+    yang_stmt *y;
+    yang_stmt *yp;
+    cg_var    *cvi = NULL;
+    cg_var    *cv = NULL;
+    cg_var    *ycv;
+    char      *body;
+    char      *reason = NULL;
 
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
-        if (xml_cv_set(x, NULL) < 0)
-            goto done;
+    if ((y = xml_spec(x)) == NULL ||
+        xml_cv(x) != NULL ||
+        (body = xml_body(x)) == NULL)
+        goto ok;
+    switch (yang_keyword_get(y)){
+    case Y_LEAF_LIST:
+        break;
+    case Y_LEAF:
+        /* List keys, use Y_LIST cache, see ys_populate_list() */
+        if ((yp = yang_parent_get(y)) != NULL &&
+            yang_keyword_get(yp) == Y_LIST){
+            while ((cvi = cvec_each(yang_cvec_get(yp), cvi)) != NULL)
+                if (strcmp(cv_string_get(cvi), yang_argument_get(y)) == 0)
+                    break;
+            if (cvi != NULL)
+                break;
+        }
+        /* Other leaves: resolved type from ys_populate_leaf() */
+        if ((ycv = yang_cv_get(y)) == NULL ||
+            cv_type_get(ycv) == CGV_STRING ||
+            cv_type_get(ycv) == CGV_REST)
+            goto ok;
+        break;
+    default:
+        goto ok;
+    }
+    if (xml_cv_parse(x, body, &cv, &reason) < 0)
+        goto done;
+ ok:
     retval = 0;
  done:
+    if (reason)
+        free(reason);
     return retval;
 }
 
+/*! Find child given interned name, as xml_find
+ *
+ * @param[in]  xp     XML parent
+ * @param[in]  iname  Interned name, see clixon_intern_find
+ * @retval     xc     Child with name
+ * @retval     NULL   Not found
+ */
+static inline cxobj *
+xml_find_interned(cxobj *xp,
+                  char  *iname)
+{
+    cxobj *xc = NULL;
+
+    while ((xc = xml_child_each(xp, xc, -1)) != NULL)
+        if (xml_name(xc) == iname)
+            break;
+    return xc;
+}
+
 /*! Help function to qsort for sorting entries in xml child vector same parent
  *
  * @param[in]  x1    object 1
@@ -329,8 +426,8 @@ xml_cmp(cxobj  *x1,
     case Y_LIST: /* Match with key values  */
         if (indexvar != NULL){
 #ifdef XML_EXPLICIT_INDEX
-            x1b = xpath_first(x1, 0, "%s", indexvar);
-            x2b = xpath_first(x2, 0, "%s", indexvar);
+            x1b = xml_search_index_leaf(x1, indexvar);
+            x2b = xml_search_index_leaf(x2, indexvar);
             if (x1b == NULL && x2b == NULL)
                 ;
             else if (x1b == NULL)
@@ -351,8 +448,15 @@ xml_cmp(cxobj  *x1,
                         goto done;
                     if (xml_cv_cache(x2b, &cv2) < 0) /* error case */
                         goto done;
-                    assert(cv1 && cv2);
-                    equal = cv_cmp(cv1, cv2);
+                    /* Untyped, eg invalid, values first */
+                    if (cv1 != NULL && cv2 != NULL)
+                        equal = cv_cmp(cv1, cv2);
+                    else if (cv1 == NULL && cv2 == NULL)
+                        equal = strcmp(b1, b2);
+                    else if (cv1 == NULL)
+                        equal = -1;
+                    else
+                        equal = 1;
                 }
             }
             if (equal)
@@ -364,12 +468,14 @@ xml_cmp(cxobj  *x1,
         cvk = yang_cvec_get(y1); /* Use Y_LIST cache, see ys_populate_list() */
         cvi = NULL;
         while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-            keyname = cv_string_get(cvi); /* operational data may have NULL keys*/
-            x1b = xml_find(x1, keyname);
+            /* Names are interned: if key name is not, neither x1 nor x2 have the key */
+            if ((keyname = clixon_intern_find(cv_string_get(cvi))) == NULL)
+                continue;
+            x1b = xml_find_interned(x1, keyname); /* operational data may have NULL keys*/
             /* match1: key matching skipped for keys not in x1 (see explanation) */
             if (skip1 && x1b == NULL)
                 continue;
-            x2b = xml_find(x2, keyname);
+            x2b = xml_find_interned(x2, keyname);
             if (x1b == NULL && x2b == NULL)
                 ;
             else if (x1b == NULL)
@@ -486,8 +592,6 @@ xml_sort_recurse(cxobj *xn)
         if (ret == 1) /* This node is not sortable */
             goto ok;
     }
-    if (xml_cv_cache_clear(xn) < 0)
-        goto done;
     x = NULL;
     while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
         if (xml_sort_recurse(x) < 0)
@@ -620,6 +724,7 @@ search_multi_equals_xvec(clixon_xvec  *childvec,
                          int           yangi,
                          int           mid,
                          int           skip1,
+                         char         *indexvar,
                          clixon_xvec  *xvec)
 {
     int        retval = -1;
@@ -635,7 +740,7 @@ search_multi_equals_xvec(clixon_xvec  *childvec,
             goto done;
         if (yangi != yi) /* wrong yang */
             break;
-        if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
+        if (xml_cmp(x1, xc, 0, skip1, indexvar) != 0)
             break;
         if (clixon_xvec_prepend(xvec, xc) < 0)
             goto done;
@@ -647,7 +752,7 @@ search_multi_equals_xvec(clixon_xvec  *childvec,
             goto done;
         if (yangi != yi) /* wrong yang */
             break;
-        if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
+        if (xml_cmp(x1, xc, 0, skip1, indexvar) != 0)
             break;
         if (clixon_xvec_append(xvec, xc) < 0)
             goto done;
@@ -758,7 +863,7 @@ xml_search_indexvar(cxobj   *xp,
                 goto done;
             /* there may be more? */
             if (search_multi_equals_xvec(ivec, x1, yangi, pos,
-                                         0, xvec) < 0)
+                                         0, indexvar, xvec) < 0)
                 goto done;
         }
     }
@@ -875,11 +980,23 @@ xml_search_yang(cxobj       *xp,
     int    upper = xml_child_nr(xp);
     int    sorted = 1;
     int    yangi;
+#ifdef XML_HASH_INDEX
+    int    ret;
+#endif
 
     if (xp == NULL){
         clixon_err(OE_XML, EINVAL, "xp is NULL");
         goto done;
     }
+#ifdef XML_HASH_INDEX
+    if (indexvar == NULL &&
+        (yang_keyword_get(yc) == Y_LIST || yang_keyword_get(yc) == Y_LEAF_LIST)){
+        if ((ret = xml_hash_index_search(xp, yc, x1, xvec)) < 0)
+            goto done;
+        if (ret == 1) /* Search made using hash index */
+            goto ok;
+    }
+#endif
     upper = xml_child_nr(xp);
     /* Assume if there are any attributes, they are first in the list, mask
        them by raising low to skip them */
@@ -898,6 +1015,9 @@ xml_search_yang(cxobj       *xp,
         goto done;
     if (xml_search_binary(xp, x1, sorted, yangi, low, upper, skip1, indexvar, xvec) < 0)
         goto done;
+#ifdef XML_HASH_INDEX
+ ok:
+#endif
     retval = 0;
  done:
     return retval;
@@ -1109,6 +1229,7 @@ xml_insert(cxobj           *xp,
 {
     int        retval = -1;
     cxobj     *xa;
+    cxobj     *xlast;
     int        low = 0;
     int        upper;
     yang_stmt *y;
@@ -1143,9 +1264,16 @@ xml_insert(cxobj           *xp,
             userorder = (yang_find(y, Y_ORDERED_BY, "user") != NULL);
     if ((yi = yang_order(y)) < -1)
         goto done;
-    if ((i = xml_insert2(xp, xi, y, yi,
-                         userorder, ins, key_val, nsc_key,
-                         low, upper)) < 0)
+    /* Fast path if xi is after the last child, eg when entries are created in order */
+    if (!userorder &&
+        upper > low &&
+        (xlast = xml_child_i(xp, upper-1)) != NULL &&
+        xml_spec(xlast) == y &&
+        xml_cmp(xi, xlast, 0, 0, NULL) > 0)
+        i = upper;
+    else if ((i = xml_insert2(xp, xi, y, yi,
+                              userorder, ins, key_val, nsc_key,
+                              low, upper)) < 0)
         goto done;
     if (xml_child_insert_pos(xp, xi, i) < 0)
         goto done;
@@ -1364,6 +1492,90 @@ xml_find_noyang_name(cxobj       *xp,
     return retval;
 }
 
+#ifdef XML_EXPLICIT_INDEX
+/*! Create node of search object for yang node y, and its ancestors up to yang list
+ *
+ * @param[in]  xe    Search object (list entry)
+ * @param[in]  ylist Yang list
+ * @param[in]  y     Yang node below list
+ * @retval     x     Node of y in search object
+ * @retval     NULL  Error
+ */
+static cxobj *
+xml_search_object(cxobj     *xe,
+                  yang_stmt *ylist,
+                  yang_stmt *y)
+{
+    cxobj     *xp = xe;
+    cxobj     *x;
+    yang_stmt *yp;
+
+    yp = yang_parent_get(y);
+    while (yang_keyword_get(yp) == Y_CHOICE || yang_keyword_get(yp) == Y_CASE)
+        yp = yang_parent_get(yp);
+    if (yp != ylist &&
+        (xp = xml_search_object(xe, ylist, yp)) == NULL)
+        return NULL;
+    if ((x = xml_new(yang_argument_get(y), xp, CX_ELMNT)) == NULL)
+        return NULL;
+    xml_spec_set(x, y);
+    return x;
+}
+
+/*! Find list entries using explicit search index of list
+ *
+ * Construct a dummy search object with the index variable, eg <y><x><i>42</i></x></y> for 
+ * index x/i, and find it in the search index vector of xp using binary search.
+ * @param[in]  xp    Parent xml node.
+ * @param[in]  yc    Yang spec of list
+ * @param[in]  cvk   Single index variable and value, eg x/i=42
+ * @param[out] xvec  Array of found nodes
+ * @retval     1     OK
+ * @retval     0     Revert, not a search index, try again with no-yang search
+ * @retval    -1     Error
+ */
+static int
+xml_find_index_explicit(cxobj       *xp,
+                        yang_stmt   *yc,
+                        cvec        *cvk,
+                        clixon_xvec *xvec)
+{
+    int        retval = -1;
+    cg_var    *cvi;
+    char      *iname;
+    yang_stmt *yi;
+    cxobj     *xc = NULL;
+    cxobj     *xi;
+    cxobj     *xb;
+
+    if (yang_keyword_get(yc) != Y_LIST ||
+        cvec_len(cvk) != 1 ||
+        (cvi = cvec_i(cvk, 0)) == NULL ||
+        (iname = cv_name_get(cvi)) == NULL ||
+        (yi = yang_search_index_leaf(yc, iname)) == NULL)
+        goto revert;
+    if ((xc = xml_new(yang_argument_get(yc), NULL, CX_ELMNT)) == NULL)
+        goto done;
+    xml_spec_set(xc, yc);
+    if ((xi = xml_search_object(xc, yc, yi)) == NULL)
+        goto done;
+    if ((xb = xml_new("body", xi, CX_BODY)) == NULL)
+        goto done;
+    if (xml_value_set(xb, cv_string_get(cvi)) < 0)
+        goto done;
+    if (xml_search_yang(xp, xc, yc, 1, iname, xvec) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (xc)
+        xml_free(xc);
+    return retval;
+ revert:
+    retval = 0;
+    goto done;
+}
+#endif /* XML_EXPLICIT_INDEX */
+
 /*! Try to find an XML child from parent with yang available using list keys and leaf-lists
  *
  * Must be populated with Yang specs, parent must be list or leaf-list, and (for list) search
@@ -1400,7 +1612,6 @@ xml_find_index_yang(cxobj       *xp,
     char      *name;
     char      *encstr;
     int        revert = 0;
-    char      *indexvar = NULL;
 
     if (xp == NULL){
         clixon_err(OE_XML, EINVAL, "xp is NULL");
@@ -1460,20 +1671,9 @@ xml_find_index_yang(cxobj       *xp,
     }
 #ifdef XML_EXPLICIT_INDEX
     if (revert){
-        char      *iname;
-        yang_stmt *yi;
-        if (cvec_len(cvk) != 1 ||
-            (cvi = cvec_i(cvk, 0)) == NULL ||
-            (iname = cv_name_get(cvi)) == NULL ||
-            (yi = yang_find_datanode(yc, iname)) == NULL ||
-            yang_flag_get(yi, YANG_FLAG_INDEX) == 0)
+        if ((retval = xml_find_index_explicit(xp, yc, cvk, xvec)) == 0)
             goto revert;
-        cbuf_reset(cb);
-        if (xml_chardata_encode(&encstr, 0, "%s", cv_string_get(cvi)) < 0)
-            goto done;
-        cprintf(cb, "<%s><%s>%s</%s></%s>", name, iname, encstr, iname, name);
-        free(encstr);
-        indexvar = iname;
+        goto done;
     }
 #else
     if (revert)
@@ -1495,7 +1695,7 @@ xml_find_index_yang(cxobj       *xp,
         if (xml_spec_set(xk, yk) < 0)
             goto done;
     }
-    if (xml_search_yang(xp, xc, yc, 1, indexvar, xvec) < 0)
+    if (xml_search_yang(xp, xc, yc, 1, NULL, xvec) < 0)
         goto done;
     retval = 1; /* OK */
  done:
@@ -1532,6 +1732,8 @@ xml_find_index_yang(cxobj       *xp,
  * - if xp is a yang list and "id" is a registered index key
  * - if xp is a yang list and first "id" is first leaf key, second "id" is second leaf key, etc.
  * - Otherwise search is made using linear search
+ * With XML_HASH_INDEX, list and leaf-list searches with all keys use a hash index instead of
+ * binary search if xp has many children, see xml_hash_index_search
  * 
  * @param[in]  xp     Parent xml node. 
  * @param[in]  yp     Yang spec of parent node or yang-spec/yang (Alternative if yc not given).
@@ -85,6 +85,7 @@
 #include "clixon_map.h"
 #include "clixon_queue.h"
 #include "clixon_hash.h"
+#include "clixon_intern.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
@@ -525,8 +526,12 @@ xpath_tree_free(xpath_tree *xs)
         free(xs->xs_strnr);
     if (xs->xs_s0)
         free(xs->xs_s0);
-    if (xs->xs_s1)
-        free(xs->xs_s1);
+    if (xs->xs_s1){
+        if (xs->xs_type == XP_NODE)
+            clixon_intern_free(xs->xs_s1);
+        else
+            free(xs->xs_s1);
+    }
     if (xs->xs_c0)
         xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
@@ -602,6 +607,301 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+#ifdef XPATH_CACHE_SIZE
+/* Cached parse tree of an XPath expression, see xpath_cache_get
+ */
+struct xpath_cache_entry{
+    qelem_t                   xe_q;     /* LRU queue, most recently used first */
+    struct xpath_cache_entry *xe_next;  /* Next in hash bucket */
+    char                     *xe_xpath; /* XPath expression */
+    uint32_t                  xe_hash;  /* Hash of xe_xpath */
+    xpath_tree               *xe_tree;  /* Parse tree of xe_xpath */
+    int                       xe_ref;   /* Ongoing evaluations using xe_tree, not evicted if > 0 */
+};
+
+/* Cache of parse trees of the most recently used XPath expressions */
+static struct xpath_cache_entry *_xpath_cache_lru = NULL;
+static struct xpath_cache_entry *_xpath_cache_bucket[XPATH_CACHE_SIZE] = {NULL,};
+static int                       _xpath_cache_nr = 0;
+
+/*! FNV-1a hash of string
+ */
+static uint32_t
+xpath_cache_hash(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Remove and free a cache entry
+ */
+static void
+xpath_cache_entry_free(struct xpath_cache_entry *xe)
+{
+    struct xpath_cache_entry **xp;
+
+    xp = &_xpath_cache_bucket[xe->xe_hash % XPATH_CACHE_SIZE];
+    while (*xp != xe)
+        xp = &(*xp)->xe_next;
+    *xp = xe->xe_next;
+    DELQ(xe, _xpath_cache_lru, struct xpath_cache_entry *);
+    _xpath_cache_nr--;
+    if (xe->xe_tree)
+        xpath_tree_free(xe->xe_tree);
+    if (xe->xe_xpath)
+        free(xe->xe_xpath);
+    free(xe);
+}
+
+/*! Get parse tree of an XPath expression from cache, parse and add it if not found
+ *
+ * The entry is referenced and not evicted until released
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[out] xep    Cache entry, release with xpath_cache_release
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_cache_get(const char                *xpath,
+                struct xpath_cache_entry **xep)
+{
+    int                       retval = -1;
+    struct xpath_cache_entry *xe;
+    struct xpath_cache_entry *xl;
+    uint32_t                  h;
+
+    if (xpath == NULL){
+        clixon_err(OE_XML, EINVAL, "XPath is NULL");
+        goto done;
+    }
+    h = xpath_cache_hash(xpath);
+    for (xe = _xpath_cache_bucket[h % XPATH_CACHE_SIZE]; xe; xe = xe->xe_next)
+        if (xe->xe_hash == h && strcmp(xe->xe_xpath, xpath) == 0)
+            break;
+    if (xe != NULL){
+        if (xe != _xpath_cache_lru){
+            DELQ(xe, _xpath_cache_lru, struct xpath_cache_entry *);
+            INSQ(xe, _xpath_cache_lru);
+        }
+    }
+    else {
+        /* Evict least recently used entries not in use */
+        xl = _xpath_cache_lru ? PREVQ(struct xpath_cache_entry *, _xpath_cache_lru) : NULL;
+        while (_xpath_cache_nr >= XPATH_CACHE_SIZE && xl != NULL){
+            xe = xl;
+            xl = (xl == _xpath_cache_lru) ? NULL : PREVQ(struct xpath_cache_entry *, xl);
+            if (xe->xe_ref == 0)
+                xpath_cache_entry_free(xe);
+        }
+        if ((xe = calloc(1, sizeof(*xe))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if (xpath_parse(xpath, &xe->xe_tree) < 0 ||
+            (xe->xe_xpath = strdup(xpath)) == NULL){
+            if (xe->xe_xpath == NULL && xe->xe_tree != NULL)
+                clixon_err(OE_UNIX, errno, "strdup");
+            if (xe->xe_tree)
+                xpath_tree_free(xe->xe_tree);
+            free(xe);
+            goto done;
+        }
+        xe->xe_hash = h;
+        xe->xe_next = _xpath_cache_bucket[h % XPATH_CACHE_SIZE];
+        _xpath_cache_bucket[h % XPATH_CACHE_SIZE] = xe;
+        INSQ(xe, _xpath_cache_lru);
+        _xpath_cache_nr++;
+    }
+    xe->xe_ref++;
+    *xep = xe;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Release a cache entry referenced by xpath_cache_get
+ */
+static void
+xpath_cache_release(struct xpath_cache_entry *xe)
+{
+    if (xe->xe_ref > 0)
+        xe->xe_ref--;
+}
+#endif /* XPATH_CACHE_SIZE */
+
+/*! Free the cache of parsed XPath expressions
+ *
+ * Call at exit
+ */
+void
+xpath_cache_exit(void)
+{
+#ifdef XPATH_CACHE_SIZE
+    while (_xpath_cache_lru != NULL)
+        xpath_cache_entry_free(_xpath_cache_lru);
+#endif
+}
+
+/*! Evaluate a parsed xpath on an XML tree and return xpath context
+ *
+ * @param[in]  xcur      XML-tree where to search
+ * @param[in]  nsc       External XML namespace context, or NULL
+ * @param[in]  xptree    Parsed XPath, eg from xpath_parse or yang_xpath_tree_get
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp       Return XPath context
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see xpath_vec_ctx  for an xpath string
+ */
+int
+xpath_vec_ctx_tree(cxobj      *xcur,
+                   cvec       *nsc,
+                   xpath_tree *xptree,
+                   int         localonly,
+                   xp_ctx    **xrp)
+{
+    int    retval = -1;
+    xp_ctx xc = {0,};
+
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+        goto done;
+    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xc.xc_nodeset){
+        free(xc.xc_nodeset);
+        xc.xc_nodeset = NULL;
+    }
+    return retval;
+}
+
+/*! Evaluate a parsed xpath on an XML tree and return nodeset as xml node vector
+ *
+ * If result is not nodeset, return empty nodeset
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xptree   Parsed XPath, eg from xpath_parse or yang_xpath_tree_get
+ * @param[out] vec      vector of xml-trees. Vector must be free():d after use
+ * @param[out] veclen   returns length of vector in return value
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xpath_vec  for an xpath string
+ */
+int
+xpath_vec_tree(cxobj      *xcur,
+               cvec       *nsc,
+               xpath_tree *xptree,
+               cxobj    ***vec,
+               size_t     *veclen)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL;
+
+    *vec = NULL;
+    *veclen = 0;
+    if (xpath_vec_ctx_tree(xcur, nsc, xptree, 0, &xr) < 0)
+        goto done;
+    if (xr && xr->xc_type == XT_NODESET){
+        *vec    = xr->xc_nodeset;
+        xr->xc_nodeset = NULL;
+        *veclen = xr->xc_size;
+    }
+    retval = 0;
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Evaluate a parsed xpath on an XML tree and return boolean
+ *
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xptree   Parsed XPath, eg from xpath_parse or yang_xpath_tree_get
+ * @retval     1        True
+ * @retval     0        False
+ * @retval    -1        Error
+ * @see xpath_vec_bool  for an xpath string
+ */
+int
+xpath_vec_bool_tree(cxobj      *xcur,
+                    cvec       *nsc,
+                    xpath_tree *xptree)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL;
+
+    if (xpath_vec_ctx_tree(xcur, nsc, xptree, 0, &xr) < 0)
+        goto done;
+    if (xr)
+        retval = ctx2boolean(xr);
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Format an xpath string from a format string and arguments
+ *
+ * Only formats if needed, a format of "%s" returns the argument as is, unless it is NULL
+ * which is formatted as before
+ * @param[in]  xpformat Format string for XPath syntax
+ * @param[in]  ap       Arguments of format
+ * @param[out] xpath    XPath string
+ * @param[out] xalloc   Set to xpath if allocated, free after use
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+xpath_vformat(const char  *xpformat,
+              va_list      ap,
+              const char **xpath,
+              char       **xalloc)
+{
+    int     retval = -1;
+    va_list ap1;
+    size_t  len;
+    char   *str;
+
+    if (strcmp(xpformat, "%s") == 0){
+        va_copy(ap1, ap);
+        str = va_arg(ap1, char *);
+        va_end(ap1);
+        if (str != NULL){
+            *xpath = str;
+            goto ok;
+        }
+    }
+    va_copy(ap1, ap);
+    len = vsnprintf(NULL, 0, xpformat, ap1);
+    va_end(ap1);
+    /* allocate an xpath string exactly fitting the length */
+    if ((str = malloc(len+1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    /* second round: actually compute xpath string content */
+    if (vsnprintf(str, len+1, xpformat, ap) < 0){
+        clixon_err(OE_UNIX, errno, "vsnprintf");
+        free(str);
+        goto done;
+    }
+    *xpath = *xalloc = str;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Given XML tree and xpath, parse xpath, eval it and return xpath context, 
  *
  * This is a raw form of xpath where you can do type conversion of the return
@@ -620,6 +920,7 @@ xpath_parse(const char  *xpath,
  *   if (xc)
  *      ctx_free(xc);
  * @endcode
+ * @note Parse trees of recently used xpaths are cached, see XPATH_CACHE_SIZE
  */
 int
 xpath_vec_ctx(cxobj      *xcur, 
@@ -628,28 +929,34 @@ xpath_vec_ctx(cxobj      *xcur,
               int         localonly,
               xp_ctx    **xrp)
 {
-    int         retval = -1;
-    xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
-    
+    int                       retval = -1;
+#ifdef XPATH_CACHE_SIZE
+    struct xpath_cache_entry *xe = NULL;
+#else
+    xpath_tree               *xptree = NULL;
+#endif
+
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
-    if (xpath_parse(xpath, &xptree) < 0)
+#ifdef XPATH_CACHE_SIZE
+    if (xpath_cache_get(xpath, &xe) < 0)
         goto done;
-    xc.xc_type = XT_NODESET;
-    xc.xc_node = xcur;
-    xc.xc_initial = xcur;
-    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+    if (xpath_vec_ctx_tree(xcur, nsc, xe->xe_tree, localonly, xrp) < 0)
         goto done;
-    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+#else
+    if (xpath_parse(xpath, &xptree) < 0)
+        goto done;
+    if (xpath_vec_ctx_tree(xcur, nsc, xptree, localonly, xrp) < 0)
         goto done;
+#endif
     retval = 0;
  done:
-    if (xc.xc_nodeset){
-        free(xc.xc_nodeset);
-        xc.xc_nodeset = NULL;
-    }
+#ifdef XPATH_CACHE_SIZE
+    if (xe)
+        xpath_cache_release(xe);
+#else
     if (xptree)
         xpath_tree_free(xptree);
+#endif
     return retval;
 }
 
@@ -682,26 +989,16 @@ xpath_first(cxobj      *xcur,
 {
     cxobj     *cx = NULL;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    const char *xpath = NULL;
+    char      *xalloc = NULL;
+    int        ret;
     xp_ctx    *xr = NULL;
     
-    va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, xpformat);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clixon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
+    if (ret < 0)
         goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
@@ -709,8 +1006,8 @@ xpath_first(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xalloc)
+        free(xalloc);
     return cx;
 }
 
@@ -741,26 +1038,16 @@ xpath_first_localonly(cxobj      *xcur,
 {
     cxobj     *cx = NULL;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    const char *xpath = NULL;
+    char      *xalloc = NULL;
+    int        ret;
     xp_ctx    *xr = NULL;
     
-    va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, xpformat);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if (ret < 0)
         goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clixon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
-        goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, NULL, xpath, 1, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
@@ -768,8 +1055,8 @@ xpath_first_localonly(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xalloc)
+        free(xalloc);
     return cx;
 }
 
@@ -806,26 +1093,16 @@ xpath_vec(cxobj      *xcur,
 {
     int        retval = -1;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    const char *xpath = NULL;
+    char      *xalloc = NULL;
+    int        ret;
     xp_ctx    *xr = NULL; 
         
-    va_start(ap, veclen);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, veclen);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xalloc);
     va_end(ap);
-    /* allocate an xpath string exactly fitting the length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if (ret < 0)
         goto done;
-    }
-    /* second round: actually compute xpath string content */
-    va_start(ap, veclen);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clixon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
-        goto done;
-    }
-    va_end(ap);
     *vec = NULL;
     *veclen = 0;
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
@@ -839,8 +1116,8 @@ xpath_vec(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xalloc)
+        free(xalloc);
     return retval;
 }
 
@@ -880,29 +1157,19 @@ xpath_vec_flag(cxobj      *xcur,
 {
     int        retval = -1;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    const char *xpath = NULL;
+    char      *xalloc = NULL;
+    int        ret;
     xp_ctx    *xr = NULL;
     int        i;
     cxobj     *x;
     int        ilen = 0; /* change when cxvec_append uses size_t */
     
-    va_start(ap, veclen);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, veclen);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, veclen);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clixon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
+    if (ret < 0)
         goto done;
-    }
-    va_end(ap);
     *vec=NULL;
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
         goto done;
@@ -919,8 +1186,8 @@ xpath_vec_flag(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xalloc)
+        free(xalloc);
     return retval;
 }
 
@@ -942,26 +1209,16 @@ xpath_vec_bool(cxobj      *xcur,
 {
     int        retval = -1;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    const char *xpath = NULL;
+    char      *xalloc = NULL;
+    int        ret;
     xp_ctx    *xr = NULL;
     
-    va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, xpformat);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clixon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
+    if (ret < 0)
         goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
         goto done;
     if (xr)
@@ -969,8 +1226,8 @@ xpath_vec_bool(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xalloc)
+        free(xalloc);
     return retval;
 }
 
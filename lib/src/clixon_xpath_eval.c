@@ -132,16 +132,17 @@ nodetest_eval_node(cxobj      *x,
     /* Namespaces is s0, name is s1 */
     if (strcmp(xs->xs_s1, "*")==0)
         return 1;
-    /* get namespace of xml tree */
-    if (xml2ns(x, prefix1, &nsxml) < 0)
-        goto done;
     prefix2 = xs->xs_s0;
     name2 = xs->xs_s1;
-    /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) != 0){
+    /* Before going into namespaces, check name equality and filter out noteq
+     * Both names are interned, see clixon_intern */
+    if (name1 != name2){
         retval = 0; /* no match */
         goto done;
     }
+    /* get namespace of xml tree */
+    if (xml2ns(x, prefix1, &nsxml) < 0)
+        goto done;
     /* Here names are equal
      * Now look for namespaces
      * 1) prefix1 and prefix2 point to same namespace <<-- try this first
@@ -202,8 +203,8 @@ nodetest_eval_node_localonly(cxobj      *x,
         goto done;
     }
     name2 = xs->xs_s1;
-    /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) == 0){
+    /* Both names are interned, see clixon_intern */
+    if (name1 == name2){
         retval = 1;
         goto done;
     }
@@ -260,25 +261,29 @@ nodetest_eval(cxobj      *x,
  * @param[in]  flags
  * @param[in]  nsc        XML Namespace context
  * @param[in]  localonly  Skip prefix and namespace tests (non-standard)
+ * @param[in]  xd         Descendant search cache, skip subtrees that cannot match, or NULL
  * @param[out] vec0
  * @param[out] vec0len
  * @retval     0          OK
  * @retval    -1          Error
+ * @see xpath_optimize_descendant
  */
 int
-nodetest_recursive(cxobj      *xn,
-                   xpath_tree *nodetest,
-                   int         node_type,
-                   uint16_t    flags,
-                   cvec       *nsc,
-                   int         localonly,
-                   cxobj    ***vec0,
-                   int        *vec0len)
+nodetest_recursive(cxobj                   *xn,
+                   xpath_tree              *nodetest,
+                   int                      node_type,
+                   uint16_t                 flags,
+                   cvec                    *nsc,
+                   int                      localonly,
+                   struct xpath_descendant *xd,
+                   cxobj                 ***vec0,
+                   int                     *vec0len)
 {
     int     retval = -1;
     cxobj  *xsub;
     cxobj **vec = *vec0;
     int     veclen = *vec0len;
+    int     ret;
 
     xsub = NULL;
     while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
@@ -289,7 +294,11 @@ nodetest_recursive(cxobj      *xn,
                     goto done;
             //      continue; /* Don't go deeper */
         }
-        if (nodetest_recursive(xsub, nodetest, node_type, flags, nsc, localonly, &vec, &veclen) < 0)
+        if ((ret = xpath_optimize_descendant_prune(xd, xsub)) < 0)
+            goto done;
+        if (ret == 1)
+            continue;
+        if (nodetest_recursive(xsub, nodetest, node_type, flags, nsc, localonly, xd, &vec, &veclen) < 0)
             goto done;
     }
     retval = 0;
@@ -332,6 +341,7 @@ xp_eval_step(xp_ctx     *xc0,
     xpath_tree *nodetest = xs->xs_c0;
     xp_ctx     *xc = NULL;
     int         ret;
+    struct xpath_descendant *xd = NULL;
 
     /* Create new xc */
     if ((xc = ctx_dup(xc0)) == NULL)
@@ -345,9 +355,11 @@ xp_eval_step(xp_ctx     *xc0,
         break;
     case A_CHILD:
         if (xc->xc_descendant){
+            if (xpath_optimize_descendant(nodetest, &xd) < 0)
+                goto done;
             for (i=0; i<xc->xc_size; i++){
                 xv = xc->xc_nodeset[i];
-                if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+                if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, xd, &vec, &veclen) < 0)
                     goto done;
             }
             xc->xc_descendant = 0;
@@ -375,9 +387,11 @@ xp_eval_step(xp_ctx     *xc0,
             vec = NULL;
         break;
     case A_DESCENDANT_OR_SELF:
+        if (xpath_optimize_descendant(nodetest, &xd) < 0)
+            goto done;
         for (i=0; i<xc->xc_size; i++){
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, xd, &vec, &veclen) < 0)
                 goto done;
         }
         for (i=0; i<veclen; i++){
@@ -391,9 +405,11 @@ xp_eval_step(xp_ctx     *xc0,
         }
         break;
     case A_DESCENDANT:
+        if (xpath_optimize_descendant(nodetest, &xd) < 0)
+            goto done;
         for (i=0; i<xc->xc_size; i++){
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, xd, &vec, &veclen) < 0)
                 goto done;
         }
         ctx_nodeset_replace(xc, vec, veclen);
@@ -450,6 +466,8 @@ xp_eval_step(xp_ctx     *xc0,
     }
     retval = 0;
  done:
+    if (xd)
+        xpath_optimize_descendant_free(xd);
     if (xc)
         ctx_free(xc);
     return retval;
@@ -697,77 +715,6 @@ xp_numop(xp_ctx    *xc1,
     return retval;
 }
 
-/*! Get xml body value as cligen variable
- *
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[out] cvp Pointer to cligen variable containing value of x body
- * @retval     0   OK, cvp contains cv or NULL
- * @retval    -1   Error
- * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Move to clixon_xml.c?
- * As a side-effect sets the cache.
- * Clear cache with xml_cv_set(x, NULL)
- * @see xml_cv_cache.c duplicated function
- */
-static int
-xml_cv_cache(cxobj   *x,
-             cg_var **cvp)
-{
-    int          retval = -1;
-    cg_var      *cv = NULL;
-    yang_stmt   *y;
-    yang_stmt   *yrestype;
-    enum cv_type cvtype;
-    int          ret;
-    char        *reason=NULL;
-    int          options = 0;
-    uint8_t      fraction = 0;
-    char        *body;
-
-    if ((body = xml_body(x)) == NULL)
-        body="";
-    if ((cv = xml_cv(x)) != NULL)
-        goto ok;
-    if ((y = xml_spec(x)) == NULL){
-        clixon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
-        goto done;
-    }
-    if (yang_type_get(y, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0)
-        goto done;
-    yang2cv_type(yang_argument_get(yrestype), &cvtype);
-    if (cvtype==CGV_ERR){
-        clixon_err(OE_YANG, errno, "yang->cligen type %s mapping failed",
-                   yang_argument_get(yrestype));
-        goto done;
-    }
-    if ((cv = cv_new(cvtype)) == NULL){
-        clixon_err(OE_YANG, errno, "cv_new");
-        goto done;
-    }
-    if (cvtype == CGV_DEC64)
-        cv_dec64_n_set(cv, fraction);
-    if ((ret = cv_parse1(body, cv, &reason)) < 0){
-        clixon_err(OE_YANG, errno, "cv_parse1");
-        goto done;
-    }
-    if (ret == 0){
-        clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
-        goto done;
-    }
-    if (xml_cv_set(x, cv) < 0)
-        goto done;
- ok:
-    *cvp = cv;
-    cv = NULL;
-    retval = 0;
- done:
-    if (reason)
-        free(reason);
-    if (cv)
-        cv_free(cv);
-    return retval;
-}
-
 /*! Given two XPath contexts, eval relational operations: <>=
  *
  * A RelationalExpr is evaluated by comparing the objects that result from 
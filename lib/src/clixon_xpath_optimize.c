@@ -68,23 +68,63 @@
 #include "clixon_xml_sort.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_function.h"
+#include "clixon_yang_schema_mount.h"
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
+/* Cache of descendant search: does the schema subtree of a yang node contain a name */
+struct xpath_descendant {
+    char        *xd_name;  /* Name of nodetest */
+    size_t       xd_size;  /* Size of xd_slots, power of 2 */
+    size_t       xd_nr;    /* Number of yang nodes in xd_slots */
+    yang_stmt  **xd_slots; /* Open addressing table of yang nodes */
+    uint8_t     *xd_value; /* 1 if subtree of corresponding slot contains name */
+};
+
+/* Mapping between plan and name, for debug */
+static const map_str2int planmap[] = {
+    {"key",           XPATH_PLAN_KEY},
+    {"key-prefix",    XPATH_PLAN_KEY_PREFIX},
+    {"index",         XPATH_PLAN_INDEX},
+    {"descendant",    XPATH_PLAN_DESCENDANT},
+    {NULL,            -1}
+};
+
 static xpath_tree *_xmtop = NULL; /* pattern match tree top */
 static xpath_tree *_xm = NULL;
 static xpath_tree *_xe = NULL;
 static int _optimize_enable = 1;
 static int _optimize_hits = 0;
+static int _optimize_plans[XPATH_PLAN_NR] = {0,};
+#ifdef XML_EXPLICIT_INDEX
+static xpath_tree *_xitop = NULL; /* pattern match tree top of search index predicate */
+static xpath_tree *_xi = NULL;
+#endif
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset number of optimized xpath steps
+ *
+ * @param[out] hits   Number of steps where a plan was used
+ * @param[out] plans  If not NULL, vector of XPATH_PLAN_NR counters, one per plan
+ * @retval     0      OK
+ * @see enum xpath_plan
+ */
 int
-xpath_list_optimize_stats(int *hits)
+xpath_list_optimize_stats(int *hits,
+                          int *plans)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    *hits = _optimize_hits;
+    int i;
+
+    if (hits)
+        *hits = _optimize_hits;
     _optimize_hits = 0;
+    for (i=0; i<XPATH_PLAN_NR; i++){
+        if (plans)
+            plans[i] = _optimize_plans[i];
+        _optimize_plans[i] = 0;
+    }
 #endif
     return 0;
 }
@@ -108,6 +148,10 @@ xpath_optimize_exit(void)
 #ifdef XPATH_LIST_OPTIMIZE
     if (_xmtop)
         xpath_tree_free(_xmtop);
+#ifdef XML_EXPLICIT_INDEX
+    if (_xitop)
+        xpath_tree_free(_xitop);
+#endif
 #endif
 }
 
@@ -159,41 +203,238 @@ xpath_optimize_init(xpath_tree **xm,
 }
 
 
-/*! Recursive function to loop over all EXPR and pattern match them
+#ifdef XML_EXPLICIT_INDEX
+/*! Initialize xpath pattern of search index predicate
  *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
+ * Same as key pattern in xpath_optimize_init but matches a relative path instead of a
+ * name: [_y/_w='_z']
+ * @param[out] xi  Pattern matching XPath tree of type EXPR
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xpath_optimize_index_init(xpath_tree **xi)
+{
+    int         retval = -1;
+    xpath_tree *xs;
+
+    if (_xi == NULL){
+        if (xpath_parse("_x[_y='_z']", &_xitop) < 0)
+            goto done;
+        /* get expression [_y=_z] */
+        if ((_xi = xpath_tree_traverse(_xitop, 0, 0, 1, 1, -1)) == NULL)
+            goto done;
+        /* get relative location path (_y) */
+        if ((xs = xpath_tree_traverse(_xi, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
+            goto done;
+        xs->xs_match++;
+        /* get keyval (_z) */
+        if ((xs = xpath_tree_traverse(_xi, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
+            goto done;
+        xs->xs_match++;
+    }
+    *xi = _xi;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Translate relative location path of child steps to a data path, eg x/y
+ *
+ * @param[in]  xt   XPath tree of type RELLOCPATH or STEP
+ * @param[out] cb   Path, without prefixes
+ * @retval     1    OK, path in cb
+ * @retval     0    Not a plain path, eg has predicates or other axes
+ */
+static int
+xpath_index_path(xpath_tree *xt,
+                 cbuf       *cb)
+{
+    xpath_tree *xs;
+
+    switch (xt->xs_type){
+    case XP_RELLOCPATH:
+        if (xt->xs_int != A_NAN || xt->xs_c0 == NULL)
+            return 0;
+        if (xpath_index_path(xt->xs_c0, cb) == 0)
+            return 0;
+        if (xt->xs_c1 == NULL)
+            return 1;
+        cprintf(cb, "/");
+        return xpath_index_path(xt->xs_c1, cb);
+    case XP_STEP:
+        if (xt->xs_int != A_CHILD ||
+            (xs = xt->xs_c0) == NULL ||
+            xs->xs_type != XP_NODE ||
+            xs->xs_s1 == NULL)
+            return 0;
+        if ((xs = xt->xs_c1) != NULL && (xs->xs_c0 != NULL || xs->xs_c1 != NULL))
+            return 0; /* predicates */
+        cprintf(cb, "%s", xt->xs_c0->xs_s1);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*! Pattern match list search on search index and use index if match
+ *
+ * @param[in]  xt     XPath tree of type PRED
+ * @param[in]  xv     XML base node
+ * @param[in]  yp     Yang of xv
+ * @param[in]  yc     Yang list
+ * @param[out] xvec   Array of found nodes
+ * @retval     1      Match, see xvec
+ * @retval     0      No match
+ * @retval    -1      Error
+ *  XPath:
+ *  y[x/i='3'] # where x/i is a search index of list y
+ */
+static int
+xpath_list_optimize_index(xpath_tree  *xt,
+                          cxobj       *xv,
+                          yang_stmt   *yp,
+                          yang_stmt   *yc,
+                          clixon_xvec *xvec)
+{
+    int          retval = -1;
+    xpath_tree  *xi = NULL;
+    xpath_tree  *xe;
+    xpath_tree **vec = NULL;
+    size_t       veclen = 0;
+    cbuf        *cb = NULL;
+    cvec        *cvk = NULL;
+    cg_var      *cvi;
+    int          ret;
+
+    /* Only a single predicate */
+    if (xt->xs_type != XP_PRED ||
+        xt->xs_c0 == NULL || xt->xs_c0->xs_c0 != NULL || xt->xs_c0->xs_c1 != NULL ||
+        (xe = xt->xs_c1) == NULL || xe->xs_type != XP_EXP)
+        goto ok;
+    if (xpath_optimize_index_init(&xi) < 0)
+        goto done;
+    if ((ret = xpath_tree_eq(xi, xe, &vec, &veclen)) < 0)
+        goto done;
+    if (ret == 0 || veclen != 2)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (xpath_index_path(vec[0], cb) == 0)
+        goto ok;
+    if (yang_search_index_leaf(yc, cbuf_get(cb)) == NULL)
+        goto ok;
+    if ((cvk = cvec_new(0)) == NULL){
+        clixon_err(OE_YANG, errno, "cvec_new");
+        goto done;
+    }
+    if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+        clixon_err(OE_XML, errno, "cvec_add");
+        goto done;
+    }
+    cv_name_set(cvi, cbuf_get(cb));
+    if (vec[1]->xs_type == XP_PRIME_NR)
+        cv_string_set(cvi, vec[1]->xs_strnr);
+    else
+        cv_string_set(cvi, vec[1]->xs_s0);
+    if (clixon_xml_find_index(xv, yp, NULL, yang_argument_get(yc), cvk, xvec) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (vec)
+        free(vec);
+    if (cb)
+        cbuf_free(cb);
+    if (cvk)
+        cvec_free(cvk);
+    return retval;
+ ok: /* no match */
+    retval = 0;
+    goto done;
+}
+#endif /* XML_EXPLICIT_INDEX */
+
+/*! Check if xpath tree contains a function depending on context position or size
+ *
+ * @param[in]  xs    XPath tree
+ * @retval     1     Contains position() or last()
+ * @retval     0     Does not
+ */
+static int
+xpath_tree_positional(xpath_tree *xs)
+{
+    if (xs == NULL)
+        return 0;
+    if (xs->xs_type == XP_PRIME_FN &&
+        (xs->xs_int == XPATHFN_POSITION || xs->xs_int == XPATHFN_LAST))
+        return 1;
+    return xpath_tree_positional(xs->xs_c0) || xpath_tree_positional(xs->xs_c1);
+}
+
+/*! Check if a predicate may depend on context position or size
+ *
+ * A predicate that evaluates to a number is compared with the context position, as are
+ * position() and last(). Such a predicate is not valid on a narrowed node-set.
+ * @param[in]  xe    XPath tree of predicate expression
+ * @retval     1     May depend on position
+ * @retval     0     Does not depend on position
+ */
+static int
+xpath_pred_positional(xpath_tree *xe)
+{
+    xpath_tree *xs = xe;
+
+    /* Skip single expressions, eg EXP->AND->RELEX */
+    while ((xs->xs_type == XP_EXP || xs->xs_type == XP_AND) &&
+           xs->xs_c0 != NULL && xs->xs_c1 == NULL)
+        xs = xs->xs_c0;
+    /* Only logical and relational expressions are known to be boolean */
+    if ((xs->xs_type != XP_EXP && xs->xs_type != XP_AND && xs->xs_type != XP_RELEX) ||
+        xs->xs_c1 == NULL)
+        return 1;
+    return xpath_tree_positional(xe);
+}
+
+/*! Recursive function to loop over and-ed terms of a predicate and pattern match them
+ *
+ * @param[in]  xe    XPath tree of predicate expression
+ * @param[in]  xrpat Pattern matching XPath tree of type RELEX
  * @param[out] cvk   Vector of <keyname>:<keyval> pairs
- * @retval     1     Match
- * @retval     0     No match
+ * @retval     0     OK
  * @retval    -1     Error
- * @see xpath_optimize_init
  */
 static int
-loop_preds(xpath_tree *xt,
-           xpath_tree *xepat,
+loop_terms(xpath_tree *xe,
+           xpath_tree *xrpat,
            cvec       *cvk)
 {
     int          retval = -1;
     int          ret;
-    xpath_tree  *xe;
     xpath_tree **vec = NULL;
     size_t       veclen = 0;
     cg_var      *cvi;
 
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-        if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
-    }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-        if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
+    switch (xe->xs_type){
+    case XP_EXP:
+    case XP_AND:
+        if (xe->xs_c1 == NULL){
+            if (xe->xs_c0 && loop_terms(xe->xs_c0, xrpat, cvk) < 0)
+                goto done;
+        }
+        else if (xe->xs_int == XO_AND){
+            if (loop_terms(xe->xs_c0, xrpat, cvk) < 0)
+                goto done;
+            if (loop_terms(xe->xs_c1, xrpat, cvk) < 0)
+                goto done;
+        }
+        break;
+    case XP_RELEX:
+        if ((ret = xpath_tree_eq(xrpat, xe, &vec, &veclen)) < 0)
             goto done;
-        if (ret == 0)
-            goto ok;
-        if (veclen != 2)
-            goto ok;
+        if (ret == 0 || veclen != 2)
+            break;
         if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
             clixon_err(OE_XML, errno, "cvec_add");
             goto done;
@@ -203,13 +444,55 @@ loop_preds(xpath_tree *xt,
             cv_string_set(cvi, vec[1]->xs_strnr);
         else
             cv_string_set(cvi, vec[1]->xs_s0);
+        break;
+    default:
+        break;
     }
-    retval = 1;
+    retval = 0;
  done:
     if (vec)
         free(vec);
     return retval;
- ok: /* no match, not special case */
+}
+
+/*! Recursive function to loop over all predicates and collect key conditions
+ *
+ * Conditions on the form <keyname>=<keyval> are collected from the and-ed terms of
+ * predicates, in order, until a predicate that may depend on context position.
+ * Other terms are not collected, they are evaluated as usual on the narrowed node-set.
+ * @param[in]  xt    XPath tree of type PRED
+ * @param[in]  xrpat Pattern matching XPath tree of type RELEX
+ * @param[out] cvk   Vector of <keyname>:<keyval> pairs
+ * @retval     1     OK, continue with next predicate
+ * @retval     0     OK, positional predicate found, stop
+ * @retval    -1     Error
+ * @see xpath_optimize_init
+ */
+static int
+loop_preds(xpath_tree *xt,
+           xpath_tree *xrpat,
+           cvec       *cvk)
+{
+    int         retval = -1;
+    int         ret;
+    xpath_tree *xe;
+
+    if (xt->xs_type == XP_PRED && xt->xs_c0){
+        if ((ret = loop_preds(xt->xs_c0, xrpat, cvk)) < 0)
+            goto done;
+        if (ret == 0)
+            goto stop;
+    }
+    if ((xe = xt->xs_c1) != NULL){
+        if (xpath_pred_positional(xe))
+            goto stop;
+        if (loop_terms(xe, xrpat, cvk) < 0)
+            goto done;
+    }
+    retval = 1;
+ done:
+    return retval;
+ stop:
     retval = 0;
     goto done;
 }
@@ -219,35 +502,39 @@ loop_preds(xpath_tree *xt,
  * @param[in]  xt     XPath tree
  * @param[in]  xv     XML base node
  * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
+ * @param[out] plan   Plan used, if match
  * @retval     1      Match
  * @retval     0      No match - use non-optimized lookup
  * @retval    -1      Error
  *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ *  y[k=3]           # corresponds to: <name>[<keyname>=<keyval>]
+ *  y[k=3][j=4]      # all keys of y in any order, also y[k=3 and j=4]
+ *  y[k=3]           # leading keys of y: range of entries, if y is ordered-by system
+ *  y[x/i=3]         # if x/i is a search index of y, see xpath_list_optimize_index
+ * Key conditions are pushed down to the list search, see loop_preds. All predicates are
+ * then evaluated as usual on the narrowed node-set.
  */
 static int
-xpath_list_optimize_fn(xpath_tree  *xt,
-                       cxobj       *xv,
-                       clixon_xvec *xvec)
+xpath_list_optimize_fn(xpath_tree      *xt,
+                       cxobj           *xv,
+                       clixon_xvec     *xvec,
+                       enum xpath_plan *plan)
 {
     int          retval = -1;
     xpath_tree  *xm = NULL;
     xpath_tree  *xem = NULL;
     char        *name;
     yang_stmt   *yp;
-    yang_stmt   *yc;
+    yang_stmt   *yc = NULL;
     cvec        *cvv = NULL;
     xpath_tree **vec = NULL;
     size_t       veclen = 0;
-    xpath_tree  *xtp;
+    xpath_tree  *xtp = NULL;
     int          ret;
+    cvec        *cvp = NULL; /* vector of key conditions of predicates */
     cvec        *cvk = NULL; /* vector of index keys */
     cg_var      *cvi;
-    int          i;
-    yang_stmt   *ypp;
+    cg_var      *cvp1;
 
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
@@ -255,15 +542,8 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
         goto ok;
-    /* Check that there is no "outer" list. */
-    ypp = yp;
-    do {
-        if (yang_keyword_get(ypp) == Y_LIST)
-            goto ok;
-    } while((ypp = yang_parent_get(ypp)) != NULL);
     /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
+     * That is, ONLY check optimize cases of this type:_x[...]
      */
     xpath_optimize_init(&xm, &xem);
     /* Here is where pattern is checked for equality and where variable binding is made (if
@@ -274,7 +554,8 @@ xpath_list_optimize_fn(xpath_tree  *xt,
         goto ok; /* no match */
     if (veclen != 2)
         goto ok;
-    name = vec[0]->xs_s1;
+    if ((name = vec[0]->xs_s1) == NULL)
+        goto ok;
     /* Extract variables */
     if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
 #ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
@@ -285,24 +566,35 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     if ((cvv = yang_cvec_get(yc)) == NULL)
         goto ok;
     xtp = vec[1];
-    if ((cvk = cvec_new(0)) == NULL){
+    if ((cvp = cvec_new(0)) == NULL){
         clixon_err(OE_YANG, errno, "cvec_new");
         goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    /* Pattern of key condition: RELEX of [_y='_z'] */
+    if (loop_preds(xtp, xem->xs_c0->xs_c0, cvp) < 0)
         goto done;
-    if (ret == 0)
-        goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
-        goto ok;
-    i = 0;
+    if ((cvk = cvec_new(0)) == NULL){
+        clixon_err(OE_YANG, errno, "cvec_new");
+        goto done;
+    }
+    /* Leading keys with conditions, in key order */
     cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
-            goto ok;
-        i++;
+    while ((cvi = cvec_each(cvv, cvi)) != NULL) {
+        if ((cvp1 = cvec_find(cvp, cv_string_get(cvi))) == NULL)
+            break;
+        if (cvec_append_var(cvk, cvp1) == NULL){
+            clixon_err(OE_XML, errno, "cvec_append_var");
+            goto done;
+        }
     }
+    if (cvec_len(cvk) == 0)
+        goto index;
+    if (cvec_len(cvk) == cvec_len(cvv))
+        *plan = XPATH_PLAN_KEY;
+    else if (yang_find(yc, Y_ORDERED_BY, "user") == NULL)
+        *plan = XPATH_PLAN_KEY_PREFIX; /* Sorted: entries with equal leading keys are adjacent */
+    else
+        goto index;
     /* Use 2a form since yc allready given to compute cvk */
     if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
         goto done;
@@ -310,17 +602,197 @@ xpath_list_optimize_fn(xpath_tree  *xt,
  done:
     if (vec)
         free(vec);
+    if (cvp)
+        cvec_free(cvp);
     if (cvk)
         cvec_free(cvk);
     return retval;
+ index: /* not list keys, try search index */
+#ifdef XML_EXPLICIT_INDEX
+    if ((ret = xpath_list_optimize_index(xtp, xv, yp, yc, xvec)) < 0)
+        goto done;
+    if (ret == 1){
+        *plan = XPATH_PLAN_INDEX;
+        retval = 1;
+        goto done;
+    }
+#endif
  ok: /* no match, not special case */
     retval = 0;
     goto done;
 }
+
+/*! Register that an optimization plan is used
+ *
+ * @param[in]  plan   Plan
+ */
+static void
+xpath_optimize_plan(enum xpath_plan plan)
+{
+    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "plan: %s", clicon_int2str(planmap, plan));
+    _optimize_hits++;
+    _optimize_plans[plan]++;
+}
+
+/*! Find yang node in descendant cache
+ *
+ * @param[in]  xd     Descendant search cache
+ * @param[in]  y      Yang node
+ * @param[out] value  1 if subtree of y contains name
+ * @retval     1      Found, see value
+ * @retval     0      Not found
+ */
+static int
+xpath_descendant_find(struct xpath_descendant *xd,
+                      yang_stmt               *y,
+                      int                     *value)
+{
+    size_t     i;
+    yang_stmt *ys;
+
+    if (xd->xd_size == 0)
+        return 0;
+    i = ((uintptr_t)y >> 3) & (xd->xd_size-1);
+    while ((ys = xd->xd_slots[i]) != NULL){
+        if (ys == y){
+            *value = xd->xd_value[i];
+            return 1;
+        }
+        i = (i+1) & (xd->xd_size-1);
+    }
+    return 0;
+}
+
+/*! Add yang node to descendant cache
+ *
+ * @param[in]  xd     Descendant search cache
+ * @param[in]  y      Yang node, not in cache
+ * @param[in]  value  1 if subtree of y contains name
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_descendant_add(struct xpath_descendant *xd,
+                     yang_stmt               *y,
+                     int                      value)
+{
+    int         retval = -1;
+    yang_stmt **slots;
+    uint8_t    *values;
+    size_t      size;
+    size_t      i;
+    size_t      j;
+
+    if (2*(xd->xd_nr+1) > xd->xd_size){
+        size = xd->xd_size ? 2*xd->xd_size : 32;
+        if ((slots = calloc(size, sizeof(yang_stmt *))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((values = calloc(size, sizeof(uint8_t))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            free(slots);
+            goto done;
+        }
+        for (i=0; i<xd->xd_size; i++){
+            if (xd->xd_slots[i] == NULL)
+                continue;
+            j = ((uintptr_t)xd->xd_slots[i] >> 3) & (size-1);
+            while (slots[j] != NULL)
+                j = (j+1) & (size-1);
+            slots[j] = xd->xd_slots[i];
+            values[j] = xd->xd_value[i];
+        }
+        if (xd->xd_slots)
+            free(xd->xd_slots);
+        if (xd->xd_value)
+            free(xd->xd_value);
+        xd->xd_slots = slots;
+        xd->xd_value = values;
+        xd->xd_size = size;
+    }
+    i = ((uintptr_t)y >> 3) & (xd->xd_size-1);
+    while (xd->xd_slots[i] != NULL)
+        i = (i+1) & (xd->xd_size-1);
+    xd->xd_slots[i] = y;
+    xd->xd_value[i] = value;
+    xd->xd_nr++;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if the schema subtree of a yang node contains a node with the name of the search
+ *
+ * Anydata, anyxml and mount-points are assumed to contain any name.
+ * @param[in]  xd     Descendant search cache
+ * @param[in]  y      Yang node
+ * @retval     1      Some descendant of y may have the name
+ * @retval     0      No descendant of y has the name
+ * @retval    -1      Error
+ */
+static int
+xpath_descendant_contains(struct xpath_descendant *xd,
+                          yang_stmt               *y)
+{
+    int        retval = -1;
+    yang_stmt *yc;
+    int        inext;
+    int        value = 0;
+    char      *arg;
+    int        ret;
+
+    if (xpath_descendant_find(xd, y, &value) == 1)
+        return value;
+    if (yang_keyword_get(y) == Y_ANYDATA ||
+        yang_keyword_get(y) == Y_ANYXML ||
+        yang_schema_mount_point(y))
+        value = 1;
+    else {
+        inext = 0;
+        while ((yc = yn_iter(y, &inext)) != NULL) {
+            switch (yang_keyword_get(yc)){
+            case Y_CONTAINER:
+            case Y_LEAF:
+            case Y_LIST:
+            case Y_LEAF_LIST:
+            case Y_ANYXML:
+            case Y_ANYDATA:
+            case Y_CHOICE:
+            case Y_CASE:
+            case Y_INPUT:
+            case Y_OUTPUT:
+            case Y_ACTION:
+            case Y_NOTIFICATION:
+                break;
+            default:
+                continue;
+            }
+            if ((arg = yang_argument_get(yc)) != NULL &&
+                strcmp(arg, xd->xd_name) == 0)
+                value = 1;
+            else if ((ret = xpath_descendant_contains(xd, yc)) < 0)
+                goto done;
+            else
+                value = ret;
+            if (value)
+                break;
+        }
+    }
+    if (xpath_descendant_add(xd, y, value) < 0)
+        goto done;
+    retval = value;
+ done:
+    return retval;
+}
 #endif /* XPATH_LIST_OPTIMIZE */
 
 /*! Identify XPath special cases and if match, use binary search.
  *
+ * @param[in]     xs     XPath step
+ * @param[in]     xv     Context node
+ * @param[in,out] xvec0  Matching nodes are appended
+ * @param[in,out] xlen0  Length of xvec0
  * @retval  1  Optimization made, special case, use x (found if != NULL)
  * @retval  0  Dont optimize: not special case, do normal processing
  * @retval -1  Error
@@ -333,26 +805,31 @@ xpath_optimize_check(xpath_tree *xs,
                      int        *xlen0)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    int          retval = -1;
-    int          ret;
-    clixon_xvec *xvec = NULL;
+    int             retval = -1;
+    int             ret;
+    clixon_xvec    *xvec = NULL;
+    enum xpath_plan plan = XPATH_PLAN_KEY;
+    int             i;
 
     if (!_optimize_enable)
         goto ok;
     else if ((xvec = clixon_xvec_new()) == NULL)
         goto done;
     /* Glue code since xpath code uses (old) cxobj ** and search code uses (new) clixon_xvec */
-    else if ((ret = xpath_list_optimize_fn(xs, xv, xvec)) < 0)
+    else if ((ret = xpath_list_optimize_fn(xs, xv, xvec, &plan)) < 0)
         goto done;
     else if (ret == 1){
-        if (xvec0 && *xvec0){
-            free(*xvec0);
-            *xvec0 = NULL;
+        /* Called for each context node, append to matches of previous context nodes */
+        if (*xvec0 == NULL){
+            if (clixon_xvec_extract(xvec, xvec0, xlen0, NULL) < 0)
+                goto done;
         }
-        if (clixon_xvec_extract(xvec, xvec0, xlen0, NULL) < 0){
-            goto done;
+        else {
+            for (i=0; i<clixon_xvec_len(xvec); i++)
+                if (cxvec_append(clixon_xvec_i(xvec, i), xvec0, xlen0) < 0)
+                    goto done;
         }
-        _optimize_hits++;
+        xpath_optimize_plan(plan);
         retval = 1; /* Optimized */
         goto done;
     }
@@ -367,3 +844,103 @@ xpath_optimize_check(xpath_tree *xs,
 #endif
 }
 
+/*! Create descendant search cache if a descendant search can be narrowed using YANG
+ *
+ * In a descendant search, eg //y, XML subtrees are skipped if the schema subtree of their
+ * YANG node does not have any node named y, see xpath_optimize_descendant_prune.
+ * @param[in]  nodetest  XPath tree of nodetest of descendant step
+ * @param[out] xdp       Descendant search cache, or NULL if not applicable. Free with
+ *                       xpath_optimize_descendant_free
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+int
+xpath_optimize_descendant(xpath_tree               *nodetest,
+                          struct xpath_descendant **xdp)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    int                      retval = -1;
+    struct xpath_descendant *xd;
+
+    *xdp = NULL;
+    if (!_optimize_enable ||
+        nodetest == NULL ||
+        nodetest->xs_type != XP_NODE ||
+        nodetest->xs_s1 == NULL ||
+        strcmp(nodetest->xs_s1, "*") == 0)
+        goto ok;
+    if ((xd = calloc(1, sizeof(*xd))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    xd->xd_name = nodetest->xs_s1;
+    xpath_optimize_plan(XPATH_PLAN_DESCENDANT);
+    *xdp = xd;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+#else
+    *xdp = NULL;
+    return 0;
+#endif
+}
+
+/*! Check if a descendant search can skip the subtree of an XML node
+ *
+ * The schema only tells what bound children may exist. Never skip nodes treated as
+ * anydata, eg mount-points without yang-library, or nodes with unbound children, eg
+ * unknown nodes, since the schema says nothing of what lies below them.
+ * @param[in]  xd     Descendant search cache
+ * @param[in]  x      XML node
+ * @retval     1      Skip, no node in subtree of x can match
+ * @retval     0      Search subtree of x
+ * @retval    -1      Error
+ */
+int
+xpath_optimize_descendant_prune(struct xpath_descendant *xd,
+                                cxobj                   *x)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    int        retval = 0;
+    yang_stmt *y;
+    cxobj     *xc;
+    int        ret;
+
+    if (xd == NULL || (y = xml_spec(x)) == NULL)
+        goto done;
+    if ((ret = xpath_descendant_contains(xd, y)) < 0){
+        retval = -1;
+        goto done;
+    }
+    if (ret == 1 || xml_flag(x, XML_FLAG_ANYDATA))
+        goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+        if (xml_spec(xc) == NULL)
+            goto done;
+    retval = 1;
+ done:
+    return retval;
+#else
+    return 0;
+#endif
+}
+
+/*! Free descendant search cache
+ *
+ * @param[in]  xd     Descendant search cache
+ */
+void
+xpath_optimize_descendant_free(struct xpath_descendant *xd)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    if (xd == NULL)
+        return;
+    if (xd->xd_slots)
+        free(xd->xd_slots);
+    if (xd->xd_value)
+        free(xd->xd_value);
+    free(xd);
+#endif
+}
@@ -120,6 +120,7 @@
 
 #include "clixon_queue.h"
 #include "clixon_hash.h"
+#include "clixon_intern.h"
 #include "clixon_handle.h"    
 #include "clixon_yang.h"
 #include "clixon_xml.h"
@@ -184,7 +185,7 @@ xpath_parse_exit(clixon_xpath_yacc *xpy)
  * @param[in]  i0     step-> axis_type
  * @param[in]  numstr original string xs_double: numeric value 
  * @param[in]  s0     String 0 set if XP_PRIME_STR, XP_PRIME_FN, XP_NODE[_FN] PATHEXPRE prefix
- * @param[in]  s1     String 1 set if XP_NODE NAME (or "*")
+ * @param[in]  s1     String 1 set if XP_NODE NAME (or "*"), interned if XP_NODE
  * @param[in]  c0     Child 0
  * @param[in]  c1     Child 1
  */
@@ -216,7 +217,17 @@ xp_new(enum xp_type  type,
     else
         xs->xs_double = 0.0;
     xs->xs_s0  = s0;
-    xs->xs_s1  = s1;
+    if (type == XP_NODE && s1 != NULL){ /* Node names are interned, see nodetest_eval_node */
+        if ((xs->xs_s1 = clixon_intern(s1)) == NULL){
+            free(s1);
+            free(xs);
+            xs = NULL;
+            goto done;
+        }
+        free(s1);
+    }
+    else
+        xs->xs_s1  = s1;
     xs->xs_c0  = c0;
     xs->xs_c1  = c1;
  done:
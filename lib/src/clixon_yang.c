@@ -89,6 +89,7 @@
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_schema_mount.h"
+#include "clixon_validate_deps.h"
 #include "clixon_yang_internal.h" /* internal included by this file only, not API */
 
 #ifdef XML_EXPLICIT_INDEX
@@ -643,6 +644,55 @@ yang_typecache_set(yang_stmt *ys,
     return 0;
 }
 
+/*! Get parsed xpath of a must, when or path statement
+ *
+ * The argument is parsed on first call unless already parsed when the yang was loaded.
+ * @param[in]  ys      Yang statement: Y_MUST, Y_WHEN or Y_PATH
+ * @param[out] xptree  XPath parse tree, kept with the statement, do not free
+ * @retval     0       OK
+ * @retval    -1       Error, or not a must, when or path statement
+ * @see xpath_vec_ctx_tree  to evaluate the parse tree
+ */
+int
+yang_xpath_tree_get(yang_stmt   *ys,
+                    xpath_tree **xptree)
+{
+    int retval = -1;
+
+    switch (ys->ys_keyword){
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+        break;
+    default:
+        clixon_err(OE_YANG, EINVAL, "No xpath of %s", yang_key2str(ys->ys_keyword));
+        goto done;
+    }
+    if (ys->ys_xpath == NULL &&
+        xpath_parse(ys->ys_argument, &ys->ys_xpath) < 0)
+        goto done;
+    *xptree = ys->ys_xpath;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Set parsed xpath of a must, when or path statement
+ *
+ * @param[in]  ys      Yang statement: Y_MUST, Y_WHEN or Y_PATH
+ * @param[in]  xptree  XPath parse tree of argument, consumed
+ * @retval     0       OK
+ */
+int
+yang_xpath_tree_set(yang_stmt  *ys,
+                    xpath_tree *xptree)
+{
+    if (ys->ys_xpath)
+        xpath_tree_free(ys->ys_xpath);
+    ys->ys_xpath = xptree;
+    return 0;
+}
+
 /*! Get mymodule
  *
  * Shortcut to "my" module. Used by augmented and unknown nodes
@@ -910,11 +960,22 @@ ys_free1(yang_stmt *ys,
             ys->ys_typecache = NULL;
         }
         break;
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+        if (ys->ys_xpath){
+            xpath_tree_free(ys->ys_xpath);
+            ys->ys_xpath = NULL;
+        }
+        break;
     case Y_MODULE:
     case Y_SUBMODULE:
         if (ys->ys_filename)
             free(ys->ys_filename);
         break;
+    case Y_SPEC:
+        yang_deps_free(ys);
+        break;
     default:
         break;
     }
@@ -1160,6 +1221,11 @@ ys_cp_one(yang_stmt *ynew,
         if (yang_typecache_get(yold)) /* Dont copy type cache, use only original */
             yang_typecache_set(ynew, NULL);
         break;
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+        ynew->ys_xpath = NULL; /* Parsed again on first use */
+        break;
     default:
         break;
     }
@@ -3334,6 +3400,10 @@ ys_populate2(yang_stmt    *ys,
     case Y_LEAF_LIST:
         if (ys_populate_leaf(h, ys) < 0)
             goto done;
+#ifdef XML_EXPLICIT_INDEX
+        if (yang_search_index_path(ys, NULL) < 0)
+            goto done;
+#endif
         break;
     case Y_MANDATORY: /* call yang_mandatory() to check if set */
     case Y_CONFIG:
@@ -4223,27 +4293,118 @@ yang_sort_subelements(yang_stmt *ys)
 }
 
 #ifdef XML_EXPLICIT_INDEX
-/*! Mark element as search_index in list
+/*! Mark leaf as search index
  *
- * @retval     0   OK
- * @retval    -1   Error
+ * The leaf may be a direct child of a list, or a descendant of a list via containers,
+ * choices or cases. The path from the list down to the leaf is marked later, after groupings
+ * and augments are expanded.
+ * @param[in] ys   Yang leaf
+ * @retval    0    OK
+ * @retval   -1    Error
+ * @see yang_search_index_path
  */
 int
 yang_list_index_add(yang_stmt *ys)
 {
-    int        retval = -1;
+    if (yang_keyword_get(ys) != Y_LEAF){
+        clixon_log(NULL, LOG_WARNING, "search_index %s should be a leaf", yang_argument_get(ys));
+        return 0;
+    }
+    yang_flag_set(ys, YANG_FLAG_INDEX);
+    return 0;
+}
+
+/*! Mark data path from closest ancestor list down to a search index leaf
+ *
+ * All nodes on the path, including the list itself, are marked with YANG_FLAG_INDEX, so
+ * that XML changes below a list entry can be mapped to the indexes of the entry.
+ * A search index not in a list is ignored with a warning, unless it is in a grouping or
+ * augment, in which case it is marked where it is expanded.
+ * @param[in] ys   Yang node
+ * @param[in] arg  Not used
+ * @retval    0    OK
+ * @retval   -1    Error
+ * @see yang_search_index_leaf  for the inverse
+ */
+int
+yang_search_index_path(yang_stmt *ys,
+                       void      *arg)
+{
     yang_stmt *yp;
 
-    if ((yp = yang_parent_get(ys)) == NULL ||
-        yang_keyword_get(yp) != Y_LIST){
-        clixon_log(NULL, LOG_WARNING, "search_index should in a list");
-        goto ok;
+    if (yang_keyword_get(ys) != Y_LEAF ||
+        yang_flag_get(ys, YANG_FLAG_INDEX) == 0)
+        return 0;
+    yp = ys;
+    while ((yp = yang_parent_get(yp)) != NULL){
+        switch (yang_keyword_get(yp)){
+        case Y_CONTAINER:
+        case Y_CHOICE:
+        case Y_CASE:
+            continue;
+        case Y_LIST:
+            break;
+        case Y_GROUPING:
+        case Y_AUGMENT:
+            return 0;
+        default:
+            yp = NULL;
+            break;
+        }
+        break;
     }
-    yang_flag_set(ys, YANG_FLAG_INDEX);
- ok:
-    retval = 0;
-   // done:
-    return retval;
+    if (yp == NULL){
+        clixon_log(NULL, LOG_WARNING, "search_index %s should be in a list", yang_argument_get(ys));
+        yang_flag_reset(ys, YANG_FLAG_INDEX);
+        return 0;
+    }
+    yp = ys;
+    while ((yp = yang_parent_get(yp)) != NULL){
+        yang_flag_set(yp, YANG_FLAG_INDEX);
+        if (yang_keyword_get(yp) == Y_LIST)
+            break;
+    }
+    return 0;
+}
+
+/*! Find search index leaf of list given a relative data path
+ *
+ * @param[in] ylist  Yang list
+ * @param[in] path   Data path relative to list entry, eg "x/y", without prefixes
+ * @retval    yleaf  Yang search index leaf
+ * @retval    NULL   Not found or not a search index
+ */
+yang_stmt *
+yang_search_index_leaf(yang_stmt *ylist,
+                       char      *path)
+{
+    yang_stmt *y = ylist;
+    char      *p;
+    char      *name;
+    char       buf[64];
+    size_t     len;
+
+    if (yang_keyword_get(ylist) != Y_LIST ||
+        yang_flag_get(ylist, YANG_FLAG_INDEX) == 0)
+        return NULL;
+    name = path;
+    do {
+        if ((p = strchr(name, '/')) != NULL){
+            if ((len = p - name) >= sizeof(buf))
+                return NULL;
+            memcpy(buf, name, len);
+            buf[len] = '\0';
+            y = yang_find_datanode(y, buf);
+            name = p + 1;
+        }
+        else
+            y = yang_find_datanode(y, name);
+        if (y == NULL || yang_flag_get(y, YANG_FLAG_INDEX) == 0)
+            return NULL;
+    } while (p != NULL);
+    if (yang_keyword_get(y) != Y_LEAF)
+        return NULL;
+    return y;
 }
 
 /*! Callback for yang clixon search_index extension
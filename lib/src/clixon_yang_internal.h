@@ -114,6 +114,8 @@ struct yang_stmt {
         rpc_callback_t  *ysu_action_cb; /* Y_ACTION: Action callback list*/
         char            *ysu_filename;  /* Y_MODULE/Y_SUBMODULE: For debug/errors: filename */
         yang_type_cache *ysu_typecache; /* Y_TYPE: cache all typedef data except unions */
+        struct xpath_tree *ysu_xpath;   /* Y_MUST/Y_WHEN/Y_PATH: parsed argument,
+                                         * see yang_xpath_tree_get */
         int              ysu_ref;     /* Y_SPEC: Reference count for free: 0 means
                                        * no sharing, 1: two references */
     } u;
@@ -123,6 +125,7 @@ struct yang_stmt {
 #define ys_action_cb      u.ysu_action_cb
 #define ys_filename       u.ysu_filename
 #define ys_typecache      u.ysu_typecache
+#define ys_xpath          u.ysu_xpath
 #define ys_ref            u.ysu_ref
 
 #endif  /* _CLIXON_YANG_INTERNAL_H_ */
@@ -101,6 +101,7 @@
 #include "clixon_yang_internal.h"
 #include "clixon_yang_sub_parse.h"
 #include "clixon_yang_parse_lib.h"
+#include "clixon_validate_deps.h"
 
 /* Size of json read buffer when reading from file*/
 #define BUFLEN 1024
@@ -1376,6 +1377,58 @@ ys_list_check(clixon_handle h,
     return retval;
 }
 
+#ifdef XML_EXPLICIT_INDEX
+/*! Add search indexes declared in config option CLICON_YANG_SEARCH_INDEX
+ *
+ * As an alternative to the search_index extension. Each option is an absolute schema-nodeid
+ * of a leaf under a list, eg /ex:table/ex:parameter/ex:value
+ * Indexes in modules not loaded (yet) are skipped, they are added when the module is loaded.
+ * @param[in] h      Clixon handle
+ * @param[in] yspec  Yang specification
+ * @retval    0      OK
+ * @retval   -1      Error
+ */
+static int
+yang_search_index_option(clixon_handle h,
+                         yang_stmt    *yspec)
+{
+    int        retval = -1;
+    cxobj     *x = NULL;
+    char      *str;
+    char      *prefix = NULL;
+    char      *p;
+    yang_stmt *y;
+
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_YANG_SEARCH_INDEX") != 0)
+            continue;
+        if ((str = xml_body(x)) == NULL || str[0] != '/' ||
+            (p = strchr(str, ':')) == NULL)
+            continue;
+        if ((prefix = strndup(str+1, p-str-1)) == NULL){
+            clixon_err(OE_YANG, errno, "strndup");
+            goto done;
+        }
+        if (yang_find_module_by_prefix_yspec(yspec, prefix) != NULL){
+            if (yang_abs_schema_nodeid(yspec, str, &y) < 0)
+                goto done;
+            if (y == NULL)
+                clixon_log(h, LOG_WARNING, "CLICON_YANG_SEARCH_INDEX %s not found", str);
+            else if (yang_list_index_add(y) < 0 ||
+                     yang_search_index_path(y, NULL) < 0)
+                goto done;
+        }
+        free(prefix);
+        prefix = NULL;
+    }
+    retval = 0;
+ done:
+    if (prefix)
+        free(prefix);
+    return retval;
+}
+#endif /* XML_EXPLICIT_INDEX */
+
 /*! Depth-first topological sort
  *
  * Topological sort of a DAG
@@ -1599,6 +1652,11 @@ yang_parse_post(clixon_handle h,
         if (yang_apply(ylist[i], -1, ys_populate2, 1, (void*)h) < 0)
             goto done;
 
+#ifdef XML_EXPLICIT_INDEX
+    /* 9b: Search indexes declared as options, extension indexes are marked in ys_populate2 */
+    if (yang_search_index_option(h, yspec) < 0)
+        goto done;
+#endif
     /* 10: sanity checks of expanded yangs need more here */
     for (i=0; i<ylen; i++){
         /* Check list key values */
@@ -1609,6 +1667,13 @@ yang_parse_post(clixon_handle h,
     for (i=0; i<ylen; i++)
         if (yang_cardinality(h, ylist[i], yang_argument_get(ylist[i])) < 0)
             goto done;
+    /* 12. Dependencies of must/when/leafref for incremental validation, of new modules */
+    if (clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL")){
+        if (yang_deps_build(yspec, modmin) < 0)
+            goto done;
+    }
+    else if (yang_deps_free(yspec) < 0)
+        goto done;
     retval = 0;
  done:
     if (ylist)
@@ -1984,6 +2049,7 @@ ys_parse_sub(yang_stmt  *ys,
     uint32_t   minmax;
     cg_var    *cv = NULL;
     yang_stmt *yp;
+    xpath_tree *xptree = NULL;
 
     arg = yang_argument_get(ys);
     keyword = yang_keyword_get(ys);
@@ -2011,8 +2077,10 @@ ys_parse_sub(yang_stmt  *ys,
         break;
     case Y_MUST:
     case Y_WHEN:
-        if (xpath_parse(yang_argument_get(ys), NULL) < 0)
+    case Y_PATH: /* leafref path */
+        if (xpath_parse(yang_argument_get(ys), &xptree) < 0)
             goto done;
+        yang_xpath_tree_set(ys, xptree);
         break;
     case Y_REVISION:
     case Y_REVISION_DATE:  /* YYYY-MM-DD encoded as uint32 YYYYMMDD */
@@ -0,0 +1,189 @@
+#!/usr/bin/env bash
+# Datastore edit journal, CLICON_XMLDB_JOURNAL
+# Edits are appended to <db>_db.journal instead of rewriting <db>_db
+# Check that:
+# - edits are written to journal, not to datastore file
+# - journal is replayed on restart
+# - commit copies journal to running
+# - journal is compacted into datastore file when it grows larger than it (and 64K)
+# - a truncated last entry, eg from a crash, is removed on restart and later entries are
+#   appended after the last complete entry
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# include err() and new() functions and creates $dir
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_JOURNAL>true</CLICON_XMLDB_JOURNAL>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+# Edit candidate
+# Args:
+# 1: name
+# 2: value
+function edit()
+{
+    name=$1
+    value=$2
+
+    new "edit $name=$value"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>$name</name><value>$value</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+edit a 1
+
+new "check candidate journal exists"
+sudo test -s $dir/candidate_db.journal || err "candidate_db.journal" "not found"
+
+new "check candidate file not rewritten"
+expectpart "$(sudo cat $dir/candidate_db)" 0 --not-- "<name>a</name>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "check running journal exists"
+sudo test -s $dir/running_db.journal || err "running_db.journal" "not found"
+
+edit b 2
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "restart backend -s none -f $cfg"
+    start_backend -s none -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "check running after restart"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter></table></data></rpc-reply>"
+
+edit a 3
+
+# Large edit: journal grows larger than file and is compacted
+long=$(printf 'x%.0s' $(seq 1 70000))
+edit c $long
+
+new "check candidate file compacted"
+expectpart "$(sudo cat $dir/candidate_db)" 0 "<name>a</name><value>3</value>" "<name>c</name>"
+
+new "check candidate journal removed"
+sudo test -e $dir/candidate_db.journal && err "no candidate_db.journal" "found"
+
+new "check candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>3</value></parameter></table></data></rpc-reply>"
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "check candidate after discard"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "check running journal exists"
+    sudo test -s $dir/running_db.journal || err "running_db.journal" "not found"
+
+    new "truncate last entry of running journal"
+    sudo sh -c "printf '100\n<edit' >> $dir/running_db.journal"
+
+    new "restart backend -s none -f $cfg"
+    start_backend -s none -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "check running after truncated journal"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter></table></data></rpc-reply>"
+
+edit d 4
+
+new "commit after truncated journal"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "restart backend -s none -f $cfg"
+    start_backend -s none -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "check running after append to truncated journal"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter><parameter><name>d</name><value>4</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+new "endtest"
+endtest
+
+rm -rf $dir
@@ -0,0 +1,197 @@
+#!/usr/bin/env bash
+# Datastore split lazy loading, CLICON_XMLDB_MULTI and CLICON_XMLDB_MULTI_RESIDENT
+# Sub-files are loaded only when an xpath or edit reaches them, and at most
+# CLICON_XMLDB_MULTI_RESIDENT sub-files stay loaded
+# Check that:
+# - edits and gets of one mount-point do not disturb others when sub-trees are evicted
+# - a mount-point can be read on restart although the sub-file of another is missing
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# include err() and new() functions and creates $dir
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fyang1=$dir/clixon-mount1.yang
+
+# Well-known digest of mount-point x xpath
+subfilex=9121a04a6f67ca5ac2184286236d42f3b7301e97.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${dir}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_LIBRARY>true</CLICON_YANG_LIBRARY>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_MULTI>true</CLICON_XMLDB_MULTI>
+  <CLICON_XMLDB_MULTI_RESIDENT>1</CLICON_XMLDB_MULTI_RESIDENT>
+  <CLICON_YANG_SCHEMA_MOUNT>true</CLICON_YANG_SCHEMA_MOUNT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import ietf-yang-schema-mount {
+    prefix yangmnt;
+  }
+  import clixon-lib {
+    prefix cl;
+  }
+  container top{
+    list mylist{
+      key name;
+      leaf name{
+        type string;
+      }
+      container root{
+         presence "Otherwise root is not visible";
+         yangmnt:mount-point "mylabel"{
+            description "Root for other yang models";
+         }
+         cl:xmldb-split{
+           description "Multi-XMLDB: split datastore here";
+         }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyang1
+module clixon-mount1{
+   yang-version 1.1;
+   namespace "urn:example:mount1";
+   prefix m1;
+   container mount1{
+      list mylist1{
+         key name1;
+         leaf name1{
+            type string;
+         }
+         leaf value1 {
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Edit mount-point in candidate
+# Args:
+# 1: mount-point name
+# 2: value
+function edit()
+{
+    name=$1
+    value=$2
+
+    new "edit $name=$value"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\"><mylist><name>$name</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>a</name1><value1>$value</value1></mylist1></mount1></root></mylist></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+# Check mount-point value
+# Args:
+# 1: db
+# 2: mount-point name
+# 3: expected value
+function check()
+{
+    db=$1
+    name=$2
+    value=$3
+
+    new "check $db $name=$value"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><$db/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='$name']/ex:root/m1:mount1\" xmlns:ex=\"urn:example:clixon\" xmlns:m1=\"urn:example:mount1\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>$name</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>a</name1><value1>$value</value1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+}
+
+new "test params: -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+    start_backend -s init -f $cfg -- -m clixon-mount1 -M urn:example:mount1
+fi
+
+new "wait backend"
+wait_backend
+
+edit x 1
+edit y 2
+edit z 3
+
+new "check three sub-files"
+expectpart "$(sudo ls $dir/candidate.d/ | grep -v 0.xml | wc -l)" 0 "3"
+
+# Sub-trees are evicted and reloaded on every other access
+check candidate x 1
+check candidate y 2
+check candidate z 3
+
+edit x 11
+check candidate y 2
+check candidate x 11
+
+new "check all"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>x</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>a</name1><value1>11</value1></mylist1></mount1></root></mylist><mylist><name>y</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>a</name1><value1>2</value1></mylist1></mount1></root></mylist><mylist><name>z</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>a</name1><value1>3</value1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+check running x 11
+check running z 3
+
+new "check stubs in running"
+expectpart "$(sudo cat $dir/running.d/0.xml)" 0 "cl:link=\"$subfilex\""
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+# Sub-file of x is only read if x is accessed
+sudo rm -f $dir/running.d/$subfilex
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s none -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+    start_backend -s none -f $cfg -- -m clixon-mount1 -M urn:example:mount1
+fi
+
+new "wait backend"
+wait_backend
+
+check running y 2
+check running z 3
+
+new "check running x sub-file missing"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='x']/ex:root\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+new "endtest"
+endtest
+
+rm -rf $dir
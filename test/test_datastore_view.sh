@@ -0,0 +1,156 @@
+#!/usr/bin/env bash
+# Zero-copy get-config, printed directly from the datastore cache (xmldb_get_view)
+# Check xpath, depth and with-defaults, and that the cache is not modified by printing,
+# eg by with-defaults report-all-tagged, and that consecutive views are not affected by an edit
+# in between
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+            leaf mtu{
+                type uint32;
+                default 1500;
+            }
+        }
+    }
+}
+EOF
+
+# Get-config of running
+# Args:
+# 1: attributes and with-defaults of get-config, eg depth="1"
+# 2: filter, or empty
+# 3: expected data
+function get()
+{
+    attr=$1
+    filter=$2
+    expect=$3
+
+    new "get-config $attr $filter"
+    if [ -z "$expect" ]; then
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config $attr><source><running/></source>$filter</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+    else
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config $attr><source><running/></source>$filter</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$expect</data></rpc-reply>"
+    fi
+}
+
+WD="<with-defaults xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults\">"
+WDNS="xmlns:wd=\"urn:ietf:params:xml:ns:netconf:default:1.0\""
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "add entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value><mtu>9000</mtu></parameter><parameter><name>c</name><value>3</value><mtu>1500</mtu></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+ALL="<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value><mtu>9000</mtu></parameter><parameter><name>c</name><value>3</value><mtu>1500</mtu></parameter></table>"
+
+get "" "" "$ALL"
+
+# xpath
+get "" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='b']\" xmlns:ex=\"urn:example:clixon\"/>" "<table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value><mtu>9000</mtu></parameter></table>"
+
+new "xpath leaf includes list key"
+get "" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']/ex:value\" xmlns:ex=\"urn:example:clixon\"/>" "<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table>"
+
+get "" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='x']\" xmlns:ex=\"urn:example:clixon\"/>" ""
+
+# depth
+get "depth=\"1\"" "" "<table xmlns=\"urn:example:clixon\"></table>"
+
+get "depth=\"2\"" "" "<table xmlns=\"urn:example:clixon\"><parameter></parameter><parameter></parameter><parameter></parameter></table>"
+
+get "depth=\"3\"" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='b']\" xmlns:ex=\"urn:example:clixon\"/>" "<table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value><mtu>9000</mtu></parameter></table>"
+
+# with-defaults
+get "" "${WD}report-all</with-defaults>" "<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value><mtu>1500</mtu></parameter><parameter><name>b</name><value>2</value><mtu>9000</mtu></parameter><parameter><name>c</name><value>3</value><mtu>1500</mtu></parameter></table>"
+
+get "" "${WD}trim</with-defaults>" "<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value><mtu>9000</mtu></parameter><parameter><name>c</name><value>3</value></parameter></table>"
+
+get "" "${WD}report-all-tagged</with-defaults>" "<table xmlns=\"urn:example:clixon\" $WDNS><parameter><name>a</name><value>1</value><mtu wd:default=\"true\">1500</mtu></parameter><parameter><name>b</name><value>2</value><mtu>9000</mtu></parameter><parameter><name>c</name><value>3</value><mtu wd:default=\"true\">1500</mtu></parameter></table>"
+
+get "" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']\" xmlns:ex=\"urn:example:clixon\"/>${WD}report-all-tagged</with-defaults>" "<table xmlns=\"urn:example:clixon\" $WDNS><parameter><name>a</name><value>1</value><mtu wd:default=\"true\">1500</mtu></parameter></table>"
+
+new "cache not modified by report-all-tagged"
+get "" "" "$ALL"
+
+get "depth=\"1\"" "" "<table xmlns=\"urn:example:clixon\"></table>"
+
+# Consecutive views with an edit in between, which sets and resets flags of the cache
+new "view before edit"
+get "" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']\" xmlns:ex=\"urn:example:clixon\"/>" "<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table>"
+
+new "edit entry b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>22</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit edit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "view after edit, only c"
+get "" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='c']\" xmlns:ex=\"urn:example:clixon\"/>" "<table xmlns=\"urn:example:clixon\"><parameter><name>c</name><value>3</value><mtu>1500</mtu></parameter></table>"
+
+new "view after edit, only b"
+get "" "<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='b']\" xmlns:ex=\"urn:example:clixon\"/>" "<table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>22</value><mtu>9000</mtu></parameter></table>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Event loop performance: per-event dispatch latency using select and epoll
+# A C program registers N pipes in the clixon event loop. Each callback reads a byte and
+# writes a byte to another pipe, measuring the time from write to callback.
+# select is limited to FD_SETSIZE, so only smaller sizes are measured with select.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of events to dispatch in each run
+: ${perfnr:=100000}
+
+cfile=$dir/event_bench.c
+app=$dir/event_bench
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static int              _npipes;
+static int              _nevents;
+static int              _count = 0;
+static int            (*_pfd)[2];
+static struct timespec  _tsent;
+static double           _total = 0.0;
+
+static int
+pipe_cb(int   fd,
+        void *arg)
+{
+    struct timespec t;
+    char            c;
+    int             i = (intptr_t)arg;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    if (read(fd, &c, 1) != 1)
+        return -1;
+    _total += (t.tv_sec - _tsent.tv_sec)*1e9 + (t.tv_nsec - _tsent.tv_nsec);
+    if (++_count >= _nevents){
+        clixon_exit_set(1);
+        return 0;
+    }
+    i = (int)(((int64_t)i*7919 + 1) % _npipes); /* Spread over all pipes */
+    clock_gettime(CLOCK_MONOTONIC, &_tsent);
+    if (write(_pfd[i][1], "x", 1) != 1)
+        return -1;
+    return 0;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    clixon_handle h;
+    int           i;
+
+    if (argc != 4){
+        fprintf(stderr, "usage: %s <nfds> <nevents> select|epoll\n", argv[0]);
+        exit(1);
+    }
+    _npipes = atoi(argv[1]);
+    _nevents = atoi(argv[2]);
+    if ((h = clixon_handle_init()) == NULL)
+        exit(1);
+    clicon_option_str_set(h, "CLICON_EVENT_EPOLL", strcmp(argv[3], "epoll")==0?"true":"false");
+    if ((_pfd = calloc(_npipes, sizeof(*_pfd))) == NULL)
+        exit(1);
+    for (i=0; i<_npipes; i++){
+        if (pipe(_pfd[i]) < 0){
+            perror("pipe");
+            exit(1);
+        }
+        if (clixon_event_reg_fd(_pfd[i][0], pipe_cb, (void*)(intptr_t)i, "bench pipe") < 0)
+            exit(1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &_tsent);
+    if (write(_pfd[0][1], "x", 1) != 1)
+        exit(1);
+    if (clixon_event_loop(h) < 0)
+        exit(1);
+    printf("%s %d fds: %.2f us/event\n", argv[3], _npipes, _total/_count/1000);
+    clixon_event_exit();
+    clixon_handle_exit(h);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+# Each pipe uses two file descriptors
+ulimit -n 20100 2> /dev/null
+
+# select: both pipe ends must be below FD_SETSIZE
+for mode in select epoll; do
+    if [ $mode = select ]; then
+        sizes="10 500"
+    else
+        sizes="10 1000 10000"
+    fi
+    for nr in $sizes; do
+        if [ $((2*nr+10)) -gt $(ulimit -n) ]; then
+            echo "Skip $mode $nr fds: open file limit $(ulimit -n)"
+            continue
+        fi
+        new "$mode: dispatch $perfnr events over $nr fds"
+        res=$($app $nr $perfnr $mode)
+        expectpart "$res" 0 "$mode $nr fds:"
+        echo "$res"
+    done
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
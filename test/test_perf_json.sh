@@ -1,6 +1,7 @@
 #!/usr/bin/env bash
 # JSON performance test:
 # 1. parse a long string
+# 2. parse a long list bound to yang, with identityref values, in reverse order
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -11,6 +12,32 @@ s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 : ${perfnr:=100000}
 
 fjson=$dir/long.json
+fyang=$dir/example.yang
+
+cat <<EOF > $fyang
+module example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    identity base;
+    identity eth{
+        base base;
+    }
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type uint32;
+            }
+            leaf type{
+                type identityref{
+                    base base;
+                }
+            }
+        }
+    }
+}
+EOF
 
 new "generate long file $fjson"
 echo -n '{"foo": "' > $fjson
@@ -24,6 +51,16 @@ new "json parse long string"
 #expecteof_file "$clixon_util_json" 0 "$fjson"
 expecteof_file "time -p $clixon_util_json -j" 0 "$fjson" "$fjson" 2>&1 | awk '/real/ {print $2}'
 
+new "generate long list $fjson"
+echo -n '{"example:table":{"parameter":[' > $fjson
+for (( i=$perfnr; i>1; i-- )); do
+    echo -n "{\"name\":$i,\"type\":\"example:eth\"}," >> $fjson
+done
+echo '{"name":1,"type":"example:eth"}]}}' >> $fjson
+
+new "json parse long list"
+expecteof_file "time -p $clixon_util_json -jy $fyang" 0 "$fjson" '^\{"example:table":\{"parameter":\[\{"name":1,"type":"example:eth"\},\{"name":2,"type":"example:eth"\},' 2>&1 | awk '/real/ {print $2}'
+
 rm -rf $dir
 
 new "endtest"
@@ -0,0 +1,171 @@
+#!/usr/bin/env bash
+# Backend IPC throughput using pipelined requests
+# A C program sends get-config requests to the backend with up to 1, 8 and 64 outstanding
+# requests on one socket, see clicon_rpc_pipe_send(). Replies are correlated by message-id.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Number of requests in each run
+: ${perfnr:=20000}
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+cfile=$dir/pipe_bench.c
+app=$dir/pipe_bench
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static int _nreplies = 0;
+static int _nerrors = 0;
+
+static int
+reply_cb(clixon_handle h,
+         cxobj        *xret,
+         void         *arg)
+{
+    _nreplies++;
+    if (xpath_first(xret, NULL, "rpc-reply/data") == NULL)
+        _nerrors++;
+    return 0;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    clixon_handle    h;
+    clicon_rpc_pipe *cp;
+    struct timespec  t0;
+    struct timespec  t1;
+    double           t;
+    int              depth;
+    int              nr;
+    int              i;
+
+    if (argc != 4){
+        fprintf(stderr, "usage: %s <sock> <depth> <nr>\n", argv[0]);
+        exit(1);
+    }
+    depth = atoi(argv[2]);
+    nr = atoi(argv[3]);
+    if ((h = clixon_handle_init()) == NULL)
+        exit(1);
+    clicon_option_str_set(h, "CLICON_SOCK", argv[1]);
+    if ((cp = clicon_rpc_pipe_new(h, depth)) == NULL)
+        exit(1);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<nr; i++)
+        if (clicon_rpc_pipe_send(cp, "<get-config><source><running/></source></get-config>",
+                                 reply_cb, NULL) < 0)
+            exit(1);
+    if (clicon_rpc_pipe_drain(cp) < 0)
+        exit(1);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+    printf("depth %d: %d replies %d errors %.0f req/s\n", depth, _nreplies, _nerrors, nr/t);
+    clicon_rpc_pipe_free(cp);
+    clixon_handle_exit(h);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+# Access to backend socket
+if [ -n "$CLICON_GROUP" ]; then
+    app="sudo -g ${CLICON_GROUP} $app"
+fi
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "add config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+for depth in 1 8 64; do
+    new "pipeline depth $depth: $perfnr get-config"
+    res=$($app $dir/$APPNAME.sock $depth $perfnr)
+    expectpart "$res" 0 "depth $depth: $perfnr replies 0 errors"
+    echo "$res"
+done
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
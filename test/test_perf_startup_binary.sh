@@ -0,0 +1,144 @@
+#!/usr/bin/env bash
+# Startup performance comparison of datastore formats: xml, json and binary
+# For each format, a large config is loaded via netconf and copied to startup,
+# then the time to start the backend from the startup datastore is measured.
+# Also check that the binary datastore is read back correctly, including keyed lookups
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in file
+: ${perfnr:=20000}
+
+APPNAME=example
+
+cfg=$dir/scaling-conf.xml
+fyang=$dir/scaling.yang
+fconfigonly=$dir/config.xml
+fconfig=$dir/large.xml
+foutput=$dir/output.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ip;
+   container "x0" {
+     container x1 {
+       list x2 {
+         key "name";
+         leaf name {
+           type string;
+         }
+         container x {
+           list y {
+             key "a";
+             leaf a {
+               type int32;
+             }
+             leaf b {
+               type int32;
+             }
+           }
+           leaf-list c {
+             type string;
+           }
+         }
+       }
+     }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+new "generate config with $perfnr list entries"
+echo -n "<x0 xmlns=\"urn:example:clixon\"><x1><x2><name>ip</name><x>" > $fconfigonly
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>$i</b></y>" >> $fconfigonly
+done
+echo -n "</x></x2></x1></x0>" >> $fconfigonly # No CR
+
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+rpc+="$(cat $fconfigonly)"
+rpc+="</config></edit-config></rpc>"
+
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+for format in xml json binary; do
+    sudo rm -f $dir/*_db
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_XMLDB_FORMAT=$format"
+        start_backend -s init -f $cfg -o CLICON_XMLDB_FORMAT=$format
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf write large config"
+    expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+    new "netconf commit large config"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf copy running to startup"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><copy-config><target><startup/></target><source><running/></source></copy-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+    fi
+
+    new "Startup $format"
+    # Cannot use start_backend here due to expected error case
+    { time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg -o CLICON_XMLDB_FORMAT=$format 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+    if [ $BE -ne 0 ]; then
+        new "start backend -s running -f $cfg -o CLICON_XMLDB_FORMAT=$format"
+        start_backend -s running -f $cfg -o CLICON_XMLDB_FORMAT=$format
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "Check running-db contents"
+    rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>")
+    echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg > $foutput
+
+    rpc="<rpc-reply $DEFAULTNS><data>"
+    rpc+="$(cat $fconfigonly)"
+    rpc+="</data></rpc-reply>"
+    expectpart "$(cat $foutput)" 0 "$(chunked_framing "$rpc")"
+
+    # Search on typed int32 list keys of the loaded tree
+    new "Check keyed lookup in running-db"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ip:x0/ip:x1/ip:x2[ip:name='ip']/ip:x/ip:y[ip:a='42']\" xmlns:ip=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x0 xmlns=\"urn:example:clixon\"><x1><x2><name>ip</name><x><y><a>42</a><b>42</b></y></x></x2></x1></x0></data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+    fi
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,217 @@
+#!/usr/bin/env bash
+# Event loop timer performance: many concurrent timers
+# A C program registers N timers expiring randomly within one second, cancels every second
+# timer by reference, and then runs the event loop until all remaining timers have fired.
+# Reports registration and cancel time, and how late timers fire.
+# Also check that a timer registered by a timer callback, even if already expired, does not
+# delay other expired timers, and is called in the next round.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of timers
+: ${perfnr:=100000}
+
+cfile=$dir/timer_bench.c
+app=$dir/timer_bench
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static int            _ntimers;
+static int            _fired = 0;
+static int            _remaining;
+static struct timeval *_tv;
+static void          **_refs;
+static double         _late = 0.0;
+static double         _latemax = 0.0;
+static struct timeval  _tprev = {0,};
+static int            _order = 0;
+
+static double
+tv2us(struct timeval *t)
+{
+    return t->tv_sec*1e6 + t->tv_usec;
+}
+
+static int
+timer_cb(int   dummy,
+         void *arg)
+{
+    struct timeval t;
+    struct timeval td;
+    int            i = (intptr_t)arg;
+
+    gettimeofday(&t, NULL);
+    timersub(&t, &_tv[i], &td);
+    _late += tv2us(&td);
+    if (tv2us(&td) > _latemax)
+        _latemax = tv2us(&td);
+    if (timercmp(&_tv[i], &_tprev, <))
+        _order++;
+    _tprev = _tv[i];
+    _refs[i] = NULL;
+    _fired++;
+    if (--_remaining == 0)
+        clixon_exit_set(1);
+    return 0;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    clixon_handle  h;
+    struct timeval t0;
+    struct timeval t1;
+    struct timeval td;
+    int            i;
+    int            ncancel = 0;
+
+    if (argc != 2){
+        fprintf(stderr, "usage: %s <ntimers>\n", argv[0]);
+        exit(1);
+    }
+    _ntimers = atoi(argv[1]);
+    if ((h = clixon_handle_init()) == NULL)
+        exit(1);
+    if ((_tv = calloc(_ntimers, sizeof(*_tv))) == NULL ||
+        (_refs = calloc(_ntimers, sizeof(*_refs))) == NULL)
+        exit(1);
+    srandom(42);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<_ntimers; i++){
+        /* Expire randomly within 1s from 0.5s from now */
+        td.tv_sec = 0;
+        td.tv_usec = 500000 + random()%1000000;
+        if (td.tv_usec >= 1000000){
+            td.tv_sec++;
+            td.tv_usec -= 1000000;
+        }
+        timeradd(&t0, &td, &_tv[i]);
+        if (clixon_event_reg_timeout_ref(_tv[i], timer_cb, (void*)(intptr_t)i, "bench timer", &_refs[i]) < 0)
+            exit(1);
+    }
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &td);
+    printf("register %d timers: %.3f s\n", _ntimers, tv2us(&td)/1e6);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<_ntimers; i+=2){
+        if (clixon_event_unreg_timeout_ref(_refs[i]) < 0)
+            exit(1);
+        _refs[i] = NULL;
+        ncancel++;
+    }
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &td);
+    printf("cancel %d timers: %.3f s\n", ncancel, tv2us(&td)/1e6);
+    _remaining = _ntimers - ncancel;
+    if (clixon_event_loop(h) < 0)
+        exit(1);
+    printf("fired %d timers: late avg %.1f us max %.1f us, out of order %d\n",
+           _fired, _late/_fired, _latemax, _order);
+    clixon_event_exit();
+    clixon_handle_exit(h);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "$perfnr timers"
+res=$($app $perfnr)
+expectpart "$res" 0 "register $perfnr timers:" "fired $((perfnr/2)) timers:" "out of order 0"
+echo "$res"
+
+cfile=$dir/timer_order.c
+app=$dir/timer_order
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static struct timeval _t0;
+
+static int
+order_cb(int   dummy,
+         void *arg)
+{
+    struct timeval t;
+    char           name = (char)(intptr_t)arg;
+
+    printf("%c", name);
+    if (name == 'a'){
+        /* Register already expired timer, earlier than b and c */
+        t = _t0;
+        t.tv_sec -= 10;
+        if (clixon_event_reg_timeout(t, order_cb, (void*)(intptr_t)'d', "order timer") < 0)
+            return -1;
+    }
+    else if (name == 'd'){
+        printf("\\n");
+        clixon_exit_set(1);
+    }
+    return 0;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    clixon_handle  h;
+    struct timeval t;
+    int            i;
+
+    if ((h = clixon_handle_init()) == NULL)
+        exit(1);
+    gettimeofday(&_t0, NULL);
+    for (i=0; i<3; i++){
+        t = _t0;
+        t.tv_sec -= 3 - i;
+        if (clixon_event_reg_timeout(t, order_cb, (void*)(intptr_t)('a'+i), "order timer") < 0)
+            exit(1);
+    }
+    if (clixon_event_loop(h) < 0)
+        exit(1);
+    clixon_event_exit();
+    clixon_handle_exit(h);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "expired timers in order, timer registered by callback last"
+expectpart "$($app)" 0 "^abcd$"
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,266 @@
+#!/usr/bin/env bash
+# Backend read workers, CLICON_BACKEND_READ_WORKERS
+# A C program runs N reader processes doing get-config of a large config in a loop and one
+# writer doing edit-config + commit. Run with read workers disabled and enabled, and
+# compare writer commit rate and total read rate.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Number of list entries in config
+: ${perfnr:=10000}
+
+# Number of reader processes
+: ${perfreaders:=8}
+
+# Number of writer commits
+: ${perfwrites:=50}
+
+# Number of read workers when enabled
+: ${perfworkers:=4}
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fconfig=$dir/large.xml
+cfile=$dir/workers_bench.c
+app=$dir/workers_bench
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static volatile sig_atomic_t _stop = 0;
+static int _nreplies = 0;
+static int _nerrors = 0;
+
+static void
+stop_handler(int sig)
+{
+    _stop = 1;
+}
+
+static int
+reply_cb(clixon_handle h,
+         cxobj        *xret,
+         void         *arg)
+{
+    _nreplies++;
+    if (xpath_first(xret, NULL, "rpc-reply/rpc-error") != NULL)
+        _nerrors++;
+    return 0;
+}
+
+/* Reader: get-config until stopped, write number of replies to fd */
+static void
+reader(clixon_handle h,
+       int           fd)
+{
+    clicon_rpc_pipe *cp;
+
+    signal(SIGTERM, stop_handler);
+    if ((cp = clicon_rpc_pipe_new(h, 1)) == NULL)
+        exit(1);
+    while (!_stop)
+        if (clicon_rpc_pipe_send(cp, "<get-config><source><running/></source></get-config>",
+                                 reply_cb, NULL) < 0 ||
+            clicon_rpc_pipe_drain(cp) < 0)
+            exit(1);
+    if (write(fd, &_nreplies, sizeof(_nreplies)) < 0)
+        exit(1);
+    clicon_rpc_pipe_free(cp);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    clixon_handle    h;
+    clicon_rpc_pipe *cp;
+    struct timespec  t0;
+    struct timespec  t1;
+    double           t;
+    int              readers;
+    int              writes;
+    int              fds[2];
+    pid_t           *pids;
+    int              nreads = 0;
+    int              n;
+    int              i;
+    char             body[256];
+
+    if (argc != 4){
+        fprintf(stderr, "usage: %s <sock> <readers> <writes>\n", argv[0]);
+        exit(1);
+    }
+    readers = atoi(argv[2]);
+    writes = atoi(argv[3]);
+    if ((h = clixon_handle_init()) == NULL)
+        exit(1);
+    clicon_option_str_set(h, "CLICON_SOCK", argv[1]);
+    if (pipe(fds) < 0)
+        exit(1);
+    if ((pids = calloc(readers, sizeof(pid_t))) == NULL)
+        exit(1);
+    for (i=0; i<readers; i++)
+        if ((pids[i] = fork()) == 0)
+            reader(h, fds[1]);
+    close(fds[1]);
+    usleep(100000);
+    if ((cp = clicon_rpc_pipe_new(h, 1)) == NULL)
+        exit(1);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<writes; i++){
+        snprintf(body, sizeof(body), "<edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>w</name><value>%d</value></parameter></table></config></edit-config>", i);
+        if (clicon_rpc_pipe_send(cp, body, reply_cb, NULL) < 0 ||
+            clicon_rpc_pipe_send(cp, "<commit/>", reply_cb, NULL) < 0 ||
+            clicon_rpc_pipe_drain(cp) < 0)
+            exit(1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+    for (i=0; i<readers; i++)
+        kill(pids[i], SIGTERM);
+    while (read(fds[0], &n, sizeof(n)) == sizeof(n))
+        nreads += n;
+    for (i=0; i<readers; i++)
+        waitpid(pids[i], NULL, 0);
+    printf("readers %d: %d commits %d errors %.1f commits/s %.1f reads/s\n",
+           readers, writes, _nerrors, writes/t, nreads/t);
+    clicon_rpc_pipe_free(cp);
+    free(pids);
+    clixon_handle_exit(h);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+# Access to backend socket
+if [ -n "$CLICON_GROUP" ]; then
+    app="sudo -g ${CLICON_GROUP} $app"
+fi
+
+new "generate config with $perfnr list entries"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$perfnr; i++ )); do
+    rpc+="<parameter><name>$i</name><value>$i</value></parameter>"
+done
+rpc+="</table></config></edit-config></rpc>"
+
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+for workers in 0 $perfworkers; do
+    new "test params: -f $cfg -o CLICON_BACKEND_READ_WORKERS=$workers"
+
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_BACKEND_READ_WORKERS=$workers"
+        start_backend -s init -f $cfg -o CLICON_BACKEND_READ_WORKERS=$workers
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "add $perfnr entries"
+    expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "workers $workers: $perfreaders readers, $perfwrites commits"
+    res=$($app $dir/$APPNAME.sock $perfreaders $perfwrites)
+    expectpart "$res" 0 "readers $perfreaders: $perfwrites commits 0 errors"
+    echo "workers $workers: $res"
+
+    new "check running"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='w']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>w</name><value>$((perfwrites-1))</value></parameter></table></data></rpc-reply>"
+
+    new "get out-rpc-errors"
+    rpc=$(chunked_framing "<rpc $DEFAULTNS><get><filter type=\"subtree\"><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><statistics><out-rpc-errors/></statistics></netconf-state></filter></get></rpc>")
+    ret=$($clixon_netconf -qf $cfg<<EOF
+$DEFAULTHELLO$rpc
+EOF
+       )
+    errors=$(echo "$ret" | grep -Eo "<out-rpc-errors>[0-9]+</out-rpc-errors>" | grep -Eo "[0-9]+")
+    if [ -z "$errors" ]; then
+        err "<out-rpc-errors>" "$ret"
+    fi
+
+    # get-config is handled by a worker if enabled, the error is counted by the backend
+    new "get-config invalid xpath error"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table[\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error>"
+
+    new "out-rpc-errors incremented"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"subtree\"><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><statistics><out-rpc-errors/></statistics></netconf-state></filter></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><statistics><out-rpc-errors>$((errors+1))</out-rpc-errors></statistics></netconf-state></data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
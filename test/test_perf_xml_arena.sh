@@ -0,0 +1,271 @@
+#!/usr/bin/env bash
+# XML arena allocation, see xml_new_arena
+# A C program parses and frees a large XML tree in a loop, with the tree allocated from
+# the heap or from an arena. Print parse+free cycles per second and peak RSS.
+# A second C program checks that arena memory is given back: when a tree is freed, and
+# when nodes moved to another tree are freed. Memory of arenas pinned by moved nodes is
+# limited, see XML_ARENA_PINNED_MAX.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in XML
+: ${perfnr:=20000}
+
+# Number of parse+free cycles
+: ${perfreq:=20}
+
+fxml=$dir/large.xml
+cfile=$dir/arena_bench.c
+app=$dir/arena_bench
+cfile2=$dir/arena_release.c
+app2=$dir/arena_release
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+int
+main(int    argc,
+     char **argv)
+{
+    FILE            *f;
+    struct stat      st;
+    char            *str;
+    cxobj           *xt;
+    int              arena;
+    int              nr;
+    int              i;
+    struct timespec  t0;
+    struct timespec  t1;
+    double           t;
+    struct rusage    ru;
+
+    if (argc != 4){
+        fprintf(stderr, "usage: %s <file> <heap|arena> <nr>\n", argv[0]);
+        exit(1);
+    }
+    arena = strcmp(argv[2], "arena") == 0;
+    nr = atoi(argv[3]);
+    if (stat(argv[1], &st) < 0 || (f = fopen(argv[1], "r")) == NULL)
+        exit(1);
+    if ((str = malloc(st.st_size + 1)) == NULL)
+        exit(1);
+    if (fread(str, 1, st.st_size, f) != st.st_size)
+        exit(1);
+    str[st.st_size] = '\0';
+    fclose(f);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<nr; i++){
+        xt = NULL;
+        if (arena && (xt = xml_new_arena(XML_TOP_SYMBOL, CX_ELMNT)) == NULL)
+            exit(1);
+        if (clixon_xml_parse_string(str, YB_NONE, NULL, &xt, NULL) < 0)
+            exit(1);
+        xml_free(xt);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("%s: %d cycles %.1f cycles/s maxrss %ld KB\n", argv[2], nr, nr/t, ru.ru_maxrss);
+    free(str);
+    return 0;
+}
+EOF
+
+cat<<EOF > $cfile2
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+/* Bytes of heap in use, or 0 if not known */
+static size_t
+heap_used(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/* Parse string into new arena tree, return the top node */
+static cxobj *
+parse_arena(char *str)
+{
+    cxobj *xt;
+
+    if ((xt = xml_new_arena(XML_TOP_SYMBOL, CX_ELMNT)) == NULL)
+        exit(1);
+    if (clixon_xml_parse_string(str, YB_NONE, NULL, &xt, NULL) < 0)
+        exit(1);
+    return xt;
+}
+
+/* Check that no arena and no XML node remain, and heap is back to h0 */
+static void
+check_empty(char  *what,
+            size_t h0)
+{
+    uint64_t anr;
+    size_t   pinned;
+    uint64_t xnr;
+    size_t   h;
+
+    xml_arena_stats(&anr, &pinned);
+    xml_stats_global(&xnr);
+    if (anr != 0 || pinned != 0 || xnr != 0){
+        fprintf(stderr, "%s: arenas %lu pinned %zu nodes %lu\n", what,
+                (unsigned long)anr, pinned, (unsigned long)xnr);
+        exit(1);
+    }
+    /* Allow for malloc bookkeeping, much less than one arena */
+    h = heap_used();
+    if (h0 && h > h0 + 64*1024){
+        fprintf(stderr, "%s: heap %zu bytes, expected %zu\n", what, h, h0);
+        exit(1);
+    }
+    printf("%s: memory released\n", what);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    FILE            *f;
+    struct stat      st;
+    char            *str;
+    cxobj           *xt;
+    cxobj           *xh;
+    cxobj           *xc;
+    int              nr;
+    int              i;
+    int              kept;
+    uint64_t         anr;
+    size_t           pinned;
+    size_t           pinned0;
+    size_t           h0;
+
+    if (argc != 3){
+        fprintf(stderr, "usage: %s <file> <nr>\n", argv[0]);
+        exit(1);
+    }
+    nr = atoi(argv[2]);
+    if (stat(argv[1], &st) < 0 || (f = fopen(argv[1], "r")) == NULL)
+        exit(1);
+    if ((str = malloc(st.st_size + 1)) == NULL)
+        exit(1);
+    if (fread(str, 1, st.st_size, f) != st.st_size)
+        exit(1);
+    str[st.st_size] = '\0';
+    fclose(f);
+    /* Warm up, eg intern table, before heap baseline */
+    xml_free(parse_arena(str));
+    h0 = heap_used();
+    /* 1. Top node freed: whole arena released */
+    for (i=0; i<nr; i++)
+        xml_free(parse_arena(str));
+    check_empty("free", h0);
+    /* 2. A node of each tree moved to a heap tree: arena pinned until the node is freed */
+    if ((xh = xml_new("keep", NULL, CX_ELMNT)) == NULL)
+        exit(1);
+    kept = 0;
+    pinned0 = 0;
+    for (i=0; i<10000; i++){
+        xt = parse_arena(str);
+        if ((xc = xml_child_i_type(xml_child_i_type(xt, 0, CX_ELMNT), 0, CX_ELMNT)) == NULL)
+            exit(1);
+        if (xml_rm(xc) < 0 || xml_addsub(xh, xc) < 0)
+            exit(1);
+        xml_free(xt);
+        if (xml_arena_stats(&anr, &pinned) < 0)
+            exit(1);
+        if (pinned == pinned0) /* Limit reached, tree from heap */
+            break;
+        pinned0 = pinned;
+        kept++;
+    }
+    if (i == 10000){
+        fprintf(stderr, "pinned: no limit, %zu bytes\n", pinned);
+        exit(1);
+    }
+    /* Stays at limit */
+    for (i=0; i<nr; i++){
+        xt = parse_arena(str);
+        xc = xml_child_i_type(xml_child_i_type(xt, 0, CX_ELMNT), 0, CX_ELMNT);
+        if (xml_rm(xc) < 0 || xml_addsub(xh, xc) < 0)
+            exit(1);
+        xml_free(xt);
+    }
+    xml_arena_stats(&anr, &pinned);
+    if (pinned != pinned0 || anr != (uint64_t)kept){
+        fprintf(stderr, "pinned: %zu bytes in %lu arenas, expected %zu in %d\n",
+                pinned, (unsigned long)anr, pinned0, kept);
+        exit(1);
+    }
+    printf("pinned: limit reached\n");
+    xml_free(xh);
+    check_empty("moved", h0);
+    free(str);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "compile $cfile2 -> $app2"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile2 -o $app2 /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile2 -o $app2 -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "generate XML with $perfnr list entries"
+echo -n "<table xmlns=\"urn:example:clixon\">" > $fxml
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>$i</name><value>$i</value></parameter>" >> $fxml
+done
+echo "</table>" >> $fxml
+
+for alloc in heap arena; do
+    new "$alloc: $perfreq parse+free cycles"
+    res=$($app $fxml $alloc $perfreq)
+    expectpart "$res" 0 "$alloc: $perfreq cycles"
+    echo "$res"
+done
+
+new "arena memory released when trees and moved nodes are freed"
+expectpart "$($app2 $fxml 4)" 0 "free: memory released" "pinned: limit reached" "moved: memory released"
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,120 @@
+#!/usr/bin/env bash
+# XML and JSON character data escaping, see xml_chardata_cbuf_append
+# A C program checks encoding and decoding of some strings, then measures encoding
+# throughput of typical config bodies: names, addresses, descriptions and long text.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of encoding rounds over all bodies
+: ${perfnr:=200000}
+
+cfile=$dir/escape_bench.c
+app=$dir/escape_bench
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static char *bodies[] = {
+    "eth0",
+    "10.0.0.1",
+    "2001:db8::1/64",
+    "true",
+    "1500",
+    "Uplink to core router, do not shut down",
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.",
+    "a < b && c > d",
+    NULL
+};
+
+static int
+check(int   quote,
+      char *str,
+      char *expect)
+{
+    char *enc = NULL;
+    char *dec = NULL;
+
+    if (xml_chardata_encode(&enc, quote, "%s", str) < 0)
+        return -1;
+    if (strcmp(enc, expect) != 0){
+        fprintf(stderr, "encode %s: %s expected %s\n", str, enc, expect);
+        return -1;
+    }
+    if (xml_chardata_decode(&dec, "%s", enc) < 0)
+        return -1;
+    if (strstr(str, "<![CDATA[") == NULL && strcmp(dec, str) != 0){
+        fprintf(stderr, "decode %s: %s expected %s\n", enc, dec, str);
+        return -1;
+    }
+    free(enc);
+    free(dec);
+    return 0;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    cbuf           *cb;
+    int             nr;
+    int             i;
+    int             j;
+    uint64_t        bytes = 0;
+    struct timespec t0;
+    struct timespec t1;
+    double          t;
+
+    if (argc != 2){
+        fprintf(stderr, "usage: %s <nr>\n", argv[0]);
+        exit(1);
+    }
+    nr = atoi(argv[1]);
+    if (check(0, "plain text", "plain text") < 0 ||
+        check(0, "a<b>c&d'e\"f", "a&lt;b&gt;c&amp;d'e\"f") < 0 ||
+        check(1, "a<b>c&d'e\"f", "a&lt;b&gt;c&amp;d&apos;e&quot;f") < 0 ||
+        check(0, "x<![CDATA[<&>]]>&y", "x<![CDATA[<&>]]>&amp;y") < 0 ||
+        check(0, "", "") < 0)
+        exit(1);
+    if ((cb = cbuf_new()) == NULL)
+        exit(1);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<nr; i++){
+        for (j=0; bodies[j]; j++){
+            cbuf_reset(cb);
+            xml_chardata_cbuf_append(cb, 0, bodies[j]);
+            bytes += cbuf_len(cb);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+    printf("encoded: %.1f MB/s\n", bytes/t/1e6);
+    cbuf_free(cb);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "check and $perfnr encoding rounds"
+res=$($app $perfnr)
+expectpart "$res" 0 "encoded: "
+echo "$res"
+
+rm -rf $dir
+
+new "endtest"
+endtest
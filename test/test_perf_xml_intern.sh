@@ -0,0 +1,114 @@
+#!/usr/bin/env bash
+# XML name interning, see clixon_intern
+# A C program parses a large XML tree and prints tree memory and interned string
+# statistics, then times xml_find() lookups of a child name in every list entry.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in XML
+: ${perfnr:=20000}
+
+# Number of lookup rounds over all list entries
+: ${perfreq:=100}
+
+fxml=$dir/large.xml
+cfile=$dir/intern_bench.c
+app=$dir/intern_bench
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+int
+main(int    argc,
+     char **argv)
+{
+    FILE            *f;
+    struct stat      st;
+    char            *str;
+    cxobj           *xt = NULL;
+    cxobj           *xtable;
+    cxobj           *x;
+    int              nr;
+    int              i;
+    uint64_t         xnr = 0;
+    size_t           xsz = 0;
+    uint64_t         inr = 0;
+    size_t           isz = 0;
+    uint64_t         found = 0;
+    struct timespec  t0;
+    struct timespec  t1;
+    double           t;
+
+    if (argc != 3){
+        fprintf(stderr, "usage: %s <file> <nr>\n", argv[0]);
+        exit(1);
+    }
+    nr = atoi(argv[2]);
+    if (stat(argv[1], &st) < 0 || (f = fopen(argv[1], "r")) == NULL)
+        exit(1);
+    if ((str = malloc(st.st_size + 1)) == NULL)
+        exit(1);
+    if (fread(str, 1, st.st_size, f) != st.st_size)
+        exit(1);
+    str[st.st_size] = '\0';
+    fclose(f);
+    if (clixon_xml_parse_string(str, YB_NONE, NULL, &xt, NULL) < 0)
+        exit(1);
+    if ((xtable = xml_find(xt, "table")) == NULL)
+        exit(1);
+    xml_stats(xt, &xnr, &xsz);
+    clixon_intern_stats(&inr, &isz);
+    printf("nodes: %" PRIu64 " tree: %zu bytes interned: %" PRIu64 " strings %zu bytes\n",
+           xnr, xsz, inr, isz);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<nr; i++){
+        x = NULL;
+        while ((x = xml_child_each(xtable, x, CX_ELMNT)) != NULL)
+            if (xml_find(x, "value") != NULL)
+                found++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+    printf("lookups: %" PRIu64 " %.1f lookups/s\n", found, found/t);
+    xml_free(xt);
+    free(str);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "generate XML with $perfnr list entries"
+echo -n "<table xmlns=\"urn:example:clixon\">" > $fxml
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>$i</name><value>$i</value></parameter>" >> $fxml
+done
+echo "</table>" >> $fxml
+
+new "parse and $perfreq lookup rounds"
+res=$($app $fxml $perfreq)
+expectpart "$res" 0 "nodes: " "lookups: $((perfnr*perfreq)) "
+echo "$res"
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+# Streamed replies, CLICON_REPLY_STREAM_SIZE
+# get and get-config replies larger than the stream size are sent from the backend in
+# several chunks while serialized, and written by the netconf client in several parts.
+# Check that:
+# - large replies are complete and have the message-id of the request
+# - small replies are not affected
+# - large replies are complete also if replies are validated, CLICON_VALIDATE_STATE_XML
+# - a client closing during a streamed reply closes the session, the backend continues
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+# Number of list entries, each around 80 bytes
+: ${nr:=1000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_REPLY_STREAM_SIZE>1024</CLICON_REPLY_STREAM_SIZE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+
+# Startup datastore and expected reply, where entries are sorted by name
+conf="<table xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$nr; i++ )); do
+    conf="$conf<parameter><name>p$i</name><value>value of parameter number $i</value></parameter>"
+done
+conf="$conf</table>"
+expect="<table xmlns=\"urn:example:clixon\">"
+for name in $(for (( i=0; i<$nr; i++ )); do echo p$i; done | LC_ALL=C sort); do
+    expect="$expect<parameter><name>$name</name><value>value of parameter number ${name#p}</value></parameter>"
+done
+expect="$expect</table>"
+echo "<${DATASTORE_TOP}>$conf</${DATASTORE_TOP}>" > $dir/startup_db
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get-config streamed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$expect</data></rpc-reply>"
+
+new "get streamed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"config\"/></rpc>" "" "<rpc-reply $DEFAULTNS><data>$expect</data></rpc-reply>"
+
+new "get-config not streamed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p42']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>p42</name><value>value of parameter number 42</value></parameter></table></data></rpc-reply>"
+
+new "edit-config after streamed replies"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>p42</name><value>42</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+# Validate replies
+sed -i 's|</clixon-config>|  <CLICON_VALIDATE_STATE_XML>true</CLICON_VALIDATE_STATE_XML>\n</clixon-config>|' $cfg
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get validated"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"config\"/></rpc>" "" "<rpc-reply $DEFAULTNS><data>$expect</data></rpc-reply>"
+
+new "get-config validated"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$expect</data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+# Client closes during a streamed reply: the reply is larger than the socket buffers, so
+# sending the rest fails after the first parts are sent.
+# The backend closes the session instead of appending an rpc-error to the partial reply
+sed -i 's|<CLICON_VALIDATE_STATE_XML>true</CLICON_VALIDATE_STATE_XML>|<CLICON_VALIDATE_STATE_XML>false</CLICON_VALIDATE_STATE_XML>|' $cfg
+: ${nrlarge:=20000}
+conf="<table xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$nrlarge; i++ )); do
+    conf="$conf<parameter><name>p$i</name><value>value of parameter number $i</value></parameter>"
+done
+conf="$conf</table>"
+echo "<${DATASTORE_TOP}>$conf</${DATASTORE_TOP}>" > $dir/startup_db
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get-config client closes during streamed reply"
+rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>")
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qf $cfg | head -c 1000)
+match=$(echo "$ret" | grep --null -o "<rpc-reply $DEFAULTNS><data>")
+if [ -z "$match" ]; then
+    err "<rpc-reply $DEFAULTNS><data>" "$ret"
+fi
+
+new "get-config after closed streamed reply"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p42']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>p42</name><value>value of parameter number 42</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
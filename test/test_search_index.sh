@@ -6,12 +6,18 @@
 #   - not a key int
 #   - key in an ordered-by user
 #   - key in state data
-# Use instance-id for tests, since api-path can only handle keys, and xpath is too complex.
+#   - index on a leaf in a container of the list entry
+# Use instance-id for tests, since api-path can only handle keys.
+# Also check xpath predicates on index variables.
+# Then check that indexes of backend datastores are maintained: xpath predicates on index
+# variables after create, value change and delete, also with an index declared by
+# CLICON_YANG_SEARCH_INDEX
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
 : ${clixon_util_path:=clixon_util_path -D $DBG -Y /usr/local/share/clixon}
+: ${clixon_util_xpath:=clixon_util_xpath -D $DBG -Y /usr/local/share/clixon}
 
 # Number of list/leaf-list entries
 : ${nr:=10000}
@@ -56,6 +62,13 @@ module moda{
         description "non-index variable";
         type int32;
       }
+      container c{
+        leaf i{
+          description "explicit index variable in container";
+          type int32;
+          cc:search_index;
+        }
+      }
     }
   }
 }
@@ -67,7 +80,7 @@ new "generate list with $nr single string key to $xml1"
 echo -n '<x1 xmlns="urn:example:a">' > $xml1
 for (( i=0; i<$nr; i++ )); do  
     let ii=$nr-$i-1
-    echo -n "<y><k1>a$i</k1><z>foo$i</z><i>$ii</i><j>$ii</j></y>" >> $xml1
+    echo -n "<y><k1>a$i</k1><z>foo$i</z><i>$ii</i><j>$ii</j><c><i>$ii</i></c></y>" >> $xml1
 done
 echo -n '</x1>' >> $xml1
 
@@ -78,7 +91,13 @@ for (( ii=0; ii<10; ii++ )); do
     # Let key index rndi be reverse of rnd
     rndi=$(( $nr - $rnd - 1 ))
     new "instance-id single string key i=$rndi (rnd:$rnd)"
-    expectpart "$($clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:i=\"$rndi\"])" 0 "^0: <y><k1>a$rnd</k1><z>foo$rnd</z><i>$rndi</i><j>$rndi</j></y>$"
+    expectpart "$($clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:i=\"$rndi\"])" 0 "^0: <y><k1>a$rnd</k1><z>foo$rnd</z><i>$rndi</i><j>$rndi</j><c><i>$rndi</i></c></y>$"
+
+    new "xpath index i=$rndi (rnd:$rnd)"
+    expectpart "$($clixon_util_xpath -f $xml1 -n a:urn:example:a -y $ydir/moda.yang -p "/a:x1/a:y[a:i='$rndi']/a:k1")" 0 "^nodeset:0:<k1>a$rnd</k1>$"
+
+    new "xpath container index c/i=$rndi (rnd:$rnd)"
+    expectpart "$($clixon_util_xpath -f $xml1 -n a:urn:example:a -y $ydir/moda.yang -p "/a:x1/a:y[a:c/a:i='$rndi']/a:k1")" 0 "^nodeset:0:<k1>a$rnd</k1>$"
 done
 
 # Then measure time for index and non-index, assume correct
@@ -91,6 +110,123 @@ new "index search latency i=$rndi"
 new "non-index search latency j=$rndi"
 { time -p $clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:j=\"$rndi\"] > /dev/null; }  2>&1 | awk '/real/ {print $2}'
 
+# Backend datastores
+APPNAME=example
+cfg=$dir/conf_yang.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$ydir/moda.yang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_SEARCH_INDEX>/a:x1/a:y/a:j</CLICON_YANG_SEARCH_INDEX>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+# get-config of running with xpath filter
+# 1: xpath
+# 2: expected data
+function get_index()
+{
+    xpath=$1
+    expect=$2
+
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"$xpath\" xmlns:a=\"urn:example:a\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS>$expect</rpc-reply>"
+}
+
+new "create entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y><k1>a0</k1><i>10</i><j>10</j><c><i>10</i></c></y><y><k1>a1</k1><i>20</i><j>20</j><c><i>20</i></c></y><y><k1>a2</k1><i>30</i><j>30</j><c><i>30</i></c></y></x1></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit create"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get index i=20 after create"
+get_index "/a:x1/a:y[a:i='20']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a1</k1></y></x1></data>"
+
+new "get container index c/i=20 after create"
+get_index "/a:x1/a:y[a:c/a:i='20']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a1</k1></y></x1></data>"
+
+new "get option index j=20 after create"
+get_index "/a:x1/a:y[a:j='20']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a1</k1></y></x1></data>"
+
+new "change values of a1 to 25"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y><k1>a1</k1><i>25</i><j>25</j><c><i>25</i></c></y></x1></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit value change"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get index i=20 after change"
+get_index "/a:x1/a:y[a:i='20']/a:k1" "<data/>"
+
+new "get index i=25 after change"
+get_index "/a:x1/a:y[a:i='25']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a1</k1></y></x1></data>"
+
+new "get container index c/i=20 after change"
+get_index "/a:x1/a:y[a:c/a:i='20']/a:k1" "<data/>"
+
+new "get container index c/i=25 after change"
+get_index "/a:x1/a:y[a:c/a:i='25']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a1</k1></y></x1></data>"
+
+new "get option index j=20 after change"
+get_index "/a:x1/a:y[a:j='20']/a:k1" "<data/>"
+
+new "get option index j=25 after change"
+get_index "/a:x1/a:y[a:j='25']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a1</k1></y></x1></data>"
+
+new "get index i=30 after change"
+get_index "/a:x1/a:y[a:i='30']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a2</k1></y></x1></data>"
+
+new "delete a1"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y nc:operation=\"delete\" xmlns:nc=\"${BASENS}\"><k1>a1</k1></y></x1></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit delete"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get index i=25 after delete"
+get_index "/a:x1/a:y[a:i='25']/a:k1" "<data/>"
+
+new "get container index c/i=25 after delete"
+get_index "/a:x1/a:y[a:c/a:i='25']/a:k1" "<data/>"
+
+new "get option index j=25 after delete"
+get_index "/a:x1/a:y[a:j='25']/a:k1" "<data/>"
+
+new "get option index j=10 after delete"
+get_index "/a:x1/a:y[a:j='10']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a0</k1></y></x1></data>"
+
+new "get option index j=30 after delete"
+get_index "/a:x1/a:y[a:j='30']/a:k1" "<data><x1 xmlns=\"urn:example:a\"><y><k1>a2</k1></y></x1></data>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
 rm -rf $dir
 
 new "endtest"
@@ -5,7 +5,8 @@
 # The test adds the rfc conf that fails, then one that passes, then makes add
 # to fail it and then del to pass it.
 # Then makes a fail / pass test on the single field case
-# Last, a complex unsorted list with several sub-elements.
+# Then a complex unsorted list with several sub-elements.
+# Last, a large list ordered by user.
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -71,6 +72,21 @@ module unique{
          type string;
        }
      }
+     list ordered {
+       description "large list ordered by user";
+       key "name";
+       ordered-by user;
+       unique "ip port";
+       leaf name {
+         type string;
+       }
+       leaf ip {
+         type string;
+       }
+       leaf port {
+         type uint16;
+       }
+     }
      leaf b{
        type string;
      }
@@ -207,6 +223,28 @@ expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS>
 new "netconf discard-changes"
 expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
 
+# Large list ordered by user, in reverse order of names
+: ${nr:=5000}
+conf=""
+for (( i=$nr; i>0; i-- )); do
+    conf+="<ordered><name>s$i</name><ip>192.0.$((i/250)).$((i%250))</ip><port>$((i%1000))</port></ordered>"
+done
+
+new "Add large list ordered by user"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><c xmlns=\"urn:example:clixon\">$conf</c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate large list ordered by user"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Add last entry with same ip and port as first"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><ordered><name>x</name><ip>192.0.$((nr/250)).$((nr%250))</ip><port>$((nr%1000))</port></ordered></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate large list (should fail)"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/ordered[name=\"x\"]/ip</non-unique><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/ordered[name=\"x\"]/port</non-unique></error-info></rpc-error></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
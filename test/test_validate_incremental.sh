@@ -0,0 +1,246 @@
+#!/usr/bin/env bash
+# Incremental validation, CLICON_VALIDATE_INCREMENTAL
+# Only constraints of changed nodes and constraints depending on changes are validated on
+# commit. Check that constraints of unchanged nodes are still validated if they refer to
+# changed nodes:
+# - leafref to a deleted list entry
+# - must referring to a changed leaf
+# - when referring to a changed leaf
+# - augment when referring to the value of its target node, "."
+# - min-elements of a list where entries are deleted
+# - min-elements and mandatory of a node remaining after deleting one of its children
+# And that changes not affecting constraints commit as usual.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fyang2=$dir/clixon-augment.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang2</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_VALIDATE_INCREMENTAL>true</CLICON_VALIDATE_INCREMENTAL>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container interfaces{
+        list interface{
+            key name;
+            min-elements 1;
+            leaf name{
+                type string;
+            }
+            leaf mtu{
+                type uint32;
+            }
+        }
+    }
+    container routes{
+        list route{
+            key prefix;
+            leaf prefix{
+                type string;
+            }
+            leaf ifname{
+                type leafref{
+                    path "/ex:interfaces/ex:interface/ex:name";
+                }
+            }
+        }
+    }
+    container system{
+        leaf max-mtu{
+            type uint32;
+            must ". >= /ex:interfaces/ex:interface[ex:name='eth0']/ex:mtu" {
+                error-message "max-mtu smaller than eth0 mtu";
+            }
+        }
+        leaf mode{
+            type string;
+        }
+        leaf bridge{
+            when "../ex:mode = 'bridge'";
+            type string;
+        }
+        leaf hostname{
+            mandatory true;
+            type string;
+        }
+        list server{
+            key name;
+            min-elements 2;
+            leaf name{
+                type string;
+            }
+        }
+    }
+    container feature{
+        leaf state{
+            type string;
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fyang2
+module clixon-augment{
+    yang-version 1.1;
+    namespace "urn:example:augment";
+    prefix aug;
+    import clixon-example {
+        prefix ex;
+    }
+    augment "/ex:feature" {
+        when "contains(., 'on')";
+        leaf option{
+            type string;
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+  <interfaces xmlns="urn:example:clixon">
+    <interface><name>eth0</name><mtu>1500</mtu></interface>
+    <interface><name>eth1</name><mtu>1500</mtu></interface>
+  </interfaces>
+  <routes xmlns="urn:example:clixon">
+    <route><prefix>10.0.0.0/8</prefix><ifname>eth1</ifname></route>
+  </routes>
+  <system xmlns="urn:example:clixon">
+    <max-mtu>9000</max-mtu>
+    <mode>bridge</mode>
+    <bridge>br0</bridge>
+    <hostname>h1</hostname>
+    <server><name>s1</name></server>
+    <server><name>s2</name></server>
+  </system>
+  <feature xmlns="urn:example:clixon">
+    <state>on</state>
+    <option xmlns="urn:example:augment">x</option>
+  </feature>
+</${DATASTORE_TOP}>
+EOF
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "change unrelated leaf"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth1</name><mtu>9000</mtu></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit unrelated leaf"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete interface referred by unchanged leafref"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><interface nc:operation=\"delete\"><name>eth1</name></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit leafref, should fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "<error-app-tag>instance-required</error-app-tag>" ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "change leaf referred by unchanged must"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth0</name><mtu>9600</mtu></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit must, should fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "<error-message>max-mtu smaller than eth0 mtu</error-message>" ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "change leaf referred by unchanged when"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><system xmlns=\"urn:example:clixon\"><mode>router</mode></system></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "validate when, should fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-message>Failed WHEN condition of bridge in module clixon-example" ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "change value of augment target"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><feature xmlns=\"urn:example:clixon\"><state>off</state></feature></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit augment when, should fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "<error-message>Failed WHEN condition of option in module " ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete all interfaces and route"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><interface nc:operation=\"delete\"><name>eth0</name></interface><interface nc:operation=\"delete\"><name>eth1</name></interface></interfaces><routes xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\" nc:operation=\"delete\"/><system xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><max-mtu nc:operation=\"delete\"/></system></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit min-elements, should fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "<error-app-tag>too-few-elements</error-app-tag>" ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete one of two list entries with min-elements 2"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><system xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><server nc:operation=\"delete\"><name>s1</name></server></system></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit min-elements of remaining list, should fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "<error-app-tag>too-few-elements</error-app-tag>" ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete mandatory leaf"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><system xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><hostname nc:operation=\"delete\"/></system></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit mandatory, should fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "<error-tag>missing-element</error-tag>" ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "add interface and route"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth2</name></interface></interfaces><routes xmlns=\"urn:example:clixon\"><route><prefix>0.0.0.0/0</prefix><ifname>eth2</ifname></route></routes></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit added"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
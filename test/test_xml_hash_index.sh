@@ -0,0 +1,229 @@
+#!/usr/bin/env bash
+# Hash index of large lists and leaf-lists, see xml_hash_index_search
+# The index is built on first search of a list or leaf-list with at least XML_HASH_INDEX_MIN
+# entries. Check that searches by edit-config and xpath find the right entries:
+# - after a key and leaf-list value is changed in place, eg "050" for 50, rehashing the entry
+# - alternating key changes and lookups of the same and other entries
+# - after entries are removed, and added again
+# - when an entry cannot be hashed, using binary search, and after it is removed
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+# Number of list/leaf-list entries, at least XML_HASH_INDEX_MIN
+: ${nr:=200}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key id;
+            leaf id{
+                type uint32;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+    container prios{
+        leaf-list prio{
+            type uint32;
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+
+new "generate startup with $nr list and leaf-list entries"
+echo -n "<${DATASTORE_TOP}><table xmlns=\"urn:example:clixon\">" > $dir/startup_db
+for (( i=0; i<$nr; i++ )); do
+    echo -n "<parameter><id>$i</id><value>v$i</value></parameter>" >> $dir/startup_db
+done
+echo -n "</table><prios xmlns=\"urn:example:clixon\">" >> $dir/startup_db
+for (( i=0; i<$nr; i++ )); do
+    echo -n "<prio>$i</prio>" >> $dir/startup_db
+done
+echo "</prios></${DATASTORE_TOP}>" >> $dir/startup_db
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+# Edit candidate
+# 1: config
+# 2: expected reply or error
+function edit()
+{
+    config=$1
+    expect=$2
+
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$config</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS>$expect</rpc-reply>"
+}
+
+# get-config of candidate with xpath filter
+# 1: xpath
+# 2: expected data
+function get()
+{
+    xpath=$1
+    expect=$2
+
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"$xpath\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS>$expect</rpc-reply>"
+}
+
+NCNS="xmlns:nc=\"${BASENS}\""
+EXISTS="<rpc-error><error-type>application</error-type><error-tag>data-exists</error-tag><error-severity>error</error-severity><error-message>Data already exists; cannot create new resource</error-message></rpc-error>"
+MISSING="<rpc-error><error-type>application</error-type><error-tag>data-missing</error-tag><error-severity>error</error-severity><error-message>Data does not exist; cannot delete resource</error-message></rpc-error>"
+
+new "get list entry 50"
+get "/ex:table/ex:parameter[ex:id='50']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>50</id><value>v50</value></parameter></table></data>"
+
+new "create existing list entry 50, should fail"
+edit "<table xmlns=\"urn:example:clixon\"><parameter nc:operation=\"create\" $NCNS><id>50</id></parameter></table>" "$EXISTS"
+
+new "create existing leaf-list entry 50, should fail"
+edit "<prios xmlns=\"urn:example:clixon\"><prio nc:operation=\"create\" $NCNS>50</prio></prios>" "$EXISTS"
+
+# Key and leaf-list value change
+new "change key 50 to 050"
+edit "<table xmlns=\"urn:example:clixon\"><parameter><id>050</id><value>w50</value></parameter></table>" "<ok/>"
+
+new "get list entry 50 after key change"
+get "/ex:table/ex:parameter[ex:id='50']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>050</id><value>w50</value></parameter></table></data>"
+
+new "get list entry 51 after key change"
+get "/ex:table/ex:parameter[ex:id='51']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>51</id><value>v51</value></parameter></table></data>"
+
+new "change leaf-list value 50 to 050"
+edit "<prios xmlns=\"urn:example:clixon\"><prio>050</prio></prios>" "<ok/>"
+
+new "create leaf-list entry 50 after value change, should fail"
+edit "<prios xmlns=\"urn:example:clixon\"><prio nc:operation=\"create\" $NCNS>50</prio></prios>" "$EXISTS"
+
+# Alternating key changes and lookups, the index is kept and the entry rehashed
+for k in 80 81 82; do
+    o=$((k+10))
+    new "change key $k to 0$k"
+    edit "<table xmlns=\"urn:example:clixon\"><parameter><id>0$k</id><value>w$k</value></parameter></table>" "<ok/>"
+
+    new "get list entry $k after key change to 0$k"
+    get "/ex:table/ex:parameter[ex:id='$k']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>0$k</id><value>w$k</value></parameter></table></data>"
+
+    new "get list entry $o after key change to 0$k"
+    get "/ex:table/ex:parameter[ex:id='$o']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>$o</id><value>v$o</value></parameter></table></data>"
+
+    new "change key 0$k back to $k"
+    edit "<table xmlns=\"urn:example:clixon\"><parameter><id>$k</id><value>x$k</value></parameter></table>" "<ok/>"
+
+    new "get list entry $k after key change back"
+    get "/ex:table/ex:parameter[ex:id='$k']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>$k</id><value>x$k</value></parameter></table></data>"
+
+    new "change leaf-list value $k to 0$k"
+    edit "<prios xmlns=\"urn:example:clixon\"><prio>0$k</prio></prios>" "<ok/>"
+
+    new "create leaf-list entry $k after value change, should fail"
+    edit "<prios xmlns=\"urn:example:clixon\"><prio nc:operation=\"create\" $NCNS>$k</prio></prios>" "$EXISTS"
+done
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+# Removal
+new "delete list and leaf-list entries 60 and 61"
+edit "<table xmlns=\"urn:example:clixon\" $NCNS><parameter nc:operation=\"delete\"><id>60</id></parameter><parameter nc:operation=\"delete\"><id>61</id></parameter></table><prios xmlns=\"urn:example:clixon\" $NCNS><prio nc:operation=\"delete\">60</prio><prio nc:operation=\"delete\">61</prio></prios>" "<ok/>"
+
+new "get list entry 60 after delete"
+get "/ex:table/ex:parameter[ex:id='60']" "<data/>"
+
+new "get list entry 62 after delete"
+get "/ex:table/ex:parameter[ex:id='62']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>62</id><value>v62</value></parameter></table></data>"
+
+new "delete leaf-list entry 61 again, should fail"
+edit "<prios xmlns=\"urn:example:clixon\" $NCNS><prio nc:operation=\"delete\">61</prio></prios>" "$MISSING"
+
+new "create deleted list and leaf-list entries 60"
+edit "<table xmlns=\"urn:example:clixon\" $NCNS><parameter nc:operation=\"create\"><id>60</id><value>x60</value></parameter></table><prios xmlns=\"urn:example:clixon\" $NCNS><prio nc:operation=\"create\">60</prio></prios>" "<ok/>"
+
+new "get list entry 60 after create"
+get "/ex:table/ex:parameter[ex:id='60']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>60</id><value>x60</value></parameter></table></data>"
+
+new "create leaf-list entry 60 again, should fail"
+edit "<prios xmlns=\"urn:example:clixon\"><prio nc:operation=\"create\" $NCNS>60</prio></prios>" "$EXISTS"
+
+# Unhashable entries: values out of range of uint32 are not parsed, left for validation
+new "add list and leaf-list entries with invalid values"
+edit "<table xmlns=\"urn:example:clixon\"><parameter><id>4294967296</id><value>bad</value></parameter></table><prios xmlns=\"urn:example:clixon\"><prio>4294967296</prio></prios>" "<ok/>"
+
+new "get list entry 70 with invalid entry"
+get "/ex:table/ex:parameter[ex:id='70']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>70</id><value>v70</value></parameter></table></data>"
+
+new "create existing list entry 70 with invalid entry, should fail"
+edit "<table xmlns=\"urn:example:clixon\"><parameter nc:operation=\"create\" $NCNS><id>70</id></parameter></table>" "$EXISTS"
+
+new "create existing leaf-list entry 70 with invalid entry, should fail"
+edit "<prios xmlns=\"urn:example:clixon\"><prio nc:operation=\"create\" $NCNS>70</prio></prios>" "$EXISTS"
+
+new "delete list entry 71 with invalid entry"
+edit "<table xmlns=\"urn:example:clixon\" $NCNS><parameter nc:operation=\"delete\"><id>71</id></parameter></table>" "<ok/>"
+
+new "get list entry 71 after delete with invalid entry"
+get "/ex:table/ex:parameter[ex:id='71']" "<data/>"
+
+new "delete invalid entries"
+edit "<table xmlns=\"urn:example:clixon\" $NCNS><parameter nc:operation=\"delete\"><id>4294967296</id></parameter></table><prios xmlns=\"urn:example:clixon\" $NCNS><prio nc:operation=\"delete\">4294967296</prio></prios>" "<ok/>"
+
+new "get list entry 70 after invalid entry deleted"
+get "/ex:table/ex:parameter[ex:id='70']" "<data><table xmlns=\"urn:example:clixon\"><parameter><id>70</id><value>v70</value></parameter></table></data>"
+
+new "create existing leaf-list entry 70 after invalid entry deleted, should fail"
+edit "<prios xmlns=\"urn:example:clixon\"><prio nc:operation=\"create\" $NCNS>70</prio></prios>" "$EXISTS"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,151 @@
+#!/usr/bin/env bash
+# XPath optimization plans, see xpath_list_optimize_fn and xpath_optimize_descendant
+# Check that optimized xpath steps give the same result as regular evaluation:
+# - nested keyed lists, also below several parent list entries
+# - multi-key and leading (partial) key predicates, in any order and and-ed
+# - predicates depending on position are not pushed down
+# - or-ed predicates
+# - descendant search, also below unknown nodes treated as anydata
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_UNKNOWN_ANYDATA>true</CLICON_YANG_UNKNOWN_ANYDATA>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container c{
+        list a{
+            key name;
+            leaf name{
+                type string;
+            }
+            list b{
+                key "k1 k2";
+                leaf k1{
+                    type string;
+                }
+                leaf k2{
+                    type string;
+                }
+            }
+        }
+        container other{
+            container deep{
+                leaf target{
+                    type string;
+                }
+            }
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+  <c xmlns="urn:example:clixon">
+    <a>
+      <name>a1</name>
+      <b><k1>0</k1><k2>1</k2></b>
+      <b><k1>1</k1><k2>1</k2></b>
+      <b><k1>1</k1><k2>2</k2></b>
+    </a>
+    <a>
+      <name>a2</name>
+      <b><k1>1</k1><k2>3</k2></b>
+      <extra><target>z</target><hidden>h</hidden></extra>
+    </a>
+    <other>
+      <deep>
+        <target>x</target>
+      </deep>
+    </other>
+  </c>
+</${DATASTORE_TOP}>
+EOF
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "nested list, all keys"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:name='a1']/ex:b[ex:k1='1'][ex:k2='2']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>1</k1><k2>2</k2></b></a></c></data></rpc-reply>"
+
+new "nested list, all keys reversed and-ed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:name='a1']/ex:b[ex:k2='2' and ex:k1='1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>1</k1><k2>2</k2></b></a></c></data></rpc-reply>"
+
+new "nested list, leading key"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:name='a1']/ex:b[ex:k1='1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>1</k1><k2>1</k2></b><b><k1>1</k1><k2>2</k2></b></a></c></data></rpc-reply>"
+
+new "nested list, non-leading key"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a/ex:b[ex:k2='1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>0</k1><k2>1</k2></b><b><k1>1</k1><k2>1</k2></b></a></c></data></rpc-reply>"
+
+new "nested list, leading key over several parent entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a/ex:b[ex:k1='1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>1</k1><k2>1</k2></b><b><k1>1</k1><k2>2</k2></b></a><a><name>a2</name><b><k1>1</k1><k2>3</k2></b></a></c></data></rpc-reply>"
+
+new "nested list, all keys over several parent entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a/ex:b[ex:k1='1'][ex:k2='3']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a2</name><b><k1>1</k1><k2>3</k2></b></a></c></data></rpc-reply>"
+
+new "leading key before position"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:name='a1']/ex:b[ex:k1='1'][2]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>1</k1><k2>2</k2></b></a></c></data></rpc-reply>"
+
+new "position before leading key, not pushed down"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:name='a1']/ex:b[2][ex:k1='1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>1</k1><k2>1</k2></b></a></c></data></rpc-reply>"
+
+new "or-ed keys, not pushed down"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:name='a1']/ex:b[ex:k1='0' or ex:k2='2']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a1</name><b><k1>0</k1><k2>1</k2></b><b><k1>1</k1><k2>2</k2></b></a></c></data></rpc-reply>"
+
+new "descendant"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"//ex:target\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a2</name><extra><target>z</target></extra></a><other><deep><target>x</target></deep></other></c></data></rpc-reply>"
+
+new "descendant with key"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"//ex:b[ex:k2='3']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a2</name><b><k1>1</k1><k2>3</k2></b></a></c></data></rpc-reply>"
+
+new "descendant only below unknown node"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"//ex:hidden\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>a2</name><extra><hidden>h</hidden></extra></a></c></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -112,6 +112,28 @@ EOF
 new "XML Add any on top"
 expectpart "$($clixon_util_xml -vy $fyang -f $fxml)" 0 '^$'
 
+# File larger than read block, bound and sorted while parsing
+nr=2000
+echo -n '<a xmlns="urn:example:match">' > $fxml
+for (( i=$nr; i>0; i-- )); do
+    echo -n "<a><k>$i</k></a>" >> $fxml
+done
+echo -n '<any><kalle>hej</kalle></any></a>' >> $fxml
+expect='<a xmlns="urn:example:match">'
+for (( i=1; i<=$nr; i++ )); do
+    expect="$expect<a><k>$i</k></a>"
+done
+expect="$expect<any><kalle>hej</kalle></any></a>"
+
+new "XML large file sorted"
+expectpart "$($clixon_util_xml -ovy $fyang -f $fxml)" 0 "^$expect$"
+
+cat <<EOF > $fxml
+   <a xmlns="urn:example:match"><a><k>1</k></a><b/><a><k>2</k></a></a>
+EOF
+new "XML unknown element in file should fail"
+expectpart "$($clixon_util_xml -vy $fyang -f $fxml 2> /dev/null)" 255 '^$'
+
 # OK, same thing with JSON!
 
 cat <<EOF > $fjson